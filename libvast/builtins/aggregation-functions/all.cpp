@@ -48,6 +48,15 @@ private:
     return data{all_};
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return data{all_};
+  }
+
+  caf::error merge(const data_view& state) override {
+    add(state);
+    return {};
+  }
+
   std::optional<bool> all_ = {};
 };
 
@@ -48,6 +48,15 @@ private:
     return data{any_};
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return data{any_};
+  }
+
+  caf::error merge(const data_view& state) override {
+    add(state);
+    return {};
+  }
+
   std::optional<bool> any_ = {};
 };
 
@@ -0,0 +1,245 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <vast/aggregation_function.hpp>
+#include <vast/hash/hash.hpp>
+#include <vast/plugin.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace vast::plugins::approx_heavy_hitters {
+
+namespace {
+
+/// A count-min sketch over 64-bit hashes, as described by Cormode and
+/// Muthukrishnan, "An improved data stream summary: the count-min sketch and
+/// its applications" (2005).
+///
+/// With a width of w and a depth of d, the estimated count of a value exceeds
+/// its true count by at most e/w times the total count with probability
+/// 1 - e^-d, and never falls below it.
+class count_min_sketch {
+public:
+  static constexpr auto width = size_t{512};
+  static constexpr auto depth = size_t{4};
+
+  /// Increments the count of a hash.
+  /// @returns The new estimated count of the hash.
+  uint64_t add(uint64_t hash, uint64_t count = 1) {
+    if (counters_.empty())
+      counters_.resize(width * depth);
+    auto result = std::numeric_limits<uint64_t>::max();
+    for (size_t row = 0; row < depth; ++row) {
+      auto& counter = counters_[row * width + column(hash, row)];
+      counter += count;
+      result = std::min(result, counter);
+    }
+    return result;
+  }
+
+  /// Estimates the count of a hash.
+  [[nodiscard]] uint64_t estimate(uint64_t hash) const noexcept {
+    if (counters_.empty())
+      return 0;
+    auto result = std::numeric_limits<uint64_t>::max();
+    for (size_t row = 0; row < depth; ++row)
+      result = std::min(result, counters_[row * width + column(hash, row)]);
+    return result;
+  }
+
+  /// Adds the counters of another sketch to this one.
+  /// @returns An error if *counters* does not have one counter per cell.
+  caf::error merge(const list_view_handle& counters) {
+    if (counters.size() != width * depth)
+      return caf::make_error(ec::invalid_argument,
+                             fmt::format("count-min sketch state has {} "
+                                         "counters, but expected {}",
+                                         counters.size(), width * depth));
+    if (counters_.empty())
+      counters_.resize(width * depth);
+    auto index = size_t{0};
+    for (const auto& counter : counters)
+      counters_[index++] += caf::get<uint64_t>(counter);
+    return {};
+  }
+
+  [[nodiscard]] const std::vector<uint64_t>& counters() const noexcept {
+    return counters_;
+  }
+
+private:
+  /// Derives the column for a row from two halves of the hash, following
+  /// Kirsch and Mitzenmacher's double hashing. As the width is a power of
+  /// two, an odd step guarantees that every row maps a hash to a different
+  /// column. An even step would make rows collide or correlate.
+  static size_t column(uint64_t hash, size_t row) noexcept {
+    static_assert(std::has_single_bit(width));
+    const auto h1 = hash & 0xffffffff;
+    const auto h2 = (hash >> 32) | 1;
+    return (h1 + row * h2) % width;
+  }
+
+  std::vector<uint64_t> counters_ = {};
+};
+
+template <concrete_type Type>
+class approx_heavy_hitters_function final : public aggregation_function {
+public:
+  /// The number of values to return.
+  static constexpr auto num_results = size_t{10};
+
+  /// The number of candidates to track. Tracking more candidates than we
+  /// return makes the result less sensitive to the order of the input.
+  static constexpr auto num_candidates = 4 * num_results;
+
+  explicit approx_heavy_hitters_function(type input_type) noexcept
+    : aggregation_function(std::move(input_type)) {
+    // nop
+  }
+
+private:
+  using view_type = vast::view<type_to_data_t<Type>>;
+
+  struct candidate {
+    uint64_t hash = {};
+    uint64_t count = {};
+    type_to_data_t<Type> value = {};
+  };
+
+  [[nodiscard]] auto output_type() const -> type override {
+    return type{list_type{input_type()}};
+  }
+
+  void add(const data_view& view) override {
+    if (caf::holds_alternative<caf::none_t>(view))
+      return;
+    const auto& value = caf::get<view_type>(view);
+    const auto digest = hash(value);
+    offer(digest, sketch_.add(digest), value);
+  }
+
+  [[nodiscard]] auto finish() && -> caf::expected<data> override {
+    std::stable_sort(candidates_.begin(), candidates_.end(),
+                     [](const candidate& lhs, const candidate& rhs) noexcept {
+                       return lhs.count > rhs.count;
+                     });
+    auto result = list{};
+    const auto size = std::min(num_results, candidates_.size());
+    result.reserve(size);
+    for (size_t i = 0; i < size; ++i)
+      result.emplace_back(std::move(candidates_[i].value));
+    return data{std::move(result)};
+  }
+
+  [[nodiscard]] auto state_type() const -> type override {
+    return type{record_type{
+      {"counters", list_type{uint64_type{}}},
+      {"candidates", list_type{input_type()}},
+    }};
+  }
+
+  [[nodiscard]] auto save() const -> caf::expected<data> override {
+    if (candidates_.empty())
+      return data{};
+    auto counters = list{};
+    counters.reserve(sketch_.counters().size());
+    for (const auto counter : sketch_.counters())
+      counters.emplace_back(counter);
+    auto candidates = list{};
+    candidates.reserve(candidates_.size());
+    for (const auto& candidate : candidates_)
+      candidates.emplace_back(candidate.value);
+    return data{record{
+      {"counters", std::move(counters)},
+      {"candidates", std::move(candidates)},
+    }};
+  }
+
+  auto merge(const data_view& state) -> caf::error override {
+    if (caf::holds_alternative<caf::none_t>(state))
+      return {};
+    auto counters = std::optional<list_view_handle>{};
+    auto candidates = std::optional<list_view_handle>{};
+    for (const auto& [key, value] : caf::get<record_view_handle>(state)) {
+      if (key == "counters")
+        counters = caf::get<list_view_handle>(value);
+      else if (key == "candidates")
+        candidates = caf::get<list_view_handle>(value);
+    }
+    if (!counters || !candidates)
+      return caf::make_error(ec::invalid_argument,
+                             "count-min sketch state is malformed");
+    if (auto err = sketch_.merge(*counters))
+      return err;
+    // The counts of all candidates changed, so we need to re-estimate them
+    // before offering the candidates of the other sketch.
+    for (auto& candidate : candidates_)
+      candidate.count = sketch_.estimate(candidate.hash);
+    for (const auto& value : *candidates) {
+      const auto& typed_value = caf::get<view_type>(value);
+      const auto digest = hash(typed_value);
+      offer(digest, sketch_.estimate(digest), typed_value);
+    }
+    return {};
+  }
+
+  /// Updates the candidates with the estimated count of a value.
+  void offer(uint64_t digest, uint64_t count, const view_type& value) {
+    const auto match = std::find_if(
+      candidates_.begin(), candidates_.end(), [&](const candidate& x) {
+        return x.hash == digest && make_view(x.value) == value;
+      });
+    if (match != candidates_.end()) {
+      match->count = count;
+      return;
+    }
+    if (candidates_.size() < num_candidates) {
+      candidates_.push_back({digest, count, materialize(value)});
+      return;
+    }
+    const auto smallest = std::min_element(
+      candidates_.begin(), candidates_.end(),
+      [](const candidate& lhs, const candidate& rhs) noexcept {
+        return lhs.count < rhs.count;
+      });
+    if (count > smallest->count)
+      *smallest = {digest, count, materialize(value)};
+  }
+
+  count_min_sketch sketch_ = {};
+  std::vector<candidate> candidates_ = {};
+};
+
+class plugin : public virtual aggregation_function_plugin {
+  auto initialize([[maybe_unused]] const record& plugin_config,
+                  [[maybe_unused]] const record& global_config)
+    -> caf::error override {
+    return {};
+  }
+
+  [[nodiscard]] auto name() const -> std::string override {
+    return "approx_heavy_hitters";
+  };
+
+  [[nodiscard]] auto make_aggregation_function(const type& input_type) const
+    -> caf::expected<std::unique_ptr<aggregation_function>> override {
+    auto f = [&]<concrete_type Type>(
+               const Type&) -> std::unique_ptr<aggregation_function> {
+      return std::make_unique<approx_heavy_hitters_function<Type>>(input_type);
+    };
+    return caf::visit(f, input_type);
+  }
+};
+
+} // namespace
+
+} // namespace vast::plugins::approx_heavy_hitters
+
+VAST_REGISTER_PLUGIN(vast::plugins::approx_heavy_hitters::plugin)
@@ -0,0 +1,299 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <vast/aggregation_function.hpp>
+#include <vast/detail/string_literal.hpp>
+#include <vast/plugin.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+namespace vast::plugins::approx_quantile {
+
+namespace {
+
+/// A merging t-digest for estimating quantiles, as described by Dunning and
+/// Ertl, "Computing extremely accurate quantiles using t-digests" (2019).
+///
+/// Added values are buffered and periodically merged into a sorted list of
+/// centroids. The scale function limits the size of centroids near the tails
+/// of the distribution, which makes estimates of extreme quantiles accurate.
+class tdigest {
+public:
+  /// The compression parameter. The number of centroids is bounded by it.
+  static constexpr auto compression = 200.0;
+
+  /// The number of values to buffer before merging them into the centroids.
+  static constexpr auto buffer_capacity = size_t{1'000};
+
+  struct centroid {
+    double mean = {};
+    double weight = {};
+  };
+
+  /// Adds a weighted value to the digest.
+  void add(double mean, double weight = 1.0) {
+    if (std::isnan(mean))
+      return;
+    buffer_.push_back({mean, weight});
+    total_weight_ += weight;
+    min_ = std::min(min_, mean);
+    max_ = std::max(max_, mean);
+    if (buffer_.size() >= buffer_capacity)
+      compress();
+  }
+
+  /// Adds the bounds of another digest.
+  void add_bounds(double min, double max) noexcept {
+    min_ = std::min(min_, min);
+    max_ = std::max(max_, max);
+  }
+
+  /// Merges all buffered values into the centroids.
+  void compress() {
+    if (buffer_.empty())
+      return;
+    buffer_.insert(buffer_.end(), centroids_.begin(), centroids_.end());
+    std::sort(buffer_.begin(), buffer_.end(),
+              [](const centroid& lhs, const centroid& rhs) noexcept {
+                return lhs.mean < rhs.mean;
+              });
+    centroids_.clear();
+    auto current = buffer_.front();
+    auto weight_so_far = 0.0;
+    auto limit = quantile_limit(0.0);
+    for (auto it = buffer_.begin() + 1; it != buffer_.end(); ++it) {
+      const auto q = (weight_so_far + current.weight + it->weight)
+                     / total_weight_;
+      if (q <= limit) {
+        current.weight += it->weight;
+        current.mean += (it->mean - current.mean) * it->weight / current.weight;
+      } else {
+        weight_so_far += current.weight;
+        centroids_.push_back(current);
+        limit = quantile_limit(weight_so_far / total_weight_);
+        current = *it;
+      }
+    }
+    centroids_.push_back(current);
+    buffer_.clear();
+  }
+
+  /// Estimates a quantile.
+  /// @pre `compress()` was called after the last call to `add`.
+  [[nodiscard]] std::optional<double> quantile(double q) const {
+    VAST_ASSERT(buffer_.empty());
+    if (centroids_.empty())
+      return std::nullopt;
+    if (centroids_.size() == 1)
+      return centroids_.front().mean;
+    const auto target = q * total_weight_;
+    // Interpolate between the centers of adjacent centroids, and between the
+    // outermost centroids and the exact minimum and maximum.
+    auto previous_center = 0.0;
+    auto previous_mean = min_;
+    auto cumulative_weight = 0.0;
+    for (const auto& c : centroids_) {
+      const auto center = cumulative_weight + c.weight / 2.0;
+      if (target < center) {
+        const auto fraction = center == previous_center
+                                ? 0.0
+                                : (target - previous_center)
+                                    / (center - previous_center);
+        return previous_mean + fraction * (c.mean - previous_mean);
+      }
+      cumulative_weight += c.weight;
+      previous_center = center;
+      previous_mean = c.mean;
+    }
+    const auto fraction = total_weight_ == previous_center
+                            ? 0.0
+                            : (target - previous_center)
+                                / (total_weight_ - previous_center);
+    return previous_mean + std::min(fraction, 1.0) * (max_ - previous_mean);
+  }
+
+  [[nodiscard]] const std::vector<centroid>& centroids() const noexcept {
+    return centroids_;
+  }
+
+  [[nodiscard]] double min() const noexcept {
+    return min_;
+  }
+
+  [[nodiscard]] double max() const noexcept {
+    return max_;
+  }
+
+private:
+  /// Returns the maximum cumulative quantile of a centroid that starts at
+  /// quantile *q*, i.e., the quantile whose scale differs by one from *q*. This
+  /// uses the scale function k(q) = δ / 2π * asin(2q - 1).
+  static double quantile_limit(double q) noexcept {
+    constexpr auto factor = compression / (2.0 * std::numbers::pi);
+    const auto k = factor * std::asin(2.0 * q - 1.0) + 1.0;
+    return (std::sin(std::min(k / factor, std::numbers::pi / 2.0)) + 1.0)
+           / 2.0;
+  }
+
+  std::vector<centroid> centroids_ = {};
+  std::vector<centroid> buffer_ = {};
+  double total_weight_ = {};
+  double min_ = std::numeric_limits<double>::infinity();
+  double max_ = -std::numeric_limits<double>::infinity();
+};
+
+template <basic_type Type>
+class approx_quantile_function final : public aggregation_function {
+public:
+  approx_quantile_function(type input_type, double quantile) noexcept
+    : aggregation_function(std::move(input_type)), quantile_{quantile} {
+    // nop
+  }
+
+private:
+  [[nodiscard]] auto output_type() const -> type override {
+    if constexpr (std::is_same_v<Type, duration_type>)
+      return type{duration_type{}};
+    else
+      return type{double_type{}};
+  }
+
+  void add(const data_view& view) override {
+    using view_type = vast::view<type_to_data_t<Type>>;
+    if (caf::holds_alternative<caf::none_t>(view))
+      return;
+    const auto value = caf::get<view_type>(view);
+    if constexpr (std::is_same_v<Type, duration_type>)
+      digest_.add(static_cast<double>(value.count()));
+    else
+      digest_.add(static_cast<double>(value));
+  }
+
+  [[nodiscard]] auto finish() && -> caf::expected<data> override {
+    digest_.compress();
+    const auto result = digest_.quantile(quantile_);
+    if (!result)
+      return data{};
+    if constexpr (std::is_same_v<Type, duration_type>)
+      return data{duration{static_cast<duration::rep>(std::llround(*result))}};
+    else
+      return data{*result};
+  }
+
+  [[nodiscard]] auto state_type() const -> type override {
+    return type{record_type{
+      {"min", double_type{}},
+      {"max", double_type{}},
+      {"means", list_type{double_type{}}},
+      {"weights", list_type{double_type{}}},
+    }};
+  }
+
+  [[nodiscard]] auto save() const -> caf::expected<data> override {
+    // Saving must not modify the digest, so we compress a copy.
+    auto digest = digest_;
+    digest.compress();
+    if (digest.centroids().empty())
+      return data{};
+    auto means = list{};
+    auto weights = list{};
+    means.reserve(digest.centroids().size());
+    weights.reserve(digest.centroids().size());
+    for (const auto& c : digest.centroids()) {
+      means.emplace_back(c.mean);
+      weights.emplace_back(c.weight);
+    }
+    return data{record{
+      {"min", digest.min()},
+      {"max", digest.max()},
+      {"means", std::move(means)},
+      {"weights", std::move(weights)},
+    }};
+  }
+
+  auto merge(const data_view& state) -> caf::error override {
+    if (caf::holds_alternative<caf::none_t>(state))
+      return {};
+    auto min = std::optional<double>{};
+    auto max = std::optional<double>{};
+    auto means = std::vector<double>{};
+    auto weights = std::vector<double>{};
+    for (const auto& [key, value] : caf::get<record_view_handle>(state)) {
+      if (key == "min") {
+        min = caf::get<double>(value);
+      } else if (key == "max") {
+        max = caf::get<double>(value);
+      } else if (key == "means") {
+        for (const auto& mean : caf::get<list_view_handle>(value))
+          means.push_back(caf::get<double>(mean));
+      } else if (key == "weights") {
+        for (const auto& weight : caf::get<list_view_handle>(value))
+          weights.push_back(caf::get<double>(weight));
+      }
+    }
+    if (!min || !max || means.size() != weights.size())
+      return caf::make_error(ec::invalid_argument,
+                             "t-digest state is malformed");
+    for (size_t i = 0; i < means.size(); ++i)
+      digest_.add(means[i], weights[i]);
+    digest_.add_bounds(*min, *max);
+    return {};
+  }
+
+  double quantile_ = {};
+  tdigest digest_ = {};
+};
+
+/// An aggregation function plugin that estimates a fixed quantile.
+template <detail::string_literal Name, int Percentile>
+class plugin final : public virtual aggregation_function_plugin {
+  auto initialize([[maybe_unused]] const record& plugin_config,
+                  [[maybe_unused]] const record& global_config)
+    -> caf::error override {
+    return {};
+  }
+
+  [[nodiscard]] auto name() const -> std::string override {
+    return std::string{Name.str()};
+  };
+
+  [[nodiscard]] auto make_aggregation_function(const type& input_type) const
+    -> caf::expected<std::unique_ptr<aggregation_function>> override {
+    auto f = [&]<concrete_type Type>(const Type& type)
+      -> caf::expected<std::unique_ptr<aggregation_function>> {
+      if constexpr (detail::is_any_v<Type, int64_type, uint64_type,
+                                     double_type, duration_type>) {
+        return std::make_unique<approx_quantile_function<Type>>(
+          input_type, static_cast<double>(Percentile) / 100.0);
+      } else {
+        return caf::make_error(ec::invalid_configuration,
+                               fmt::format("{} aggregation function does not "
+                                           "support type {}",
+                                           name(), type));
+      }
+    };
+    return caf::visit(f, input_type);
+  }
+};
+
+using approx_median_plugin = plugin<"approx_median", 50>;
+using approx_p90_plugin = plugin<"approx_p90", 90>;
+using approx_p95_plugin = plugin<"approx_p95", 95>;
+using approx_p99_plugin = plugin<"approx_p99", 99>;
+
+} // namespace
+
+} // namespace vast::plugins::approx_quantile
+
+VAST_REGISTER_PLUGIN(vast::plugins::approx_quantile::approx_median_plugin)
+VAST_REGISTER_PLUGIN(vast::plugins::approx_quantile::approx_p90_plugin)
+VAST_REGISTER_PLUGIN(vast::plugins::approx_quantile::approx_p95_plugin)
+VAST_REGISTER_PLUGIN(vast::plugins::approx_quantile::approx_p99_plugin)
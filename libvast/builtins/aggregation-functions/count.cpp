@@ -42,6 +42,17 @@ private:
     return count_;
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return count_;
+  }
+
+  caf::error merge(const data_view& state) override {
+    if (caf::holds_alternative<caf::none_t>(state))
+      return {};
+    count_ += caf::get<view<uint64_t>>(state);
+    return {};
+  }
+
   uint64_t count_ = {};
 };
 
@@ -85,6 +85,22 @@ private:
     return data{std::move(result)};
   }
 
+  [[nodiscard]] auto save() const -> caf::expected<data> override {
+    auto result = list{};
+    result.reserve(distinct_.size());
+    for (const auto& value : distinct_)
+      result.emplace_back(value);
+    return data{std::move(result)};
+  }
+
+  auto merge(const data_view& state) -> caf::error override {
+    if (caf::holds_alternative<caf::none_t>(state))
+      return {};
+    for (const auto& value : caf::get<list_view_handle>(state))
+      add(value);
+    return {};
+  }
+
   tsl::robin_set<type_to_data_t<Type>, heterogeneous_data_hash<Type>,
                  heterogeneous_data_equal<Type>>
     distinct_ = {};
@@ -7,6 +7,7 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <vast/aggregation_function.hpp>
+#include <vast/arrow_table_slice.hpp>
 #include <vast/plugin.hpp>
 
 namespace vast::plugins::min {
@@ -35,10 +36,45 @@ private:
       min_ = materialize(caf::get<view_type>(view));
   }
 
+  void add(const arrow::Array& array) override {
+    using view_type = vast::view<type_to_data_t<Type>>;
+    if constexpr (std::is_same_v<type_to_arrow_array_t<Type>,
+                                 type_to_arrow_array_storage_t<Type>>) {
+      // Determine the minimum of the array first, and materialize it only
+      // once at the end.
+      const auto& values = caf::get<type_to_arrow_array_t<Type>>(array);
+      auto result = min_ ? std::optional<view_type>{make_view(*min_)}
+                         : std::optional<view_type>{};
+      auto updated = false;
+      for (int64_t row = 0; row < values.length(); ++row) {
+        if (values.IsNull(row))
+          continue;
+        const auto value = value_at(Type{}, values, row);
+        if (!result || value < *result) {
+          result = value;
+          updated = true;
+        }
+      }
+      if (updated)
+        min_ = materialize(*result);
+    } else {
+      aggregation_function::add(array);
+    }
+  }
+
   [[nodiscard]] caf::expected<data> finish() && override {
     return data{min_};
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return data{min_};
+  }
+
+  caf::error merge(const data_view& state) override {
+    add(state);
+    return {};
+  }
+
   std::optional<type_to_data_t<Type>> min_ = {};
 };
 
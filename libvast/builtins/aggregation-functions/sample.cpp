@@ -47,6 +47,15 @@ private:
     return std::move(sample_);
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return sample_;
+  }
+
+  caf::error merge(const data_view& state) override {
+    add(state);
+    return {};
+  }
+
   data sample_ = {};
 };
 
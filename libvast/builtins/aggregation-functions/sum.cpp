@@ -7,6 +7,7 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <vast/aggregation_function.hpp>
+#include <vast/arrow_table_slice.hpp>
 #include <vast/plugin.hpp>
 
 namespace vast::plugins::sum {
@@ -37,10 +38,41 @@ private:
       sum_ = *sum_ + materialize(caf::get<view_type>(view));
   }
 
+  void add(const arrow::Array& array) override {
+    if constexpr (detail::is_any_v<Type, int64_type, uint64_type, double_type,
+                                   duration_type>) {
+      const auto& values = caf::get<type_to_arrow_array_t<Type>>(array);
+      if (values.null_count() == values.length())
+        return;
+      auto sum = sum_.value_or(type_to_data_t<Type>{});
+      if (values.null_count() == 0) {
+        // Without nulls, the loop is simple enough to be vectorized.
+        for (int64_t row = 0; row < values.length(); ++row)
+          sum = sum + value_at(Type{}, values, row);
+      } else {
+        for (int64_t row = 0; row < values.length(); ++row)
+          if (!values.IsNull(row))
+            sum = sum + value_at(Type{}, values, row);
+      }
+      sum_ = sum;
+    } else {
+      aggregation_function::add(array);
+    }
+  }
+
   [[nodiscard]] caf::expected<data> finish() && override {
     return data{sum_};
   }
 
+  [[nodiscard]] caf::expected<data> save() const override {
+    return data{sum_};
+  }
+
+  caf::error merge(const data_view& state) override {
+    add(state);
+    return {};
+  }
+
   std::optional<type_to_data_t<Type>> sum_ = {};
 };
 
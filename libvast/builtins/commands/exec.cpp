@@ -58,7 +58,10 @@ auto exec_command(std::span<const std::string> args, caf::actor_system& sys)
                                        pipeline->to_string()));
   }
   caf::scoped_actor self{sys};
-  auto executor = self->spawn(pipeline_executor, std::move(*pipeline));
+  // The executor blocks while it runs a pipeline without remote operators, so
+  // we give it a thread of its own.
+  auto executor
+    = self->spawn<caf::detached>(pipeline_executor, std::move(*pipeline));
   auto result = caf::expected<void>{};
   // TODO: This command should probably implement signal handling, and check
   // whether a signal was raised in every iteration over the executor. This
@@ -90,8 +93,16 @@ public:
 
   auto make_command() const
     -> std::pair<std::unique_ptr<command>, command::factory> override {
-    auto exec = std::make_unique<command>("exec", "execute a pipeline locally",
-                                          command::opts("?vast.exec"));
+    auto exec = std::make_unique<command>(
+      "exec", "execute a pipeline locally",
+      command::opts("?vast.exec")
+        .add<uint64_t>("parallelism", "number of instances of operators that "
+                                      "process their input in parallel "
+                                      "(default: one per hardware thread)")
+        .add<bool>("preserve-order", "keep the output of operators with "
+                                     "multiple instances in input order")
+        .add<bool>("pin-threads", "pin the instances of operators to their "
+                                  "own CPUs, one NUMA node at a time"));
     auto factory = command::factory{
       {"exec",
        [=](const invocation& inv, caf::actor_system& sys) -> caf::message {
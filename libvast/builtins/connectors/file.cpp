@@ -8,10 +8,12 @@
 
 #include <vast/concept/parseable/to.hpp>
 #include <vast/concept/parseable/vast/data.hpp>
+#include <vast/concept/parseable/vast/si.hpp>
 #include <vast/detail/env.hpp>
 #include <vast/detail/fdinbuf.hpp>
 #include <vast/detail/fdoutbuf.hpp>
 #include <vast/detail/file_path_to_parser.hpp>
+#include <vast/detail/narrow.hpp>
 #include <vast/detail/posix.hpp>
 #include <vast/detail/string.hpp>
 #include <vast/logger.hpp>
@@ -20,12 +22,16 @@
 #include <caf/detail/scope_guard.hpp>
 #include <caf/error.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
 #include <fcntl.h>
 #include <filesystem>
 #include <memory>
+#include <optional>
 #include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <variant>
 
@@ -51,6 +57,123 @@ auto expand_path(std::string path) -> std::string {
   return path;
 }
 
+#if defined(POSIX_FADV_SEQUENTIAL)
+
+/// Gives the kernel a hint about how we are going to access a range of a file.
+/// Not all platforms support `posix_fadvise(2)`, so all callers must check for
+/// `POSIX_FADV_SEQUENTIAL` first.
+void advise(int fd, size_t offset, size_t size, int advice) {
+  ::posix_fadvise(fd, detail::narrow_cast<::off_t>(offset),
+                  detail::narrow_cast<::off_t>(size), advice);
+}
+
+#endif
+
+/// Reads a regular file in large blocks with `pread(2)`.
+///
+/// After reading a block, the reader asks the kernel to read the next block
+/// ahead asynchronously, so that it is in the page cache by the time the
+/// downstream operators are done with the current block.
+/// @param fd The file descriptor of the file.
+/// @param block_size The number of bytes per block.
+/// @param no_cache Whether to drop blocks from the page cache after reading
+/// them, so that reading a file once does not evict data that is read often.
+/// @param ctrl The control plane to report errors to.
+auto read_blocks(file_description_wrapper fd, size_t block_size,
+                 bool no_cache, operator_control_plane& ctrl)
+  -> generator<chunk_ptr> {
+  const auto file_size = [&]() -> std::optional<size_t> {
+    struct ::stat status {};
+    if (::fstat(*fd, &status) == -1) {
+      ctrl.abort(caf::make_error(ec::filesystem_error,
+                                 fmt::format("fstat(2) failed: {}",
+                                             detail::describe_errno())));
+      return std::nullopt;
+    }
+    return detail::narrow_cast<size_t>(status.st_size);
+  };
+  // We size every block by the number of bytes that remain in the file, so
+  // that small files and the last block of a file do not hold on to an
+  // entire block. The file may grow while we read it, so once we reach the
+  // size that we know of, we check whether there is more before stopping.
+  auto size = file_size();
+  if (not size)
+    co_return;
+#if defined(POSIX_FADV_SEQUENTIAL)
+  advise(*fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  auto offset = size_t{0};
+  while (true) {
+    if (offset >= *size) {
+      size = file_size();
+      if (not size or *size <= offset)
+        co_return;
+    }
+    const auto capacity = std::min(block_size, *size - offset);
+    // We deliberately leave the buffer uninitialized, because we overwrite it
+    // right away.
+    auto buffer = std::unique_ptr<std::byte[]>{new std::byte[capacity]};
+    auto bytes_read = size_t{0};
+    while (bytes_read < capacity) {
+      const auto bytes
+        = ::pread(*fd, buffer.get() + bytes_read, capacity - bytes_read,
+                  detail::narrow_cast<::off_t>(offset + bytes_read));
+      if (bytes == -1) {
+        if (errno == EINTR)
+          continue;
+        ctrl.abort(caf::make_error(ec::filesystem_error,
+                                   fmt::format("pread(2) failed: {}",
+                                               detail::describe_errno())));
+        co_return;
+      }
+      if (bytes == 0)
+        break;
+      bytes_read += detail::narrow_cast<size_t>(bytes);
+    }
+#if defined(POSIX_FADV_SEQUENTIAL)
+    if (no_cache)
+      advise(*fd, offset, bytes_read, POSIX_FADV_DONTNEED);
+#endif
+    offset += bytes_read;
+    if (bytes_read == 0)
+      co_return;
+    // A short read means that the file shrank while we read it.
+    const auto complete = bytes_read == capacity;
+#if defined(POSIX_FADV_SEQUENTIAL)
+    if (complete and offset < *size)
+      advise(*fd, offset, std::min(block_size, *size - offset),
+             POSIX_FADV_WILLNEED);
+#endif
+    const auto* data = buffer.get();
+    co_yield chunk::make(data, bytes_read,
+                         [buffer = std::move(buffer)]() noexcept {
+                           static_cast<void>(buffer);
+                         });
+    if (not complete)
+      co_return;
+  }
+}
+
+/// Splits a memory-mapped file into windows, so that downstream operators can
+/// start working before the kernel paged in the entire file.
+/// @param mapping The memory-mapped file.
+/// @param window_size The number of bytes per window.
+/// @pre `window_size` is a multiple of the page size.
+auto map_windows(chunk_ptr mapping, size_t window_size)
+  -> generator<chunk_ptr> {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  auto* data = const_cast<std::byte*>(mapping->data());
+  ::madvise(data, mapping->size(), MADV_SEQUENTIAL);
+  for (auto offset = size_t{0}; offset < mapping->size();
+       offset += window_size) {
+    const auto next = offset + window_size;
+    if (next < mapping->size())
+      ::madvise(data + next, std::min(window_size, mapping->size() - next),
+                MADV_WILLNEED);
+    co_yield mapping->slice(offset, window_size);
+  }
+}
+
 class writer {
 public:
   virtual ~writer() = default;
@@ -163,14 +286,20 @@ class plugin : public virtual loader_plugin, public virtual saver_plugin {
 public:
   static constexpr auto max_chunk_size = size_t{16384};
 
-  auto
-  make_loader(std::span<std::string const> args, operator_control_plane&) const
+  /// The size of the blocks to read from regular files.
+  static constexpr auto default_block_size = size_t{4} << 20;
+
+  auto make_loader(std::span<std::string const> args,
+                   operator_control_plane& ctrl) const
     -> caf::expected<generator<chunk_ptr>> override {
     auto read_timeout = read_timeout_;
     auto path = std::string{};
     auto following = false;
     auto mmap = false;
+    auto no_cache = false;
+    auto chunk_size = std::optional<size_t>{};
     auto is_socket = false;
+    auto is_regular = false;
     for (auto i = size_t{0}; i < args.size(); ++i) {
       const auto& arg = args[i];
       if (arg == "--timeout") {
@@ -187,10 +316,26 @@ public:
                                  fmt::format("could not parse duration: {}",
                                              args[i + 1]));
         }
+      } else if (arg == "--chunk-size") {
+        if (i + 1 == args.size()) {
+          return caf::make_error(ec::syntax_error,
+                                 fmt::format("missing chunk size value"));
+        }
+        auto parsed_size = uint64_t{};
+        if (not parsers::bytesize(args[i + 1], parsed_size)
+            or parsed_size == 0) {
+          return caf::make_error(ec::syntax_error,
+                                 fmt::format("could not parse chunk size: {}",
+                                             args[i + 1]));
+        }
+        chunk_size = detail::narrow_cast<size_t>(parsed_size);
+        ++i;
       } else if (arg == "-") {
         path = std_io_path;
       } else if (arg == "--mmap") {
         mmap = true;
+      } else if (arg == "--no-cache") {
+        no_cache = true;
       } else if (arg == "-f" || arg == "--follow") {
         following = true;
       } else if (not arg.starts_with("-")) {
@@ -203,6 +348,7 @@ public:
                                              expanded, err));
         }
         is_socket = (status.type() == std::filesystem::file_type::socket);
+        is_regular = (status.type() == std::filesystem::file_type::regular);
         if (path == std_io_path) {
           return caf::make_error(ec::parse_error,
                                  fmt::format("file argument {} can not be "
@@ -229,15 +375,33 @@ public:
         return caf::make_error(ec::filesystem_error,
                                "cannot use `--follow` with `--mmap`");
       }
+      if (no_cache) {
+        return caf::make_error(ec::filesystem_error,
+                               "cannot use `--no-cache` with `--mmap`");
+      }
       auto chunk = chunk::mmap(path);
       if (not chunk)
         return std::move(chunk.error());
+      if (chunk_size) {
+        // Windows must start at page boundaries for madvise(2).
+        const auto page_size
+          = detail::narrow_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        const auto window_size
+          = (*chunk_size + page_size - 1) / page_size * page_size;
+        return map_windows(std::move(*chunk), window_size);
+      }
       return std::invoke(
         [](chunk_ptr chunk) mutable -> generator<chunk_ptr> {
           co_yield std::move(chunk);
         },
         std::move(*chunk));
     }
+    const auto reads_blocks = is_regular and not following;
+    if (no_cache and not reads_blocks) {
+      return caf::make_error(ec::filesystem_error,
+                             "`--no-cache` requires a regular file without "
+                             "`--follow`");
+    }
     auto fd = file_description_wrapper(new int(STDIN_FILENO), [](auto* fd) {
       std::default_delete<int>()(fd);
     });
@@ -275,12 +439,18 @@ public:
         }
       }
     }
+    if (reads_blocks) {
+      return read_blocks(std::move(fd),
+                         chunk_size.value_or(default_block_size), no_cache,
+                         ctrl);
+    }
     return std::invoke(
-      [](auto timeout, auto fd, auto following) -> generator<chunk_ptr> {
-        auto in_buf = detail::fdinbuf(*fd, max_chunk_size);
+      [](auto timeout, auto fd, auto following,
+         size_t chunk_size) -> generator<chunk_ptr> {
+        auto in_buf = detail::fdinbuf(*fd, chunk_size);
         in_buf.read_timeout() = timeout;
         auto current_data = std::vector<std::byte>{};
-        current_data.reserve(max_chunk_size);
+        current_data.reserve(chunk_size);
         auto eof_reached = false;
         while (following or not eof_reached) {
           auto current_char = in_buf.sbumpc();
@@ -288,7 +458,7 @@ public:
             current_data.emplace_back(static_cast<std::byte>(current_char));
           }
           if (current_char == detail::fdinbuf::traits_type::eof()
-              or current_data.size() == max_chunk_size) {
+              or current_data.size() == chunk_size) {
             eof_reached = (current_char == detail::fdinbuf::traits_type::eof()
                            and not in_buf.timed_out());
             if (eof_reached and current_data.empty() and not following) {
@@ -299,12 +469,13 @@ public:
             if (eof_reached and not following) {
               break;
             }
-            current_data.reserve(max_chunk_size);
+            current_data.reserve(chunk_size);
           }
         }
         co_return;
       },
-      read_timeout, std::move(fd), following);
+      read_timeout, std::move(fd), following,
+      chunk_size.value_or(max_chunk_size));
   }
 
   auto default_parser(std::span<std::string const> args) const
@@ -314,7 +485,7 @@ public:
       if (arg == "-") {
         break;
       }
-      if (arg == "--timeout") {
+      if (arg == "--timeout" || arg == "--chunk-size") {
         ++i;
       } else if (!arg.starts_with("-")) {
         return {detail::file_path_to_parser(arg), {}};
@@ -10,14 +10,17 @@
 
 #include <vast/adaptive_table_slice_builder.hpp>
 #include <vast/arrow_table_slice.hpp>
+#include <vast/columnar_json_printer.hpp>
 #include <vast/concept/parseable/vast/data.hpp>
 #include <vast/concept/printable/vast/json.hpp>
 #include <vast/config_options.hpp>
 #include <vast/defaults.hpp>
 #include <vast/detail/assert.hpp>
 #include <vast/detail/padded_buffer.hpp>
+#include <vast/die.hpp>
 #include <vast/generator.hpp>
 #include <vast/operator_control_plane.hpp>
+#include <vast/operator_queue.hpp>
 #include <vast/plugin.hpp>
 
 #include <arrow/record_batch.h>
@@ -25,6 +28,13 @@
 
 #include <simdjson.h>
 
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 namespace vast::plugins::json {
 
 namespace {
@@ -359,7 +369,7 @@ auto handle_truncated_bytes(size_t truncated_bytes, json_buffer& buffer,
 }
 
 auto handle_known_schema(simdjson::ondemand::document_stream::iterator doc_it,
-                         selector& selector, parser_state& state,
+                         const selector& selector, parser_state& state,
                          const std::vector<type>& schemas,
                          operator_control_plane& ctrl) -> parser_action {
   auto maybe_schema_name = get_schema_name(*doc_it, selector);
@@ -411,19 +421,27 @@ auto unflatten_if_needed(std::string_view separator, table_slice slice) {
   return unflatten(slice, separator);
 }
 
-auto make_parser_impl(generator<chunk_ptr> json_chunk_generator,
-                      operator_control_plane& ctrl,
-                      std::optional<selector> selector, bool infer_types,
-                      std::string separator) -> generator<table_slice> {
+/// The options of the parser.
+struct parser_args {
+  std::optional<selector> schema_selector = {};
+  bool infer_types = true;
+  std::string separator = {};
+  uint64_t max_table_slice_rows = defaults::import::table_slice_size;
+  uint64_t threads = 1;
+  bool ordered = true;
+};
+
+auto parse_chunks(generator<chunk_ptr> json_chunk_generator,
+                  operator_control_plane& ctrl, const parser_args& args,
+                  const std::vector<type>& schemas) -> generator<table_slice> {
+  const auto& selector = args.schema_selector;
+  const auto& separator = args.separator;
   const auto schema_is_known = selector.has_value();
-  const auto schemas
-    = get_schemas(schema_is_known, ctrl, not separator.empty());
-  auto state = parser_state{.infer_types = infer_types};
+  auto state = parser_state{.infer_types = args.infer_types};
   if (not schema_is_known)
     state.last_used_builder = std::addressof(state.unknown_schema_builder);
-  auto field_validator = create_field_validator(schema_is_known, infer_types);
-  // TODO: change max table slice size to be fetched from options.
-  constexpr auto max_table_slice_rows = defaults::import::table_slice_size;
+  auto field_validator
+    = create_field_validator(schema_is_known, args.infer_types);
   auto parser = simdjson::ondemand::parser{};
   auto stream = simdjson::ondemand::document_stream{};
   auto json_to_parse_buffer = json_buffer{};
@@ -470,7 +488,7 @@ auto make_parser_impl(generator<chunk_ptr> json_chunk_generator,
                                        view, error_message(err))));
         continue;
       }
-      if (state.last_used_builder->rows() == max_table_slice_rows) {
+      if (state.last_used_builder->rows() == args.max_table_slice_rows) {
         co_yield unflatten_if_needed(separator, state.last_used_builder->finish(
                                                   state.last_used_schema_name));
         if (not schema_is_known)
@@ -485,6 +503,407 @@ auto make_parser_impl(generator<chunk_ptr> json_chunk_generator,
     co_yield unflatten_if_needed(separator, std::move(*slice));
 }
 
+auto make_parser_impl(generator<chunk_ptr> json_chunk_generator,
+                      operator_control_plane& ctrl, parser_args args)
+  -> generator<table_slice> {
+  const auto schemas = get_schemas(args.schema_selector.has_value(), ctrl,
+                                   not args.separator.empty());
+  for (auto&& slice :
+       parse_chunks(std::move(json_chunk_generator), ctrl, args, schemas))
+    co_yield std::move(slice);
+}
+
+// -- parallel parsing ---------------------------------------------------------
+
+/// The minimum size of the blocks that the parallel parser hands to its
+/// workers. Blocks end at a newline, so they are usually a bit larger.
+constexpr auto parallel_block_size = size_t{4} << 20;
+
+/// Splits line-delimited input into blocks of whole lines. Yields an empty
+/// chunk when the input stalls, after handing over all complete lines.
+auto split_blocks(generator<chunk_ptr> input) -> generator<chunk_ptr> {
+  auto buffer = std::vector<char>{};
+  // Takes all complete lines from the buffer, if any.
+  auto take_lines = [&]() -> chunk_ptr {
+    const auto newline = std::find(buffer.rbegin(), buffer.rend(), '\n');
+    if (newline == buffer.rend())
+      return {};
+    auto rest = std::vector<char>(newline.base(), buffer.end());
+    buffer.erase(newline.base(), buffer.end());
+    return chunk::make(std::exchange(buffer, std::move(rest)));
+  };
+  for (auto&& chnk : input) {
+    if (not chnk or chnk->size() == 0u) {
+      if (auto block = take_lines())
+        co_yield std::move(block);
+      co_yield {};
+      continue;
+    }
+    const auto* data = reinterpret_cast<const char*>(chnk->data());
+    buffer.insert(buffer.end(), data, data + chnk->size());
+    if (buffer.size() < parallel_block_size)
+      continue;
+    if (auto block = take_lines())
+      co_yield std::move(block);
+  }
+  if (not buffer.empty())
+    co_yield chunk::make(std::move(buffer));
+}
+
+/// The warnings and errors of the workers of the parallel parser, which run
+/// outside of the actor that executes the parser.
+class worker_diagnostics {
+public:
+  void warn(caf::error warning) {
+    auto lock = std::lock_guard{mutex_};
+    warnings_.push_back(std::move(warning));
+  }
+
+  void abort(caf::error error) {
+    auto lock = std::lock_guard{mutex_};
+    if (not error_)
+      error_ = std::move(error);
+  }
+
+  /// Forwards all diagnostics to the control plane of the parser.
+  /// @returns `false` if a worker aborted.
+  auto forward(operator_control_plane& ctrl) -> bool {
+    auto lock = std::lock_guard{mutex_};
+    for (auto& warning : warnings_)
+      ctrl.warn(std::move(warning));
+    warnings_.clear();
+    if (error_) {
+      ctrl.abort(std::exchange(error_, {}));
+      return false;
+    }
+    return true;
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<caf::error> warnings_;
+  caf::error error_;
+};
+
+/// The control plane of a worker of the parallel parser, which collects the
+/// diagnostics of the worker.
+class worker_control_plane final : public operator_control_plane {
+public:
+  worker_control_plane(worker_diagnostics& diagnostics,
+                       const operator_control_plane& parent)
+    : diagnostics_{diagnostics}, parent_{parent} {
+  }
+
+  auto self() noexcept -> system::execution_node_actor::base& override {
+    die("not implemented");
+  }
+
+  auto node() noexcept -> system::node_actor override {
+    // Workers run outside of the actor system, so they have no node handle.
+    return {};
+  }
+
+  auto abort(caf::error error) noexcept -> void override {
+    VAST_ASSERT(error != caf::none);
+    diagnostics_.abort(std::move(error));
+  }
+
+  auto warn(caf::error warning) noexcept -> void override {
+    diagnostics_.warn(std::move(warning));
+  }
+
+  auto emit(table_slice) noexcept -> void override {
+    die("not implemented");
+  }
+
+  auto schemas() const noexcept -> const std::vector<type>& override {
+    return parent_.schemas();
+  }
+
+  auto concepts() const noexcept -> const concepts_map& override {
+    return parent_.concepts();
+  }
+
+private:
+  worker_diagnostics& diagnostics_;
+  const operator_control_plane& parent_;
+};
+
+/// Worker threads that parse blocks of lines, each with a parser and table
+/// slice builders of its own.
+class worker_pool {
+public:
+  worker_pool(const parser_args& args, const std::vector<type>& schemas,
+              operator_control_plane& ctrl)
+    : args_{args},
+      schemas_{schemas},
+      // Blocks are large, so we keep only a few of them in flight.
+      input_{std::make_shared<operator_queue<chunk_ptr>>(2 * args.threads, 1,
+                                                         args.threads)},
+      output_{std::make_shared<operator_queue<table_slice>>(
+        defaults::exec::queue_capacity * args.threads, args.threads)} {
+    VAST_ASSERT(args.threads > 0);
+    threads_.reserve(args.threads);
+    for (size_t i = 0; i < args.threads; ++i) {
+      threads_.emplace_back([this, &ctrl] {
+        auto worker_ctrl = worker_control_plane{diagnostics_, ctrl};
+        run(worker_ctrl);
+        input_->cancel();
+        output_->close();
+      });
+    }
+  }
+
+  worker_pool(const worker_pool&) = delete;
+  auto operator=(const worker_pool&) -> worker_pool& = delete;
+
+  ~worker_pool() noexcept {
+    close_input();
+    output_->cancel();
+    join();
+  }
+
+  /// Returns the queue of blocks for the workers.
+  auto input() -> operator_queue<chunk_ptr>& {
+    return *input_;
+  }
+
+  /// Returns the queue that contains the slices of all workers. An empty
+  /// slice marks that a worker parsed the block with the same sequence number
+  /// completely.
+  auto output() -> operator_queue<table_slice>& {
+    return *output_;
+  }
+
+  /// Returns the warnings and errors of all workers.
+  auto diagnostics() -> worker_diagnostics& {
+    return diagnostics_;
+  }
+
+  /// Signals the workers that no more blocks follow.
+  void close_input() {
+    if (not std::exchange(input_closed_, true))
+      input_->close();
+  }
+
+  /// Waits for all workers to finish.
+  void join() {
+    for (auto& thread : threads_)
+      if (thread.joinable())
+        thread.join();
+  }
+
+private:
+  void run(operator_control_plane& ctrl) {
+    auto block = chunk_ptr{};
+    auto sequence = uint64_t{};
+    auto single = [](chunk_ptr chnk) -> generator<chunk_ptr> {
+      co_yield std::move(chnk);
+    };
+    while (true) {
+      const auto status
+        = input_->pop(block, sequence, defaults::exec::queue_poll_interval);
+      if (status == operator_queue_status::closed)
+        return;
+      if (status == operator_queue_status::timeout)
+        continue;
+      for (auto&& slice :
+           parse_chunks(single(std::move(block)), ctrl, args_, schemas_)) {
+        if (slice.rows() == 0)
+          continue;
+        if (not output_->push(std::move(slice), sequence))
+          return;
+      }
+      if (not output_->push(table_slice{}, sequence))
+        return;
+    }
+  }
+
+  const parser_args& args_;
+  const std::vector<type>& schemas_;
+  worker_diagnostics diagnostics_;
+  std::shared_ptr<operator_queue<chunk_ptr>> input_;
+  std::shared_ptr<operator_queue<table_slice>> output_;
+  bool input_closed_ = false;
+  std::vector<std::thread> threads_;
+};
+
+/// Collects the slices of the workers of the parallel parser, optionally in
+/// the order of their blocks, and merges adjacent slices of the same schema.
+class slice_merger {
+public:
+  slice_merger(bool ordered, uint64_t max_table_slice_rows,
+               uint64_t max_backlog)
+    : ordered_{ordered},
+      max_table_slice_rows_{max_table_slice_rows},
+      max_backlog_{max_backlog} {
+  }
+
+  /// Checks whether the block with the given sequence number may be handed to
+  /// the workers. When preserving order, the slices of all blocks after the
+  /// oldest incomplete one wait in the merger, so we limit how far the workers
+  /// may run ahead of a slow block.
+  auto accepts(uint64_t sequence) const -> bool {
+    return not ordered_ || sequence < next_ + max_backlog_;
+  }
+
+  /// Adds a slice of the block with the given sequence number. An empty slice
+  /// marks that the block is complete.
+  void add(table_slice slice, uint64_t sequence) {
+    if (not ordered_) {
+      if (slice.rows() > 0)
+        merge(std::move(slice));
+      return;
+    }
+    auto& entry = pending_[sequence];
+    if (slice.rows() == 0)
+      entry.done = true;
+    else
+      entry.slices.push_back(std::move(slice));
+    auto it = pending_.begin();
+    while (it != pending_.end() && it->first == next_ && it->second.done) {
+      for (auto& x : it->second.slices)
+        merge(std::move(x));
+      it = pending_.erase(it);
+      ++next_;
+    }
+  }
+
+  /// Releases the slices that wait for more slices of their schema.
+  void seal() {
+    if (held_.empty())
+      return;
+    ready_.push_back(concatenate(std::exchange(held_, {})));
+    held_rows_ = 0;
+  }
+
+  /// Releases all slices, regardless of whether their blocks are complete.
+  void flush() {
+    for (auto& [_, entry] : pending_)
+      for (auto& x : entry.slices)
+        merge(std::move(x));
+    pending_.clear();
+    seal();
+  }
+
+  /// Removes the slices that may leave the parser.
+  auto take() -> std::vector<table_slice> {
+    return std::exchange(ready_, {});
+  }
+
+private:
+  struct pending {
+    std::vector<table_slice> slices = {};
+    bool done = false;
+  };
+
+  void merge(table_slice slice) {
+    if (not held_.empty()
+        && (held_.front().schema() != slice.schema()
+            || held_rows_ + slice.rows() > max_table_slice_rows_))
+      seal();
+    held_rows_ += slice.rows();
+    held_.push_back(std::move(slice));
+    if (held_rows_ >= max_table_slice_rows_)
+      seal();
+  }
+
+  bool ordered_;
+  uint64_t max_table_slice_rows_;
+  uint64_t max_backlog_;
+  uint64_t next_ = 0;
+  std::map<uint64_t, pending> pending_;
+  std::vector<table_slice> held_;
+  uint64_t held_rows_ = 0;
+  std::vector<table_slice> ready_;
+};
+
+auto make_parallel_parser_impl(generator<chunk_ptr> json_chunk_generator,
+                               operator_control_plane& ctrl, parser_args args)
+  -> generator<table_slice> {
+  const auto schemas = get_schemas(args.schema_selector.has_value(), ctrl,
+                                   not args.separator.empty());
+  auto pool = worker_pool{args, schemas, ctrl};
+  // The workers and their input queue hold up to three blocks per worker. We
+  // allow for one more, so that the bound only kicks in if a block is slow.
+  auto merger = slice_merger{args.ordered, args.max_table_slice_rows,
+                             4 * args.threads};
+  auto slice = table_slice{};
+  auto sequence = uint64_t{};
+  auto next = uint64_t{0};
+  for (auto&& block : split_blocks(std::move(json_chunk_generator))) {
+    if (block) {
+      const auto current = next++;
+      auto stopped_early = [&] {
+        if (pool.diagnostics().forward(ctrl))
+          ctrl.abort(caf::make_error(ec::logic_error,
+                                     "json parser workers stopped early"));
+      };
+      while (true) {
+        if (merger.accepts(current)) {
+          const auto status = pool.input().push(
+            block, current, std::chrono::steady_clock::duration{});
+          if (status == operator_queue_status::ok)
+            break;
+          if (status == operator_queue_status::closed) {
+            stopped_early();
+            co_return;
+          }
+        }
+        // All workers are busy, or too many blocks wait for an earlier one,
+        // so we forward their output until they take the next block.
+        const auto status = pool.output().pop(
+          slice, sequence, defaults::exec::queue_poll_interval);
+        if (status == operator_queue_status::ok)
+          merger.add(std::move(slice), sequence);
+        if (status == operator_queue_status::closed) {
+          stopped_early();
+          co_return;
+        }
+        for (auto& x : merger.take())
+          co_yield std::move(x);
+      }
+    } else {
+      // The input stalls, so we release what we have instead of waiting for
+      // more slices of the same schema.
+      merger.seal();
+    }
+    while (pool.output().pop(slice, sequence,
+                             std::chrono::steady_clock::duration{})
+           == operator_queue_status::ok)
+      merger.add(std::move(slice), sequence);
+    if (not pool.diagnostics().forward(ctrl))
+      co_return;
+    auto ready = merger.take();
+    if (ready.empty())
+      co_yield {};
+    for (auto& x : ready)
+      co_yield std::move(x);
+  }
+  pool.close_input();
+  while (true) {
+    const auto status = pool.output().pop(slice, sequence,
+                                          defaults::exec::queue_poll_interval);
+    if (status == operator_queue_status::closed)
+      break;
+    if (status == operator_queue_status::ok)
+      merger.add(std::move(slice), sequence);
+    if (not pool.diagnostics().forward(ctrl))
+      co_return;
+    auto ready = merger.take();
+    if (ready.empty())
+      co_yield {};
+    for (auto& x : ready)
+      co_yield std::move(x);
+  }
+  pool.join();
+  if (not pool.diagnostics().forward(ctrl))
+    co_return;
+  merger.flush();
+  for (auto& x : merger.take())
+    co_yield std::move(x);
+}
+
 auto get_selector(const caf::settings& settings, operator_control_plane& ctrl)
   -> std::optional<selector> {
   if (not settings.contains("selector"))
@@ -517,15 +936,33 @@ class plugin final : public virtual parser_plugin,
     options.add<std::string>("selector", "");
     options.add<std::string>("unnest-separator", "");
     options.add<bool>("no-infer", "");
+    options.add<uint64_t>("max-rows", "");
+    options.add<uint64_t>("threads", "");
+    options.add<bool>("unordered", "");
     if (auto [ec, it] = options.parse(settings, args);
         ec != caf::pec::success) {
       return caf::make_error(ec,
                              fmt::format("failed to parse option '{}'", *it));
     }
-    return make_parser_impl(
-      std::move(json_chunk_generator), ctrl, get_selector(settings, ctrl),
-      not settings.contains("no-infer"),
-      caf::get_or<std::string>(settings, "unnest-separator", ""));
+    auto opts = parser_args{
+      .schema_selector = get_selector(settings, ctrl),
+      .infer_types = not settings.contains("no-infer"),
+      .separator = caf::get_or<std::string>(settings, "unnest-separator", ""),
+      .max_table_slice_rows = caf::get_or<uint64_t>(
+        settings, "max-rows", defaults::import::table_slice_size),
+      .threads = caf::get_or<uint64_t>(settings, "threads", uint64_t{1}),
+      .ordered = not settings.contains("unordered"),
+    };
+    if (opts.max_table_slice_rows == 0)
+      return caf::make_error(ec::invalid_argument,
+                             "json parser requires --max-rows to be positive");
+    if (opts.threads == 0)
+      opts.threads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (opts.threads == 1)
+      return make_parser_impl(std::move(json_chunk_generator), ctrl,
+                              std::move(opts));
+    return make_parallel_parser_impl(std::move(json_chunk_generator), ctrl,
+                                     std::move(opts));
   }
 
   auto default_loader(std::span<std::string const>) const
@@ -536,7 +973,6 @@ class plugin final : public virtual parser_plugin,
   auto make_printer(std::span<std::string const> args, type input_schema,
                     operator_control_plane&) const
     -> caf::expected<printer> override {
-    (void)input_schema;
     bool pretty = false;
     if (args.size() == 1 && args.front() == "--pretty") {
       pretty = true;
@@ -546,17 +982,36 @@ class plugin final : public virtual parser_plugin,
                                          "arguments: {}",
                                          fmt::join(args, ", ")));
     };
-    return to_printer([pretty](table_slice slice) -> generator<chunk_ptr> {
+    if (not pretty) {
+      // JSON printer should output NDJSON, see:
+      // https://github.com/ndjson/ndjson-spec
+      // We prepare printing once per schema. This printer may see multiple
+      // schemas when it prints into a joint output.
+      auto printers = std::unordered_map<type, columnar_json_printer>{};
+      if (caf::holds_alternative<record_type>(input_schema))
+        printers.try_emplace(input_schema, input_schema);
+      return to_printer(
+        [printers = std::move(printers)](
+          table_slice slice) mutable -> generator<chunk_ptr> {
+          if (slice.rows() == 0) {
+            co_yield {};
+            co_return;
+          }
+          auto printer = printers.find(slice.schema());
+          if (printer == printers.end())
+            printer
+              = printers.try_emplace(slice.schema(), slice.schema()).first;
+          auto buffer = std::vector<char>{};
+          printer->second.print(slice, buffer);
+          co_yield chunk::make(std::move(buffer));
+        });
+    }
+    return to_printer([](table_slice slice) -> generator<chunk_ptr> {
       if (slice.rows() == 0) {
         co_yield {};
         co_return;
       }
-      // JSON printer should output NDJSON, see:
-      // https://github.com/ndjson/ndjson-spec
-      auto printer = vast::json_printer{{.oneline = not pretty}};
-      // TODO: Since this printer is per-schema we can write an optimized
-      // version of it that gets the schema ahead of time and only expects
-      // data corresponding to exactly that schema.
+      auto printer = vast::json_printer{{.oneline = false}};
       auto buffer = std::vector<char>{};
       auto resolved_slice = resolve_enumerations(slice);
       auto array
@@ -8,12 +8,18 @@
 
 #include "vast/arrow_table_slice.hpp"
 #include "vast/cast.hpp"
+#include "vast/concept/parseable/numeric/real.hpp"
 #include "vast/concept/parseable/string/any.hpp"
+#include "vast/concept/parseable/vast/ip.hpp"
 #include "vast/concept/parseable/vast/option_set.hpp"
 #include "vast/concept/parseable/vast/pipeline.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/json.hpp"
 #include "vast/data.hpp"
+#include "vast/defaults.hpp"
+#include "vast/detail/delimiter_scanner.hpp"
+#include "vast/detail/narrow.hpp"
+#include "vast/detail/overload.hpp"
 #include "vast/detail/string.hpp"
 #include "vast/detail/string_literal.hpp"
 #include "vast/detail/to_xsv_sep.hpp"
@@ -34,6 +40,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <iterator>
 #include <string>
 #include <string_view>
@@ -196,12 +203,12 @@ auto parse_type(std::string_view zeek_type) -> caf::expected<type> {
 struct zeek_metadata {
   using iterator_type = std::string_view::const_iterator;
 
-  auto is_unset(std::string_view field) -> bool {
+  auto is_unset(std::string_view field) const -> bool {
     return std::equal(unset_field.begin(), unset_field.end(), field.begin(),
                       field.end());
   }
 
-  auto is_empty(std::string_view field) -> bool {
+  auto is_empty(std::string_view field) const -> bool {
     return std::equal(empty_field.begin(), empty_field.end(), field.begin(),
                       field.end());
   }
@@ -218,6 +225,16 @@ struct zeek_metadata {
                              fmt::format("zeek-tsv parser failed: invalid "
                                          "#separator option encountered"));
     }
+    // The delimiter scanner that splits the lines looks for a single
+    // character, so we reject longer separators rather than split at their
+    // first character only.
+    if (sep_option.size() != 4) {
+      return caf::make_error(ec::syntax_error,
+                             fmt::format("zeek-tsv parser failed: only "
+                                         "single-character separators are "
+                                         "supported, but got {}",
+                                         sep_option));
+    }
     auto sep_char = std::stoi(sep_option.substr(2, 2), nullptr, 16);
     VAST_ASSERT(sep_char >= 0 && sep_char <= 255);
     if (not sep.empty())
@@ -329,6 +346,183 @@ struct zeek_metadata {
   std::vector<rule<iterator_type, data>> parsers{};
 };
 
+/// Builds table slices from the values of a Zeek log, with one Arrow builder
+/// per column.
+///
+/// Most values in Zeek logs are timestamps, addresses, ports, counts, and
+/// strings. Columns of these types parse values directly into their builders,
+/// which avoids the type-erased parser and the intermediate `data`. All other
+/// columns, and values that the direct path rejects, use the parsers of the
+/// metadata.
+class zeek_builder {
+public:
+  explicit zeek_builder(const zeek_metadata& metadata)
+    : metadata_{&metadata},
+      builder_{caf::get<record_type>(metadata.temp_slice_schema)
+                 .make_arrow_builder(arrow::default_memory_pool())} {
+    const auto& schema = caf::get<record_type>(metadata.temp_slice_schema);
+    columns_.reserve(schema.num_fields());
+    for (size_t i = 0; i < schema.num_fields(); ++i) {
+      auto field_type = schema.field(i).type;
+      const auto kind = caf::visit(
+        detail::overload{
+          [](const int64_type&) {
+            return column_kind::int64;
+          },
+          [](const uint64_type&) {
+            return column_kind::uint64;
+          },
+          [](const double_type&) {
+            return column_kind::real;
+          },
+          [](const time_type&) {
+            return column_kind::time;
+          },
+          [](const duration_type&) {
+            return column_kind::duration;
+          },
+          [](const string_type&) {
+            return column_kind::string;
+          },
+          [](const ip_type&) {
+            return column_kind::ip;
+          },
+          [](const auto&) {
+            return column_kind::generic;
+          },
+        },
+        field_type);
+      columns_.push_back({
+        kind,
+        std::move(field_type),
+        builder_->field_builder(detail::narrow_cast<int>(i)),
+      });
+    }
+  }
+
+  /// Starts a new row.
+  auto begin_row() -> arrow::Status {
+    ++rows_;
+    return builder_->Append();
+  }
+
+  /// Appends a value to the current row.
+  /// @param column The index of the column.
+  /// @param value The value as it appears in the log.
+  /// @returns An `Invalid` status if the value failed to parse, in which case
+  /// the column holds a null value.
+  auto add(size_t column, std::string_view value) -> arrow::Status {
+    auto& [kind, column_type, builder] = columns_[column];
+    if (metadata_->is_unset(value))
+      return builder->AppendNull();
+    if (metadata_->is_empty(value))
+      return append_builder(column_type, *builder,
+                            make_data_view(column_type.construct()));
+    switch (kind) {
+      case column_kind::int64:
+        if (auto x = int64_t{}; parse_integer(value, x))
+          return append_builder(int64_type{}, as<int64_type>(*builder), x);
+        break;
+      case column_kind::uint64:
+        if (auto x = uint64_t{}; parse_integer(value, x))
+          return append_builder(uint64_type{}, as<uint64_type>(*builder), x);
+        break;
+      case column_kind::real:
+        if (auto x = double{}; parsers::real(value, x))
+          return append_builder(double_type{}, as<double_type>(*builder), x);
+        break;
+      case column_kind::time:
+        if (auto x = double{}; parsers::real(value, x))
+          return append_builder(
+            time_type{}, as<time_type>(*builder),
+            time{std::chrono::duration_cast<duration>(double_seconds(x))});
+        break;
+      case column_kind::duration:
+        if (auto x = double{}; parsers::real(value, x))
+          return append_builder(
+            duration_type{}, as<duration_type>(*builder),
+            std::chrono::duration_cast<duration>(double_seconds(x)));
+        break;
+      case column_kind::string:
+        // Unescaping leaves strings without backslashes as they are.
+        if (not value.empty() and value.find('\\') == value.npos)
+          return append_builder(string_type{}, as<string_type>(*builder),
+                                value);
+        break;
+      case column_kind::ip:
+        if (auto x = ip{}; parsers::ip(value, x))
+          return append_builder(ip_type{}, as<ip_type>(*builder), x);
+        break;
+      case column_kind::generic:
+        break;
+    }
+    auto x = data{};
+    if (not metadata_->parsers[column](value, x)) {
+      if (auto status = builder->AppendNull(); not status.ok())
+        return status;
+      return arrow::Status::Invalid("failed to parse value");
+    }
+    return append_builder(column_type, *builder, make_data_view(x));
+  }
+
+  /// Returns the number of rows since the last call to `finish`.
+  [[nodiscard]] auto rows() const -> size_t {
+    return rows_;
+  }
+
+  /// Turns all rows into a table slice, cast to the output schema of the
+  /// metadata if it has one.
+  auto finish() -> table_slice {
+    auto array = builder_->Finish().ValueOrDie();
+    auto batch = arrow::RecordBatch::Make(
+      metadata_->temp_slice_schema.to_arrow_schema(),
+      detail::narrow_cast<int64_t>(std::exchange(rows_, 0)),
+      caf::get<type_to_arrow_array_t<record_type>>(*array).fields());
+    auto result = table_slice{batch, metadata_->temp_slice_schema};
+    if (metadata_->output_slice_schema)
+      result = cast(std::move(result), metadata_->output_slice_schema);
+    return result;
+  }
+
+private:
+  enum class column_kind {
+    generic,
+    int64,
+    uint64,
+    real,
+    time,
+    duration,
+    string,
+    ip,
+  };
+
+  struct column_state {
+    column_kind kind;
+    class type type;
+    arrow::ArrayBuilder* builder;
+  };
+
+  template <concrete_type Type>
+  static auto as(arrow::ArrayBuilder& builder)
+    -> type_to_arrow_builder_t<Type>& {
+    return static_cast<type_to_arrow_builder_t<Type>&>(builder);
+  }
+
+  /// Parses an integer with `std::from_chars`, which does not accept all the
+  /// notations that the parsers of the metadata do.
+  template <class Integer>
+  static auto parse_integer(std::string_view value, Integer& x) -> bool {
+    const auto* end = value.data() + value.size();
+    const auto [ptr, ec] = std::from_chars(value.data(), end, x);
+    return ec == std::errc{} and ptr == end;
+  }
+
+  const zeek_metadata* metadata_;
+  std::shared_ptr<type_to_arrow_builder_t<record_type>> builder_;
+  std::vector<column_state> columns_ = {};
+  size_t rows_ = 0;
+};
+
 struct zeek_printer {
   zeek_printer(char set_sep, std::string_view empty = "",
                std::string_view unset = "", bool disable_timestamp_tags = false)
@@ -559,8 +753,9 @@ public:
         }
         ++it;
         auto closed = false;
-        auto b = table_slice_builder{metadata.temp_slice_schema};
-        std::vector<data> xs(metadata.fields.size());
+        auto b = zeek_builder{metadata};
+        auto scanner = detail::delimiter_scanner{metadata.sep[0]};
+        auto values = std::vector<std::string_view>{};
         for (; it != lines.end(); ++it) {
           auto line = *it;
           if (not line) {
@@ -591,18 +786,14 @@ public:
               co_return;
             }
             closed = false;
-            auto finished = b.finish();
-            if (metadata.output_slice_schema)
-              finished
-                = cast(std::move(finished), metadata.output_slice_schema);
-            co_yield std::move(finished);
+            co_yield b.finish();
             auto parsed = metadata.parse_header(it, lines, ctrl);
             if (not parsed) {
               ctrl.abort(parsed.error());
               co_return;
             }
-            xs.resize(metadata.fields.size());
-            b = table_slice_builder{metadata.temp_slice_schema};
+            b = zeek_builder{metadata};
+            scanner = detail::delimiter_scanner{metadata.sep[0]};
             ++it;
           }
           if (closed) {
@@ -613,7 +804,7 @@ public:
                                                    "preceded by Zeek header")));
             co_return;
           }
-          auto values = detail::split((*it).value(), metadata.sep);
+          scanner.split((*it).value(), values);
           if (values.size() != metadata.fields.size()) {
             ctrl.warn(caf::make_error(
               ec::parse_error,
@@ -623,38 +814,32 @@ public:
                           metadata.fields.size(), values.size())));
             continue;
           }
+          if (auto status = b.begin_row(); not status.ok()) {
+            ctrl.abort(caf::make_error(ec::parse_error,
+                                       fmt::format("zeek-tsv parser failed "
+                                                   "to add row: {}",
+                                                   status.ToString())));
+            co_return;
+          }
           for (auto i = size_t{0}; i < values.size(); ++i) {
-            auto value = values[i];
-            if (metadata.is_unset(value)) {
-              xs[i] = caf::none;
-            } else if (metadata.is_empty(value)) {
-              xs[i] = caf::get<record_type>(metadata.temp_slice_schema)
-                        .field(i)
-                        .type.construct();
-            } else if (!metadata.parsers[i](values[i], xs[i])) {
+            auto status = b.add(i, values[i]);
+            if (status.IsInvalid()) {
               ctrl.warn(caf::make_error(ec::parse_error,
-                                        fmt::format("zeek-tsv parser skipped "
-                                                    "line: failed"
+                                        fmt::format("zeek-tsv parser failed "
                                                     "to parse value '{}'",
-                                                    value)));
-              continue;
-            }
-          }
-          for (auto i = size_t{0}; i < xs.size(); ++i) {
-            auto&& x = xs[i];
-            if (not b.add(make_data_view(x))) {
+                                                    values[i])));
+            } else if (not status.ok()) {
               ctrl.abort(caf::make_error(ec::parse_error,
                                          fmt::format("zeek-tsv parser failed "
                                                      "to finalize value '{}'",
-                                                     x)));
+                                                     values[i])));
               co_return;
             }
           }
+          if (b.rows() >= defaults::import::table_slice_size)
+            co_yield b.finish();
         }
-        auto finished = b.finish();
-        if (metadata.output_slice_schema)
-          finished = cast(std::move(finished), metadata.output_slice_schema);
-        co_yield std::move(finished);
+        co_yield b.finish();
       },
       to_lines(std::move(loader)), ctrl);
   }
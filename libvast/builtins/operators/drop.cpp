@@ -12,6 +12,7 @@
 #include <vast/concept/parseable/vast/pipeline.hpp>
 #include <vast/detail/inspection_common.hpp>
 #include <vast/error.hpp>
+#include <vast/fused_operator.hpp>
 #include <vast/logger.hpp>
 #include <vast/plugin.hpp>
 #include <vast/type.hpp>
@@ -50,7 +51,8 @@ struct configuration {
 /// Drops the specifed fields from the input.
 class drop_operator final
   : public schematic_operator<
-      drop_operator, std::optional<std::vector<indexed_transformation>>> {
+      drop_operator, std::optional<std::vector<indexed_transformation>>>,
+    public fusable_operator {
 public:
   explicit drop_operator(configuration config) noexcept
     : config_{std::move(config)} {
@@ -97,6 +99,23 @@ public:
     return {};
   }
 
+  auto fuse(const type& schema, operator_control_plane& ctrl) const
+    -> caf::expected<fused_step> override {
+    auto state = initialize(schema, ctrl);
+    if (!state)
+      return std::move(state.error());
+    return [transformations = std::move(*state)](fused_batch& batch) {
+      if (transformations)
+        batch.transform_columns(*transformations);
+      else
+        batch.discard();
+    };
+  }
+
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::stateless;
+  }
+
   [[nodiscard]] auto to_string() const noexcept -> std::string override {
     return fmt::format("drop {}", fmt::join(config_.fields, ", "));
   }
@@ -93,6 +93,10 @@ public:
     }
   }
 
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::per_schema;
+  }
+
   auto to_string() const -> std::string override {
     if (field_ == default_field_name)
       return "enumerate";
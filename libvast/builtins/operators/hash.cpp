@@ -110,6 +110,10 @@ public:
     return transform_columns(slice, state);
   };
 
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::stateless;
+  }
+
   auto to_string() const noexcept -> std::string override {
     VAST_ASSERT(config_.out == fmt::format("{}_hashed", config_.field));
     auto result = std::string{"hash "};
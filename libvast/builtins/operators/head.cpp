@@ -46,6 +46,10 @@ public:
     return fmt::format("head {}", limit_);
   }
 
+  auto row_limit() const -> std::optional<uint64_t> override {
+    return limit_;
+  }
+
 private:
   uint64_t limit_;
 };
@@ -69,6 +69,10 @@ public:
     return op_->detached();
   }
 
+  auto parallelism() const -> operator_parallelism override {
+    return op_->parallelism();
+  }
+
   auto infer_type_impl(operator_type input) const
     -> caf::expected<operator_type> override {
     return op_->infer_type(input);
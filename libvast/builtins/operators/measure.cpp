@@ -6,6 +6,7 @@
 // SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <vast/adaptive_table_slice_builder.hpp>
 #include <vast/concept/parseable/string/char_class.hpp>
 #include <vast/concept/parseable/vast/pipeline.hpp>
 #include <vast/error.hpp>
@@ -22,8 +23,12 @@ namespace {
 
 class measure_operator final : public crtp_operator<measure_operator> {
 public:
-  measure_operator(uint64_t batch_size, bool real_time, bool cumulative)
-    : batch_size_{batch_size}, real_time_{real_time}, cumulative_{cumulative} {
+  measure_operator(uint64_t batch_size, bool real_time, bool cumulative,
+                   bool shape_cache)
+    : batch_size_{batch_size},
+      real_time_{real_time},
+      cumulative_{cumulative},
+      shape_cache_{shape_cache} {
   }
 
   auto operator()(generator<table_slice> input) const
@@ -37,8 +42,34 @@ public:
         {"schema_id", string_type{}},
       },
     };
-    auto builder = table_slice_builder{schema};
+    static const auto shape_cache_schema = type{
+      "vast.metrics.events",
+      record_type{
+        {"timestamp", time_type{}},
+        {"events", uint64_type{}},
+        {"schema", string_type{}},
+        {"schema_id", string_type{}},
+        {"shape_cache_hit_rate", double_type{}},
+      },
+    };
+    auto builder
+      = table_slice_builder{shape_cache_ ? shape_cache_schema : schema};
     auto counters = std::unordered_map<type, uint64_t>{};
+    // The hit rate of the shape caches of all adaptive table slice builders,
+    // which parsers use, since the previous measurement or since the start.
+    auto shape_cache_baseline
+      = adaptive_table_slice_builder::total_shape_cache_metrics();
+    auto shape_cache_hit_rate = [&]() -> data_view {
+      const auto current
+        = adaptive_table_slice_builder::total_shape_cache_metrics();
+      const auto hits = current.hits - shape_cache_baseline.hits;
+      const auto misses = current.misses - shape_cache_baseline.misses;
+      if (not cumulative_)
+        shape_cache_baseline = current;
+      if (hits + misses == 0)
+        return caf::none;
+      return static_cast<double>(hits) / static_cast<double>(hits + misses);
+    };
     for (auto&& slice : input) {
       if (slice.rows() == 0) {
         if (builder.rows() == 0) {
@@ -52,7 +83,8 @@ public:
       events = cumulative_ ? events + slice.rows() : slice.rows();
       const auto ok
         = builder.add(time{std::chrono::system_clock::now()}, events,
-                      slice.schema().name(), slice.schema().make_fingerprint());
+                      slice.schema().name(), slice.schema().make_fingerprint())
+          && (not shape_cache_ || builder.add(shape_cache_hit_rate()));
       VAST_ASSERT(ok);
       if (real_time_ || builder.rows() == batch_size_) {
         co_yield builder.finish();
@@ -99,14 +131,16 @@ public:
   }
 
   auto to_string() const -> std::string override {
-    return fmt::format("measure{}{}", real_time_ ? " --real-time" : "",
-                       cumulative_ ? " --cumulative" : "");
+    return fmt::format("measure{}{}{}", real_time_ ? " --real-time" : "",
+                       cumulative_ ? " --cumulative" : "",
+                       shape_cache_ ? " --shape-cache" : "");
   }
 
 private:
   uint64_t batch_size_ = {};
   bool real_time_ = {};
   bool cumulative_ = {};
+  bool shape_cache_ = {};
 };
 
 class plugin final : public virtual operator_plugin {
@@ -131,6 +165,7 @@ public:
     const auto* const l = pipeline.end();
     bool real_time = false;
     bool cumulative = false;
+    bool shape_cache = false;
     const auto p = *ignore((required_ws_or_comment
                             >> str{"--real-time"}.then([&](std::string) {
                                 real_time = true;
@@ -138,6 +173,10 @@ public:
                            | (required_ws_or_comment
                               >> str{"--cumulative"}.then([&](std::string) {
                                   cumulative = true;
+                                }))
+                           | (required_ws_or_comment
+                              >> str{"--shape-cache"}.then([&](std::string) {
+                                  shape_cache = true;
                                 })))
                    >> optional_ws_or_comment >> end_of_pipeline_operator;
     if (!p(f, l, unused)) {
@@ -150,7 +189,8 @@ public:
     }
     return {
       std::string_view{f, l},
-      std::make_unique<measure_operator>(batch_size_, real_time, cumulative),
+      std::make_unique<measure_operator>(batch_size_, real_time, cumulative,
+                                         shape_cache),
     };
   }
 
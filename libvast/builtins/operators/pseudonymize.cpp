@@ -107,6 +107,10 @@ public:
     return transform_columns(slice, state);
   }
 
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::stateless;
+  }
+
   auto to_string() const -> std::string override {
     auto result
       = fmt::format("pseudonymize --method=\"{}\" ",
@@ -14,6 +14,7 @@
 #include <vast/detail/narrow.hpp>
 #include <vast/detail/overload.hpp>
 #include <vast/error.hpp>
+#include <vast/fused_operator.hpp>
 #include <vast/plugin.hpp>
 #include <vast/table_slice_builder.hpp>
 #include <vast/type.hpp>
@@ -114,7 +115,8 @@ auto make_replace(const table_slice& slice, const operand& op) {
 
 template <mode Mode>
 class put_extend_operator final
-  : public crtp_operator<put_extend_operator<Mode>> {
+  : public crtp_operator<put_extend_operator<Mode>>,
+    public fusable_operator {
 public:
   explicit put_extend_operator(configuration config) noexcept
     : config_{std::move(config)} {
@@ -125,6 +127,45 @@ public:
     -> table_slice {
     if (slice.rows() == 0)
       return {};
+    return transform_columns(slice, make_transformations(slice, ctrl));
+  }
+
+  auto fuse(const type&, operator_control_plane& ctrl) const
+    -> caf::expected<fused_step> override {
+    return [this, &ctrl](fused_batch& batch) {
+      // The operands evaluate row by row, so we only evaluate them for the
+      // selected rows.
+      auto slice = batch.slice();
+      if (batch.empty())
+        return;
+      batch.transform_columns(make_transformations(slice, ctrl));
+    };
+  }
+
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::stateless;
+  }
+
+  [[nodiscard]] auto to_string() const noexcept -> std::string override {
+    auto result = std::string{operator_name(Mode)};
+    bool first = true;
+    for (const auto& [field, operand] : config_.extractor_to_operand) {
+      if (not std::exchange(first, false)) {
+        result += ',';
+      }
+      fmt::format_to(std::back_inserter(result), " {}", field);
+      if (operand) {
+        fmt::format_to(std::back_inserter(result), "={}", *operand);
+      }
+    }
+    return result;
+  }
+
+private:
+  /// Creates the transformations for a slice, which refer to the slice.
+  auto make_transformations(const table_slice& slice,
+                            operator_control_plane& ctrl) const
+    -> std::vector<indexed_transformation> {
     const auto& layout = caf::get<record_type>(slice.schema());
     auto batch = to_record_batch(slice);
     VAST_ASSERT(batch);
@@ -200,26 +241,9 @@ public:
         break;
       }
     }
-    // Lastly, apply our transformation.
-    return transform_columns(slice, transformations);
+    return transformations;
   }
 
-  [[nodiscard]] auto to_string() const noexcept -> std::string override {
-    auto result = std::string{operator_name(Mode)};
-    bool first = true;
-    for (const auto& [field, operand] : config_.extractor_to_operand) {
-      if (not std::exchange(first, false)) {
-        result += ',';
-      }
-      fmt::format_to(std::back_inserter(result), " {}", field);
-      if (operand) {
-        fmt::format_to(std::back_inserter(result), "={}", *operand);
-      }
-    }
-    return result;
-  }
-
-private:
   /// The underlying configuration of the transformation.
   configuration config_ = {};
 };
@@ -14,6 +14,7 @@
 #include <vast/concept/parseable/vast/data.hpp>
 #include <vast/concept/parseable/vast/pipeline.hpp>
 #include <vast/detail/inspection_common.hpp>
+#include <vast/fused_operator.hpp>
 #include <vast/plugin.hpp>
 #include <vast/table_slice_builder.hpp>
 #include <vast/type.hpp>
@@ -73,7 +74,8 @@ struct state_t {
 };
 
 class rename_operator final
-  : public schematic_operator<rename_operator, state_t> {
+  : public schematic_operator<rename_operator, state_t>,
+    public fusable_operator {
 public:
   rename_operator(configuration config) : config_{std::move(config)} {
     // nop
@@ -130,6 +132,22 @@ public:
     return slice;
   }
 
+  auto fuse(const type& schema, operator_control_plane& ctrl) const
+    -> caf::expected<fused_step> override {
+    auto state = initialize(schema, ctrl);
+    if (!state)
+      return std::move(state.error());
+    return [state = std::move(*state)](fused_batch& batch) {
+      batch.transform_columns(state.field_transformations);
+      if (state.renamed_schema)
+        batch.cast(*state.renamed_schema);
+    };
+  }
+
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::stateless;
+  }
+
   auto to_string() const noexcept -> std::string override {
     auto result = std::string{"rename"};
     auto first = true;
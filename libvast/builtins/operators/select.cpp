@@ -11,6 +11,7 @@
 #include <vast/concept/convertible/to.hpp>
 #include <vast/concept/parseable/vast/pipeline.hpp>
 #include <vast/error.hpp>
+#include <vast/fused_operator.hpp>
 #include <vast/pipeline.hpp>
 #include <vast/plugin.hpp>
 #include <vast/type.hpp>
@@ -46,7 +47,8 @@ struct configuration {
 };
 
 class select_operator final
-  : public schematic_operator<select_operator, std::vector<offset>> {
+  : public schematic_operator<select_operator, std::vector<offset>>,
+    public fusable_operator {
 public:
   explicit select_operator(configuration config) noexcept
     : config_{std::move(config)} {
@@ -69,6 +71,20 @@ public:
     return select_columns(slice, state);
   }
 
+  auto fuse(const type& schema, operator_control_plane& ctrl) const
+    -> caf::expected<fused_step> override {
+    auto state = initialize(schema, ctrl);
+    if (!state)
+      return std::move(state.error());
+    return [indices = std::move(*state)](fused_batch& batch) {
+      batch.select_columns(indices);
+    };
+  }
+
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::stateless;
+  }
+
   auto to_string() const -> std::string override {
     return fmt::format("select {}", fmt::join(config_.fields, ", "));
   }
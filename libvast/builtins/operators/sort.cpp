@@ -7,21 +7,39 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <vast/arrow_table_slice.hpp>
+#include <vast/chunk.hpp>
 #include <vast/concept/parseable/numeric/integral.hpp>
 #include <vast/concept/parseable/vast/pipeline.hpp>
+#include <vast/defaults.hpp>
 #include <vast/error.hpp>
 #include <vast/logger.hpp>
 #include <vast/pipeline.hpp>
 #include <vast/plugin.hpp>
+#include <vast/si_literals.hpp>
 #include <vast/table_slice.hpp>
+#include <vast/uuid.hpp>
 
 #include <arrow/compute/api_vector.h>
 #include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include <arrow/util/byte_size.h>
+
+#include <cmath>
+#include <compare>
+#include <filesystem>
+#include <fstream>
+#include <queue>
 
 namespace vast::plugins::sort {
 
 namespace {
 
+using namespace si_literals;
+
+/// The default upper bound for the size of the events that the operator
+/// buffers in memory before spilling them to disk.
+constexpr auto default_memory_budget = uint64_t{1_Gi};
+
 auto is_extension_type(const type& type) -> bool {
   VAST_ASSERT(type);
   const auto f = []<concrete_type Type>(const Type&) {
@@ -31,11 +49,198 @@ auto is_extension_type(const type& type) -> bool {
   return caf::visit(f, type);
 }
 
+/// Compares two sort keys with the same semantics as Arrow's sort functions,
+/// i.e., null values and NaNs are placed according to the null placement,
+/// with NaNs being placed closer to the other values than null values.
+auto compare_keys(const data_view& lhs, const data_view& rhs,
+                  const arrow::compute::ArraySortOptions& sort_options)
+  -> std::weak_ordering {
+  const auto rank = [](const data_view& x) {
+    if (caf::holds_alternative<caf::none_t>(x)) {
+      return 2;
+    }
+    if (const auto* value = caf::get_if<double>(&x);
+        value && std::isnan(*value)) {
+      return 1;
+    }
+    return 0;
+  };
+  const auto lhs_rank = rank(lhs);
+  const auto rhs_rank = rank(rhs);
+  if (lhs_rank != rhs_rank) {
+    return sort_options.null_placement == arrow::compute::NullPlacement::AtEnd
+             ? lhs_rank <=> rhs_rank
+             : rhs_rank <=> lhs_rank;
+  }
+  if (lhs_rank != 0) {
+    return std::weak_ordering::equivalent;
+  }
+  const auto ascending
+    = sort_options.order == arrow::compute::SortOrder::Ascending;
+  if (lhs < rhs) {
+    return ascending ? std::weak_ordering::less : std::weak_ordering::greater;
+  }
+  if (rhs < lhs) {
+    return ascending ? std::weak_ordering::greater : std::weak_ordering::less;
+  }
+  return std::weak_ordering::equivalent;
+}
+
+/// Takes the rows at the given positions from a record batch.
+auto take(const std::shared_ptr<arrow::RecordBatch>& batch,
+          const std::vector<int64_t>& rows)
+  -> std::shared_ptr<arrow::RecordBatch> {
+  const auto indices = std::shared_ptr<arrow::Array>{
+    std::make_shared<arrow::Int64Array>(
+      detail::narrow_cast<int64_t>(rows.size()), arrow::Buffer::Wrap(rows))};
+  return arrow::compute::Take(batch, indices).ValueOrDie().record_batch();
+}
+
+/// Concatenates record batches of the same schema into a single one.
+auto concatenate(arrow::RecordBatchVector batches)
+  -> std::shared_ptr<arrow::RecordBatch> {
+  VAST_ASSERT(not batches.empty());
+  if (batches.size() == 1) {
+    return std::move(batches.front());
+  }
+  const auto table = arrow::Table::FromRecordBatches(std::move(batches))
+                       .ValueOrDie()
+                       ->CombineChunks()
+                       .ValueOrDie();
+  auto columns = arrow::ArrayVector{};
+  columns.reserve(table->num_columns());
+  for (const auto& column : table->columns()) {
+    VAST_ASSERT(column->num_chunks() == 1);
+    columns.push_back(column->chunk(0));
+  }
+  return arrow::RecordBatch::Make(table->schema(), table->num_rows(),
+                                  std::move(columns));
+}
+
+/// Gathers individual rows of table slices into batches of one schema using
+/// Arrow's take function, so that we do not need to yield one slice per row.
+class row_gatherer {
+public:
+  /// Adds a row to the current batch.
+  /// @returns The previous batch if the row did not fit into it, and an empty
+  /// slice otherwise.
+  auto add(const table_slice& slice, int64_t row) -> table_slice {
+    auto result = table_slice{};
+    if (not order_.empty()
+        && (slice.schema() != schema_
+            || order_.size() >= defaults::import::table_slice_size)) {
+      result = finish();
+    }
+    if (order_.empty()) {
+      schema_ = slice.schema();
+    }
+    auto batch = to_record_batch(slice);
+    auto [source, inserted]
+      = source_indices_.try_emplace(batch.get(), sources_.size());
+    if (inserted) {
+      import_time_ = std::max(import_time_, slice.import_time());
+      sources_.push_back(std::move(batch));
+      source_rows_.emplace_back();
+    }
+    auto& rows = source_rows_[source->second];
+    order_.emplace_back(source->second,
+                        detail::narrow_cast<int64_t>(rows.size()));
+    rows.push_back(row);
+    return result;
+  }
+
+  /// Finishes the current batch.
+  /// @returns The current batch, or an empty slice if there is none.
+  auto finish() -> table_slice {
+    if (order_.empty()) {
+      return {};
+    }
+    // Taking rows from a table with one chunk per source costs as much as all
+    // rows of the sources, which adds up to quadratic costs if every batch
+    // takes a few rows from many large sources. Instead, we take the rows of
+    // every source separately, and then restore their order with a second
+    // take over the concatenation of the taken rows.
+    auto taken = arrow::RecordBatchVector{};
+    taken.reserve(sources_.size());
+    auto starts = std::vector<int64_t>{};
+    starts.reserve(sources_.size());
+    auto num_taken = int64_t{0};
+    for (size_t i = 0; i < sources_.size(); ++i) {
+      starts.push_back(num_taken);
+      num_taken += detail::narrow_cast<int64_t>(source_rows_[i].size());
+      taken.push_back(take(sources_[i], source_rows_[i]));
+    }
+    auto batch = concatenate(std::move(taken));
+    // The rows of a single source are already in order.
+    if (sources_.size() > 1) {
+      auto positions = std::vector<int64_t>{};
+      positions.reserve(order_.size());
+      for (const auto& [source, index] : order_) {
+        positions.push_back(starts[source] + index);
+      }
+      batch = take(batch, positions);
+    }
+    auto result = table_slice{std::move(batch), schema_};
+    result.import_time(import_time_);
+    order_.clear();
+    sources_.clear();
+    source_indices_.clear();
+    source_rows_.clear();
+    import_time_ = {};
+    return result;
+  }
+
+private:
+  /// The schema of the current batch.
+  type schema_ = {};
+
+  /// The record batches that the rows of the current batch are taken from.
+  std::vector<std::shared_ptr<arrow::RecordBatch>> sources_ = {};
+
+  /// Maps the record batches in `sources_` to their index.
+  std::unordered_map<const arrow::RecordBatch*, size_t> source_indices_ = {};
+
+  /// For every record batch in `sources_`, the rows to take from it.
+  std::vector<std::vector<int64_t>> source_rows_ = {};
+
+  /// The rows of the current batch in order, as the index of their source and
+  /// their index in the rows to take from that source.
+  std::vector<std::pair<size_t, int64_t>> order_ = {};
+
+  /// The latest import time of all sources.
+  time import_time_ = {};
+};
+
+/// A sorted sequence of events that was spilled to disk.
+struct spilled_run {
+  /// The file that contains the serialized slices of the run.
+  std::filesystem::path path = {};
+
+  /// The offset and size of every slice in the file.
+  std::vector<std::pair<size_t, size_t>> extents = {};
+};
+
 class sort_state {
 public:
   sort_state(const std::string& key,
-             const arrow::compute::ArraySortOptions& sort_options)
-    : key_{key}, sort_options_{sort_options} {
+             const arrow::compute::ArraySortOptions& sort_options,
+             uint64_t memory_budget, std::optional<uint64_t> limit)
+    : key_{key},
+      sort_options_{sort_options},
+      memory_budget_{memory_budget},
+      limit_{limit} {
+  }
+
+  sort_state(const sort_state&) = delete;
+  auto operator=(const sort_state&) -> sort_state& = delete;
+  sort_state(sort_state&&) = delete;
+  auto operator=(sort_state&&) -> sort_state& = delete;
+
+  ~sort_state() noexcept {
+    for (const auto& run : runs_) {
+      auto err = std::error_code{};
+      std::filesystem::remove(run.path, err);
+    }
   }
 
   auto try_add(table_slice slice, operator_control_plane& ctrl) -> table_slice {
@@ -46,48 +251,227 @@ public:
     if (not path) {
       return {};
     }
+    buffer(std::move(slice), *path);
+    // In top-k mode we only ever need to keep the first k events, so we
+    // periodically drop everything else. This bounds the memory usage without
+    // having to compare the sort keys one by one.
+    if (limit_
+        && buffered_rows_ >= std::max(2 * *limit_,
+                                      defaults::import::table_slice_size)) {
+      truncate();
+    }
+    if (buffered_bytes_ > memory_budget_) {
+      if (auto err = spill()) {
+        ctrl.abort(std::move(err));
+      }
+    }
+    return {};
+  }
+
+  auto sorted(operator_control_plane& ctrl) && -> generator<table_slice> {
+    // If nothing was spilled, we can just sort the events in memory.
+    if (runs_.empty()) {
+      for (auto&& slice : drain()) {
+        co_yield std::move(slice);
+      }
+      co_return;
+    }
+    // Otherwise, we merge the sorted runs, the last one of which is still in
+    // memory. The spilled runs are memory-mapped, so only the pages that the
+    // merge currently works on need to be resident.
+    auto runs = std::vector<std::vector<table_slice>>{};
+    runs.reserve(runs_.size() + 1);
+    for (const auto& run : runs_) {
+      auto chunk = chunk::mmap(run.path);
+      if (not chunk) {
+        ctrl.abort(caf::make_error(ec::filesystem_error,
+                                   fmt::format("failed to read spilled events "
+                                               "from {}: {}",
+                                               run.path, chunk.error())));
+        co_return;
+      }
+      auto& slices = runs.emplace_back();
+      slices.reserve(run.extents.size());
+      for (const auto& [begin, length] : run.extents) {
+        slices.emplace_back((*chunk)->slice(begin, length),
+                            table_slice::verify::no);
+      }
+    }
+    auto& last_run = runs.emplace_back();
+    for (auto&& slice : drain()) {
+      last_run.push_back(std::move(slice));
+    }
+    for (auto&& slice : merge(std::move(runs))) {
+      co_yield std::move(slice);
+    }
+  }
+
+private:
+  /// The position of the next event of a sorted run during the merge.
+  struct cursor {
+    size_t run = {};
+    size_t slice = {};
+    int64_t row = {};
+    std::shared_ptr<arrow::Array> keys = {};
+  };
+
+  /// Adds a slice to the in-memory buffer.
+  void buffer(table_slice slice, const offset& path) {
     auto batch = to_record_batch(slice);
     VAST_ASSERT(batch);
-    sort_keys_.push_back(arrow::FieldPath{*path}.Get(*batch).ValueOrDie());
+    buffered_bytes_ += arrow::util::TotalBufferSize(*batch);
+    buffered_rows_ += slice.rows();
+    sort_keys_.push_back(arrow::FieldPath{path}.Get(*batch).ValueOrDie());
     offset_table_.push_back(offset_table_.back()
                             + detail::narrow_cast<int64_t>(slice.rows()));
     cache_.push_back(std::move(slice));
-    return {};
   }
 
-  auto sorted() && -> generator<table_slice> {
+  /// Sorts the buffered events, and yields them in batches. Clears the buffer
+  /// once all events were yielded.
+  auto drain() -> generator<table_slice> {
     // If there is nothing to sort, then we can just return early.
     if (cache_.empty()) {
       co_return;
     }
     // Arrow's sort function returns us an Int64Array of indices, which are
     // guaranteed not to be null. We map these in a two-step process onto our
-    // cached table slices, and yield slices of size 1 for each returned row.
-    // The algorithm below uses an offset table that has an additional 0 value
-    // at the start, and uses std::upper_bound to find the entry in the cache
-    // using the offset table.
+    // cached table slices and gather the rows into batches. The algorithm
+    // below uses an offset table that has an additional 0 value at the start,
+    // and uses std::upper_bound to find the entry in the cache using the
+    // offset table.
     const auto chunked_key
       = arrow::ChunkedArray::Make(std::move(sort_keys_)).ValueOrDie();
     const auto indices
       = arrow::compute::SortIndices(*chunked_key, sort_options_).ValueOrDie();
-    auto result_buffer = std::vector<table_slice>{};
+    auto gatherer = row_gatherer{};
+    auto remaining = limit_.value_or(std::numeric_limits<uint64_t>::max());
     for (const auto& index : static_cast<const arrow::Int64Array&>(*indices)) {
       VAST_ASSERT(index.has_value());
+      if (remaining == 0) {
+        break;
+      }
+      --remaining;
       const auto offset = std::prev(
         std::upper_bound(offset_table_.begin(), offset_table_.end(), *index));
       const auto cache_index = std::distance(offset_table_.begin(), offset);
       const auto row = *index - *offset;
-      const auto& slice = cache_[cache_index];
-      auto result = subslice(slice, row, row + 1);
-      VAST_ASSERT(result.rows() == 1);
-      // TODO: Yielding slices with 1 row is very inefficient, and we probably
-      // want to batch them to larger slices here before yielding (or implicitly
-      // run the results through the rebatch operator).
+      if (auto result = gatherer.add(cache_[cache_index], row);
+          result.rows() > 0) {
+        co_yield std::move(result);
+      }
+    }
+    if (auto result = gatherer.finish(); result.rows() > 0) {
+      co_yield std::move(result);
+    }
+    cache_.clear();
+    offset_table_ = {0};
+    sort_keys_.clear();
+    buffered_bytes_ = 0;
+    buffered_rows_ = 0;
+  }
+
+  /// Drops all buffered events that do not make it into the top k.
+  void truncate() {
+    VAST_ASSERT(limit_);
+    auto kept = std::vector<table_slice>{};
+    for (auto&& slice : drain()) {
+      kept.push_back(std::move(slice));
+    }
+    for (auto& slice : kept) {
+      const auto& path = key_field_path_.at(slice.schema());
+      VAST_ASSERT(path);
+      buffer(std::move(slice), *path);
+    }
+  }
+
+  /// Sorts the buffered events and writes them to a temporary file.
+  auto spill() -> caf::error {
+    auto& run = runs_.emplace_back();
+    run.path = std::filesystem::temp_directory_path()
+               / fmt::format("vast-sort-{}", uuid::random());
+    VAST_DEBUG("sort operator spills {} events to {}", buffered_rows_,
+               run.path);
+    auto stream = std::ofstream{run.path, std::ios::binary | std::ios::trunc};
+    auto offset = size_t{0};
+    for (auto&& slice : drain()) {
+      // The slices we write are serialized in the same format that we use for
+      // sending them over the wire, which allows for mapping them back into
+      // memory without copying.
+      auto serialized
+        = table_slice{to_record_batch(slice), slice.schema(),
+                      table_slice::serialize::yes};
+      const auto bytes = as_bytes(serialized);
+      stream.write(reinterpret_cast<const char*>(bytes.data()),
+                   detail::narrow_cast<std::streamsize>(bytes.size()));
+      run.extents.emplace_back(offset, bytes.size());
+      offset += bytes.size();
+    }
+    stream.close();
+    if (not stream) {
+      return caf::make_error(ec::filesystem_error,
+                             fmt::format("failed to spill events to {}",
+                                         run.path));
+    }
+    return {};
+  }
+
+  /// Merges sorted runs of events, and yields them in batches.
+  auto merge(std::vector<std::vector<table_slice>> runs)
+    -> generator<table_slice> {
+    const auto key_of = [&](const cursor& x) {
+      return value_at(key_type_, *x.keys, x.row);
+    };
+    const auto keys_of = [&](size_t run, size_t slice) {
+      const auto& path = key_field_path_.at(runs[run][slice].schema());
+      VAST_ASSERT(path);
+      return arrow::FieldPath{*path}
+        .Get(*to_record_batch(runs[run][slice]))
+        .ValueOrDie();
+    };
+    // The priority queue yields the greatest element first, so we need to
+    // invert the order. Ties are broken by the run index, which keeps the
+    // merge stable as the runs are ordered by their arrival.
+    const auto after = [&](const cursor& lhs, const cursor& rhs) {
+      const auto order = compare_keys(key_of(lhs), key_of(rhs), sort_options_);
+      if (order != std::weak_ordering::equivalent) {
+        return order == std::weak_ordering::greater;
+      }
+      return lhs.run > rhs.run;
+    };
+    auto queue
+      = std::priority_queue<cursor, std::vector<cursor>, decltype(after)>{
+        after};
+    for (size_t run = 0; run < runs.size(); ++run) {
+      if (not runs[run].empty()) {
+        queue.push(cursor{run, 0, 0, keys_of(run, 0)});
+      }
+    }
+    auto gatherer = row_gatherer{};
+    auto remaining = limit_.value_or(std::numeric_limits<uint64_t>::max());
+    while (not queue.empty() && remaining > 0) {
+      auto next = queue.top();
+      queue.pop();
+      --remaining;
+      if (auto result = gatherer.add(runs[next.run][next.slice], next.row);
+          result.rows() > 0) {
+        co_yield std::move(result);
+      }
+      if (++next.row
+          == detail::narrow_cast<int64_t>(runs[next.run][next.slice].rows())) {
+        if (++next.slice == runs[next.run].size()) {
+          continue;
+        }
+        next.row = 0;
+        next.keys = keys_of(next.run, next.slice);
+      }
+      queue.push(std::move(next));
+    }
+    if (auto result = gatherer.finish(); result.rows() > 0) {
       co_yield std::move(result);
     }
   }
 
-private:
   auto find_or_create_path(const type& schema, operator_control_plane& ctrl)
     -> const std::optional<offset>& {
     auto key_path = key_field_path_.find(schema);
@@ -143,6 +527,12 @@ private:
   /// The sort options, as passed to the operator.
   const arrow::compute::ArraySortOptions& sort_options_;
 
+  /// The upper bound for `buffered_bytes_` before spilling to disk.
+  const uint64_t memory_budget_;
+
+  /// The maximum number of events to yield, if any.
+  const std::optional<uint64_t> limit_;
+
   /// The slices that we want to sort.
   std::vector<table_slice> cache_ = {};
 
@@ -155,6 +545,13 @@ private:
   /// The arrays that we sort by, in the same order as the offset table.
   std::vector<std::shared_ptr<arrow::Array>> sort_keys_ = {};
 
+  /// The approximate size and the number of the cached events.
+  uint64_t buffered_bytes_ = {};
+  uint64_t buffered_rows_ = {};
+
+  /// The sorted runs that were spilled to disk, in order of arrival.
+  std::vector<spilled_run> runs_ = {};
+
   /// The cached field paths for the sorted-by field per schema. A nullopt value
   /// indicates that sorting is not possible for this schema.
   std::unordered_map<type, std::optional<offset>> key_field_path_ = {};
@@ -165,42 +562,61 @@ private:
 
 class sort_operator final : public crtp_operator<sort_operator> {
 public:
-  sort_operator(std::string key, arrow::compute::ArraySortOptions sort_options)
-    : key_{std::move(key)}, sort_options_{std::move(sort_options)} {
+  sort_operator(std::string key, arrow::compute::ArraySortOptions sort_options,
+                uint64_t memory_budget, std::optional<uint64_t> limit = {})
+    : key_{std::move(key)},
+      sort_options_{std::move(sort_options)},
+      memory_budget_{memory_budget},
+      limit_{limit} {
   }
 
   auto
   operator()(generator<table_slice> input, operator_control_plane& ctrl) const
     -> generator<table_slice> {
-    auto state = sort_state{key_, sort_options_};
+    auto state = sort_state{key_, sort_options_, memory_budget_, limit_};
     for (auto&& slice : input) {
       co_yield state.try_add(std::move(slice), ctrl);
     }
-    for (auto&& slice : std::move(state).sorted()) {
+    for (auto&& slice : std::move(state).sorted(ctrl)) {
       co_yield std::move(slice);
     }
   }
 
   auto to_string() const -> std::string override {
     return fmt::format(
-      "sort {}{}{}", key_,
+      "sort {}{}{}{}", key_,
       sort_options_.order == arrow::compute::SortOrder::Ascending ? ""
                                                                   : " desc",
       sort_options_.null_placement == arrow::compute::NullPlacement::AtEnd
         ? ""
         : " nulls-first",
-      key_);
+      limit_ ? fmt::format(" | head {}", *limit_) : "");
+  }
+
+  auto limit_pushdown(uint64_t limit) const -> operator_ptr override {
+    return std::make_unique<sort_operator>(key_, sort_options_, memory_budget_,
+                                           std::min(limit, limit_.value_or(
+                                                             limit)));
   }
 
 private:
   std::string key_ = {};
   arrow::compute::ArraySortOptions sort_options_
     = arrow::compute::ArraySortOptions::Defaults();
+  uint64_t memory_budget_ = default_memory_budget;
+  std::optional<uint64_t> limit_ = {};
 };
 
 class plugin final : public virtual operator_plugin {
 public:
-  auto initialize(const record&, const record&) -> caf::error override {
+  auto initialize(const record& plugin_config, const record&)
+    -> caf::error override {
+    auto memory_budget
+      = try_get_or(plugin_config, "memory-budget", default_memory_budget);
+    if (not memory_budget) {
+      return std::move(memory_budget.error());
+    }
+    memory_budget_ = *memory_budget;
     return {};
   }
 
@@ -241,9 +657,13 @@ public:
     }
     return {
       std::string_view{f, l},
-      std::make_unique<sort_operator>(std::move(key), std::move(sort_options)),
+      std::make_unique<sort_operator>(std::move(key), std::move(sort_options),
+                                      memory_budget_),
     };
   }
+
+private:
+  uint64_t memory_budget_ = default_memory_budget;
 };
 
 } // namespace
@@ -8,24 +8,32 @@
 
 #include <vast/aggregation_function.hpp>
 #include <vast/arrow_table_slice.hpp>
+#include <vast/chunk.hpp>
 #include <vast/concept/convertible/data.hpp>
 #include <vast/concept/convertible/to.hpp>
 #include <vast/concept/parseable/core.hpp>
 #include <vast/concept/parseable/vast/pipeline.hpp>
 #include <vast/concept/parseable/vast/time.hpp>
+#include <vast/die.hpp>
 #include <vast/error.hpp>
-#include <vast/hash/hash_append.hpp>
+#include <vast/hash/xxhash.hpp>
 #include <vast/plugin.hpp>
 #include <vast/table_slice_builder.hpp>
 #include <vast/type.hpp>
+#include <vast/uuid.hpp>
 
 #include <arrow/compute/api_scalar.h>
+#include <arrow/compute/api_vector.h>
 #include <arrow/record_batch.h>
 #include <arrow/type.h>
 #include <caf/expected.hpp>
-#include <tsl/robin_map.h>
 
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <span>
 #include <utility>
 
 namespace vast::plugins::summarize {
@@ -49,6 +57,12 @@ make_round_temporal_options(duration time_resolution) noexcept {
   };
 }
 
+/// The default maximum number of groups to keep in memory.
+constexpr auto default_max_groups = size_t{1'048'576};
+
+/// The attribute that marks the schema of partial aggregation states.
+constexpr auto partial_state_attribute = "summarize-partial";
+
 /// The configuration of a summarize pipeline operator, for example:
 ///
 ///   summarize:
@@ -118,6 +132,9 @@ struct configuration {
   /// Configuration for aggregation columns.
   std::vector<aggregation> aggregations = {};
 
+  /// The maximum number of groups to keep in memory before spilling.
+  size_t max_groups = default_max_groups;
+
 private:
   /// Parse the unresolved group-by-extractors from their configuration.
   /// @param config The relevant configuration subsection.
@@ -342,6 +359,10 @@ struct aggregation_column {
       column.input_type = std::move(input_type);
       column.output_name = aggregation.output;
       column.output_type = std::move(output_type);
+      column.state_type = (*instance)->state_type();
+      // Aggregation functions that do not support partial aggregation fail to
+      // save their state, even if they did not see any input.
+      column.mergeable = static_cast<bool>((*instance)->save());
     }
     return result;
   }
@@ -360,80 +381,347 @@ struct aggregation_column {
 
   /// The output field's type.
   class type output_type = {};
+
+  /// The type of the intermediate state of the aggregation function.
+  class type state_type = {};
+
+  /// Whether the aggregation function supports partial aggregation.
+  bool mergeable = {};
 };
 
 /// The key by which aggregations are grouped. Essentially, this is a vector of
-/// data. We create a new type here to support a custom hash and equality
-/// operation to support lookups with non-materialized keys.
+/// data.
 struct group_by_key : std::vector<data> {
   using vector::vector;
 };
 
-/// A view on a group-by key.
-struct group_by_key_view : std::vector<data_view> {
-  using vector::vector;
+/// Appends a value to the encoding of a group-by key. The encoding is
+/// injective, i.e., two keys are equal if and only if their encodings are.
+void encode_group_by_value(const data_view& value,
+                           std::vector<std::byte>& out) {
+  const auto append_bytes = [&](std::span<const std::byte> bytes) {
+    out.insert(out.end(), bytes.begin(), bytes.end());
+  };
+  const auto append = [&](const auto& x) {
+    append_bytes(std::as_bytes(std::span{&x, 1}));
+  };
+  const auto append_string = [&](std::string_view x) {
+    append(uint64_t{x.size()});
+    append_bytes(std::as_bytes(std::span{x.data(), x.size()}));
+  };
+  out.push_back(static_cast<std::byte>(value.index()));
+  auto f = detail::overload{
+    [](caf::none_t) {},
+    [&](bool x) {
+      append(x);
+    },
+    [&](int64_t x) {
+      append(x);
+    },
+    [&](uint64_t x) {
+      append(x);
+    },
+    [&](double x) {
+      // Positive and negative zero compare equal, so they must be encoded
+      // identically.
+      append(x == 0.0 ? 0.0 : x);
+    },
+    [&](duration x) {
+      append(x.count());
+    },
+    [&](time x) {
+      append(x.time_since_epoch().count());
+    },
+    [&](std::string_view x) {
+      append_string(x);
+    },
+    [&](const pattern_view& x) {
+      append_string(x.string());
+      append(x.case_insensitive());
+    },
+    [&](const ip& x) {
+      append_bytes(as_bytes(x));
+    },
+    [&](const subnet& x) {
+      append_bytes(as_bytes(x.network()));
+      append(x.length());
+    },
+    [&](enumeration x) {
+      append(x);
+    },
+    [&](const list_view_handle& xs) {
+      append(uint64_t{xs.size()});
+      for (const auto& x : xs)
+        encode_group_by_value(x, out);
+    },
+    [&](const map_view_handle& xs) {
+      append(uint64_t{xs.size()});
+      for (const auto& [key, value] : xs) {
+        encode_group_by_value(key, out);
+        encode_group_by_value(value, out);
+      }
+    },
+    [&](const record_view_handle& xs) {
+      append(uint64_t{xs.size()});
+      for (const auto& [key, value] : xs) {
+        append_string(key);
+        encode_group_by_value(value, out);
+      }
+    },
+  };
+  caf::visit(f, value);
+}
 
-  /// Materializes a view on a group-by key.
-  /// @param views The group-by key view to materialize.
-  friend group_by_key materialize(const group_by_key_view& views) {
-    auto result = group_by_key{};
-    result.reserve(views.size());
-    for (const auto& view : views)
-      result.push_back(materialize(view));
-    return result;
+/// Returns the size of the fixed-width encoding of the values of a group-by
+/// column, or zero if the values do not have a fixed-width encoding.
+size_t fixed_key_width(const type& type) noexcept {
+  auto f = []<concrete_type Type>(const Type&) -> size_t {
+    if constexpr (std::is_same_v<Type, bool_type>)
+      return sizeof(bool);
+    else if constexpr (detail::is_any_v<Type, int64_type, uint64_type,
+                                        double_type, duration_type, time_type>)
+      return sizeof(int64_t);
+    else if constexpr (std::is_same_v<Type, ip_type>)
+      return 16;
+    else
+      return 0;
+  };
+  return caf::visit(f, type);
+}
+
+/// Encodes a fixed-width group-by column for all rows of a batch. Every value
+/// is encoded as a validity byte followed by the value's bytes.
+/// @param type The type of the column.
+/// @param array The values of the column.
+/// @param out The position of the column in the encoding of the first row.
+/// @param stride The size of the encoding of a row.
+/// @pre `fixed_key_width(type) > 0`
+void encode_fixed_width_column(const type& type, const arrow::Array& array,
+                               std::byte* out, size_t stride) noexcept {
+  auto f = [&]<concrete_type Type>(const Type& type) noexcept {
+    if constexpr (detail::is_any_v<Type, bool_type, int64_type, uint64_type,
+                                   double_type, duration_type, time_type,
+                                   ip_type>) {
+      // Resolve the storage array only once instead of once per row.
+      const auto& storage = [&]() -> const auto& {
+        if constexpr (arrow::is_extension_type<
+                        type_to_arrow_type_t<Type>>::value)
+          return static_cast<const type_to_arrow_array_storage_t<Type>&>(
+            *caf::get<type_to_arrow_array_t<Type>>(array).storage());
+        else
+          return caf::get<type_to_arrow_array_t<Type>>(array);
+      }();
+      // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      for (int64_t row = 0; row < storage.length(); ++row, out += stride) {
+        if (storage.IsNull(row))
+          continue;
+        *out = std::byte{1};
+        const auto x = value_at(type, storage, row);
+        if constexpr (std::is_same_v<Type, ip_type>) {
+          std::memcpy(out + 1, as_bytes(x).data(), 16);
+        } else if constexpr (std::is_same_v<Type, double_type>) {
+          const auto normalized = x == 0.0 ? 0.0 : x;
+          std::memcpy(out + 1, &normalized, sizeof(normalized));
+        } else if constexpr (std::is_same_v<Type, duration_type>) {
+          const auto count = x.count();
+          std::memcpy(out + 1, &count, sizeof(count));
+        } else if constexpr (std::is_same_v<Type, time_type>) {
+          const auto count = x.time_since_epoch().count();
+          std::memcpy(out + 1, &count, sizeof(count));
+        } else {
+          std::memcpy(out + 1, &x, sizeof(x));
+        }
+      }
+      // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    } else {
+      die(fmt::format("type {} has no fixed-width group-by key encoding",
+                      type));
+    }
+  };
+  caf::visit(f, type);
+}
+
+/// A hash table that maps encoded group-by keys to dense group ids. The table
+/// uses open addressing with linear probing over a flat array of slots, and
+/// stores the keys back-to-back in a single buffer.
+class group_table {
+public:
+  /// Looks up the group id for a key.
+  /// @param key The encoded group-by key.
+  /// @param hash The hash of *key*.
+  /// @returns The group id, or `std::nullopt` if the key does not exist.
+  std::optional<uint32_t>
+  find(std::span<const std::byte> key, uint64_t hash) const noexcept {
+    if (slots_.empty())
+      return std::nullopt;
+    const auto mask = slots_.size() - 1;
+    for (auto index = hash & mask;; index = (index + 1) & mask) {
+      const auto& slot = slots_[index];
+      if (slot.group == empty)
+        return std::nullopt;
+      if (slot.hash == hash && std::ranges::equal(key_of(slot.group), key))
+        return slot.group;
+    }
+  }
+
+  /// Inserts a key and assigns it the next group id.
+  /// @param key The encoded group-by key.
+  /// @param hash The hash of *key*.
+  /// @returns The group id of the inserted key.
+  /// @pre `!find(key, hash)`
+  uint32_t insert(std::span<const std::byte> key, uint64_t hash) {
+    VAST_ASSERT(!find(key, hash));
+    // Keep the load factor below 1/2, which keeps the probe sequences short.
+    if ((size() + 1) * 2 > slots_.size())
+      grow();
+    const auto group = detail::narrow_cast<uint32_t>(size());
+    keys_.insert(keys_.end(), key.begin(), key.end());
+    key_offsets_.push_back(keys_.size());
+    place(group, hash);
+    return group;
+  }
+
+  /// @returns The number of keys in the table.
+  size_t size() const noexcept {
+    return key_offsets_.size() - 1;
   }
-};
 
-/// The hash functor for enabling use of *group_by_key* as a key in unordered
-/// map data structures with transparent lookup.
-struct group_by_key_hash {
-  size_t operator()(const group_by_key& x) const noexcept {
-    auto hasher = xxh64{};
-    for (const auto& value : x)
-      hash_append(hasher, make_view(value));
-    return hasher.finish();
+private:
+  struct slot {
+    uint64_t hash = {};
+    uint32_t group = empty;
+  };
+
+  static constexpr auto empty = std::numeric_limits<uint32_t>::max();
+
+  std::span<const std::byte> key_of(uint32_t group) const noexcept {
+    return std::span{keys_}.subspan(key_offsets_[group],
+                                    key_offsets_[group + 1]
+                                      - key_offsets_[group]);
+  }
+
+  void place(uint32_t group, uint64_t hash) noexcept {
+    const auto mask = slots_.size() - 1;
+    auto index = hash & mask;
+    while (slots_[index].group != empty)
+      index = (index + 1) & mask;
+    slots_[index] = {hash, group};
   }
 
-  size_t operator()(const group_by_key_view& x) const noexcept {
-    auto hasher = xxh64{};
-    for (const auto& value : x)
-      hash_append(hasher, value);
-    return hasher.finish();
+  void grow() {
+    auto old_slots = std::exchange(
+      slots_, std::vector<slot>(std::max(size_t{64}, slots_.size() * 2)));
+    for (const auto& slot : old_slots)
+      if (slot.group != empty)
+        place(slot.group, slot.hash);
   }
+
+  /// The slots of the table. The size is always a power of two.
+  std::vector<slot> slots_ = {};
+
+  /// The keys of all groups, stored back-to-back in order of their group ids.
+  std::vector<std::byte> keys_ = {};
+
+  /// The offsets of the keys in `keys_`, with an additional entry at the end.
+  std::vector<size_t> key_offsets_ = {0};
 };
 
-/// The equality functor for enabling use of *group_by_key* as a key in
-/// unordered map data structures with transparent lookup.
-struct group_by_key_equal {
-  using is_transparent = void;
+/// A temporary file containing serialized table slices, which is removed when
+/// the object is destroyed.
+class spill_file {
+public:
+  spill_file()
+    : path_{std::filesystem::temp_directory_path()
+            / fmt::format("vast-summarize-{}", uuid::random())} {
+  }
 
-  bool
-  operator()(const group_by_key_view& x, const group_by_key& y) const noexcept {
-    return std::equal(x.begin(), x.end(), y.begin(), y.end(),
-                      [](const auto& lhs, const auto& rhs) {
-                        return lhs == make_view(rhs);
-                      });
+  spill_file(const spill_file&) = delete;
+  spill_file& operator=(const spill_file&) = delete;
+
+  spill_file(spill_file&& other) noexcept
+    : path_{std::exchange(other.path_, {})},
+      extents_{std::exchange(other.extents_, {})} {
   }
 
-  bool
-  operator()(const group_by_key& x, const group_by_key_view& y) const noexcept {
-    return std::equal(x.begin(), x.end(), y.begin(), y.end(),
-                      [](const auto& lhs, const auto& rhs) {
-                        return make_view(lhs) == rhs;
-                      });
+  spill_file& operator=(spill_file&& other) noexcept {
+    if (this != &other) {
+      remove();
+      path_ = std::exchange(other.path_, {});
+      extents_ = std::exchange(other.extents_, {});
+    }
+    return *this;
   }
 
-  bool operator()(const group_by_key& x, const group_by_key& y) const noexcept {
-    return x == y;
+  ~spill_file() noexcept {
+    remove();
   }
 
-  bool operator()(const group_by_key_view& x,
-                  const group_by_key_view& y) const noexcept {
-    return x == y;
+  /// Appends a table slice to the file.
+  caf::error append(const table_slice& slice) {
+    auto serialized = table_slice{to_record_batch(slice), slice.schema(),
+                                  table_slice::serialize::yes};
+    const auto bytes = as_bytes(serialized);
+    auto stream = std::ofstream{path_, std::ios::binary | std::ios::app};
+    stream.write(reinterpret_cast<const char*>(bytes.data()),
+                 detail::narrow_cast<std::streamsize>(bytes.size()));
+    stream.close();
+    if (!stream)
+      return caf::make_error(ec::filesystem_error,
+                             fmt::format("failed to spill aggregation "
+                                         "states to {}",
+                                         path_));
+    const auto offset
+      = extents_.empty() ? size_t{0}
+                         : extents_.back().first + extents_.back().second;
+    extents_.emplace_back(offset, bytes.size());
+    return {};
   }
+
+  /// Reads all table slices from the file.
+  caf::expected<std::vector<table_slice>> read() const {
+    auto result = std::vector<table_slice>{};
+    if (extents_.empty())
+      return result;
+    auto chunk = chunk::mmap(path_);
+    if (!chunk)
+      return caf::make_error(ec::filesystem_error,
+                             fmt::format("failed to read spilled "
+                                         "aggregation states from {}: {}",
+                                         path_, chunk.error()));
+    result.reserve(extents_.size());
+    for (const auto& [offset, size] : extents_)
+      result.emplace_back((*chunk)->slice(offset, size),
+                          table_slice::verify::no);
+    return result;
+  }
+
+private:
+  void remove() noexcept {
+    if (extents_.empty())
+      return;
+    auto err = std::error_code{};
+    std::filesystem::remove(path_, err);
+  }
+
+  std::filesystem::path path_ = {};
+  std::vector<std::pair<size_t, size_t>> extents_ = {};
 };
 
 /// A configured aggregation that is bound to a single schema.
+///
+/// The aggregation is a hash aggregation: for every batch, it encodes the
+/// group-by keys of all rows, hashes them in bulk, and maps them to dense
+/// group ids. It then reorders the aggregated columns by group so that every
+/// aggregation function is fed a contiguous array per group and batch rather
+/// than individual values.
+///
+/// The aggregation runs in two phases if the number of groups exceeds the
+/// configured maximum: the partial aggregation state of all groups held in
+/// memory is partitioned by the hash of the groups and spilled to disk, and
+/// the aggregation starts over with no groups. After the input ends, the
+/// partial states of every partition are merged separately, which yields the
+/// final result for all groups of that partition. Aggregations with functions
+/// that do not support partial aggregation never spill.
 class aggregation {
 public:
   /// The buckets to aggregate into. Essentially, this is an ordered list of
@@ -441,10 +729,23 @@ public:
   /// matching group-by keys.
   using bucket = std::vector<std::unique_ptr<aggregation_function>>;
 
+  /// The number of partitions to spill partial aggregation states into.
+  static constexpr auto num_spill_partitions = size_t{16};
+
+  /// The maximum nesting depth for re-spilling partitions. Beyond this depth
+  /// the aggregation keeps all groups in memory.
+  static constexpr auto max_spill_depth = size_t{4};
+
   /// Create an aggregation by binding the summarize pipeline operator
   /// configuration to a given schema.
+  /// @param schema The schema of the events to aggregate.
+  /// @param config The configuration of the summarize pipeline operator.
+  /// @param depth The number of times the input was spilled before.
+  /// @param merging Whether the input consists of partial aggregation states
+  /// of events of *schema* rather than the events themselves.
   [[nodiscard]] static caf::expected<aggregation>
-  make(const type& schema, const configuration& config) noexcept {
+  make(const type& schema, const configuration& config, size_t depth = 0,
+       bool merging = false) noexcept {
     auto group_by_columns = group_by_column::make(schema, config);
     if (!group_by_columns)
       return group_by_columns.error();
@@ -452,8 +753,17 @@ public:
     if (!aggregation_columns)
       return aggregation_columns.error();
     auto result = aggregation{};
+    result.schema = schema;
+    result.config = config;
+    result.depth = depth;
+    result.merging = merging;
     result.group_by_columns = std::move(*group_by_columns);
     result.aggregation_columns = std::move(*aggregation_columns);
+    result.spillable = std::all_of(result.aggregation_columns.begin(),
+                                   result.aggregation_columns.end(),
+                                   [](const aggregation_column& column) {
+                                     return column.mergeable;
+                                   });
     result.output_schema = [&]() noexcept -> type {
       auto fields = std::vector<record_type::field_view>{};
       fields.reserve(result.group_by_columns.size()
@@ -464,84 +774,315 @@ public:
         fields.emplace_back(column.output_name, column.output_type);
       return {schema.name(), record_type{fields}};
     }();
+    result.partial_schema = [&]() noexcept -> type {
+      auto fields = std::vector<record_type::field_view>{};
+      fields.reserve(result.group_by_columns.size()
+                     + result.aggregation_columns.size());
+      for (const auto& column : result.group_by_columns)
+        fields.emplace_back(column.name, column.type);
+      for (const auto& column : result.aggregation_columns)
+        fields.emplace_back(column.output_name, column.state_type);
+      return {schema.name(), record_type{fields}, {{partial_state_attribute}}};
+    }();
+    for (const auto& column : result.group_by_columns) {
+      const auto width = fixed_key_width(column.type);
+      if (width == 0) {
+        result.key_stride = 0;
+        break;
+      }
+      result.key_stride += 1 + width;
+    }
     return result;
   }
 
   /// Aggregate a batch.
   /// @param batch The record batch to aggregate. Must exactly match the
-  /// configured schema.
+  /// configured schema, or the partial schema when merging.
   void add(const std::shared_ptr<arrow::RecordBatch>& batch) {
     VAST_ASSERT(batch);
+    VAST_ASSERT(batch->num_rows() > 0);
+    if (error)
+      return;
+    // Spill before rather than while processing a batch, so the number of
+    // groups exceeds the maximum by at most the number of rows of a batch.
+    if (spillable && depth < max_spill_depth
+        && groups.size() >= config.max_groups) {
+      spill();
+      if (error)
+        return;
+    }
+    const auto num_rows = batch->num_rows();
     // Determine the inputs only once ahead of time.
     const auto group_by_arrays = make_group_by_arrays(*batch);
     const auto aggregation_arrays = make_aggregation_arrays(*batch);
-    // Helper lambda for updating a bucket.
-    const auto update_bucket = [&](bucket& bucket, int offset,
-                                   int length) noexcept {
-      VAST_ASSERT(length > 0);
-      if (length == 1) {
-        for (size_t column = 0; column < aggregation_columns.size(); ++column) {
-          for (const auto& array : aggregation_arrays[column])
-            bucket[column]->add(
-              value_at(aggregation_columns[column].input_type, *array, offset));
-        }
-      } else {
-        for (size_t column = 0; column < aggregation_columns.size(); ++column) {
-          for (const auto& array : aggregation_arrays[column])
-            bucket[column]->add(*array->Slice(offset, length));
-        }
+    encode_keys(group_by_arrays, num_rows);
+    // Map all rows to their groups, creating new groups lazily.
+    const auto seed = static_cast<xxh3_64::seed_type>(depth);
+    row_groups.resize(num_rows);
+    ++epoch;
+    batch_groups.clear();
+    for (int64_t row = 0; row < num_rows; ++row) {
+      const auto key = encoded_key(row);
+      const auto hash = xxh3_64::make(key, seed);
+      auto group = groups.find(key, hash);
+      if (!group) {
+        group = groups.insert(key, hash);
+        group_hashes.push_back(hash);
+        create_bucket(group_by_arrays, row);
       }
-    };
-    // A key view used to determine the bucket for the current row.
-    auto reusable_key_view = group_by_key_view{};
-    reusable_key_view.resize(group_by_columns.size(), {});
-    // Helper lambda for finding a bucket, or creating a new one lazily.
-    const auto find_or_create_bucket = [&](int row) -> bucket* {
+      if (group_epochs[*group] != epoch) {
+        group_epochs[*group] = epoch;
+        group_rows[*group] = 0;
+        batch_groups.push_back(*group);
+      }
+      ++group_rows[*group];
+      row_groups[row] = *group;
+    }
+    update_buckets(aggregation_arrays, num_rows);
+  }
+
+  /// Returns whether all aggregation functions support partial aggregation.
+  bool mergeable() const noexcept {
+    return spillable;
+  }
+
+  /// Returns the number of groups held in memory.
+  size_t num_groups() const noexcept {
+    return groups.size();
+  }
+
+  /// Returns the schema of the partial states.
+  const type& partial_states_schema() const noexcept {
+    return partial_schema;
+  }
+
+  /// Takes the partial states of all groups held in memory, and starts over
+  /// with no groups.
+  /// @pre `mergeable()`
+  [[nodiscard]] caf::expected<table_slice> take_partial_states() {
+    VAST_ASSERT(spillable);
+    if (error)
+      return error;
+    if (buckets.empty())
+      return table_slice{};
+    auto result = finish_buckets(true);
+    if (!result) {
+      error = result.error();
+      return result;
+    }
+    reset_groups();
+    return result;
+  }
+
+  /// Finish the buckets into new batches.
+  [[nodiscard]] generator<caf::expected<table_slice>> finish() {
+    // If we spilled before, all remaining groups must be spilled as well, as
+    // their partial states need to be merged with the spilled ones.
+    if (!error && !spill_partitions.empty())
+      spill();
+    if (error) {
+      co_yield std::move(error);
+      co_return;
+    }
+    if (spill_partitions.empty()) {
+      if (!buckets.empty())
+        co_yield finish_buckets(false);
+      co_return;
+    }
+    // Merge the spilled partitions one after the other. As every group was
+    // assigned to exactly one partition, the results are disjoint.
+    for (auto& partition : std::exchange(spill_partitions, {})) {
+      auto slices = partition.read();
+      if (!slices) {
+        co_yield std::move(slices.error());
+        co_return;
+      }
+      auto nested = make(schema, config, depth + 1, true);
+      if (!nested) {
+        co_yield std::move(nested.error());
+        co_return;
+      }
+      for (const auto& slice : *slices)
+        nested->add(to_record_batch(slice));
+      for (auto&& result : nested->finish())
+        co_yield std::move(result);
+    }
+  }
+
+private:
+  /// Encodes the group-by keys of all rows of a batch into `key_buffer`.
+  void encode_keys(const arrow::ArrayVector& group_by_arrays,
+                   int64_t num_rows) {
+    const auto rows = detail::narrow_cast<size_t>(num_rows);
+    if (key_stride > 0) {
+      // All group-by columns have a fixed-width encoding, so we can encode
+      // the keys one column at a time.
+      key_buffer.assign(rows * key_stride, std::byte{0});
+      auto column_offset = size_t{0};
+      for (size_t column = 0; column < group_by_columns.size(); ++column) {
+        encode_fixed_width_column(group_by_columns[column].type,
+                                  *group_by_arrays[column],
+                                  key_buffer.data() + column_offset,
+                                  key_stride);
+        column_offset += 1 + fixed_key_width(group_by_columns[column].type);
+      }
+      return;
+    }
+    key_buffer.clear();
+    key_offsets.clear();
+    key_offsets.reserve(rows + 1);
+    key_offsets.push_back(0);
+    for (int64_t row = 0; row < num_rows; ++row) {
       for (size_t column = 0; column < group_by_columns.size(); ++column)
-        reusable_key_view[column] = value_at(group_by_columns[column].type,
-                                             *group_by_arrays[column], row);
-      if (auto bucket = buckets.find(reusable_key_view);
-          bucket != buckets.end())
-        return bucket.value().get();
-      auto new_bucket = std::make_shared<bucket>();
-      new_bucket->reserve(aggregation_columns.size());
-      for (const auto& column : aggregation_columns) {
-        auto function
-          = plugins::find<aggregation_function_plugin>(column.function_name)
-              ->make_aggregation_function(column.input_type);
-        // We check whether it's possible to create the aggregation function for
-        // the column's input type ahead of time, so there's no need to check
-        // again here.
-        VAST_ASSERT(function);
-        new_bucket->push_back(std::move(*function));
+        encode_group_by_value(value_at(group_by_columns[column].type,
+                                       *group_by_arrays[column], row),
+                              key_buffer);
+      key_offsets.push_back(key_buffer.size());
+    }
+  }
+
+  /// Returns the encoded group-by key of a row of the current batch.
+  std::span<const std::byte> encoded_key(int64_t row) const noexcept {
+    const auto index = detail::narrow_cast<size_t>(row);
+    if (key_stride > 0)
+      return std::span{key_buffer}.subspan(index * key_stride, key_stride);
+    return std::span{key_buffer}.subspan(key_offsets[index],
+                                         key_offsets[index + 1]
+                                           - key_offsets[index]);
+  }
+
+  /// Creates the bucket for a new group.
+  void create_bucket(const arrow::ArrayVector& group_by_arrays, int64_t row) {
+    auto& key = keys.emplace_back();
+    key.reserve(group_by_columns.size());
+    for (size_t column = 0; column < group_by_columns.size(); ++column)
+      key.push_back(materialize(value_at(group_by_columns[column].type,
+                                         *group_by_arrays[column], row)));
+    auto& new_bucket = buckets.emplace_back();
+    new_bucket.reserve(aggregation_columns.size());
+    for (const auto& column : aggregation_columns) {
+      auto function
+        = plugins::find<aggregation_function_plugin>(column.function_name)
+            ->make_aggregation_function(column.input_type);
+      // We check whether it's possible to create the aggregation function for
+      // the column's input type ahead of time, so there's no need to check
+      // again here.
+      VAST_ASSERT(function);
+      new_bucket.push_back(std::move(*function));
+    }
+    group_epochs.push_back(0);
+    group_rows.push_back(0);
+    group_positions.push_back(0);
+  }
+
+  /// Feeds the aggregated columns of the current batch into the buckets.
+  void update_buckets(const std::vector<arrow::ArrayVector>& aggregation_arrays,
+                      int64_t num_rows) {
+    if (batch_groups.empty() || aggregation_columns.empty())
+      return;
+    // Compute a stable order of the rows by group using a counting sort. If
+    // the rows already are in that order, we can avoid reordering the arrays.
+    auto offset = int64_t{0};
+    for (auto group : batch_groups) {
+      group_positions[group] = offset;
+      offset += group_rows[group];
+    }
+    auto order = std::vector<int64_t>(detail::narrow_cast<size_t>(offset));
+    auto is_sorted = true;
+    for (int64_t row = 0; row < num_rows; ++row) {
+      auto& position = group_positions[row_groups[row]];
+      is_sorted = is_sorted && position == row;
+      order[position++] = row;
+    }
+    auto indices = std::shared_ptr<arrow::Array>{};
+    if (!is_sorted)
+      indices = std::make_shared<arrow::Int64Array>(
+        detail::narrow_cast<int64_t>(order.size()),
+        arrow::Buffer::Wrap(order));
+    for (size_t column = 0; column < aggregation_columns.size(); ++column) {
+      for (const auto& array : aggregation_arrays[column]) {
+        const auto input
+          = indices ? arrow::compute::Take(*array, *indices).ValueOrDie()
+                    : array;
+        auto first = int64_t{0};
+        for (auto group : batch_groups) {
+          const auto length = group_rows[group];
+          auto& function = *buckets[group][column];
+          if (merging) {
+            for (auto row = first; row < first + length; ++row) {
+              if (auto err = function.merge(value_at(
+                    aggregation_columns[column].state_type, *input, row))) {
+                error = std::move(err);
+                return;
+              }
+            }
+          } else if (length == 1)
+            function.add(
+              value_at(aggregation_columns[column].input_type, *input, first));
+          else
+            function.add(*input->Slice(first, length));
+          first += length;
+        }
       }
-      auto [it, inserted] = buckets.emplace(materialize(reusable_key_view),
-                                            std::move(new_bucket));
-      VAST_ASSERT(inserted);
-      return it.value().get();
-    };
-    // Iterate over all rows of the batch, and determine a sliding window of
-    // rows beloging to the same batch as large as possible, and then update the
-    // corresponding bucket.
-    auto first_row = 0;
-    auto* first_bucket = find_or_create_bucket(first_row);
-    VAST_ASSERT(batch->num_rows() > 0);
-    for (auto row = 1; row < batch->num_rows(); ++row) {
-      auto* bucket = find_or_create_bucket(row);
-      if (bucket == first_bucket)
+    }
+  }
+
+  /// Spills the partial states of all groups held in memory, partitioned by
+  /// the hashes of the groups, and resets the hash table.
+  void spill() {
+    if (buckets.empty())
+      return;
+    auto partial = finish_buckets(true);
+    if (!partial) {
+      error = std::move(partial.error());
+      return;
+    }
+    // Use the upper bits of the hash for partitioning, as the lower bits
+    // determine the slot in the hash table.
+    auto partitioned_groups = std::vector<std::vector<int64_t>>{};
+    partitioned_groups.resize(num_spill_partitions);
+    for (size_t group = 0; group < group_hashes.size(); ++group)
+      partitioned_groups[(group_hashes[group] >> 32) % num_spill_partitions]
+        .push_back(detail::narrow_cast<int64_t>(group));
+    reset_groups();
+    if (spill_partitions.empty())
+      spill_partitions.resize(num_spill_partitions);
+    const auto batch = to_record_batch(*partial);
+    for (size_t partition = 0; partition < num_spill_partitions; ++partition) {
+      const auto& rows = partitioned_groups[partition];
+      if (rows.empty())
         continue;
-      update_bucket(*first_bucket, first_row, row - first_row);
-      first_row = row;
-      first_bucket = bucket;
+      const auto indices = std::shared_ptr<arrow::Array>{
+        std::make_shared<arrow::Int64Array>(
+          detail::narrow_cast<int64_t>(rows.size()),
+          arrow::Buffer::Wrap(rows))};
+      const auto taken = arrow::compute::Take(batch, indices)
+                           .ValueOrDie()
+                           .record_batch();
+      if (auto err = spill_partitions[partition].append(
+            table_slice{taken, partial_schema})) {
+        error = std::move(err);
+        return;
+      }
     }
-    update_bucket(*first_bucket, first_row,
-                  detail::narrow_cast<int>(batch->num_rows()) - first_row);
+  }
+
+  /// Resets the hash table after its buckets were finished.
+  void reset_groups() noexcept {
+    groups = {};
+    group_hashes.clear();
+    group_epochs.clear();
+    group_rows.clear();
+    group_positions.clear();
   }
 
   /// Finish the buckets into a new batch.
-  [[nodiscard]] caf::expected<table_slice> finish() {
-    VAST_ASSERT(output_schema);
-    auto builder = caf::get<record_type>(output_schema)
+  /// @param partial Whether to save the partial states of the aggregation
+  /// functions rather than finishing them.
+  [[nodiscard]] caf::expected<table_slice> finish_buckets(bool partial) {
+    const auto& result_schema = partial ? partial_schema : output_schema;
+    VAST_ASSERT(result_schema);
+    auto builder = caf::get<record_type>(result_schema)
                      .make_arrow_builder(arrow::default_memory_pool());
     VAST_ASSERT(builder);
     const auto num_rows = detail::narrow_cast<int>(buckets.size());
@@ -550,7 +1091,11 @@ public:
       return caf::make_error(ec::system_error,
                              fmt::format("failed to reserve: {}",
                                          reserve_status.ToString()));
-    for (auto [key, bucket] : std::exchange(buckets, {})) {
+    auto finished_keys = std::exchange(keys, {});
+    auto finished_buckets = std::exchange(buckets, {});
+    for (size_t group = 0; group < finished_buckets.size(); ++group) {
+      const auto& key = finished_keys[group];
+      auto& bucket = finished_buckets[group];
       const auto append_row_status = builder->Append();
       if (!append_row_status.ok())
         return caf::make_error(ec::system_error,
@@ -567,12 +1112,14 @@ public:
                                              key[column],
                                              append_status.ToString()));
       }
-      for (size_t column = 0; column < bucket->size(); ++column) {
-        auto value = std::move(*(*bucket)[column]).finish();
+      for (size_t column = 0; column < bucket.size(); ++column) {
+        auto value = partial ? bucket[column]->save()
+                             : std::move(*bucket[column]).finish();
         if (!value)
           return value.error();
         const auto append_status
-          = append_builder(aggregation_columns[column].output_type,
+          = append_builder(partial ? aggregation_columns[column].state_type
+                                   : aggregation_columns[column].output_type,
                            *builder->field_builder(
                              detail::narrow_cast<int>(key.size() + column)),
                            make_data_view(*value));
@@ -588,19 +1135,24 @@ public:
                              fmt::format("failed to finish: {}",
                                          array.status().ToString()));
     auto batch = arrow::RecordBatch::Make(
-      output_schema.to_arrow_schema(), num_rows,
+      result_schema.to_arrow_schema(), num_rows,
       caf::get<type_to_arrow_array_t<record_type>>(*array.MoveValueUnsafe())
         .fields());
-    return table_slice{batch, output_schema};
+    return table_slice{batch, result_schema};
   }
 
-private:
   /// Read the input arrays for the configured group-by columns.
   /// @param batch The record batch to extract from.
   arrow::ArrayVector
   make_group_by_arrays(const arrow::RecordBatch& batch) noexcept {
     auto result = arrow::ArrayVector{};
     result.reserve(group_by_columns.size());
+    if (merging) {
+      // Partial states start with the already resolved group-by columns.
+      for (size_t column = 0; column < group_by_columns.size(); ++column)
+        result.push_back(batch.column(detail::narrow_cast<int>(column)));
+      return result;
+    }
     for (const auto& group_by_column : group_by_columns) {
       auto array = static_cast<arrow::FieldPath>(group_by_column.input)
                      .Get(batch)
@@ -623,6 +1175,14 @@ private:
   make_aggregation_arrays(const arrow::RecordBatch& batch) noexcept {
     auto result = std::vector<arrow::ArrayVector>{};
     result.reserve(aggregation_columns.size());
+    if (merging) {
+      // Partial states contain a single state column per aggregation column
+      // after the group-by columns.
+      for (size_t column = 0; column < aggregation_columns.size(); ++column)
+        result.push_back({batch.column(
+          detail::narrow_cast<int>(group_by_columns.size() + column))});
+      return result;
+    }
     for (const auto& column : aggregation_columns) {
       auto sub_result = arrow::ArrayVector{};
       sub_result.reserve(column.inputs.size());
@@ -634,6 +1194,20 @@ private:
     return result;
   };
 
+  /// The schema and configuration the aggregation was created from.
+  type schema = {};
+  configuration config = {};
+
+  /// The number of times the input of this aggregation was spilled before.
+  size_t depth = {};
+
+  /// Whether the input consists of partial states rather than events.
+  bool merging = {};
+
+  /// Whether all aggregation functions support partial aggregation. If not,
+  /// the aggregation keeps all groups in memory.
+  bool spillable = {};
+
   /// The configured and bound group-by columns.
   std::vector<group_by_column> group_by_columns = {};
 
@@ -643,12 +1217,87 @@ private:
   /// The output schema.
   type output_schema = {};
 
-  /// The buckets for the ongoing aggregation.
-  tsl::robin_map<group_by_key, std::shared_ptr<bucket>, group_by_key_hash,
-                 group_by_key_equal>
-    buckets = {};
+  /// The schema of the partial states, which has the same group-by columns
+  /// as the output schema and a column of the state type of every aggregation
+  /// function.
+  type partial_schema = {};
+
+  /// The size of an encoded group-by key if all group-by columns have a
+  /// fixed-width encoding, and zero otherwise.
+  size_t key_stride = {};
+
+  /// The encoded group-by keys of the current batch, and their offsets in
+  /// case the keys are not of a fixed width.
+  std::vector<std::byte> key_buffer = {};
+  std::vector<size_t> key_offsets = {};
+
+  /// The group of every row of the current batch.
+  std::vector<uint32_t> row_groups = {};
+
+  /// The groups in the current batch, in order of their first occurrence.
+  std::vector<uint32_t> batch_groups = {};
+
+  /// A counter incremented for every batch, and for every group the counter
+  /// of the last batch that contained the group. This allows for determining
+  /// the groups of a batch without clearing a per-group data structure.
+  uint64_t epoch = {};
+  std::vector<uint64_t> group_epochs = {};
+
+  /// For every group, the number of rows in the current batch, and the
+  /// position of the next row when ordering the rows of the batch by group.
+  std::vector<int64_t> group_rows = {};
+  std::vector<int64_t> group_positions = {};
+
+  /// Maps the encoded group-by keys to their group ids, and the hash of the
+  /// encoded group-by key of every group.
+  group_table groups = {};
+  std::vector<uint64_t> group_hashes = {};
+
+  /// For every group, the materialized group-by key and the bucket.
+  std::vector<group_by_key> keys = {};
+  std::vector<bucket> buckets = {};
+
+  /// The partitions of the spilled partial states.
+  std::vector<spill_file> spill_partitions = {};
+
+  /// The first error that occurred while spilling, merging, or taking the
+  /// partial states.
+  caf::error error = {};
 };
 
+/// The phases of a summarize operator that was split into a partial phase
+/// and a final phase.
+enum class aggregation_phase {
+  complete, ///< Aggregate events into results.
+  partial,  ///< Aggregate events into partial aggregation states.
+  final,    ///< Merge partial aggregation states and events into results.
+};
+
+/// Maps the schemas of partial aggregation states to the schemas of the events
+/// they were aggregated from. The partial and final phase of a summarize
+/// operator share this, so that the final phase can bind the configuration to
+/// the schema of the events when merging partial states.
+class partial_schemas {
+public:
+  /// Registers the schema of partial states.
+  void add(const type& partial_schema, const type& schema) {
+    auto lock = std::lock_guard{mutex_};
+    schemas_.try_emplace(partial_schema, schema);
+  }
+
+  /// Looks up the schema of the events for the schema of partial states.
+  std::optional<type> find(const type& partial_schema) const {
+    auto lock = std::lock_guard{mutex_};
+    const auto it = schemas_.find(partial_schema);
+    if (it == schemas_.end())
+      return std::nullopt;
+    return it->second;
+  }
+
+private:
+  mutable std::mutex mutex_ = {};
+  std::unordered_map<type, type> schemas_ = {};
+};
 
 /// The summarize pipeline operator implementation.
 class summarize_operator final
@@ -661,8 +1310,34 @@ public:
     // nop
   }
 
+  /// Creates a phase of a split pipeline operator.
+  /// @param config The parsed configuration of the summarize operator.
+  /// @param phase The phase of the operator.
+  /// @param schemas The registry shared by both phases.
+  summarize_operator(configuration config, aggregation_phase phase,
+                     std::shared_ptr<partial_schemas> schemas) noexcept
+    : config_{std::move(config)}, phase_{phase}, schemas_{std::move(schemas)} {
+    VAST_ASSERT(schemas_);
+  }
+
   auto initialize(const type& schema, operator_control_plane&) const
     -> caf::expected<state_type> override {
+    if (phase_ == aggregation_phase::final
+        && schema.attribute(partial_state_attribute)) {
+      // The partial phase registered the schema of the events before passing
+      // on any partial states.
+      auto events_schema = schemas_->find(schema);
+      if (!events_schema)
+        return caf::make_error(ec::logic_error,
+                               fmt::format("summarize operator received "
+                                           "partial states of unknown "
+                                           "schema {}",
+                                           schema));
+      auto result = aggregation::make(*events_schema, config_, 0, true);
+      if (!result)
+        return std::move(result.error());
+      return std::move(*result);
+    }
     auto result = aggregation::make(schema, config_);
     if (!result) {
       VAST_WARN("summarize operator does not apply to schema {} and discards "
@@ -670,13 +1345,28 @@ public:
                 schema, result.error());
       return std::nullopt;
     }
-    return *result;
+    if (phase_ == aggregation_phase::partial && result->mergeable())
+      schemas_->add(result->partial_states_schema(), schema);
+    return std::move(*result);
   }
 
   auto process(table_slice slice, state_type& state) const
     -> output_type override {
-    if (state) {
-      state->add(to_record_batch(slice));
+    if (!state)
+      return {};
+    if (phase_ == aggregation_phase::partial && !state->mergeable()) {
+      // The final phase aggregates these events itself.
+      return slice;
+    }
+    state->add(to_record_batch(slice));
+    // Rather than spilling, the partial phase passes its groups on to the
+    // final phase when it holds too many. Errors stick to the aggregation,
+    // which reports them when finishing.
+    if (phase_ == aggregation_phase::partial
+        && state->num_groups() >= config_.max_groups) {
+      auto partial_states = state->take_partial_states();
+      if (partial_states)
+        return std::move(*partial_states);
     }
     return {};
   }
@@ -685,12 +1375,24 @@ public:
               operator_control_plane& ctrl) const
     -> generator<output_type> override {
     for (auto& [_, state] : states) {
+      if (state && phase_ == aggregation_phase::partial) {
+        if (!state->mergeable())
+          continue;
+        auto partial_states = state->take_partial_states();
+        if (!partial_states) {
+          ctrl.abort(partial_states.error());
+          co_return;
+        }
+        co_yield std::move(*partial_states);
+        continue;
+      }
       if (state) {
-        if (auto batch = state->finish()) {
+        for (auto&& batch : state->finish()) {
+          if (!batch) {
+            ctrl.abort(batch.error());
+            co_return;
+          }
           co_yield std::move(*batch);
-        } else {
-          ctrl.abort(batch.error());
-          break;
         }
       }
     }
@@ -722,18 +1424,41 @@ public:
     return result;
   }
 
+  auto split_partial() const
+    -> std::optional<std::pair<operator_ptr, operator_ptr>> override {
+    if (phase_ != aggregation_phase::complete)
+      return std::nullopt;
+    auto schemas = std::make_shared<partial_schemas>();
+    return std::pair<operator_ptr, operator_ptr>{
+      std::make_unique<summarize_operator>(
+        config_, aggregation_phase::partial, schemas),
+      std::make_unique<summarize_operator>(config_, aggregation_phase::final,
+                                           schemas),
+    };
+  }
+
 private:
   /// The underlying configuration of the summary transformation.
   configuration config_ = {};
+
+  /// The phase of the operator.
+  aggregation_phase phase_ = aggregation_phase::complete;
+
+  /// The registry of partial state schemas shared by the phases of a split
+  /// operator.
+  std::shared_ptr<partial_schemas> schemas_ = {};
 };
 
 /// The summarize pipeline operator plugin.
 class plugin final : public virtual operator_plugin {
 public:
-  caf::error initialize([[maybe_unused]] const record& plugin_config,
+  caf::error initialize(const record& plugin_config,
                         [[maybe_unused]] const record& global_config) override {
-    // Native plugins never have any plugin-specific configuration, so there's
-    // nothing to do here.
+    auto max_groups = try_get_or(plugin_config, "max-groups-in-memory",
+                                 uint64_t{default_max_groups});
+    if (!max_groups)
+      return std::move(max_groups.error());
+    max_groups_ = detail::narrow_cast<size_t>(*max_groups);
     return {};
   }
 
@@ -788,12 +1513,16 @@ public:
     }
     config.group_by_extractors = std::move(std::get<1>(parsed_aggregations));
     config.time_resolution = std::move(std::get<2>(parsed_aggregations));
+    config.max_groups = max_groups_;
 
     return {
       std::string_view{f, l},
       std::make_unique<summarize_operator>(std::move(config)),
     };
   }
+
+private:
+  size_t max_groups_ = default_max_groups;
 };
 
 } // namespace
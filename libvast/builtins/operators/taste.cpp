@@ -38,6 +38,10 @@ public:
     return result;
   }
 
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::per_schema;
+  }
+
   auto to_string() const -> std::string override {
     return fmt::format("taste {}", limit_);
   }
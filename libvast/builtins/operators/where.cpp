@@ -14,6 +14,7 @@
 #include <vast/concept/parseable/vast/pipeline.hpp>
 #include <vast/error.hpp>
 #include <vast/expression.hpp>
+#include <vast/fused_operator.hpp>
 #include <vast/logger.hpp>
 #include <vast/pipeline.hpp>
 #include <vast/plugin.hpp>
@@ -48,7 +49,8 @@ struct configuration {
 
 // Selects matching rows from the input.
 class where_operator final
-  : public schematic_operator<where_operator, std::optional<expression>> {
+  : public schematic_operator<where_operator, std::optional<expression>>,
+    public fusable_operator {
 public:
   /// Constructs a *where* pipeline operator.
   /// @pre *expr* must be normalized and validated
@@ -80,11 +82,28 @@ public:
     return {};
   }
 
+  auto fuse(const type& schema, operator_control_plane& ctrl) const
+    -> caf::expected<fused_step> override {
+    auto state = initialize(schema, ctrl);
+    if (!state)
+      return std::move(state.error());
+    return [expr = std::move(*state)](fused_batch& batch) {
+      if (expr)
+        batch.filter(*expr);
+      else
+        batch.discard();
+    };
+  }
+
   auto predicate_pushdown(expression const& expr) const
     -> std::optional<std::pair<expression, operator_ptr>> override {
     return std::pair{conjunction{expr_, expr}, nullptr};
   }
 
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::stateless;
+  }
+
   auto to_string() const -> std::string override {
     return fmt::format("where {}", expr_);
   };
@@ -7,25 +7,36 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #include <vast/arrow_table_slice.hpp>
+#include <vast/bitmap_algorithms.hpp>
 #include <vast/chunk.hpp>
 #include <vast/collect.hpp>
 #include <vast/concept/convertible/data.hpp>
 #include <vast/data.hpp>
+#include <vast/detail/base64.hpp>
 #include <vast/detail/narrow.hpp>
+#include <vast/detail/overload.hpp>
+#include <vast/detail/serialize.hpp>
 #include <vast/error.hpp>
+#include <vast/expression.hpp>
 #include <vast/fwd.hpp>
 #include <vast/generator.hpp>
+#include <vast/ids.hpp>
 #include <vast/plugin.hpp>
 #include <vast/store.hpp>
 #include <vast/table_slice.hpp>
 
 #include <arrow/io/file.h>
 #include <arrow/io/memory.h>
-#include <arrow/ipc/feather.h>
 #include <arrow/ipc/reader.h>
-#include <arrow/table.h>
-#include <arrow/util/iterator.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/record_batch.h>
+#include <arrow/util/compression.h>
 #include <arrow/util/key_value_metadata.h>
+#include <caf/binary_deserializer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
 
 namespace vast::plugins::feather {
 
@@ -96,9 +107,146 @@ auto wrap_record_batch(const table_slice& slice)
   return new_rb;
 }
 
-/// Decode an Arrow IPC stream incrementally.
-auto decode_ipc_stream(chunk_ptr chunk)
-  -> caf::expected<generator<std::shared_ptr<arrow::RecordBatch>>> {
+/// The key in the footer metadata of a Feather file that holds the statistics
+/// of all record batches.
+constexpr auto batch_statistics_key = std::string_view{"VAST:batches:v1"};
+
+/// Statistics of a single record batch in a Feather file. These are stored in
+/// the footer of the file, which allows for deciding which batches to read
+/// without decoding any of them.
+struct batch_statistics {
+  /// The number of rows in the batch.
+  uint64_t rows = {};
+
+  /// The import time of the batch.
+  time import_time = {};
+
+  /// The minimum and maximum values of every leaf column in the batch, or
+  /// null if the column has no ordered type or contains no values.
+  std::vector<data> min = {};
+  std::vector<data> max = {};
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, batch_statistics& x) {
+    return f.object(x)
+      .pretty_name("vast.plugins.feather.batch_statistics")
+      .fields(f.field("rows", x.rows), f.field("import-time", x.import_time),
+              f.field("min", x.min), f.field("max", x.max));
+  }
+};
+
+/// Computes the statistics for a table slice.
+auto make_batch_statistics(const table_slice& slice) -> batch_statistics {
+  auto result = batch_statistics{};
+  result.rows = slice.rows();
+  result.import_time = slice.import_time();
+  const auto& schema = caf::get<record_type>(slice.schema());
+  const auto batch = to_record_batch(slice);
+  result.min.reserve(schema.num_leaves());
+  result.max.reserve(schema.num_leaves());
+  for (const auto& [field, index] : schema.leaves()) {
+    const auto array
+      = static_cast<arrow::FieldPath>(index).Get(*batch).ValueOrDie();
+    auto f = [&]<concrete_type Type>(const Type& type) {
+      if constexpr (detail::is_any_v<Type, int64_type, uint64_type,
+                                     double_type, duration_type, time_type>) {
+        auto min = std::optional<type_to_data_t<Type>>{};
+        auto max = std::optional<type_to_data_t<Type>>{};
+        for (const auto& value :
+             values(type, caf::get<type_to_arrow_array_t<Type>>(*array))) {
+          if (!value)
+            continue;
+          // NaN compares false with everything, so it must neither become
+          // nor replace a bound. Predicates never match NaN, so the bounds of
+          // the other values are sufficient to prune with.
+          if constexpr (std::is_same_v<Type, double_type>)
+            if (std::isnan(*value))
+              continue;
+          if (!min || *value < *min)
+            min = *value;
+          if (!max || *value > *max)
+            max = *value;
+        }
+        result.min.emplace_back(min);
+        result.max.emplace_back(max);
+      } else {
+        result.min.emplace_back();
+        result.max.emplace_back();
+      }
+    };
+    caf::visit(f, field.type);
+  }
+  return result;
+}
+
+/// Checks whether a batch may contain rows that match an expression, given its
+/// statistics. This is conservative, i.e., it only returns false if the batch
+/// definitely contains no matching rows.
+/// @param expr The expression tailored to the schema of the batch.
+/// @param statistics The statistics of the batch.
+auto may_match(const expression& expr, const batch_statistics& statistics)
+  -> bool {
+  const auto check_range = [](const data& min, const data& max,
+                              relational_operator op, const data& value) {
+    // We can only use the range if the value has the same type; all other
+    // comparisons are left to the actual evaluation.
+    if (caf::holds_alternative<caf::none_t>(min)
+        || value.get_data().index() != min.get_data().index())
+      return true;
+    switch (op) {
+      case relational_operator::equal:
+        return evaluate(min, relational_operator::less_equal, value)
+               && evaluate(max, relational_operator::greater_equal, value);
+      case relational_operator::less:
+        return evaluate(min, relational_operator::less, value);
+      case relational_operator::less_equal:
+        return evaluate(min, relational_operator::less_equal, value);
+      case relational_operator::greater:
+        return evaluate(max, relational_operator::greater, value);
+      case relational_operator::greater_equal:
+        return evaluate(max, relational_operator::greater_equal, value);
+      default:
+        return true;
+    }
+  };
+  auto f = detail::overload{
+    [&](const conjunction& xs) -> bool {
+      return std::all_of(xs.begin(), xs.end(), [&](const expression& x) {
+        return may_match(x, statistics);
+      });
+    },
+    [&](const disjunction& xs) -> bool {
+      return std::any_of(xs.begin(), xs.end(), [&](const expression& x) {
+        return may_match(x, statistics);
+      });
+    },
+    [&](const predicate& pred) -> bool {
+      const auto* value = caf::get_if<data>(&pred.rhs);
+      if (!value)
+        return true;
+      if (const auto* lhs = caf::get_if<data_extractor>(&pred.lhs)) {
+        if (lhs->column >= statistics.min.size())
+          return true;
+        return check_range(statistics.min[lhs->column],
+                           statistics.max[lhs->column], pred.op, *value);
+      }
+      if (const auto* lhs = caf::get_if<meta_extractor>(&pred.lhs);
+          lhs && lhs->kind == meta_extractor::import_time) {
+        const auto import_time = data{statistics.import_time};
+        return check_range(import_time, import_time, pred.op, *value);
+      }
+      return true;
+    },
+    [](const auto&) -> bool {
+      return true;
+    },
+  };
+  return caf::visit(f, expr);
+}
+
+/// Opens an Arrow IPC file for random access to its record batches.
+auto open_ipc_file(chunk_ptr chunk)
+  -> caf::expected<std::shared_ptr<arrow::ipc::RecordBatchFileReader>> {
   // See arrow::ipc::internal::kArrowMagicBytes in
   // arrow/ipc/metadata_internal.h.
   static constexpr auto arrow_magic_bytes = std::string_view{"ARROW1"};
@@ -114,65 +262,73 @@ auto decode_ipc_stream(chunk_ptr chunk)
     return caf::make_error(ec::format_error,
                            fmt::format("failed to open reader: {}",
                                        open_reader_result.status().ToString()));
-  auto reader = open_reader_result.MoveValueUnsafe();
-  auto get_generator_result = reader->GetRecordBatchGenerator();
-  if (!get_generator_result.ok())
-    return caf::make_error(
-      ec::format_error, fmt::format("failed to get batch generator: {}",
-                                    get_generator_result.status().ToString()));
-  auto gen = get_generator_result.MoveValueUnsafe();
-  return []([[maybe_unused]] auto reader,
-            auto gen) -> generator<std::shared_ptr<arrow::RecordBatch>> {
-    while (true) {
-      auto next = gen();
-      if (!next.is_finished())
-        next.Wait();
-      VAST_ASSERT(next.is_finished());
-      auto result = next.MoveResult().ValueOrDie();
-      if (arrow::IsIterationEnd(result))
-        co_return;
-      co_yield std::move(result);
-    }
-  }(std::move(reader), std::move(gen));
+  return open_reader_result.MoveValueUnsafe();
+}
+
+/// Reads the batch statistics from the footer of an Arrow IPC file.
+/// @returns The statistics, or an empty list if the file was written without
+/// them.
+auto read_batch_statistics(const arrow::ipc::RecordBatchFileReader& reader)
+  -> caf::expected<std::vector<batch_statistics>> {
+  auto result = std::vector<batch_statistics>{};
+  const auto metadata = reader.metadata();
+  if (!metadata)
+    return result;
+  const auto index = metadata->FindKey(std::string{batch_statistics_key});
+  if (index < 0)
+    return result;
+  const auto bytes = detail::base64::decode(metadata->value(index));
+  auto source = caf::binary_deserializer{nullptr, bytes.data(), bytes.size()};
+  if (!source.apply(result))
+    return caf::make_error(ec::format_error,
+                           fmt::format("failed to read batch statistics: {}",
+                                       source.get_error()));
+  if (result.size()
+      != detail::narrow_cast<size_t>(reader.num_record_batches()))
+    return caf::make_error(ec::format_error,
+                           fmt::format("found statistics for {} batches in a "
+                                       "file with {} batches",
+                                       result.size(),
+                                       reader.num_record_batches()));
+  return result;
 }
 
 class passive_feather_store final : public passive_store {
   [[nodiscard]] caf::error load(chunk_ptr chunk) override {
-    auto decode_result = decode_ipc_stream(std::move(chunk));
-    if (!decode_result)
+    auto reader = open_ipc_file(std::move(chunk));
+    if (!reader)
+      return caf::make_error(ec::format_error,
+                             fmt::format("failed to load feather store: {}",
+                                         reader.error()));
+    auto statistics = read_batch_statistics(**reader);
+    if (!statistics)
       return caf::make_error(ec::format_error,
                              fmt::format("failed to load feather store: {}",
-                                         decode_result.error()));
-    remaining_slices_generator_ = std::move(*decode_result);
-    remaining_slices_iterator_ = remaining_slices_generator_.begin();
+                                         statistics.error()));
+    reader_ = std::move(*reader);
+    statistics_ = std::move(*statistics);
+    cached_slices_.resize(reader_->num_record_batches());
+    // Files written with batch statistics allow us to know the offsets of all
+    // batches up front, which in turn allows for reading only the batches
+    // relevant to a query.
+    if (!statistics_.empty()) {
+      offsets_.reserve(statistics_.size());
+      auto offset = id{};
+      for (const auto& batch : statistics_) {
+        offsets_.push_back(offset);
+        offset += batch.rows;
+      }
+      cached_num_events_ = offset;
+    }
     return {};
   }
 
   [[nodiscard]] generator<table_slice> slices() const override {
     auto offset = id{};
-    auto i = size_t{};
-    while (true) {
-      if (i < cached_slices_.size()) {
-        VAST_ASSERT(offset == cached_slices_[i].offset());
-      } else if (remaining_slices_iterator_
-                 != remaining_slices_generator_.end()) {
-        auto batch = std::move(*remaining_slices_iterator_);
-        VAST_ASSERT(batch);
-        ++remaining_slices_iterator_;
-        auto import_time_column = batch->GetColumnByName("import_time");
-        auto slice = cached_slices_.empty()
-                       ? table_slice{unwrap_record_batch(batch)}
-                       : table_slice{unwrap_record_batch(batch),
-                                     cached_slices_[0].schema()};
-        slice.offset(offset);
-        slice.import_time(derive_import_time(import_time_column));
-        cached_slices_.push_back(std::move(slice));
-      } else {
-        co_return;
-      }
-      co_yield cached_slices_[i];
-      offset += cached_slices_[i].rows();
-      ++i;
+    for (size_t i = 0; i < cached_slices_.size(); ++i) {
+      const auto& slice = slice_at(i, offset);
+      co_yield slice;
+      offset += slice.rows();
     }
   }
 
@@ -183,19 +339,96 @@ class passive_feather_store final : public passive_store {
   }
 
   [[nodiscard]] type schema() const override {
-    for (const auto& slice : slices())
-      return slice.schema();
-    die("store must not be empty");
+    if (cached_schema_)
+      return cached_schema_;
+    // The schema of the events is stored as the type of the event column of
+    // the envelope, so we can get it without reading a single batch.
+    const auto event_field = reader_->schema()->GetFieldByName("event");
+    if (!event_field)
+      die("store must have an event column");
+    const auto event_schema = arrow::Schema{event_field->type()->fields(),
+                                            event_field->metadata()};
+    cached_schema_ = type::from_arrow(event_schema);
+    return cached_schema_;
+  }
+
+  [[nodiscard]] generator<uint64_t>
+  count(expression expr, ids selection) const override {
+    if (offsets_.empty())
+      return passive_store::count(std::move(expr), std::move(selection));
+    return count_candidates(std::move(expr), std::move(selection));
+  }
+
+  [[nodiscard]] generator<table_slice>
+  extract(expression expr, ids selection) const override {
+    if (offsets_.empty())
+      return passive_store::extract(std::move(expr), std::move(selection));
+    return extract_candidates(std::move(expr), std::move(selection));
   }
 
 private:
-  generator<std::shared_ptr<arrow::RecordBatch>> remaining_slices_generator_
-    = {};
-  mutable generator<std::shared_ptr<arrow::RecordBatch>>::iterator
-    remaining_slices_iterator_
-    = {};
+  /// Returns the slice for a batch, reading and decompressing it on first
+  /// access.
+  const table_slice& slice_at(size_t index, id offset) const {
+    auto& slice = cached_slices_[index];
+    if (!slice) {
+      auto batch = reader_->ReadRecordBatch(detail::narrow_cast<int>(index));
+      if (!batch.ok())
+        die(fmt::format("failed to read record batch {} of feather store: {}",
+                        index, batch.status().ToString()));
+      const auto import_time_column
+        = batch.ValueUnsafe()->GetColumnByName("import_time");
+      slice.emplace(unwrap_record_batch(batch.ValueUnsafe()), schema());
+      slice->offset(offset);
+      slice->import_time(derive_import_time(import_time_column));
+    }
+    VAST_ASSERT(slice->offset() == offset);
+    return *slice;
+  }
+
+  /// Returns the indices of all batches that may contain rows matching a
+  /// query, in order.
+  /// @pre `!offsets_.empty()`
+  std::vector<size_t>
+  candidates(const expression& expr, const ids& selection) const {
+    auto relevant = std::vector<bool>(offsets_.size(), selection.empty());
+    for (const auto& run : select_runs(selection)) {
+      // The offsets of the batches are sorted, so the first batch overlapping
+      // with the run is the last one that starts at or before its first id.
+      auto index = static_cast<size_t>(
+        std::upper_bound(offsets_.begin(), offsets_.end(), run.first)
+        - offsets_.begin());
+      for (index = index == 0 ? 0 : index - 1;
+           index < offsets_.size() && offsets_[index] < run.last; ++index)
+        relevant[index] = true;
+    }
+    auto result = std::vector<size_t>{};
+    for (size_t index = 0; index < relevant.size(); ++index)
+      if (relevant[index] && may_match(expr, statistics_[index]))
+        result.push_back(index);
+    return result;
+  }
+
+  generator<uint64_t> count_candidates(expression expr, ids selection) const {
+    for (const auto index : candidates(expr, selection))
+      co_yield count_matching(slice_at(index, offsets_[index]), expr,
+                              selection);
+  }
+
+  generator<table_slice>
+  extract_candidates(expression expr, ids selection) const {
+    for (const auto index : candidates(expr, selection))
+      if (auto filtered_slice
+          = filter(slice_at(index, offsets_[index]), expr, selection))
+        co_yield std::move(*filtered_slice);
+  }
+
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader_ = {};
+  std::vector<batch_statistics> statistics_ = {};
+  std::vector<id> offsets_ = {};
   mutable uint64_t cached_num_events_ = {};
-  mutable std::vector<table_slice> cached_slices_ = {};
+  mutable type cached_schema_ = {};
+  mutable std::vector<std::optional<table_slice>> cached_slices_ = {};
 };
 
 class active_feather_store final : public active_store {
@@ -222,23 +455,48 @@ public:
   }
 
   [[nodiscard]] caf::expected<chunk_ptr> finish() override {
+    if (slices_.empty())
+      return caf::make_error(ec::logic_error, "cannot write an empty feather "
+                                              "store");
+    // We write every table slice as a separate record batch, and store their
+    // statistics in the footer. This allows for reading and decompressing
+    // only the batches relevant to a query.
     auto record_batches = arrow::RecordBatchVector{};
+    auto statistics = std::vector<batch_statistics>{};
     record_batches.reserve(slices_.size());
-    for (const auto& slice : slices_)
+    statistics.reserve(slices_.size());
+    for (const auto& slice : slices_) {
       record_batches.push_back(wrap_record_batch(slice));
-    const auto table = ::arrow::Table::FromRecordBatches(record_batches);
-    if (!table.ok())
-      return caf::make_error(ec::system_error, table.status().ToString());
+      statistics.push_back(make_batch_statistics(slice));
+    }
+    auto serialized_statistics = caf::byte_buffer{};
+    if (!detail::serialize(serialized_statistics, statistics))
+      return caf::make_error(ec::serialization_error,
+                             "failed to serialize batch statistics");
+    const auto metadata = arrow::key_value_metadata(
+      {std::string{batch_statistics_key}},
+      {detail::base64::encode(std::string_view{
+        reinterpret_cast<const char*>(serialized_statistics.data()),
+        serialized_statistics.size()})});
+    auto codec = arrow::util::Codec::Create(
+      arrow::Compression::ZSTD,
+      detail::narrow<int>(feather_config_.zstd_compression_level));
+    if (!codec.ok())
+      return caf::make_error(ec::system_error, codec.status().ToString());
+    auto write_options = arrow::ipc::IpcWriteOptions::Defaults();
+    write_options.codec = codec.MoveValueUnsafe();
     auto output_stream = arrow::io::BufferOutputStream::Create().ValueOrDie();
-    auto write_properties = arrow::ipc::feather::WriteProperties::Defaults();
-    // TODO: Set write_properties.chunksize to the expected batch size
-    write_properties.compression = arrow::Compression::ZSTD;
-    write_properties.compression_level
-      = detail::narrow<int>(feather_config_.zstd_compression_level);
-    const auto write_status = ::arrow::ipc::feather::WriteTable(
-      *table.ValueUnsafe(), output_stream.get(), write_properties);
-    if (!write_status.ok())
-      return caf::make_error(ec::system_error, write_status.ToString());
+    auto writer
+      = arrow::ipc::MakeFileWriter(output_stream, record_batches[0]->schema(),
+                                   write_options, metadata);
+    if (!writer.ok())
+      return caf::make_error(ec::system_error, writer.status().ToString());
+    for (const auto& record_batch : record_batches)
+      if (auto status = writer.ValueUnsafe()->WriteRecordBatch(*record_batch);
+          !status.ok())
+        return caf::make_error(ec::system_error, status.ToString());
+    if (auto status = writer.ValueUnsafe()->Close(); !status.ok())
+      return caf::make_error(ec::system_error, status.ToString());
     auto buffer = output_stream->Finish();
     if (!buffer.ok())
       return caf::make_error(ec::system_error, buffer.status().ToString());
@@ -12,10 +12,21 @@
 #include "vast/detail/series_builders.hpp"
 #include "vast/table_slice.hpp"
 
+#include <string>
 #include <variant>
+#include <vector>
 
 namespace vast {
 
+/// Statistics about the shape cache of adaptive table slice builders.
+struct shape_cache_metrics {
+  /// The number of rows whose fields all came from the cache.
+  uint64_t hits = 0;
+
+  /// The number of rows that required looking up fields by name.
+  uint64_t misses = 0;
+};
+
 class adaptive_table_slice_builder {
 public:
   adaptive_table_slice_builder() = default;
@@ -40,6 +51,9 @@ public:
     detail::arrow_length_type starting_rows_count_ = 0;
   };
 
+  /// The number of row shapes that a builder remembers.
+  static constexpr size_t shape_cache_capacity = 4;
+
   /// @brief Inserts a row to the output table slice.
   /// @return An object used to manipulate fields of an inserted row. The
   /// returned object must be destroyed beforore calling this method again.
@@ -57,13 +71,81 @@ public:
   /// @return count of currently occupied rows.
   auto rows() const -> detail::arrow_length_type;
 
+  /// @brief Returns statistics about the shape cache of this builder.
+  auto shape_cache_metrics() const -> vast::shape_cache_metrics;
+
+  /// @brief Returns statistics about the shape caches of all builders in this
+  /// process, which they report whenever they finish a table slice.
+  static auto total_shape_cache_metrics() -> vast::shape_cache_metrics;
+
 private:
+  /// Remembers the sequences of top-level fields of recently added rows
+  /// together with their series builders. Rows of homogeneous input usually
+  /// have the same fields in the same order, so verifying that a field has
+  /// the name of the field at the same position of a cached shape is enough
+  /// to find its series builder.
+  ///
+  /// The cache holds series builders rather than the typed Arrow builders
+  /// underneath them. A series builder that saw only nulls so far replaces
+  /// its Arrow builder once it sees its first value, and an enumeration
+  /// builder accepts strings. Appending through the series builder keeps that
+  /// adaptivity, at the cost of one dispatch on the value type per field.
+  class shape_cache {
+  public:
+    /// Starts matching the fields of a new row.
+    auto begin_row() -> void;
+
+    /// Returns the series builder of the next field of the current row if a
+    /// cached shape knows it. Otherwise, the caller must look up the field and
+    /// pass the result to `record`.
+    auto next(std::string_view name) -> detail::series_builder*;
+
+    /// Records the series builder of the next field after a call to `next`
+    /// returned none.
+    /// @param builder The series builder, or `nullptr` if it does not exist
+    /// yet.
+    auto record(std::string_view name, detail::series_builder* builder)
+      -> void;
+
+    /// Ends the current row, and remembers its shape unless it is known.
+    auto end_row() -> void;
+
+    /// Returns the hits and misses so far.
+    auto metrics() const -> vast::shape_cache_metrics;
+
+    /// Returns the hits and misses since the last call.
+    auto take_metrics() -> vast::shape_cache_metrics;
+
+  private:
+    struct field {
+      std::string name;
+      detail::series_builder* builder = nullptr;
+    };
+
+    using shape = std::vector<field>;
+
+    static constexpr auto no_shape = static_cast<size_t>(-1);
+
+    /// The cached shapes, most recently used first.
+    std::vector<shape> shapes_ = {};
+    /// The shape that matches the current row so far.
+    size_t current_ = no_shape;
+    /// The number of fields of the current row so far.
+    size_t position_ = 0;
+    /// The fields of the current row after it diverged from all shapes.
+    shape pending_ = {};
+    bool diverged_ = false;
+    vast::shape_cache_metrics metrics_ = {};
+    vast::shape_cache_metrics reported_ = {};
+  };
+
   auto get_schema(std::string_view slice_schema_name) const -> type;
   auto finish_impl() -> std::shared_ptr<arrow::Array>;
 
   std::variant<detail::concrete_series_builder<record_type>,
                detail::fixed_fields_record_builder>
     root_builder_;
+  shape_cache shapes_ = {};
 };
 
 } // namespace vast
@@ -43,6 +43,26 @@ public:
   /// Finish the aggregation into a single materialized value.
   [[nodiscard]] virtual caf::expected<data> finish() && = 0;
 
+  /// Return the type of the intermediate state of the function.
+  /// @note The default implementation returns the output type.
+  [[nodiscard]] virtual type state_type() const;
+
+  /// Save the intermediate state of the function, such that another instance
+  /// of the function can pick up the aggregation via *merge*. This enables
+  /// computing partial aggregates independently and combining them later.
+  /// @returns A value that is either *null* or matches the state type.
+  /// @note The default implementation returns an error, indicating that the
+  /// function does not support partial aggregation.
+  [[nodiscard]] virtual caf::expected<data> save() const;
+
+  /// Merge an intermediate state of another instance of the function with the
+  /// same input type into this one.
+  /// @param state The state to merge, as returned by *save*.
+  /// @pre *state* is either *null* or matches the state type.
+  /// @note The default implementation returns an error, indicating that the
+  /// function does not support partial aggregation.
+  virtual caf::error merge(const data_view& state);
+
 protected:
   /// Constructs the aggregation function. Must be called from implementing base
   /// classes.
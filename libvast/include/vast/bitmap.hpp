@@ -14,6 +14,7 @@
 #include "vast/detail/type_traits.hpp"
 #include "vast/ewah_bitmap.hpp"
 #include "vast/null_bitmap.hpp"
+#include "vast/roaring_bitmap.hpp"
 #include "vast/wah_bitmap.hpp"
 
 #include <caf/detail/type_list.hpp>
@@ -30,7 +31,8 @@ class bitmap : public bitmap_base<bitmap>, detail::equality_comparable<bitmap> {
   friend bitmap_bit_range;
 
 public:
-  using types = caf::detail::type_list<ewah_bitmap, null_bitmap, wah_bitmap>;
+  using types = caf::detail::type_list<ewah_bitmap, null_bitmap, wah_bitmap,
+                                       roaring_bitmap>;
 
   using variant = caf::detail::tl_apply_t<types, caf::variant>;
 
@@ -75,6 +77,7 @@ public:
   variant& get_data();
   [[nodiscard]] const variant& get_data() const;
 
+  /// Compares two bitmaps by their bits, regardless of their encodings.
   friend bool operator==(const bitmap& x, const bitmap& y);
 
   template <class Inspector>
@@ -103,14 +106,26 @@ public:
   [[nodiscard]] bool done() const;
 
 private:
-  using range_variant
-    = caf::variant<ewah_bitmap_range, null_bitmap_range, wah_bitmap_range>;
+  using range_variant = caf::variant<ewah_bitmap_range, null_bitmap_range,
+                                     wah_bitmap_range, roaring_bitmap_range>;
 
   range_variant range_;
 };
 
 bitmap_bit_range bit_range(const bitmap& bm);
 
+/// Computes the bitwise AND of two type-erased bitmaps. If either operand is a
+/// Roaring bitmap, the result is a Roaring bitmap and the operation works
+/// container by container.
+/// @relates bitmap
+bitmap binary_and(const bitmap& lhs, const bitmap& rhs);
+
+/// Computes the bitwise OR of two type-erased bitmaps. If either operand is a
+/// Roaring bitmap, the result is a Roaring bitmap and the operation works
+/// container by container.
+/// @relates bitmap
+bitmap binary_or(const bitmap& lhs, const bitmap& rhs);
+
 } // namespace vast
 
 namespace caf {
@@ -26,6 +26,9 @@ public:
   [[nodiscard]] std::optional<bool>
   lookup(relational_operator op, data_view rhs) const override;
 
+  [[nodiscard]] synopsis_match
+  exact_lookup(relational_operator op, data_view rhs) const override;
+
   [[nodiscard]] bool equals(const synopsis& other) const noexcept override;
 
   [[nodiscard]] size_t memusage() const override;
@@ -0,0 +1,75 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/fwd.hpp"
+
+#include "vast/offset.hpp"
+#include "vast/type.hpp"
+
+#include <string>
+#include <vector>
+
+namespace vast {
+
+/// Prints table slices of a single schema as NDJSON.
+///
+/// The printer prepares everything that depends only on the schema once, e.g.,
+/// the keys of all fields along with their separators. Printing formats one
+/// column at a time and then assembles the rows in a buffer that has the
+/// right size up front. The output is the same as that of `json_printer` with
+/// the `oneline` option and otherwise default options, except that it prints
+/// enumerations by name.
+class columnar_json_printer {
+public:
+  /// Prepares printing for a schema.
+  /// @pre `caf::holds_alternative<record_type>(schema)`
+  explicit columnar_json_printer(type schema);
+
+  /// Returns the schema that this printer was prepared for.
+  [[nodiscard]] auto schema() const -> const type&;
+
+  /// Appends every row of a slice to a buffer, each on its own line.
+  /// @pre `slice.schema() == schema()`
+  void print(const table_slice& slice, std::vector<char>& buffer) const;
+
+private:
+  /// A step in printing a row.
+  struct instruction {
+    enum class kind {
+      literal, ///< Print the text in `literals_[index]`.
+      column,  ///< Print the value in `columns_[index]`.
+      record,  ///< Print `null` and jump to `skip` if `records_[index]` is
+               ///< null.
+    };
+
+    enum kind kind = {};
+    size_t index = {};
+    size_t skip = {};
+  };
+
+  /// A non-record field, identified by its offset.
+  struct column {
+    class type type;
+    offset index;
+  };
+
+  void compile(const record_type& record, const offset& index,
+               std::string& pending);
+
+  void flush(std::string& pending);
+
+  type schema_ = {};
+  std::vector<instruction> program_ = {};
+  std::vector<std::string> literals_ = {};
+  std::vector<column> columns_ = {};
+  std::vector<offset> records_ = {};
+};
+
+} // namespace vast
@@ -110,6 +110,46 @@ struct infer {
   static constexpr size_t buffer_size = 8'192;
 };
 
+// -- constants for pipeline execution -----------------------------------------
+
+/// Contains constants for the execution of pipelines.
+namespace exec {
+
+/// The maximum number of batches in flight between two operators of a local
+/// pipeline.
+inline constexpr size_t queue_capacity = 16;
+
+/// The maximum time an operator of a local pipeline blocks while waiting for
+/// input before it gets a chance to make progress without it.
+inline constexpr auto queue_poll_interval = std::chrono::milliseconds{100};
+
+/// The number of rows up to which an operator of a local pipeline combines
+/// consecutive small batches of the same schema from its input queue before
+/// processing them. A value of 0 disables combining batches.
+inline constexpr uint64_t batch_rows = 1'024;
+
+/// The maximum time an operator of a local pipeline holds back batches while
+/// combining them, measured from the arrival of the oldest batch.
+inline constexpr auto batch_linger = std::chrono::milliseconds{10};
+
+/// The number of instances of operators that can process parts of their input
+/// in parallel. A value of 0 uses one instance per hardware thread.
+inline constexpr uint64_t parallelism = 0;
+
+/// The number of instances of such operators in pipeline segments that run at
+/// the node. The node shares its threads with all other components, so it
+/// does not use one instance per hardware thread by default.
+inline constexpr uint64_t node_parallelism = 1;
+
+/// Whether operators with multiple instances restore the order of their
+/// input in their output.
+inline constexpr bool preserve_order = true;
+
+/// Whether to pin the instances of operators to their own CPUs.
+inline constexpr bool pin_threads = false;
+
+} // namespace exec
+
 // -- constants for the index --------------------------------------------------
 
 /// Contains constants for value index parameterization.
@@ -269,6 +309,19 @@ inline constexpr double fp_rate = 0.01;
 /// Flag that enables creation of partition indexes in the database.
 inline constexpr bool create_partition_index = true;
 
+/// The bitmap encoding of the IDs that partition indexes return.
+inline constexpr std::string_view bitmap_encoding = "ewah";
+
+/// The kind of index that partitions create for string fields.
+inline constexpr std::string_view string_index = "bitslice";
+
+/// The kind of index that partitions create for arithmetic fields.
+inline constexpr std::string_view arithmetic_index = "range";
+
+/// Whether passive partitions evaluate expressions directly against their
+/// value indexes instead of spawning one INDEXER actor per field.
+inline constexpr bool synchronous_evaluation = false;
+
 /// Whether to spawn central components in separate threads.
 inline constexpr bool detach_components = true;
 
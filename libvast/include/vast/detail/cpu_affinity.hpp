@@ -0,0 +1,31 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <caf/error.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace vast::detail {
+
+/// Lists the CPUs that the current process may run on, such that the CPUs of
+/// a NUMA node are adjacent. Assigning threads to consecutive CPUs thus fills
+/// up one node before moving on to the next.
+/// @returns The CPU numbers, or the range `[0, hardware concurrency)` on
+/// platforms without NUMA information.
+std::vector<size_t> numa_ordered_cpus();
+
+/// Restricts the calling thread to a single CPU.
+/// @param cpu The number of the CPU.
+/// @returns An error if the platform does not support it or the CPU is not
+/// available.
+caf::error pin_current_thread(size_t cpu);
+
+} // namespace vast::detail
@@ -0,0 +1,99 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace vast::detail {
+
+/// Finds the positions of up to two delimiter characters in a buffer.
+///
+/// The scanner compares 64 bytes at a time against the delimiters and
+/// condenses the result into a bitmask with one bit per byte, using AVX2 if
+/// available. Walking the set bits of the mask then yields the delimiters in
+/// order, without looking at the bytes in between one by one.
+class delimiter_scanner {
+public:
+  /// The number of bytes that a single mask covers.
+  static constexpr auto block_size = size_t{64};
+
+  /// Constructs a scanner for a single delimiter.
+  explicit delimiter_scanner(char delimiter) noexcept;
+
+  /// Constructs a scanner for two delimiters.
+  delimiter_scanner(char first, char second) noexcept;
+
+  /// Returns a mask whose bit *i* is set if `data[i]` is a delimiter.
+  /// @param data The start of the block.
+  /// @param size The number of bytes to look at. Bits past it are never set.
+  /// @pre `size <= block_size`
+  [[nodiscard]] auto mask(const char* data, size_t size) const noexcept
+    -> uint64_t;
+
+  /// Splits a buffer at every delimiter. Like `detail::split`, this omits the
+  /// empty part after a trailing delimiter.
+  /// @param buffer The buffer to split.
+  /// @param result The parts of *buffer*, which gets cleared first. Splitting
+  /// into the same vector repeatedly reuses its storage.
+  void split(std::string_view buffer,
+             std::vector<std::string_view>& result) const;
+
+private:
+  char first_;
+  char second_;
+};
+
+/// Iterates over the positions of all delimiters in a buffer.
+class delimiter_cursor {
+public:
+  /// Signals that no delimiters remain.
+  static constexpr auto npos = std::string_view::npos;
+
+  /// Starts iterating over a buffer.
+  /// @param scanner The scanner to use, which must outlive the cursor.
+  /// @param buffer The buffer, which must outlive the cursor.
+  delimiter_cursor(const delimiter_scanner& scanner,
+                   std::string_view buffer) noexcept
+    : scanner_{&scanner}, buffer_{buffer} {
+    load();
+  }
+
+  /// Returns the position of the next delimiter, or `npos` if there is none.
+  auto next() noexcept -> size_t {
+    while (mask_ == 0) {
+      block_ += delimiter_scanner::block_size;
+      if (block_ >= buffer_.size())
+        return npos;
+      load();
+    }
+    const auto result = block_ + std::countr_zero(mask_);
+    mask_ &= mask_ - 1;
+    return result;
+  }
+
+private:
+  void load() noexcept {
+    if (block_ < buffer_.size())
+      mask_ = scanner_->mask(
+        buffer_.data() + block_,
+        std::min(delimiter_scanner::block_size, buffer_.size() - block_));
+  }
+
+  const delimiter_scanner* scanner_;
+  std::string_view buffer_;
+  size_t block_ = 0;
+  uint64_t mask_ = 0;
+};
+
+} // namespace vast::detail
@@ -0,0 +1,126 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace vast::detail {
+
+/// A bounded lock-free queue for multiple producers and multiple consumers.
+///
+/// Every cell of the ring carries a sequence number that tells producers and
+/// consumers whether it is free or occupied for their current lap, so that
+/// each operation costs a single compare-and-swap on the shared position in
+/// the common case. See Dmitry Vyukov, "Bounded MPMC queue" (2010).
+template <class T>
+  requires(std::is_nothrow_move_assignable_v<T>
+           && std::is_default_constructible_v<T>)
+class mpmc_queue {
+public:
+  /// Constructs an empty queue.
+  /// @param capacity The maximum number of elements, which gets rounded up to
+  /// the next power of two.
+  explicit mpmc_queue(size_t capacity)
+    : capacity_{std::bit_ceil(capacity < 2 ? size_t{2} : capacity)},
+      cells_{std::make_unique<cell[]>(capacity_)} {
+    for (size_t i = 0; i < capacity_; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  mpmc_queue(const mpmc_queue&) = delete;
+  mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+  /// Appends an element unless the queue is full.
+  /// @param x The element to append, which stays untouched on failure.
+  /// @returns `true` if the element was appended.
+  bool try_push(T&& x) noexcept {
+    auto pos = push_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& c = cells_[pos & (capacity_ - 1)];
+      const auto sequence = c.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence)
+                        - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (push_pos_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed)) {
+          c.value = std::move(x);
+          c.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // The consumers have not yet freed the cell of the previous lap.
+        return false;
+      } else {
+        pos = push_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// Removes the oldest element unless the queue is empty.
+  /// @param x The destination for the removed element.
+  /// @returns `true` if an element was removed.
+  bool try_pop(T& x) noexcept {
+    auto pos = pop_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& c = cells_[pos & (capacity_ - 1)];
+      const auto sequence = c.sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence)
+                        - static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (pop_pos_.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+          x = std::move(c.value);
+          // Release the resources of the element right away instead of when
+          // the cell gets overwritten.
+          c.value = T{};
+          c.sequence.store(pos + capacity_, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = pop_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @returns The number of elements, which may already be outdated when
+  /// other threads access the queue concurrently.
+  [[nodiscard]] size_t size() const noexcept {
+    const auto pop_pos = pop_pos_.load(std::memory_order_acquire);
+    const auto push_pos = push_pos_.load(std::memory_order_acquire);
+    return push_pos > pop_pos ? push_pos - pop_pos : 0;
+  }
+
+  /// @returns The maximum number of elements.
+  [[nodiscard]] size_t capacity() const noexcept {
+    return capacity_;
+  }
+
+private:
+  /// The assumed size of a cache line, which separates data that different
+  /// threads modify to avoid false sharing.
+  static constexpr size_t cache_line_size = 64;
+
+  struct alignas(cache_line_size) cell {
+    std::atomic<size_t> sequence = {};
+    T value = {};
+  };
+
+  const size_t capacity_;
+  const std::unique_ptr<cell[]> cells_;
+  alignas(cache_line_size) std::atomic<size_t> push_pos_ = {};
+  alignas(cache_line_size) std::atomic<size_t> pop_pos_ = {};
+};
+
+} // namespace vast::detail
@@ -17,6 +17,8 @@
 #include "vast/time_synopsis.hpp"
 #include "vast/type.hpp"
 
+#include <optional>
+
 namespace vast::detail {
 
 /// Gets the INDEXER at position in the schema.
@@ -30,22 +32,21 @@ fetch_indexer(const PartitionState& state, const data_extractor& dx,
   return state.indexer_at(dx.column);
 }
 
-/// Retrieves an INDEXER for a predicate with a data extractor.
-/// @param dx The extractor.
-/// @param op The operator (only used to precompute ids for type queries.
+/// Computes the IDs for a predicate with a meta extractor.
+/// @param ex The extractor.
+/// @param op The operator.
 /// @param x The literal side of the predicate.
+/// @returns The IDs for the predicate, or `std::nullopt` if the meta extractor
+/// is not supported.
 /// @relates active_partition_state
 /// @relates passive_partition_state
 template <typename PartitionState>
-system::indexer_actor
-fetch_indexer(const PartitionState& state, const meta_extractor& ex,
-              relational_operator op, const data& x) {
-  VAST_TRACE_SCOPE("{} {} {}", VAST_ARG(ex), VAST_ARG(op), VAST_ARG(x));
+std::optional<ids>
+lookup_meta(const PartitionState& state, const meta_extractor& ex,
+            relational_operator op, const data& x) {
   ids row_ids;
   if (ex.kind == meta_extractor::type) {
     // We know the answer immediately: all IDs that are part of the table.
-    // However, we still have to "lift" this result into an actor for the
-    // EVALUATOR.
     for (auto& [name, ids] : state.type_ids()) {
       if (evaluate(name, op, x))
         row_ids |= ids;
@@ -72,11 +73,30 @@ fetch_indexer(const PartitionState& state, const meta_extractor& ex,
     }
   } else {
     VAST_WARN("{} got unsupported attribute: {}", *state.self, ex.kind);
-    return {};
+    return std::nullopt;
   }
+  return row_ids;
+}
+
+/// Retrieves an INDEXER for a predicate with a meta extractor.
+/// @param ex The extractor.
+/// @param op The operator (only used to precompute ids for type queries.
+/// @param x The literal side of the predicate.
+/// @relates active_partition_state
+/// @relates passive_partition_state
+template <typename PartitionState>
+system::indexer_actor
+fetch_indexer(const PartitionState& state, const meta_extractor& ex,
+              relational_operator op, const data& x) {
+  VAST_TRACE_SCOPE("{} {} {}", VAST_ARG(ex), VAST_ARG(op), VAST_ARG(x));
+  auto row_ids = lookup_meta(state, ex, op, x);
+  if (!row_ids)
+    return {};
+  // We still have to "lift" this result into an actor for the EVALUATOR.
   // TODO: Spawning a one-shot actor is quite expensive. Maybe the
   //       partition could instead maintain this actor lazily.
-  return state.self->spawn([row_ids]() -> system::indexer_actor::behavior_type {
+  return state.self->spawn([row_ids = std::move(*row_ids)]()
+                             -> system::indexer_actor::behavior_type {
     return {
       [=](atom::evaluate, const curried_predicate&) {
         return row_ids;
@@ -3,6 +3,7 @@
 #include "vast/fwd.hpp"
 
 #include "vast/operator_control_plane.hpp"
+#include "vast/operator_queue.hpp"
 #include "vast/pipeline.hpp"
 #include "vast/system/actors.hpp"
 
@@ -45,4 +46,16 @@ auto execution_node(
   operator_ptr op, system::node_actor node)
   -> system::execution_node_actor::behavior_type;
 
+/// Runs an operator of a local pipeline on the calling thread until it
+/// finishes, or until the next operator stops consuming. Unlike the execution
+/// node, it exchanges batches with the neighboring operators through bounded
+/// lock-free queues instead of CAF streams.
+/// @param op The operator to run.
+/// @param input The queue of the previous operator, if any.
+/// @param output The queue of the next operator, if any.
+/// @returns The error of the operator, if any.
+auto run_queued_execution_node(const operator_base& op,
+                               const operator_queue_ptr& input,
+                               const operator_queue_ptr& output) -> caf::error;
+
 } // namespace vast
@@ -0,0 +1,176 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/fwd.hpp"
+
+#include "vast/detail/heterogeneous_string_hash.hpp"
+#include "vast/operator.hpp"
+#include "vast/qualified_record_field.hpp"
+#include "vast/time.hpp"
+#include "vast/view.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace vast {
+
+/// A field-major index over the synopses of a sequence of partitions.
+///
+/// A partition synopsis stores the synopses of all fields of one partition,
+/// but the catalog evaluates a predicate on one field across all partitions.
+/// This index transposes the partition synopses: for every field, it stores
+/// the synopses of all partitions contiguously, and it resolves field names
+/// with a hash lookup instead of suffix-matching the fields of every partition.
+///
+/// The index refers to the synopses owned by the partition synopses it was
+/// built from, and must be updated alongside the sequence of partitions.
+///
+/// The per-partition entries of a column live in slots that never move, so
+/// that inserting or removing a partition costs the same regardless of the
+/// number of partitions. The index maps the positions of the partitions in
+/// the sequence to their slots, and reuses the slots of removed partitions.
+class field_synopsis_index {
+public:
+  /// The synopses of one field across all partitions. All per-partition
+  /// entries are indexed by slot rather than by position.
+  struct column {
+    /// The indexed field.
+    qualified_record_field field = {};
+
+    /// For every partition, whether the partition has the field at all. This
+    /// is only ever false for legacy partitions without a schema.
+    std::vector<bool> present = {};
+
+    /// For every partition, the field synopsis, or the synopsis for the type
+    /// of the field if there is no dedicated field synopsis. Null if the
+    /// partition has neither, in which case it cannot be ruled out.
+    std::vector<const synopsis*> synopses = {};
+
+    /// For every partition, the blocks of the split-block Bloom filter of the
+    /// synopsis, or an empty span if the synopsis has none. This allows for
+    /// probing the string synopses of all partitions at once.
+    std::vector<std::span<const uint32_t>> filters = {};
+
+    /// The number of non-empty entries in `filters`.
+    size_t num_filters = 0;
+
+    /// For every partition, whether the field may contain null values. The
+    /// synopses never see nulls, so they can only show that all values of a
+    /// field satisfy a predicate if the field has none.
+    std::vector<uint8_t> nulls = {};
+
+    /// The bounds of the time synopses of all partitions. Only maintained
+    /// while every partition has a time synopsis for the field.
+    bool has_time_bounds = false;
+    std::vector<time> min_times = {};
+    std::vector<time> max_times = {};
+  };
+
+  // -- modifiers --------------------------------------------------------------
+
+  /// Inserts a partition.
+  /// @param position The position of the partition in the sequence.
+  /// @param synopsis The synopsis of the partition.
+  /// @pre `position <= size()`
+  void insert(size_t position, const partition_synopsis& synopsis);
+
+  /// Replaces the synopsis of a partition.
+  /// @param position The position of the partition in the sequence.
+  /// @param synopsis The new synopsis of the partition.
+  /// @pre `position < size()`
+  void replace(size_t position, const partition_synopsis& synopsis);
+
+  /// Removes a partition.
+  /// @param position The position of the partition in the sequence.
+  /// @pre `position < size()`
+  void erase(size_t position);
+
+  // -- properties -------------------------------------------------------------
+
+  /// @returns The number of indexed partitions.
+  [[nodiscard]] size_t size() const noexcept;
+
+  /// @returns All indexed columns.
+  [[nodiscard]] const std::vector<column>& columns() const noexcept;
+
+  /// Resolves the key of a field extractor.
+  /// @param key The field extractor key.
+  /// @returns The positions of all columns in `columns()` whose fully qualified
+  /// name equals *key* or ends in *key* preceded by a dot.
+  [[nodiscard]] std::span<const size_t> resolve(std::string_view key) const;
+
+  // -- lookup -----------------------------------------------------------------
+
+  /// Marks all partitions for which the synopses of a column cannot rule out
+  /// that the partition contains matches for a predicate.
+  /// @param column The column to look up.
+  /// @param op The operator of the predicate.
+  /// @param rhs The RHS of the predicate.
+  /// @param positions The positions of the partitions to consider, or null
+  /// to consider all partitions.
+  /// @param selected The per-partition result; entries of partitions that
+  /// cannot be ruled out are set to 1, other entries are left untouched.
+  /// @pre `selected.size() == size()`
+  void lookup(const column& column, relational_operator op, data_view rhs,
+              const std::vector<size_t>* positions,
+              std::vector<uint8_t>& selected) const;
+
+  /// Marks all partitions for which the synopses of a column show that every
+  /// value satisfies a predicate, i.e., that the negated predicate cannot
+  /// match. Partitions that may have nulls for the column are never marked,
+  /// because nulls do not satisfy any predicate.
+  /// @param column The column to look up.
+  /// @param op The operator of the predicate.
+  /// @param rhs The RHS of the predicate.
+  /// @param positions The positions of the partitions to consider, or null
+  /// to consider all partitions.
+  /// @param selected The per-partition result; entries of partitions for
+  /// which all values satisfy the predicate are set to 1, other entries are
+  /// left untouched.
+  /// @pre `selected.size() == size()`
+  void lookup_all(const column& column, relational_operator op, data_view rhs,
+                  const std::vector<size_t>* positions,
+                  std::vector<uint8_t>& selected) const;
+
+private:
+  /// Returns the column for a field, creating it if it does not exist.
+  column& column_for(const qualified_record_field& field);
+
+  /// Resets the entries of a slot for all columns.
+  void reset(size_t slot);
+
+  /// Assigns the entries of a slot for all columns.
+  /// @pre The entries of *slot* are reset.
+  void assign(size_t slot, const partition_synopsis& synopsis);
+
+  /// The slot of every partition, in the order of the sequence.
+  std::vector<size_t> slots_ = {};
+
+  /// The number of slots in every column.
+  size_t num_slots_ = {};
+
+  /// The slots of removed partitions, which are free for reuse.
+  std::vector<size_t> free_slots_ = {};
+
+  /// The indexed columns.
+  std::vector<column> columns_ = {};
+
+  /// Maps fields to their position in `columns_`.
+  std::unordered_map<qualified_record_field, size_t> column_positions_ = {};
+
+  /// Maps all dot-separated suffixes of the fully qualified field names to
+  /// the positions of the matching columns in `columns_`.
+  detail::heterogeneous_string_hashmap<std::vector<size_t>> suffixes_ = {};
+};
+
+} // namespace vast
@@ -0,0 +1,143 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/fwd.hpp"
+
+#include "vast/arrow_table_slice.hpp"
+#include "vast/ids.hpp"
+#include "vast/pipeline.hpp"
+#include "vast/table_slice.hpp"
+#include "vast/type.hpp"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace vast {
+
+/// A batch on its way through a chain of fused operators.
+///
+/// Column transformations apply to the underlying record batch directly,
+/// without wrapping it in a table slice in between. Row selections only
+/// accumulate, and take effect when an operator needs the rows themselves or
+/// when the chain ends.
+class fused_batch {
+public:
+  /// Starts a batch from a table slice.
+  /// @pre `slice.rows() > 0`
+  explicit fused_batch(table_slice slice);
+
+  /// Returns the current schema of the batch.
+  [[nodiscard]] auto schema() const -> const type&;
+
+  /// Returns whether no rows remain.
+  [[nodiscard]] auto empty() const -> bool;
+
+  /// Drops all rows.
+  void discard();
+
+  /// Keeps only the rows that match an expression.
+  /// @param expr The expression, tailored to the current schema.
+  void filter(const expression& expr);
+
+  /// Returns the selected rows as a table slice.
+  auto slice() -> const table_slice&;
+
+  /// Applies a list of transformations to the columns.
+  /// @pre Transformations must be sorted by index.
+  void
+  transform_columns(const std::vector<indexed_transformation>& transformations);
+
+  /// Removes all columns except for the given ones.
+  /// @pre Indices must be sorted.
+  void select_columns(const std::vector<offset>& indices);
+
+  /// Casts the batch to an equivalent schema.
+  /// @pre `can_cast(schema(), schema)`
+  void cast(const type& schema);
+
+  /// Ends the chain and returns the selected rows as a table slice.
+  auto finish() && -> table_slice;
+
+private:
+  /// Returns all rows as a table slice, including those that are not
+  /// selected.
+  auto unfiltered() -> const table_slice&;
+
+  type schema_ = {};
+  std::shared_ptr<arrow::RecordBatch> batch_ = {};
+  table_slice slice_ = {};
+  std::optional<ids> selection_ = {};
+  id offset_ = invalid_id;
+  time import_time_ = {};
+};
+
+/// Applies an operator to a batch of a specific schema.
+using fused_step = std::function<void(fused_batch&)>;
+
+/// An operator that processes every batch on its own by selecting rows and
+/// transforming columns. Adjacent operators of this kind run as a single
+/// `fused_operator`.
+class fusable_operator {
+public:
+  virtual ~fusable_operator() = default;
+
+  /// Prepares the operator for batches of a schema.
+  /// @param schema The schema of the batches.
+  /// @param ctrl The control plane of the fused operator. It outlives the
+  /// returned step.
+  virtual auto fuse(const type& schema, operator_control_plane& ctrl) const
+    -> caf::expected<fused_step>
+    = 0;
+
+  /// Returns whether the operator can currently take part in fusion. Wrappers
+  /// around other operators use this to forward the ability of the wrapped
+  /// operator.
+  virtual auto fusable() const -> bool {
+    return true;
+  }
+};
+
+/// Returns whether an operator implements `fusable_operator` and can take
+/// part in fusion.
+auto is_fusable(const operator_base& op) -> bool;
+
+/// Runs a chain of fusable operators in a single pass over every batch, so
+/// that only the end of the chain materializes a table slice.
+class fused_operator final : public operator_base {
+public:
+  /// Constructs a fused operator.
+  /// @param ops The operators in order.
+  /// @pre All operators in *ops* implement `fusable_operator`.
+  explicit fused_operator(std::vector<operator_ptr> ops);
+
+  auto instantiate(operator_input input, operator_control_plane& ctrl) const
+    -> caf::expected<operator_output> override;
+
+  auto copy() const -> operator_ptr override;
+
+  auto to_string() const -> std::string override;
+
+  auto predicate_pushdown(expression const& expr) const
+    -> std::optional<std::pair<expression, operator_ptr>> override;
+
+  auto location() const -> operator_location override;
+
+  auto parallelism() const -> operator_parallelism override;
+
+  auto infer_type_impl(operator_type input) const
+    -> caf::expected<operator_type> override;
+
+private:
+  std::vector<operator_ptr> ops_;
+};
+
+} // namespace vast
@@ -155,6 +155,7 @@ class plugin_ptr;
 class plugin;
 class port;
 class record_type;
+class roaring_bitmap;
 class segment;
 class string_type;
 class subnet_type;
@@ -277,6 +278,7 @@ namespace bitmap {
 
 struct EWAHBitmap;
 struct NullBitmap;
+struct RoaringBitmap;
 struct WAHBitmap;
 
 } // namespace bitmap
@@ -415,6 +417,7 @@ CAF_BEGIN_TYPE_ID_BLOCK(vast_types, first_vast_type_id)
   VAST_ADD_TYPE_ID((vast::query_options))
   VAST_ADD_TYPE_ID((vast::relational_operator))
   VAST_ADD_TYPE_ID((vast::rest_endpoint))
+  VAST_ADD_TYPE_ID((vast::roaring_bitmap))
   VAST_ADD_TYPE_ID((vast::subnet))
   VAST_ADD_TYPE_ID((vast::table_slice_column))
   VAST_ADD_TYPE_ID((vast::table_slice))
@@ -0,0 +1,336 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/inspection_common.hpp"
+#include "vast/detail/overload.hpp"
+#include "vast/detail/type_traits.hpp"
+#include "vast/error.hpp"
+#include "vast/ewah_bitmap.hpp"
+#include "vast/fbs/value_index.hpp"
+#include "vast/ids.hpp"
+#include "vast/index/container_lookup.hpp"
+#include "vast/operator.hpp"
+#include "vast/time.hpp"
+#include "vast/value_index.hpp"
+#include "vast/view.hpp"
+
+#include <caf/error.hpp>
+#include <caf/expected.hpp>
+#include <caf/settings.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace vast {
+
+/// The bit slices of a sequence of unsigned 64-bit keys: the *i*-th slice
+/// holds the *i*-th bit of every key as uncompressed words. Slices whose bit
+/// is the same for all keys are stored as a single bit, which removes most
+/// slices for clustered values like timestamps.
+///
+/// Comparisons with a key use the range algorithm by O'Neil and Quass,
+/// "Improved Query Performance with Variant Indexes" (1997), which refines the
+/// sets of keys that are less than, greater than, and equal to the key from
+/// the most to the least significant slice. The refinement works on blocks of
+/// words that stay in the L1 cache for all slices.
+class bit_slices {
+public:
+  /// The number of slices.
+  static constexpr size_t num_slices = 64;
+
+  /// Appends a key.
+  /// @param key The key to append.
+  /// @param pos The position of the key.
+  /// @pre `pos >= size()`
+  void append(uint64_t key, size_t pos);
+
+  /// @returns The number of keys, including the skipped positions.
+  [[nodiscard]] size_t size() const noexcept;
+
+  /// Computes the positions whose keys compare to a key.
+  /// @param op The comparison, which must be one of `==`, `!=`, `<`, `<=`,
+  /// `>`, or `>=`.
+  /// @param key The key to compare with.
+  /// @returns The positions that satisfy the comparison.
+  [[nodiscard]] ewah_bitmap lookup(relational_operator op, uint64_t key) const;
+
+  /// Computes the sum of the selected keys.
+  /// @param selection The positions to consider, as uncompressed words.
+  [[nodiscard]] __uint128_t sum(std::span<const uint64_t> selection) const;
+
+  /// Computes the minimum of the selected keys.
+  /// @param selection The positions to consider, as uncompressed words.
+  /// @returns The minimum, or `std::nullopt` if the selection is empty.
+  [[nodiscard]] std::optional<uint64_t>
+  min(std::span<const uint64_t> selection) const;
+
+  /// Computes the maximum of the selected keys.
+  /// @param selection The positions to consider, as uncompressed words.
+  /// @returns The maximum, or `std::nullopt` if the selection is empty.
+  [[nodiscard]] std::optional<uint64_t>
+  max(std::span<const uint64_t> selection) const;
+
+  /// Replaces the slices whose bit is the same for all valid positions with
+  /// a single bit.
+  /// @param valid The positions that hold a key, as uncompressed words.
+  void compact(std::span<const uint64_t> valid);
+
+  [[nodiscard]] size_t memusage() const;
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, bit_slices& x) {
+    return detail::apply_all(f, x.size_, x.constant_mask_, x.constant_bits_,
+                             x.slices_);
+  }
+
+  friend auto pack(flatbuffers::FlatBufferBuilder& builder,
+                   const bit_slices& from,
+                   flatbuffers::Offset<fbs::value_index::detail::ValueIndexBase>
+                     base_offset)
+    -> flatbuffers::Offset<fbs::value_index::BitSlicedIndex>;
+
+  friend auto
+  unpack(const fbs::value_index::BitSlicedIndex& from, bit_slices& to)
+    -> caf::error;
+
+private:
+  /// Turns all constant slices back into uncompressed words.
+  void expand();
+
+  size_t size_ = 0;
+  uint64_t constant_mask_ = 0;
+  uint64_t constant_bits_ = 0;
+  std::vector<std::vector<uint64_t>> slices_
+    = std::vector<std::vector<uint64_t>>(num_slices);
+};
+
+namespace detail {
+
+/// Expands the first *n* bits of a bitmap into uncompressed words.
+template <class Bitmap>
+std::vector<uint64_t> to_words(const Bitmap& bm, size_t n) {
+  auto result = std::vector<uint64_t>((n + 63) / 64);
+  if (bm.empty() || all<0>(bm))
+    return result;
+  for (auto [first, last] : select_runs(bm)) {
+    last = std::min<size_t>(last, n);
+    for (auto i = first; i < last;) {
+      const auto offset = i % 64;
+      const auto count = std::min<size_t>(64 - offset, last - i);
+      const auto mask = count == 64 ? ~uint64_t{0}
+                                    : ((uint64_t{1} << count) - 1) << offset;
+      result[i / 64] |= mask;
+      i += count;
+    }
+  }
+  return result;
+}
+
+} // namespace detail
+
+/// An index for arithmetic values that stores the bit slices of their
+/// order-preserving 64-bit representation. Unlike the `arithmetic_index`, it
+/// does not bin values, so lookups are exact, and it answers sums, minima,
+/// and maxima directly from the slices.
+template <class T>
+class bit_sliced_index : public value_index {
+public:
+  static_assert(detail::is_any_v<T, int64_t, uint64_t, double, duration, time>,
+                "invalid type T for bit_sliced_index");
+
+  using value_type = std::conditional_t<detail::is_any_v<T, time, duration>,
+                                        duration::rep, T>;
+
+  /// Constructs a bit-sliced index.
+  /// @param t An arithmetic type.
+  /// @param opts Runtime context for index parameterization.
+  explicit bit_sliced_index(vast::type t, caf::settings opts = {})
+    : value_index{std::move(t), std::move(opts)} {
+    // nop
+  }
+
+  bool inspect_impl(supported_inspectors& inspector) override {
+    return value_index::inspect_impl(inspector)
+           && std::visit(
+             [this](auto visitor) {
+               return visitor.get().apply(slices_);
+             },
+             inspector);
+  }
+
+  /// Computes the sum of the selected values.
+  /// @param selection The IDs to consider.
+  /// @returns The sum, or an error if it does not fit into `T`.
+  [[nodiscard]] caf::expected<T> sum(const ids& selection) const
+    requires(!detail::is_any_v<T, double, time>)
+  {
+    const auto words = select(selection);
+    auto total = static_cast<__int128_t>(slices_.sum(words));
+    if constexpr (std::is_signed_v<value_type>) {
+      // Undo the offset of the representation for every selected value.
+      auto count = __int128_t{0};
+      for (auto word : words)
+        count += std::popcount(word);
+      total -= count << 63;
+    }
+    if (total < std::numeric_limits<value_type>::min()
+        || total > std::numeric_limits<value_type>::max())
+      return caf::make_error(ec::invalid_result,
+                             "sum exceeds the range of the value type");
+    return from_value(static_cast<value_type>(total));
+  }
+
+  /// Computes the minimum of the selected values.
+  /// @param selection The IDs to consider.
+  /// @returns The minimum, or `std::nullopt` if no value is selected.
+  [[nodiscard]] std::optional<T> min(const ids& selection) const {
+    if (auto key = slices_.min(select(selection)))
+      return from_value(from_key(*key));
+    return std::nullopt;
+  }
+
+  /// Computes the maximum of the selected values.
+  /// @param selection The IDs to consider.
+  /// @returns The maximum, or `std::nullopt` if no value is selected.
+  [[nodiscard]] std::optional<T> max(const ids& selection) const {
+    if (auto key = slices_.max(select(selection)))
+      return from_value(from_key(*key));
+    return std::nullopt;
+  }
+
+private:
+  static constexpr auto sign_bit = uint64_t{1} << 63;
+
+  /// Maps a value to an unsigned key with the same order.
+  static uint64_t to_key(value_type x) noexcept {
+    if constexpr (std::is_same_v<value_type, uint64_t>) {
+      return x;
+    } else if constexpr (std::is_same_v<value_type, double>) {
+      // Map -0.0 to 0.0 so that both compare equal.
+      const auto bits = std::bit_cast<uint64_t>(x == 0.0 ? 0.0 : x);
+      return bits & sign_bit ? ~bits : bits | sign_bit;
+    } else {
+      return static_cast<uint64_t>(x) ^ sign_bit;
+    }
+  }
+
+  static value_type from_key(uint64_t key) noexcept {
+    if constexpr (std::is_same_v<value_type, uint64_t>) {
+      return key;
+    } else if constexpr (std::is_same_v<value_type, double>) {
+      return std::bit_cast<double>(key & sign_bit ? key & ~sign_bit : ~key);
+    } else {
+      return static_cast<value_type>(key ^ sign_bit);
+    }
+  }
+
+  static T from_value(value_type x) noexcept {
+    if constexpr (std::is_same_v<T, duration>)
+      return duration{x};
+    else if constexpr (std::is_same_v<T, time>)
+      return time{duration{x}};
+    else
+      return x;
+  }
+
+  /// Restricts a selection to the IDs that hold a value.
+  std::vector<uint64_t> select(const ids& selection) const {
+    return detail::to_words(selection & mask(), slices_.size());
+  }
+
+  bool append_impl(data_view d, id pos) override {
+    auto append = [&](value_type x) {
+      slices_.append(to_key(x), pos);
+      return true;
+    };
+    auto f = detail::overload{
+      [&](auto&&) {
+        return false;
+      },
+      [&](view<T> x) {
+        if constexpr (std::is_same_v<T, duration>)
+          return append(x.count());
+        else if constexpr (std::is_same_v<T, time>)
+          return append(x.time_since_epoch().count());
+        else
+          return append(x);
+      },
+    };
+    return caf::visit(f, d);
+  }
+
+  [[nodiscard]] caf::expected<ids>
+  lookup_impl(relational_operator op, data_view d) const override {
+    auto lookup = [&](value_type x) -> caf::expected<ids> {
+      switch (op) {
+        default:
+          return caf::make_error(ec::unsupported_operator, op);
+        case relational_operator::equal:
+        case relational_operator::not_equal:
+        case relational_operator::less:
+        case relational_operator::less_equal:
+        case relational_operator::greater:
+        case relational_operator::greater_equal:
+          return ids{slices_.lookup(op, to_key(x))};
+      }
+    };
+    auto f = detail::overload{
+      [&](auto x) -> caf::expected<ids> {
+        return caf::make_error(ec::type_clash, value_type{}, materialize(x));
+      },
+      [&](view<T> x) -> caf::expected<ids> {
+        if constexpr (std::is_same_v<T, duration>)
+          return lookup(x.count());
+        else if constexpr (std::is_same_v<T, time>)
+          return lookup(x.time_since_epoch().count());
+        else
+          return lookup(x);
+      },
+      [&](view<list> xs) {
+        return detail::container_lookup(*this, op, xs);
+      },
+    };
+    return caf::visit(f, d);
+  }
+
+  [[nodiscard]] size_t memusage_impl() const override {
+    return slices_.memusage();
+  }
+
+  flatbuffers::Offset<fbs::ValueIndex>
+  pack_impl(flatbuffers::FlatBufferBuilder& builder,
+            flatbuffers::Offset<fbs::value_index::detail::ValueIndexBase>
+              base_offset) override {
+    slices_.compact(detail::to_words(mask(), slices_.size()));
+    const auto bit_sliced_index_offset = pack(builder, slices_, base_offset);
+    return fbs::CreateValueIndex(builder,
+                                 fbs::value_index::ValueIndex::bit_sliced,
+                                 bit_sliced_index_offset.Union());
+  }
+
+  caf::error unpack_impl(const fbs::ValueIndex& from) override {
+    const auto* from_bit_sliced = from.value_index_as_bit_sliced();
+    VAST_ASSERT(from_bit_sliced);
+    return unpack(*from_bit_sliced, slices_);
+  }
+
+  bit_slices slices_;
+};
+
+} // namespace vast
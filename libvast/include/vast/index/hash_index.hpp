@@ -222,8 +222,7 @@ private:
     }
     // Implementation of the one-pass search algorithm that computes the
     // resulting ID set. The predicate depends on the operator and RHS.
-    auto scan = [&](auto predicate) -> ids {
-      ewah_bitmap result;
+    auto scan_into = [&](auto result, auto predicate) -> ids {
       auto rng = select(this->mask());
       if (rng.done())
         return result;
@@ -239,6 +238,14 @@ private:
       }
       return result;
     };
+    // Equality lookups typically yield sparse and scattered IDs, for which
+    // Roaring bitmaps are more compact and faster to combine.
+    auto scan = [&](auto predicate) -> ids {
+      if (caf::get_or(this->options(), "bitmap", std::string{"ewah"})
+          == "roaring")
+        return scan_into(roaring_bitmap{}, predicate);
+      return scan_into(ewah_bitmap{}, predicate);
+    };
     if (op == relational_operator::equal
         || op == relational_operator::not_equal) {
       auto k = find_digest(x);
@@ -0,0 +1,85 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/detail/flat_map.hpp"
+#include "vast/error.hpp"
+#include "vast/ewah_bitmap.hpp"
+#include "vast/ids.hpp"
+#include "vast/value_index.hpp"
+#include "vast/view.hpp"
+
+#include <caf/error.hpp>
+#include <caf/expected.hpp>
+#include <caf/fwd.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace vast {
+
+/// An inverted index from the trigrams of strings to the IDs of the strings
+/// that contain them, as described by Cox, "Regular Expression Matching with a
+/// Trigram Index" (2012).
+///
+/// Unlike the string index, which compares a needle at every possible offset
+/// of every string, the trigram index answers substring and regular expression
+/// queries by intersecting the posting lists of the trigrams that every match
+/// must contain. The result is a superset of the matching IDs that the store
+/// narrows down by evaluating the predicate on the candidates.
+///
+/// The index folds ASCII characters to lower case, which makes it applicable
+/// to both case-sensitive and case-insensitive queries. It additionally keeps
+/// a digest per string to answer equality queries without false negatives.
+class trigram_index : public value_index {
+public:
+  /// The maximum number of literal substrings of a regular expression whose
+  /// combinations the index considers. Patterns with more substrings that
+  /// occur in the index yield all IDs.
+  static constexpr size_t max_pattern_atoms = 12;
+
+  /// Constructs a trigram index.
+  /// @param t An instance of `string_type`.
+  /// @param opts Runtime context for index parameterization.
+  explicit trigram_index(vast::type t, caf::settings opts = {});
+
+  bool inspect_impl(supported_inspectors& inspector) override;
+
+private:
+  bool append_impl(data_view x, id pos) override;
+
+  caf::expected<ids>
+  lookup_impl(relational_operator op, data_view x) const override;
+
+  size_t memusage_impl() const override;
+
+  flatbuffers::Offset<fbs::ValueIndex>
+  pack_impl(flatbuffers::FlatBufferBuilder& builder,
+            flatbuffers::Offset<fbs::value_index::detail::ValueIndexBase>
+              base_offset) override;
+
+  caf::error unpack_impl(const fbs::ValueIndex& from) override;
+
+  /// Computes the IDs of all strings that contain every trigram of *str*.
+  /// @pre `str.size() >= 3`
+  ewah_bitmap lookup_trigrams(std::string_view str) const;
+
+  /// Computes the IDs of all strings with the same digest as *str*.
+  ewah_bitmap lookup_digest(std::string_view str) const;
+
+  /// Computes the IDs of all strings that may match a regular expression.
+  ids lookup_pattern(view<pattern> x) const;
+
+  detail::flat_map<uint32_t, ewah_bitmap> postings_;
+  std::vector<uint64_t> digests_;
+};
+
+} // namespace vast
@@ -27,11 +27,16 @@ struct index_config {
     std::vector<std::string> targets = {};
     double fp_rate = defaults::system::fp_rate;
     bool create_partition_index = defaults::system::create_partition_index;
+    std::string bitmap = std::string{defaults::system::bitmap_encoding};
+    std::string string_index = std::string{defaults::system::string_index};
+    std::string arithmetic_index
+      = std::string{defaults::system::arithmetic_index};
 
     template <class Inspector>
     friend auto inspect(Inspector& f, rule& x) {
       return detail::apply_all(f, x.targets, x.fp_rate,
-                               x.create_partition_index);
+                               x.create_partition_index, x.bitmap,
+                               x.string_index, x.arithmetic_index);
     }
 
     static inline const record_type& schema() noexcept {
@@ -39,6 +44,9 @@ struct index_config {
         {"targets", list_type{string_type{}}},
         {"fp-rate", double_type{}},
         {"partition-index", bool_type{}},
+        {"bitmap", string_type{}},
+        {"string-index", string_type{}},
+        {"arithmetic-index", string_type{}},
       };
       return result;
     }
@@ -46,16 +54,19 @@ struct index_config {
 
   std::vector<rule> rules = {};
   double default_fp_rate = defaults::system::fp_rate;
+  bool synchronous_evaluation = defaults::system::synchronous_evaluation;
 
   template <class Inspector>
   friend auto inspect(Inspector& f, index_config& x) {
-    return detail::apply_all(f, x.rules, x.default_fp_rate);
+    return detail::apply_all(f, x.rules, x.default_fp_rate,
+                             x.synchronous_evaluation);
   }
 
   static inline const record_type& schema() noexcept {
     static auto result = record_type{
       {"rules", list_type{rule::schema()}},
       {"default-fp-rate", double_type{}},
+      {"synchronous-evaluation", bool_type{}},
     };
     return result;
   }
@@ -64,4 +75,25 @@ struct index_config {
 bool should_create_partition_index(const qualified_record_field& index_qf,
                                    const std::vector<index_config::rule>& rules);
 
+/// Returns the bitmap encoding of the IDs that the partition index of a field
+/// returns, i.e., either "ewah" or "roaring".
+std::string_view
+index_bitmap_encoding(const qualified_record_field& index_qf,
+                      const std::vector<index_config::rule>& rules);
+
+/// Returns the kind of index for a string field, i.e., either "bitslice" or
+/// "trigram".
+std::string_view
+index_string_kind(const qualified_record_field& index_qf,
+                  const std::vector<index_config::rule>& rules);
+
+/// Returns the kind of index for an arithmetic field, i.e., either "range" or
+/// "bit-sliced".
+std::string_view
+index_arithmetic_kind(const qualified_record_field& index_qf,
+                      const std::vector<index_config::rule>& rules);
+
+/// Checks that all rules of an index configuration are valid.
+caf::error validate(const index_config& config);
+
 } // namespace vast
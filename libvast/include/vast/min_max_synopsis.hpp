@@ -32,21 +32,59 @@ public:
 
   [[nodiscard]] std::optional<bool>
   lookup(relational_operator op, data_view rhs) const override {
-    auto do_lookup
-      = [this](relational_operator op, data_view xv) -> std::optional<bool> {
+    if (auto result = match(op, rhs))
+      return *result != synopsis_match::none;
+    return {};
+  }
+
+  [[nodiscard]] synopsis_match
+  exact_lookup(relational_operator op, data_view rhs) const override {
+    return match(op, rhs).value_or(synopsis_match::maybe);
+  }
+
+  [[nodiscard]] size_t memusage() const override {
+    return sizeof(min_max_synopsis);
+  }
+
+  bool inspect_impl(supported_inspectors& inspector) override {
+    return std::visit(
+      [this](auto inspector) {
+        return inspector.get().apply(min_) && inspector.get().apply(max_);
+      },
+      inspector);
+  }
+
+  [[nodiscard]] T min() const noexcept {
+    return min_;
+  }
+
+  [[nodiscard]] T max() const noexcept {
+    return max_;
+  }
+
+private:
+  [[nodiscard]] std::optional<synopsis_match>
+  match(relational_operator op, data_view rhs) const {
+    auto do_lookup = [this](relational_operator op,
+                            data_view xv) -> std::optional<synopsis_match> {
       if (auto x = caf::get_if<view<T>>(&xv))
         return {lookup_impl(op, *x)};
       else
         return {};
     };
-    auto membership = [&]() -> std::optional<bool> {
+    auto membership = [&]() -> std::optional<synopsis_match> {
       if (auto xs = caf::get_if<view<list>>(&rhs)) {
+        auto result = synopsis_match::none;
         for (auto x : **xs) {
-          auto result = do_lookup(relational_operator::equal, x);
-          if (result && *result)
-            return true;
+          auto element = do_lookup(relational_operator::equal, x);
+          if (!element)
+            continue;
+          if (*element == synopsis_match::all)
+            return synopsis_match::all;
+          if (*element == synopsis_match::maybe)
+            result = synopsis_match::maybe;
         }
-        return false;
+        return result;
       }
       return {};
     };
@@ -55,7 +93,7 @@ public:
         return membership();
       case relational_operator::not_in:
         if (auto result = membership())
-          return !*result;
+          return negate(*result);
         else
           return result;
       case relational_operator::equal:
@@ -70,28 +108,8 @@ public:
     }
   }
 
-  [[nodiscard]] size_t memusage() const override {
-    return sizeof(min_max_synopsis);
-  }
-
-  bool inspect_impl(supported_inspectors& inspector) override {
-    return std::visit(
-      [this](auto inspector) {
-        return inspector.get().apply(min_) && inspector.get().apply(max_);
-      },
-      inspector);
-  }
-
-  [[nodiscard]] T min() const noexcept {
-    return min_;
-  }
-
-  [[nodiscard]] T max() const noexcept {
-    return max_;
-  }
-
-private:
-  [[nodiscard]] bool lookup_impl(relational_operator op, const T x) const {
+  [[nodiscard]] synopsis_match
+  lookup_impl(relational_operator op, const T x) const {
     // Let *min* and *max* constitute the LHS of the lookup operation and *rhs*
     // be the value to compare with on the RHS. Then, there are 5 possible
     // scenarios to differentiate for the inputs:
@@ -111,23 +129,34 @@ private:
     //   (4) [4,8] < 8 is true  (4 < 8 || 8 < 8)
     //   (5) [4,8] < 9 is true  (4 < 9 || 8 < 9)
     //
-    // Thus, for range comparisons we need to test `min op rhs || max op rhs`.
+    // Thus, for range comparisons we need to test `min op rhs || max op rhs`
+    // to find out whether any value matches. Conversely, all values match if
+    // `min op rhs && max op rhs`. A synopsis without any values has min >
+    // max, in which case no value matches.
+    if (min_ > max_)
+      return synopsis_match::none;
+    auto make_match = [](bool any, bool all) {
+      if (all)
+        return synopsis_match::all;
+      return any ? synopsis_match::maybe : synopsis_match::none;
+    };
     switch (op) {
       default:
         VAST_ASSERT(!"unsupported operator");
-        return false;
+        return synopsis_match::none;
       case relational_operator::equal:
-        return min_ <= x && x <= max_;
+        return make_match(min_ <= x && x <= max_, min_ == x && max_ == x);
       case relational_operator::not_equal:
-        return !(min_ <= x && x <= max_);
+        return negate(
+          make_match(min_ <= x && x <= max_, min_ == x && max_ == x));
       case relational_operator::less:
-        return min_ < x;
+        return make_match(min_ < x, max_ < x);
       case relational_operator::less_equal:
-        return min_ <= x;
+        return make_match(min_ <= x, max_ <= x);
       case relational_operator::greater:
-        return max_ > x;
+        return make_match(max_ > x, min_ > x);
       case relational_operator::greater_equal:
-        return max_ >= x;
+        return make_match(max_ >= x, min_ >= x);
     }
   }
 
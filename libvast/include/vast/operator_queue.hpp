@@ -0,0 +1,178 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/fwd.hpp"
+
+#include "vast/chunk.hpp"
+#include "vast/detail/mpmc_queue.hpp"
+#include "vast/pipeline.hpp"
+#include "vast/table_slice.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <variant>
+
+namespace vast {
+
+/// The outcome of removing a batch from an operator queue.
+enum class operator_queue_status {
+  /// The queue returned a batch.
+  ok,
+  /// The queue stayed empty until the timeout expired.
+  timeout,
+  /// The queue is empty and all producers closed it, or, when appending a
+  /// batch, all consumers cancelled it.
+  closed,
+};
+
+/// Statistics about the batches that passed through an operator queue.
+struct operator_queue_metrics {
+  /// The number of batches.
+  uint64_t batches = 0;
+
+  /// The total time that batches spent in the queue.
+  std::chrono::nanoseconds total_latency = {};
+
+  /// The longest time that a single batch spent in the queue.
+  std::chrono::nanoseconds max_latency = {};
+
+  /// The number of times that a producer waited for a free slot.
+  uint64_t full_waits = 0;
+
+  /// The number of times that a consumer waited for a batch.
+  uint64_t empty_waits = 0;
+};
+
+/// A bounded queue of batches between two operators of a local pipeline.
+///
+/// The batches travel through a lock-free ring. The capacity of the ring is
+/// the credit of the producer: once it is exhausted, the producer blocks until
+/// the consumer removes a batch. Threads only synchronize on a mutex when they
+/// need to wait, i.e., when the queue is full or empty.
+///
+/// Every batch carries a sequence number, which allows for restoring the order
+/// of batches after multiple consumers processed them concurrently.
+template <operator_input_batch T>
+class operator_queue {
+public:
+  /// Constructs an empty queue.
+  /// @param capacity The maximum number of batches in flight.
+  /// @param producers The number of producers that must close the queue.
+  /// @param consumers The number of consumers that must cancel the queue.
+  explicit operator_queue(size_t capacity, size_t producers = 1,
+                          size_t consumers = 1);
+
+  /// Appends a batch with the next sequence number, and blocks while the
+  /// queue is full.
+  /// @param x The batch to append.
+  /// @returns `false` if the consumers cancelled the queue.
+  /// @pre `close()` was not called by all producers.
+  bool push(T x);
+
+  /// Appends a batch with a given sequence number, and blocks while the queue
+  /// is full.
+  /// @param x The batch to append.
+  /// @param sequence The sequence number of the batch.
+  /// @returns `false` if the consumers cancelled the queue.
+  /// @pre `close()` was not called by all producers.
+  bool push(T x, uint64_t sequence);
+
+  /// Appends a batch with a given sequence number, and blocks for at most
+  /// *timeout* while the queue is full.
+  /// @param x The batch to append, which stays untouched unless the result is
+  /// `operator_queue_status::ok`.
+  /// @param sequence The sequence number of the batch.
+  /// @param timeout The maximum time to wait for a free slot.
+  /// @pre `close()` was not called by all producers.
+  [[nodiscard]] operator_queue_status
+  push(T& x, uint64_t sequence, std::chrono::steady_clock::duration timeout);
+
+  /// Removes the oldest batch, and blocks while the queue is empty.
+  /// @param x The destination for the removed batch.
+  /// @param timeout The maximum time to wait for a batch.
+  [[nodiscard]] operator_queue_status
+  pop(T& x, std::chrono::steady_clock::duration timeout);
+
+  /// Removes the oldest batch together with its sequence number, and blocks
+  /// while the queue is empty.
+  /// @param x The destination for the removed batch.
+  /// @param sequence The destination for the sequence number of the batch.
+  /// @param timeout The maximum time to wait for a batch.
+  [[nodiscard]] operator_queue_status
+  pop(T& x, uint64_t& sequence, std::chrono::steady_clock::duration timeout);
+
+  /// Signals that a producer will not append more batches. Once all producers
+  /// did so, the consumers still receive the batches that are in the queue.
+  void close();
+
+  /// Signals that a consumer will not remove more batches. Once all consumers
+  /// did so, the producers unblock.
+  void cancel();
+
+  /// @returns Statistics about the batches that passed through the queue.
+  [[nodiscard]] operator_queue_metrics metrics() const;
+
+private:
+  using clock = std::chrono::steady_clock;
+
+  /// A batch together with its sequence number and the time it entered the
+  /// queue.
+  struct entry {
+    T batch;
+    uint64_t sequence;
+    clock::time_point pushed;
+  };
+
+  /// Appends an entry, and blocks while the queue is full.
+  /// @param e The entry to append, which stays untouched on failure.
+  /// @param deadline The time to stop waiting for a free slot, if any.
+  operator_queue_status
+  push(entry& e, std::optional<clock::time_point> deadline);
+
+  /// Wakes up threads that wait for the opposite end of the queue.
+  void notify(std::atomic<size_t>& waiting, std::condition_variable& cv);
+
+  detail::mpmc_queue<entry> queue_;
+  std::atomic<uint64_t> next_sequence_ = 0;
+  std::atomic<size_t> producers_;
+  std::atomic<size_t> consumers_;
+  std::atomic<bool> closed_ = false;
+  std::atomic<bool> cancelled_ = false;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::atomic<size_t> waiting_producers_ = 0;
+  std::atomic<size_t> waiting_consumers_ = 0;
+  std::atomic<uint64_t> batches_ = 0;
+  std::atomic<int64_t> total_latency_ = 0;
+  std::atomic<int64_t> max_latency_ = 0;
+  std::atomic<uint64_t> full_waits_ = 0;
+  std::atomic<uint64_t> empty_waits_ = 0;
+};
+
+/// A queue that connects two operators of a local pipeline, or nothing at the
+/// ends of the pipeline.
+using operator_queue_ptr
+  = std::variant<std::monostate, std::shared_ptr<operator_queue<table_slice>>,
+                 std::shared_ptr<operator_queue<chunk_ptr>>>;
+
+/// Creates a queue for the batches of an operator output.
+/// @param type The output type of the producing operator.
+/// @param capacity The maximum number of batches in flight.
+/// @returns A queue, or nothing if *type* is `void`.
+auto make_operator_queue(operator_type type, size_t capacity)
+  -> operator_queue_ptr;
+
+} // namespace vast
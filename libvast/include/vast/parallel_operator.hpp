@@ -0,0 +1,86 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/fwd.hpp"
+
+#include "vast/pipeline.hpp"
+
+#include <caf/fwd.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace vast {
+
+/// Runs multiple instances of an operator in threads of their own, each of
+/// which processes a part of the input.
+///
+/// All instances of a stateless operator take their input from a single
+/// queue. For operators with per-schema state, every schema maps to exactly
+/// one instance. The output of the instances gets merged back into a single
+/// output, which optionally has the same order as the input.
+class parallel_operator final : public operator_base {
+public:
+  /// Constructs a parallel operator.
+  /// @param op The operator to run multiple instances of.
+  /// @param instances The number of instances.
+  /// @param ordered Whether to preserve the order of the input batches.
+  /// @param pinned Whether to pin every instance to its own CPU, filling up
+  /// one NUMA node before the next.
+  /// @pre `op->parallelism() != operator_parallelism::none`
+  parallel_operator(operator_ptr op, size_t instances, bool ordered,
+                    bool pinned = false);
+
+  auto instantiate(operator_input input, operator_control_plane& ctrl) const
+    -> caf::expected<operator_output> override;
+
+  auto copy() const -> operator_ptr override;
+
+  auto to_string() const -> std::string override;
+
+  auto location() const -> operator_location override;
+
+  auto detached() const -> bool override;
+
+  auto infer_type_impl(operator_type input) const
+    -> caf::expected<operator_type> override;
+
+private:
+  operator_ptr op_;
+  size_t instances_;
+  bool ordered_;
+  bool pinned_;
+};
+
+/// Wraps an operator in a `parallel_operator` if it supports multiple
+/// instances and the configuration asks for more than one.
+/// @param op The operator to wrap.
+/// @param options The configuration, which controls the number of instances
+/// with `vast.exec.parallelism`, the order of the output with
+/// `vast.exec.preserve-order`, and the placement of the instances with
+/// `vast.exec.pin-threads`.
+/// @param instances The number of instances to use instead of the configured
+/// `vast.exec.parallelism`, where 0 means one per hardware thread.
+/// @returns The wrapped operator, or *op* itself.
+auto parallelize(operator_ptr op, const caf::settings& options,
+                 std::optional<uint64_t> instances = {}) -> operator_ptr;
+
+/// Fuses runs of adjacent stateless operators into a single operator, so that
+/// every instance passes a batch through all of them without handing it over
+/// to another thread in between, and then wraps every operator like the
+/// overload for a single operator.
+/// @param ops The operators of a pipeline.
+/// @param options The configuration, see above.
+/// @returns The operators to run instead of *ops*.
+auto parallelize(std::vector<operator_ptr> ops, const caf::settings& options)
+  -> std::vector<operator_ptr>;
+
+} // namespace vast
@@ -16,6 +16,9 @@
 #include "vast/table_slice.hpp"
 #include "vast/uuid.hpp"
 
+#include <optional>
+#include <unordered_set>
+
 namespace caf {
 
 // Forward declaration to be able to befriend the unshare implementation.
@@ -73,6 +76,17 @@ struct partition_synopsis final : public caf::ref_counted {
   /// Synopsis data structures for individual columns.
   std::unordered_map<qualified_record_field, synopsis_ptr> field_synopses_;
 
+  /// The fields that contain null values. The synopses only ever see the
+  /// non-null values of a field, so they cannot tell on their own whether a
+  /// predicate holds for all values of a field. This is `std::nullopt` for
+  /// partition synopses that were created before it was tracked, in which
+  /// case every field may contain nulls.
+  std::optional<std::unordered_set<qualified_record_field>> null_fields_
+    = std::unordered_set<qualified_record_field>{};
+
+  /// Checks whether a field may contain null values.
+  [[nodiscard]] bool may_have_nulls(const qualified_record_field& field) const;
+
   // -- flatbuffer -------------------------------------------------------------
 
   FRIEND_ATTRIBUTE_NODISCARD friend caf::expected<
@@ -124,6 +124,13 @@ enum class operator_location {
   anywhere, ///< Run this operator where the previous operator ran.
 };
 
+/// Describes whether multiple instances of an operator may share its input.
+enum class operator_parallelism {
+  none,       ///< Run a single instance of this operator.
+  stateless,  ///< Any instance may process any batch.
+  per_schema, ///< A single instance must process all batches of a schema.
+};
+
 /// Base class of all pipeline operators. Commonly used as `operator_ptr`.
 class operator_base {
 public:
@@ -167,6 +174,34 @@ public:
     return {};
   }
 
+  /// Returns `n` if the operator forwards only the first `n` events of its
+  /// input and drops the rest, like `head n`.
+  virtual auto row_limit() const -> std::optional<uint64_t> {
+    return {};
+  }
+
+  /// Tries to push a row limit into the operator.
+  ///
+  /// Returns `nullptr` if the operator can not make use of the limit.
+  /// Otherwise, returns `this2` such that `this | head limit` is equivalent to
+  /// `this2`.
+  virtual auto limit_pushdown(uint64_t limit) const -> operator_ptr {
+    (void)limit;
+    return nullptr;
+  }
+
+  /// Tries to split the operator into a partial and a final phase.
+  ///
+  /// Returns `std::nullopt` if the operator can not be split. Otherwise,
+  /// returns `std::pair{partial, final}` such that running `partial` on
+  /// disjoint parts of the input separately, and passing all of their outputs
+  /// to a single `final`, is equivalent to `this`. The two phases may share
+  /// state, so they must run in the same process.
+  virtual auto split_partial() const
+    -> std::optional<std::pair<operator_ptr, operator_ptr>> {
+    return {};
+  }
+
   /// Returns the location of the operator.
   virtual auto location() const -> operator_location {
     return operator_location::anywhere;
@@ -177,6 +212,13 @@ public:
     return false;
   }
 
+  /// Returns whether the executor may run multiple instances of the operator
+  /// that each process a part of its input. The executor only considers this
+  /// for operators whose input and output are batches.
+  virtual auto parallelism() const -> operator_parallelism {
+    return operator_parallelism::none;
+  }
+
   /// Retrieve the output type of this operator for a given input.
   ///
   /// The default implementation will try to instantiate the operator and then
@@ -253,6 +295,13 @@ public:
   /// Returns whether this is a well-formed `void -> void` pipeline.
   auto is_closed() const -> bool;
 
+  /// Collapses runs of adjacent operators that implement `fusable_operator`
+  /// into a single `fused_operator`, so that a batch passes through all of
+  /// them at once. Instantiating a pipeline does this implicitly.
+  /// @param ops The operators of a pipeline.
+  /// @returns The operators to run instead of *ops*.
+  static auto fuse(std::vector<operator_ptr> ops) -> std::vector<operator_ptr>;
+
   /// Same as `predicate_pushdown`, but returns a `pipeline` object directly.
   auto predicate_pushdown_pipeline(expression const& expr) const
     -> std::optional<std::pair<expression, pipeline>>;
@@ -265,6 +314,11 @@ public:
     die("pipeline::detached() must not be called");
   }
 
+  /// Returns `operator_parallelism::stateless` if all operators are
+  /// stateless. Per-schema state does not carry over, because the operators
+  /// before may change the schema.
+  auto parallelism() const -> operator_parallelism override;
+
   auto instantiate(operator_input input, operator_control_plane& control) const
     -> caf::expected<operator_output> override;
 
@@ -303,6 +357,10 @@ public:
   }
 
 private:
+  /// Replaces operators followed by a row limit with the result of their
+  /// `limit_pushdown`, e.g., to turn `sort x | head 10` into a top-k sort.
+  void push_down_limits();
+
   std::vector<operator_ptr> operators_;
 };
 
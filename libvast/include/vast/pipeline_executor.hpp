@@ -39,7 +39,9 @@ struct pipeline_executor_state {
   size_t remote_spawn_count{0};
 
   /// Spawns a set of execution nodes, creating one execution node actor per
-  /// operator. The operators must form a valid pipeline. The *remote* node
+  /// operator. Operators that support multiple instances run them in their
+  /// own threads behind a single execution node. The operators must form a
+  /// valid pipeline. The *remote* node
   /// actor may be nullptr if all operators' locations are local or anywhere.
   void spawn_execution_nodes(system::node_actor remote,
                              std::vector<operator_ptr> ops);
@@ -48,6 +50,14 @@ struct pipeline_executor_state {
   /// remote execution nodes were spawned.
   void continue_if_done_spawning();
 
+  /// Runs a pipeline without remote operators to completion, with one thread
+  /// per operator. Adjacent operators exchange batches through bounded
+  /// lock-free queues instead of CAF streams, which avoids the overhead of
+  /// the stream protocol for every batch. Runs of stateless operators get
+  /// fused, and a pool of instances passes every batch through all of them.
+  /// Logs the time that every operator spent at the end.
+  auto run_queued(std::vector<operator_ptr> ops) -> caf::result<void>;
+
   /// Start the pipeline execution. Assumes that all execution nodes were
   /// spawned successfully.
   auto run() -> caf::result<void>;
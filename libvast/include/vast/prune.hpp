@@ -25,6 +25,9 @@ namespace vast {
 // to
 //
 //     ':string == "u8wm3g4pw100420ydpzc"'
+//
+// The rewrite widens the set of partitions an expression selects, so it is
+// not applied below negations.
 expression prune(expression e, const detail::heterogeneous_string_hashset& hs);
 
 } // namespace vast
@@ -12,8 +12,10 @@
 
 #include "vast/query_context.hpp"
 #include "vast/system/actors.hpp"
+#include "vast/time.hpp"
 #include "vast/uuid.hpp"
 
+#include <functional>
 #include <vector>
 
 namespace vast {
@@ -41,6 +43,17 @@ struct query_state {
   /// The number of partitions that are processed already.
   uint32_t completed_partitions = 0;
 
+  /// The time at which the query was inserted into the queue.
+  time arrival = {};
+
+  /// Returns the virtual deadline of the query, which determines the order in
+  /// which the queue schedules partitions. Every scheduled partition pushes
+  /// the deadline back by an amount inversely proportional to the priority of
+  /// the query, so queries with many partitions cannot monopolize lookups, and
+  /// low-priority queries yield to normal ones without starving. The amount
+  /// is at most ten times that of a query with normal priority.
+  [[nodiscard]] time deadline() const;
+
   template <class Inspector>
   friend auto inspect(Inspector& f, query_state& x) {
     return f.object(x)
@@ -50,7 +63,8 @@ struct query_state {
               f.field("candidate-partitions", x.candidate_partitions),
               f.field("requested-partitions", x.requested_partitions),
               f.field("scheduled-partitions", x.scheduled_partitions),
-              f.field("completed-partitions", x.completed_partitions));
+              f.field("completed-partitions", x.completed_partitions),
+              f.field("arrival", x.arrival));
   }
 
   std::size_t memusage() const {
@@ -84,12 +98,20 @@ public:
     std::vector<uuid> queries;
     bool erased = false;
 
-    friend bool operator<(const entry& lhs, const entry& rhs) noexcept;
     friend bool operator==(const entry& lhs, const uuid& rhs) noexcept;
 
     std::size_t memusage() const;
   };
 
+  // -- constructors -----------------------------------------------------------
+
+  /// Constructs an empty queue that uses the system clock.
+  query_queue() = default;
+
+  /// Constructs an empty queue.
+  /// @param clock The clock that provides the arrival time of queries.
+  explicit query_queue(std::function<time()> clock);
+
   // -- observers --------------------------------------------------------------
 
   /// Calculates the number of partitions that need to be loaded to complete all
@@ -129,7 +151,9 @@ public:
   bool mark_partition_erased(const uuid& pid);
 
   /// Retrieves the next partition to be scheduled and the related queries and
-  /// increments the scheduled counters for the latter.
+  /// increments the scheduled counters for the latter. Picks the partition
+  /// with the earliest deadline of its active queries, and prefers partitions
+  /// that serve more queries at the same deadline.
   [[nodiscard]] std::optional<entry> next();
 
   /// Returns a client handle in case the requested batch has been completed.
@@ -139,15 +163,52 @@ public:
   std::size_t memusage() const;
 
 private:
+  /// The position of a partition in the schedule. Partitions are ordered by
+  /// the earliest deadline of their active queries, then by their number of
+  /// queries in descending order, and finally by their ID.
+  struct schedule_key {
+    time deadline = {};
+    size_t num_queries = {};
+    uuid partition = {};
+
+    /// Whether *lhs* must be scheduled after *rhs*. Serves as the comparator
+    /// for the min-heap.
+    static bool
+    after(const schedule_key& lhs, const schedule_key& rhs) noexcept;
+
+    /// Whether two keys are the same.
+    static bool same(const schedule_key& lhs, const schedule_key& rhs) noexcept;
+  };
+
+  /// Computes the current schedule key of an active partition.
+  [[nodiscard]] schedule_key make_schedule_key(const entry& partition) const;
+
+  /// Adds an active partition to the schedule, or updates its key if it may
+  /// have moved forward.
+  void schedule(const entry& partition);
+
   /// Maps query IDs to pending queries lookup state.
   std::unordered_map<uuid, query_state> queries_ = {};
 
   /// Maps partitions IDs to lists of query IDs.
-  std::vector<entry> partitions = {};
+  std::unordered_map<uuid, entry> partitions = {};
+
+  /// A min-heap of the keys of all active partitions. Scheduling a partition
+  /// only ever pushes deadlines back, so the heap holds lower bounds of the
+  /// actual keys, and `next()` recomputes the key at the top of the heap only.
+  /// Whenever the key of a partition may move forward, e.g., when a query is
+  /// added to it, the partition gets an additional, up-to-date entry. Entries
+  /// of partitions that are no longer active are dropped when they surface.
+  std::vector<schedule_key> schedule_ = {};
 
   /// Maps partitions IDs to lists of query IDs, only contains entries where all
   /// queries are currently inactive.
   std::vector<entry> inactive_partitions = {};
+
+  /// The clock that provides the arrival time of queries.
+  std::function<time()> clock_ = [] {
+    return time::clock::now();
+  };
 };
 
 } // namespace vast
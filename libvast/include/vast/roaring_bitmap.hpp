@@ -0,0 +1,179 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/bitmap_base.hpp"
+#include "vast/detail/inspection_common.hpp"
+#include "vast/detail/operators.hpp"
+#include "vast/word.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vast {
+
+class roaring_bitmap_range;
+
+/// A bitmap that partitions the bit positions into chunks of 2^16 bits, and
+/// stores the 1-bits of every chunk in the most compact of three kinds of
+/// containers, as described by Lemire et al., "Roaring Bitmaps: Implementation
+/// of an Optimized Software Library" (2018):
+///
+/// - An *array* container holds the sorted positions of up to 4096 1-bits.
+/// - A *bitset* container holds all 2^16 bits of the chunk in 1024 words.
+/// - A *run* container holds sorted runs of 1-bits as pairs of start position
+///   and length minus one.
+///
+/// Chunks without any 1-bits have no container at all. Unlike the run-length
+/// encoded bitmaps, this representation supports random access, and bitwise
+/// operations between two Roaring bitmaps work container by container, which
+/// skips chunks that only exist in one operand entirely. This makes it a good
+/// fit for sparse and scattered IDs, e.g., the results of hash index lookups.
+class roaring_bitmap : public bitmap_base<roaring_bitmap>,
+                       detail::equality_comparable<roaring_bitmap> {
+  friend roaring_bitmap_range;
+
+public:
+  /// The number of bits per chunk.
+  static constexpr size_type chunk_size = size_type{1} << 16;
+
+  /// The maximum number of 1-bits in an array container.
+  static constexpr size_t max_array_size = 4096;
+
+  /// The number of words of a bitset container.
+  static constexpr size_t bitset_size = chunk_size / word_type::width;
+
+  /// The kinds of containers.
+  enum class container_kind : uint8_t { array, bitset, run };
+
+  /// The 1-bits of a single chunk.
+  struct container {
+    /// The representation of the container.
+    container_kind kind = container_kind::array;
+
+    /// The number of 1-bits in the container.
+    uint32_t cardinality = 0;
+
+    /// The sorted positions for array containers, and the sorted pairs of
+    /// start position and length minus one for run containers.
+    std::vector<uint16_t> values = {};
+
+    /// The words for bitset containers.
+    std::vector<block_type> words = {};
+
+    friend bool operator==(const container& x, const container& y);
+
+    template <class Inspector>
+    friend auto inspect(Inspector& f, container& x) {
+      auto kind = static_cast<uint8_t>(x.kind);
+      auto result
+        = detail::apply_all(f, kind, x.cardinality, x.values, x.words);
+      x.kind = static_cast<container_kind>(kind);
+      return result;
+    }
+  };
+
+  roaring_bitmap() = default;
+
+  explicit roaring_bitmap(size_type n, bool bit = false);
+
+  // -- inspectors -----------------------------------------------------------
+
+  [[nodiscard]] bool empty() const;
+
+  [[nodiscard]] size_type size() const;
+
+  [[nodiscard]] size_t memusage() const;
+
+  /// Accesses the *i*-th bit in logarithmic time.
+  /// @param i The index into the bitmap.
+  /// @returns `true` iff bit *i* is 1.
+  /// @pre `i < size()`
+  bool operator[](size_type i) const;
+
+  // -- modifiers ------------------------------------------------------------
+
+  void append_bit(bool bit);
+
+  void append_bits(bool bit, size_type n);
+
+  void append_block(block_type bits, size_type n = word_type::width);
+
+  void flip();
+
+  // -- bitwise operations ---------------------------------------------------
+
+  roaring_bitmap& operator&=(const roaring_bitmap& other);
+
+  roaring_bitmap& operator|=(const roaring_bitmap& other);
+
+  /// Computes the bitwise AND of two Roaring bitmaps container by container.
+  friend roaring_bitmap
+  binary_and(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+  /// Computes the bitwise OR of two Roaring bitmaps container by container.
+  friend roaring_bitmap
+  binary_or(const roaring_bitmap& lhs, const roaring_bitmap& rhs);
+
+  // -- concepts -------------------------------------------------------------
+
+  friend bool operator==(const roaring_bitmap& x, const roaring_bitmap& y);
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, roaring_bitmap& bm) {
+    return detail::apply_all(f, bm.keys_, bm.containers_, bm.num_bits_);
+  }
+
+  friend auto
+  pack(flatbuffers::FlatBufferBuilder& builder, const roaring_bitmap& from)
+    -> flatbuffers::Offset<fbs::bitmap::RoaringBitmap>;
+
+  friend auto unpack(const fbs::bitmap::RoaringBitmap& from, roaring_bitmap& to)
+    -> caf::error;
+
+private:
+  /// Sets all bits in *[first, last)* to 1.
+  /// @pre `first >= size()`
+  void add_range(size_type first, size_type last);
+
+  /// The chunk index of every container, in ascending order.
+  std::vector<size_type> keys_ = {};
+
+  /// The containers, in the same order as their keys.
+  std::vector<container> containers_ = {};
+
+  size_type num_bits_ = 0;
+};
+
+class roaring_bitmap_range
+  : public bit_range_base<roaring_bitmap_range, roaring_bitmap::block_type> {
+public:
+  using word_type = roaring_bitmap::word_type;
+
+  roaring_bitmap_range() = default;
+
+  explicit roaring_bitmap_range(const roaring_bitmap& bm);
+
+  void next();
+  [[nodiscard]] bool done() const;
+
+private:
+  void scan();
+
+  const roaring_bitmap* bm_ = nullptr;
+  roaring_bitmap::size_type position_ = 0;
+  size_t container_ = 0;
+  size_t materialized_ = -1;
+  std::vector<roaring_bitmap::block_type> words_ = {};
+};
+
+roaring_bitmap_range bit_range(const roaring_bitmap& bm);
+
+} // namespace vast
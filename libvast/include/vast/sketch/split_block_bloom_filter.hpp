@@ -0,0 +1,146 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// This Bloom filter divides its bits into blocks of 256 bits, each consisting
+// of eight 32-bit words. The upper half of a digest selects a block, and the
+// lower half sets or tests exactly one bit in every word of the block, as
+// described by Putze et al., "Cache-, Hash- and Space-Efficient Bloom
+// Filters" (2007), and as used by Apache Parquet and Apache Impala.
+//
+// Compared to the Bloom filter that remixes a digest k times over one flat bit
+// array, every probe touches a single cache line, and the eight bit positions
+// of a probe only depend on the digest, so they can be computed with a single
+// SIMD multiplication and shift, and reused across filters.
+//
+#pragma once
+
+#include "vast/chunk.hpp"
+#include "vast/sketch/bloom_filter_config.hpp"
+
+#include <caf/expected.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace vast::sketch {
+
+class frozen_split_block_bloom_filter;
+
+/// The number of bits per block of a split-block Bloom filter.
+inline constexpr size_t split_block_bits = 256;
+
+/// The number of 32-bit words per block of a split-block Bloom filter. This is
+/// also the number of bits that every digest sets, i.e., the parameter *k*.
+inline constexpr size_t split_block_words = 8;
+
+/// Computes the false-positive probability of a split-block Bloom filter.
+/// @param n The number of distinct digests in the filter.
+/// @param num_blocks The number of blocks of the filter.
+double split_block_false_positive_rate(uint64_t n, uint64_t num_blocks);
+
+/// A mutable split-block Bloom filter.
+class split_block_bloom_filter {
+public:
+  /// Constructs a split-block Bloom filter from a configuration, which must
+  /// specify either *n* and *p*, or *m* and *n*. The number of bits *m* is
+  /// rounded up to a multiple of the block size, and *k* must be 8 if given.
+  /// @param *cfg* The desired Bloom filter configuration.
+  /// @returns The Bloom filter for *cfg* iff the parameterization is valid.
+  static caf::expected<split_block_bloom_filter> make(bloom_filter_config cfg);
+
+  /// Default-constructs an empty filter that contains no digests.
+  split_block_bloom_filter() noexcept;
+
+  /// Adds a hash digest to the Bloom filter.
+  /// @param digest The digest to add.
+  void add(uint64_t digest) noexcept;
+
+  /// Test whether a hash digest is in the Bloom filter.
+  /// @param digest The digest to test.
+  /// @returns `false` if the *digest* is not in the set and `true` if *digest*
+  /// may exist according to the false-positive probability of the filter.
+  bool lookup(uint64_t digest) const noexcept;
+
+  /// Retrieves the parameters of the filter.
+  const bloom_filter_params& parameters() const noexcept;
+
+  /// Retrieves the underlying blocks.
+  std::span<const uint32_t> blocks() const noexcept;
+
+  // -- concepts --------------------------------------------------------------
+
+  friend bool operator==(const split_block_bloom_filter& x,
+                         const split_block_bloom_filter& y) noexcept;
+
+  friend size_t mem_usage(const split_block_bloom_filter& x);
+
+  friend caf::expected<frozen_split_block_bloom_filter>
+  freeze(const split_block_bloom_filter& x);
+
+  template <class Inspector>
+  friend auto inspect(Inspector& f, split_block_bloom_filter& x) {
+    return f.object(x)
+      .pretty_name("vast.sketch.split-block-bloom-filter")
+      .fields(f.field("m", x.params_.m), f.field("n", x.params_.n),
+              f.field("k", x.params_.k), f.field("p", x.params_.p),
+              f.field("blocks", x.blocks_));
+  }
+
+private:
+  explicit split_block_bloom_filter(bloom_filter_params params);
+
+  bloom_filter_params params_;
+  std::vector<uint32_t> blocks_;
+};
+
+/// An immutable split-block Bloom filter wrapped in a contiguous chunk of
+/// memory.
+class frozen_split_block_bloom_filter {
+public:
+  /// Constructs a frozen split-block Bloom filter from a flatbuffer.
+  /// @pre *table* must be a valid split-block Bloom filter flatbuffer.
+  explicit frozen_split_block_bloom_filter(chunk_ptr table) noexcept;
+
+  /// Test whether a hash digest is in the Bloom filter.
+  /// @param digest The digest to test.
+  /// @returns `false` if the *digest* is not in the set and `true` if *digest*
+  /// may exist according to the false-positive probability of the filter.
+  bool lookup(uint64_t digest) const noexcept;
+
+  /// Retrieves the parameters of the filter.
+  const bloom_filter_params& parameters() const noexcept;
+
+  /// Retrieves the underlying blocks.
+  std::span<const uint32_t> blocks() const noexcept;
+
+  // -- concepts --------------------------------------------------------------
+
+  friend size_t mem_usage(const frozen_split_block_bloom_filter& x) noexcept;
+
+private:
+  bloom_filter_params params_;
+  std::span<const uint32_t> blocks_;
+  chunk_ptr table_;
+};
+
+/// Tests whether a hash digest may be in each of a sequence of split-block
+/// Bloom filters. This computes the bits to test only once, and then probes
+/// one block per filter in a tight loop, which makes it considerably faster
+/// than testing the filters one by one.
+/// @param digest The digest to test.
+/// @param filters The blocks of the filters to test, as returned by
+/// `blocks()`. Empty filters never contain the digest.
+/// @param result The per-filter result; entries of filters that may contain
+/// *digest* are set to 1, other entries are left untouched.
+/// @pre `filters.size() == result.size()`
+void lookup(uint64_t digest, std::span<const std::span<const uint32_t>> filters,
+            std::span<uint8_t> result) noexcept;
+
+} // namespace vast::sketch
@@ -0,0 +1,69 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/bloom_filter_parameters.hpp"
+#include "vast/sketch/split_block_bloom_filter.hpp"
+#include "vast/synopsis.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+namespace vast {
+
+/// A string synopsis backed by a split-block Bloom filter over the digests of
+/// the strings. Unlike the `string_synopsis`, which hashes the looked up value
+/// once per partition, the digest only depends on the value, which allows for
+/// probing the synopses of many partitions at once.
+class split_block_string_synopsis final : public synopsis {
+public:
+  /// The attribute of the type of the synopsis that distinguishes it from a
+  /// `string_synopsis` when deserializing.
+  static constexpr auto layout_attribute = "synopsis-layout";
+
+  /// The value of the layout attribute.
+  static constexpr auto layout = std::string_view{"split-block"};
+
+  split_block_string_synopsis(vast::type x,
+                              sketch::split_block_bloom_filter filter);
+
+  /// Computes the digest of a string that the synopsis stores.
+  static uint64_t digest(std::string_view x) noexcept;
+
+  [[nodiscard]] synopsis_ptr clone() const override;
+
+  void add(data_view x) override;
+
+  [[nodiscard]] std::optional<bool>
+  lookup(relational_operator op, data_view rhs) const override;
+
+  [[nodiscard]] bool equals(const synopsis& other) const noexcept override;
+
+  [[nodiscard]] size_t memusage() const override;
+
+  bool inspect_impl(supported_inspectors& inspector) override;
+
+  /// Retrieves the underlying Bloom filter.
+  [[nodiscard]] const sketch::split_block_bloom_filter& filter() const noexcept;
+
+private:
+  sketch::split_block_bloom_filter filter_;
+};
+
+/// Checks whether a string type denotes a split-block string synopsis.
+bool has_split_block_layout(const type& type);
+
+/// Constructs a split-block string synopsis.
+/// @param type A string type, annotated with the Bloom filter parameters.
+/// @param params The Bloom filter parameters, which must specify *n* and *p*.
+/// @returns The synopsis, or `nullptr` if the parameters are invalid.
+synopsis_ptr make_split_block_string_synopsis(vast::type type,
+                                              bloom_filter_parameters params);
+
+} // namespace vast
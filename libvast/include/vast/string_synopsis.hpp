@@ -16,6 +16,7 @@
 #include "vast/detail/assert.hpp"
 #include "vast/error.hpp"
 #include "vast/logger.hpp"
+#include "vast/split_block_string_synopsis.hpp"
 
 #include <caf/config_value.hpp>
 #include <caf/settings.hpp>
@@ -59,9 +60,8 @@ template <>
 struct buffered_synopsis_traits<std::string> {
   template <typename HashFunction>
   static synopsis_ptr make(vast::type type, bloom_filter_parameters p,
-                           std::vector<size_t> seeds = {}) {
-    return make_string_synopsis<HashFunction>(std::move(type), std::move(p),
-                                              std::move(seeds));
+                           std::vector<size_t> = {}) {
+    return make_split_block_string_synopsis(std::move(type), std::move(p));
   }
 
   static size_t memusage(const std::unordered_set<std::string>& x) {
@@ -126,8 +126,11 @@ make_buffered_string_synopsis(vast::type type, bloom_filter_parameters params) {
 template <class HashFunction>
 synopsis_ptr make_string_synopsis(vast::type type, const caf::settings& opts) {
   VAST_ASSERT(caf::holds_alternative<string_type>(type));
-  if (auto xs = parse_parameters(type))
+  if (auto xs = parse_parameters(type)) {
+    if (has_split_block_layout(type))
+      return make_split_block_string_synopsis(std::move(type), std::move(*xs));
     return make_string_synopsis<HashFunction>(std::move(type), std::move(*xs));
+  }
   // If no explicit Bloom filter parameters were attached to the type, we try
   // to use the maximum partition size of the index as upper bound for the
   // expected number of events.
@@ -143,13 +146,13 @@ synopsis_ptr make_string_synopsis(vast::type type, const caf::settings& opts) {
   params.p
     = caf::get_or(opts, "string-synopsis-fp-rate", defaults::system::fp_rate);
   auto annotated_type = annotate_parameters(type, params);
-  // Create either a a buffered_string_synopsis or a plain string synopsis
+  // Create either a a buffered_string_synopsis or a split-block string synopsis
   // depending on the callers preference.
   auto buffered = caf::get_or(opts, "buffer-input-data", false);
   auto result
     = buffered
         ? make_buffered_string_synopsis<HashFunction>(std::move(type), params)
-        : make_string_synopsis<HashFunction>(std::move(annotated_type), params);
+        : make_split_block_string_synopsis(std::move(annotated_type), params);
   if (!result)
     VAST_ERROR("{} failed to evaluate Bloom filter parameters: {} {}", __func__,
                params.n, params.p);
@@ -34,6 +34,32 @@ namespace vast {
 /// @relates synopsis
 using synopsis_ptr = std::unique_ptr<synopsis>;
 
+/// The result of an exact synopsis lookup, describing how many of the values
+/// added to a synopsis satisfy a predicate.
+enum class synopsis_match : uint8_t {
+  /// No value satisfies the predicate.
+  none,
+  /// Some values may satisfy the predicate.
+  maybe,
+  /// All values satisfy the predicate.
+  all,
+};
+
+/// Negates the result of an exact synopsis lookup, i.e., turns the result for
+/// a predicate into the result for its negation.
+/// @relates synopsis_match
+constexpr synopsis_match negate(synopsis_match x) noexcept {
+  switch (x) {
+    case synopsis_match::none:
+      return synopsis_match::all;
+    case synopsis_match::maybe:
+      return synopsis_match::maybe;
+    case synopsis_match::all:
+      return synopsis_match::none;
+  }
+  __builtin_unreachable();
+}
+
 /// The abstract base class for synopsis data structures.
 class synopsis {
 public:
@@ -69,6 +95,20 @@ public:
   [[nodiscard]] virtual std::optional<bool>
   lookup(relational_operator op, data_view rhs) const = 0;
 
+  /// Tests how many values satisfy a predicate. Unlike `lookup`, this
+  /// distinguishes a predicate that holds for all values from one that may
+  /// hold for some, which is what allows for pruning with negated predicates.
+  /// Only synopses that are exact about the values they contain can ever
+  /// return `synopsis_match::all`; the default implementation never does.
+  /// Synopses never see null values, so `synopsis_match::all` only describes
+  /// the non-null values, and callers must account for nulls separately.
+  /// @param op The operator of the predicate.
+  /// @param rhs The RHS of the predicate.
+  /// @pre: The query has already been type-checked.
+  /// @returns Whether none, some, or all values satisfy `*this op rhs`.
+  [[nodiscard]] virtual synopsis_match
+  exact_lookup(relational_operator op, data_view rhs) const;
+
   /// @returns A best-effort estimate of the size (in bytes) of this synopsis.
   [[nodiscard]] virtual size_t memusage() const = 0;
 
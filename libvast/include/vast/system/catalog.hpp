@@ -14,6 +14,7 @@
 #include "vast/detail/heterogeneous_string_hash.hpp"
 #include "vast/detail/inspection_common.hpp"
 #include "vast/expression.hpp"
+#include "vast/field_synopsis_index.hpp"
 #include "vast/module.hpp"
 #include "vast/partition_synopsis.hpp"
 #include "vast/system/actors.hpp"
@@ -109,8 +110,15 @@ public:
   [[nodiscard]] caf::expected<catalog_lookup_result>
   lookup(const expression& expr) const;
 
+  /// Retrieves the list of candidate partition IDs of a given schema.
+  /// @param expr The expression to lookup.
+  /// @param schema The schema of the partitions to consider.
+  /// @param candidates If set, restricts the lookup to these partitions.
+  /// @returns The candidate partitions, sorted by their ID.
+  /// @pre *candidates* must be sorted and have the schema *schema*.
   [[nodiscard]] catalog_lookup_result::candidate_info
-  lookup_impl(const expression& expr, const type& schema) const;
+  lookup_impl(const expression& expr, const type& schema,
+              const std::vector<partition_info>* candidates = nullptr) const;
 
   /// @returns A best-effort estimate of the amount of memory used for this
   /// catalog (in bytes).
@@ -152,6 +160,11 @@ public:
   std::unordered_map<vast::type, detail::flat_map<uuid, partition_synopsis_ptr>>
     synopses_per_type = {};
 
+  /// For each type, a field-major index over the synopses in
+  /// `synopses_per_type`, with partitions in the same order.
+  std::unordered_map<vast::type, field_synopsis_index> field_synopses_per_type
+    = {};
+
   /// The set of fields that should not be touched by the pruner.
   detail::heterogeneous_string_hashset unprunable_fields;
 
@@ -78,6 +78,15 @@ struct evaluator_state {
   static inline const char* name = "evaluator";
 };
 
+/// Combines the hits of the predicates of an expression by resolving its
+/// conjunctions, disjunctions, and negations.
+/// @param expr The expression.
+/// @param predicate_hits The hits per predicate, keyed by the offset of the
+/// predicate in *expr*.
+ids evaluate_predicate_hits(
+  const expression& expr,
+  const evaluator_state::predicate_hits_map& predicate_hits);
+
 /// Wraps a query expression in an actor. Upon receiving hits from INDEXER
 /// actors, re-evaluates the expression and relays new hits to the INDEX CLIENT.
 /// @pre `!eval.empty()`
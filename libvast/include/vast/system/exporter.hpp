@@ -24,10 +24,13 @@
 #include <caf/scheduled_actor.hpp>
 #include <caf/typed_event_based_actor.hpp>
 
+#include <memory>
 #include <queue>
 
 namespace vast::system {
 
+struct exporter_partial_phase;
+
 struct exporter_state {
   /// -- constructor -----------------------------------------------------------
 
@@ -84,6 +87,11 @@ struct exporter_state {
   /// The executor for the pipeline of this exporter.
   generator<caf::expected<void>> executor = {};
 
+  /// Runs the partial phase of the first operator of the pipeline for the
+  /// results of every batch of partitions, if the pipeline starts with an
+  /// operator that can be split into a partial and a final phase.
+  std::shared_ptr<exporter_partial_phase> partial_phase = {};
+
   /// The textual representation of this pipeline.
   std::string pipeline_str = {};
 };
@@ -142,6 +142,35 @@ struct index_counters {
   size_t partition_scheduled = 0;
 };
 
+/// Adapts the number of concurrent partition lookups to the observed latency
+/// of lookups. Lookups on partitions that must first be loaded from disk spend
+/// most of their time waiting for I/O, so the index can run more of them at
+/// once than there are CPU cores without oversubscribing the CPU.
+struct lookup_concurrency {
+  /// Records the latency of a partition lookup.
+  /// @param latency The time between sending a query to a partition and
+  /// receiving the response.
+  /// @param materialized Whether the partition was loaded from disk for the
+  /// lookup.
+  void record(duration latency, bool materialized);
+
+  /// Computes the number of lookups to run concurrently.
+  /// @param parallelism The number of lookups that can use the CPU at the same
+  /// time.
+  /// @param max The configured maximum number of concurrent lookups.
+  /// @returns *max* until the first lookups finished, and otherwise the number
+  /// of lookups that keep all cores busy, clamped to `[1, max]`.
+  [[nodiscard]] size_t limit(size_t parallelism, size_t max) const;
+
+  /// Moving averages of the lookup latencies for partitions that were loaded
+  /// from disk and for partitions that were already in memory, in seconds.
+  double materialized_latency = 0.0;
+  double cached_latency = 0.0;
+
+  /// Moving average of the fraction of lookups that loaded a partition.
+  double materialized_fraction = 0.0;
+};
+
 /// The state of the index actor.
 struct index_state {
   // -- type aliases -----------------------------------------------------------
@@ -304,6 +333,11 @@ struct index_state {
   /// lookups.
   size_t running_partition_lookups = 0;
 
+  /// Adapts the number of partitions serving lookups at the same time to the
+  /// observed I/O and CPU time per lookup, never exceeding
+  /// `max_concurrent_partition_lookups`.
+  lookup_concurrency partition_lookup_concurrency = {};
+
   /// Keeps temporary statistics that are flushed with the metrics.
   index_counters counters = {};
 
@@ -26,6 +26,7 @@
 #include <caf/typed_event_based_actor.hpp>
 
 #include <filesystem>
+#include <optional>
 #include <span>
 #include <unordered_map>
 #include <vector>
@@ -50,6 +51,18 @@ struct passive_partition_state {
 
   indexer_actor indexer_at(size_t position) const;
 
+  /// Gets the value index at a certain position, deserializing it on first
+  /// access.
+  /// @returns A pointer to the value index, or `nullptr` if it is missing or
+  /// cannot be deserialized.
+  const value_index* value_index_at(size_t position) const;
+
+  /// Evaluates an expression directly against the value indexes of the
+  /// partition, without spawning INDEXER actors.
+  /// @returns The candidate IDs for the expression, or `std::nullopt` if the
+  /// expression does not apply to the partition.
+  std::optional<ids> lookup(const expression& expr) const;
+
   const std::optional<vast::record_type>& combined_schema() const;
 
   const std::unordered_map<std::string, ids>& type_ids() const;
@@ -114,6 +127,14 @@ struct passive_partition_state {
   /// Maps qualified fields to indexer actors. This is mutable since
   /// indexers are spawned lazily on first access.
   mutable std::vector<indexer_actor> indexers = {};
+
+  /// Evaluate queries with `lookup` instead of spawning INDEXER actors.
+  bool synchronous_evaluation = false;
+
+  /// The value indexes used for synchronous evaluation, at the same positions
+  /// as the `indexers`. This is mutable since value indexes are deserialized
+  /// lazily on first access.
+  mutable std::vector<value_index_ptr> value_indexes = {};
 };
 
 // -- flatbuffers --------------------------------------------------------------
@@ -145,9 +166,11 @@ struct partition_chunk {
 /// @param accountant the accountant to send metrics to.
 /// @param filesystem The actor handle of the filesystem actor.
 /// @param path The path where the partition flatbuffer can be found.
+/// @param synchronous_evaluation Whether to evaluate queries directly against
+/// the value indexes instead of spawning one INDEXER actor per field.
 partition_actor::behavior_type passive_partition(
   partition_actor::stateful_pointer<passive_partition_state> self, uuid id,
   accountant_actor accountant, filesystem_actor filesystem,
-  const std::filesystem::path& path);
+  const std::filesystem::path& path, bool synchronous_evaluation);
 
 } // namespace vast::system
@@ -0,0 +1,81 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/fwd.hpp"
+
+#include "vast/fused_operator.hpp"
+#include "vast/pipeline.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace vast {
+
+/// Statistics about the work of an operator, which all instances of the
+/// operator update concurrently.
+struct operator_timings {
+  /// The time that the operator spent on its own, i.e., excluding the time
+  /// it waited for its input, summed up over all instances.
+  std::atomic<int64_t> busy_nanoseconds = 0;
+
+  /// The number of non-empty batches that the operator received.
+  std::atomic<uint64_t> inputs = 0;
+
+  /// The number of non-empty batches that the operator produced.
+  std::atomic<uint64_t> outputs = 0;
+
+  /// @returns The time that the operator spent on its own.
+  [[nodiscard]] auto busy() const -> std::chrono::nanoseconds {
+    return std::chrono::nanoseconds{busy_nanoseconds.load()};
+  }
+};
+
+/// Measures the time that an operator spends, and otherwise behaves like the
+/// operator itself. Copies of a timed operator share their statistics.
+///
+/// A timed operator is fusable if the wrapped operator is. Within a fused
+/// chain, it measures only the step of the wrapped operator, so that every
+/// operator of the chain keeps its own statistics.
+class timed_operator final : public operator_base, public fusable_operator {
+public:
+  /// Constructs a timed operator.
+  /// @param op The operator to measure.
+  /// @param timings The statistics to update.
+  timed_operator(operator_ptr op, std::shared_ptr<operator_timings> timings);
+
+  auto instantiate(operator_input input, operator_control_plane& ctrl) const
+    -> caf::expected<operator_output> override;
+
+  auto copy() const -> operator_ptr override;
+
+  auto to_string() const -> std::string override;
+
+  auto location() const -> operator_location override;
+
+  auto detached() const -> bool override;
+
+  auto parallelism() const -> operator_parallelism override;
+
+  auto infer_type_impl(operator_type input) const
+    -> caf::expected<operator_type> override;
+
+  auto fuse(const type& schema, operator_control_plane& ctrl) const
+    -> caf::expected<fused_step> override;
+
+  auto fusable() const -> bool override;
+
+private:
+  operator_ptr op_;
+  std::shared_ptr<operator_timings> timings_;
+};
+
+} // namespace vast
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "vast/chunk.hpp"
+#include "vast/detail/delimiter_scanner.hpp"
 #include "vast/generator.hpp"
 
 namespace vast {
@@ -18,6 +19,7 @@ namespace vast {
 /// empty line is translated into an empty string view.
 inline auto to_lines(generator<chunk_ptr> input)
   -> generator<std::optional<std::string_view>> {
+  const auto scanner = detail::delimiter_scanner{'\n', '\r'};
   auto buffer = std::string{};
   bool ended_on_linefeed = false;
   for (auto&& chunk : input) {
@@ -31,8 +33,14 @@ inline auto to_lines(generator<chunk_ptr> input)
       ++begin;
     };
     ended_on_linefeed = false;
-    for (const auto* current = begin; current != end; ++current) {
-      if (*current != '\n' && *current != '\r') {
+    const auto* const first = begin;
+    auto cursor = detail::delimiter_cursor{
+      scanner, std::string_view{first, static_cast<size_t>(end - first)}};
+    for (auto pos = cursor.next(); pos != detail::delimiter_cursor::npos;
+         pos = cursor.next()) {
+      const auto* current = first + pos;
+      // Skip the linefeed of a CRLF sequence that we already consumed.
+      if (current < begin) {
         continue;
       }
       if (buffer.empty()) {
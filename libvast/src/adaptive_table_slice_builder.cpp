@@ -10,9 +10,16 @@
 
 #include <arrow/record_batch.h>
 
+#include <algorithm>
+#include <atomic>
+
 namespace vast {
 
 namespace {
+
+std::atomic<uint64_t> total_shape_cache_hits = 0;
+std::atomic<uint64_t> total_shape_cache_misses = 0;
+
 auto init_root_builder(const type& start_schema, bool allow_fields_discovery)
   -> std::variant<detail::concrete_series_builder<record_type>,
                   detail::fixed_fields_record_builder> {
@@ -36,6 +43,10 @@ auto adaptive_table_slice_builder::push_row() -> row_guard {
 
 auto adaptive_table_slice_builder::finish(std::string_view slice_schema_name)
   -> table_slice {
+  const auto metrics = shapes_.take_metrics();
+  total_shape_cache_hits.fetch_add(metrics.hits, std::memory_order_relaxed);
+  total_shape_cache_misses.fetch_add(metrics.misses,
+                                     std::memory_order_relaxed);
   auto final_array = finish_impl();
   if (not final_array)
     return table_slice{};
@@ -57,6 +68,19 @@ auto adaptive_table_slice_builder::rows() const -> detail::arrow_length_type {
     root_builder_);
 }
 
+auto adaptive_table_slice_builder::shape_cache_metrics() const
+  -> vast::shape_cache_metrics {
+  return shapes_.metrics();
+}
+
+auto adaptive_table_slice_builder::total_shape_cache_metrics()
+  -> vast::shape_cache_metrics {
+  return {
+    .hits = total_shape_cache_hits.load(std::memory_order_relaxed),
+    .misses = total_shape_cache_misses.load(std::memory_order_relaxed),
+  };
+}
+
 auto adaptive_table_slice_builder::get_schema(
   std::string_view slice_schema_name) const -> type {
   return std::visit(
@@ -81,6 +105,7 @@ auto adaptive_table_slice_builder::finish_impl()
 adaptive_table_slice_builder::row_guard::row_guard(
   adaptive_table_slice_builder& builder)
   : builder_{builder}, starting_rows_count_{builder_.rows()} {
+  builder_.shapes_.begin_row();
 }
 
 auto adaptive_table_slice_builder::row_guard::cancel() -> void {
@@ -96,6 +121,8 @@ auto adaptive_table_slice_builder::row_guard::cancel() -> void {
 
 auto adaptive_table_slice_builder::row_guard::push_field(
   std::string_view field_name) -> detail::field_guard {
+  if (auto* cached = builder_.shapes_.next(field_name))
+    return {detail::builder_provider{std::ref(*cached)}, starting_rows_count_};
   auto provider
     = std::visit(detail::overload{
                    [field_name](detail::fixed_fields_record_builder& b) {
@@ -107,11 +134,14 @@ auto adaptive_table_slice_builder::row_guard::push_field(
                    },
                  },
                  builder_.root_builder_);
-
+  builder_.shapes_.record(field_name, provider.is_builder_constructed()
+                                        ? std::addressof(provider.provide())
+                                        : nullptr);
   return {std::move(provider), starting_rows_count_};
 }
 
 adaptive_table_slice_builder::row_guard::~row_guard() noexcept {
+  builder_.shapes_.end_row();
   std::visit(
     [](auto& b) {
       b.fill_nulls();
@@ -119,4 +149,88 @@ adaptive_table_slice_builder::row_guard::~row_guard() noexcept {
     builder_.root_builder_);
 }
 
+auto adaptive_table_slice_builder::shape_cache::begin_row() -> void {
+  current_ = shapes_.empty() ? no_shape : 0;
+  position_ = 0;
+  pending_.clear();
+  diverged_ = shapes_.empty();
+}
+
+auto adaptive_table_slice_builder::shape_cache::next(std::string_view name)
+  -> detail::series_builder* {
+  if (diverged_)
+    return nullptr;
+  const auto matches = [&](const shape& candidate) {
+    return position_ < candidate.size() && candidate[position_].name == name;
+  };
+  if (not matches(shapes_[current_])) {
+    // Look for another shape that has the same fields so far.
+    const auto& fields = shapes_[current_];
+    const auto it
+      = std::find_if(shapes_.begin(), shapes_.end(), [&](const shape& other) {
+          return matches(other)
+                 && std::equal(fields.begin(), fields.begin() + position_,
+                               other.begin(), [](const auto& x, const auto& y) {
+                                 return x.name == y.name;
+                               });
+        });
+    if (it == shapes_.end()) {
+      pending_.assign(fields.begin(), fields.begin() + position_);
+      diverged_ = true;
+      return nullptr;
+    }
+    current_ = static_cast<size_t>(it - shapes_.begin());
+  }
+  // A field may have no series builder yet when the cached row had no value
+  // for it. We leave it to the caller to look it up then.
+  auto* builder = shapes_[current_][position_].builder;
+  if (builder)
+    ++position_;
+  return builder;
+}
+
+auto adaptive_table_slice_builder::shape_cache::record(
+  std::string_view name, detail::series_builder* builder) -> void {
+  if (diverged_) {
+    pending_.push_back({std::string{name}, builder});
+    return;
+  }
+  auto& cached = shapes_[current_][position_++];
+  VAST_ASSERT(cached.name == name);
+  cached.builder = builder;
+}
+
+auto adaptive_table_slice_builder::shape_cache::end_row() -> void {
+  if (not diverged_) {
+    if (position_ > 0) {
+      ++metrics_.hits;
+      std::rotate(shapes_.begin(), shapes_.begin() + current_,
+                  shapes_.begin() + current_ + 1);
+    }
+    return;
+  }
+  if (pending_.empty())
+    return;
+  ++metrics_.misses;
+  if (shapes_.size() == shape_cache_capacity)
+    shapes_.pop_back();
+  shapes_.insert(shapes_.begin(), std::move(pending_));
+  pending_ = {};
+}
+
+auto adaptive_table_slice_builder::shape_cache::metrics() const
+  -> vast::shape_cache_metrics {
+  return metrics_;
+}
+
+auto adaptive_table_slice_builder::shape_cache::take_metrics()
+  -> vast::shape_cache_metrics {
+  auto result = vast::shape_cache_metrics{
+    .hits = metrics_.hits - reported_.hits,
+    .misses = metrics_.misses - reported_.misses,
+  };
+  reported_ = metrics_;
+  return result;
+}
+
 } // namespace vast
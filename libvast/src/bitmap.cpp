@@ -86,7 +86,17 @@ const bitmap::variant& bitmap::get_data() const {
 }
 
 bool operator==(const bitmap& x, const bitmap& y) {
-  return x.bitmap_ == y.bitmap_;
+  if (x.bitmap_.index() == y.bitmap_.index())
+    return x.bitmap_ == y.bitmap_;
+  // Bitmaps with different encodings are equal if they have the same bits.
+  if (x.size() != y.size())
+    return false;
+  auto xs = select(x);
+  auto ys = select(y);
+  for (; !xs.done() && !ys.done(); xs.next(), ys.next())
+    if (xs.get() != ys.get())
+      return false;
+  return xs.done() && ys.done();
 }
 
 auto pack(flatbuffers::FlatBufferBuilder& builder, const bitmap& from)
@@ -107,6 +117,11 @@ auto pack(flatbuffers::FlatBufferBuilder& builder, const bitmap& from)
       return fbs::CreateBitmap(builder, fbs::bitmap::Bitmap::wah,
                                wah_offset.Union());
     },
+    [&](const roaring_bitmap& roaring) {
+      const auto roaring_offset = pack(builder, roaring).Union();
+      return fbs::CreateBitmap(builder, fbs::bitmap::Bitmap::roaring,
+                               roaring_offset.Union());
+    },
   };
   return caf::visit(f, from.bitmap_);
 }
@@ -128,6 +143,8 @@ auto unpack(const fbs::Bitmap& from, bitmap& to) -> caf::error {
       return do_unpack(*from.bitmap_as_null(), null_bitmap{});
     case fbs::bitmap::Bitmap::wah:
       return do_unpack(*from.bitmap_as_wah(), wah_bitmap{});
+    case fbs::bitmap::Bitmap::roaring:
+      return do_unpack(*from.bitmap_as_roaring(), roaring_bitmap{});
   }
   __builtin_unreachable();
 }
@@ -162,4 +179,42 @@ bitmap_bit_range bit_range(const bitmap& bm) {
   return bitmap_bit_range{bm};
 }
 
+namespace {
+
+/// Converts a bitmap into a Roaring bitmap, unless it already is one.
+const roaring_bitmap& as_roaring(const bitmap& bm, roaring_bitmap& buffer) {
+  if (const auto* roaring = caf::get_if<roaring_bitmap>(&bm))
+    return *roaring;
+  buffer.append(bm);
+  return buffer;
+}
+
+} // namespace
+
+bitmap binary_and(const bitmap& lhs, const bitmap& rhs) {
+  if (caf::holds_alternative<roaring_bitmap>(lhs)
+      || caf::holds_alternative<roaring_bitmap>(rhs)) {
+    auto lhs_buffer = roaring_bitmap{};
+    auto rhs_buffer = roaring_bitmap{};
+    return binary_and(as_roaring(lhs, lhs_buffer), as_roaring(rhs, rhs_buffer));
+  }
+  auto op = [](auto x, auto y) {
+    return x & y;
+  };
+  return binary_eval<false, false>(lhs, rhs, op);
+}
+
+bitmap binary_or(const bitmap& lhs, const bitmap& rhs) {
+  if (caf::holds_alternative<roaring_bitmap>(lhs)
+      || caf::holds_alternative<roaring_bitmap>(rhs)) {
+    auto lhs_buffer = roaring_bitmap{};
+    auto rhs_buffer = roaring_bitmap{};
+    return binary_or(as_roaring(lhs, lhs_buffer), as_roaring(rhs, rhs_buffer));
+  }
+  auto op = [](auto x, auto y) {
+    return x | y;
+  };
+  return binary_eval<true, true>(lhs, rhs, op);
+}
+
 } // namespace vast
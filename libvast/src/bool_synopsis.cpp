@@ -47,6 +47,24 @@ bool_synopsis::lookup(relational_operator op, data_view rhs) const {
   return {};
 }
 
+synopsis_match
+bool_synopsis::exact_lookup(relational_operator op, data_view rhs) const {
+  if (auto b = caf::get_if<view<bool>>(&rhs)) {
+    const auto any = *b ? true_ : false_;
+    const auto any_other = *b ? false_ : true_;
+    auto result = synopsis_match::maybe;
+    if (!any)
+      result = synopsis_match::none;
+    else if (!any_other)
+      result = synopsis_match::all;
+    if (op == relational_operator::equal)
+      return result;
+    if (op == relational_operator::not_equal)
+      return any || any_other ? negate(result) : synopsis_match::none;
+  }
+  return synopsis_match::maybe;
+}
+
 bool bool_synopsis::equals(const synopsis& other) const noexcept {
   if (typeid(other) != typeid(bool_synopsis))
     return false;
@@ -0,0 +1,237 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/columnar_json_printer.hpp"
+
+#include "vast/arrow_table_slice.hpp"
+#include "vast/concept/printable/vast/json.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/escapers.hpp"
+#include "vast/detail/narrow.hpp"
+#include "vast/detail/type_traits.hpp"
+#include "vast/die.hpp"
+#include "vast/table_slice.hpp"
+
+#include <arrow/array.h>
+#include <arrow/record_batch.h>
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace vast {
+
+namespace {
+
+/// Returns whether a character changes when escaping it with
+/// `detail::json_escaper`.
+constexpr auto needs_escaping(char c) -> bool {
+  const auto x = static_cast<unsigned char>(c);
+  return x < 0x20 || x == '"' || x == '\\' || x == 0x7f;
+}
+
+/// Returns the position of the first character in a string that needs
+/// escaping, or the size of the string if there is none. Strings rarely need
+/// escaping, so we test eight characters at a time.
+auto find_escape(std::string_view str) -> size_t {
+  constexpr auto ones = ~uint64_t{0} / 255;
+  constexpr auto high_bits = ones * 0x80;
+  // Sets the high bit of a byte if a byte is zero, and never if none is.
+  const auto has_zero = [&](uint64_t word) {
+    return (word - ones) & ~word & high_bits;
+  };
+  auto pos = size_t{0};
+  for (; pos + sizeof(uint64_t) <= str.size(); pos += sizeof(uint64_t)) {
+    auto word = uint64_t{};
+    std::memcpy(&word, str.data() + pos, sizeof(word));
+    const auto control = (word - ones * 0x20) & ~word & high_bits;
+    if (control != 0 || has_zero(word ^ (ones * '"')) != 0
+        || has_zero(word ^ (ones * '\\')) != 0
+        || has_zero(word ^ (ones * 0x7f)) != 0)
+      break;
+  }
+  for (; pos < str.size(); ++pos)
+    if (needs_escaping(str[pos]))
+      break;
+  return pos;
+}
+
+/// Appends a string as a quoted and escaped JSON string.
+void append_string(std::string& out, std::string_view str) {
+  out += '"';
+  while (true) {
+    const auto pos = find_escape(str);
+    out.append(str.data(), pos);
+    if (pos == str.size())
+      break;
+    const auto* first = str.data() + pos;
+    detail::json_escaper(first, std::back_inserter(out));
+    str.remove_prefix(first - str.data());
+  }
+  out += '"';
+}
+
+/// The formatted values of a column, one after another.
+struct formatted_column {
+  std::string data = {};
+  std::vector<size_t> offsets = {};
+
+  [[nodiscard]] auto at(size_t row) const -> std::string_view {
+    return std::string_view{data}.substr(offsets[row],
+                                         offsets[row + 1] - offsets[row]);
+  }
+};
+
+auto format_column(const type& type, const arrow::Array& array)
+  -> formatted_column {
+  static const auto printer = json_printer{{.oneline = true}};
+  auto result = formatted_column{};
+  const auto rows = array.length();
+  result.offsets.reserve(detail::narrow_cast<size_t>(rows) + 1);
+  auto out = std::back_inserter(result.data);
+  auto f = [&]<concrete_type Type>(const Type& concrete) {
+    for (int64_t row = 0; row < rows; ++row) {
+      result.offsets.push_back(result.data.size());
+      if (array.IsNull(row)) {
+        result.data += "null";
+        continue;
+      }
+      if constexpr (std::is_same_v<Type, record_type>) {
+        die("records must not be printed as a column");
+      } else if constexpr (detail::is_any_v<Type, int64_type, uint64_type>) {
+        auto digits = std::array<char, 24>{};
+        const auto [end, ec] = std::to_chars(
+          digits.data(), digits.data() + digits.size(),
+          value_at(concrete, array, row));
+        VAST_ASSERT(ec == std::errc{});
+        result.data.append(digits.data(), end);
+      } else if constexpr (std::is_same_v<Type, string_type>) {
+        append_string(result.data, value_at(concrete, array, row));
+      } else if constexpr (std::is_same_v<Type, enumeration_type>) {
+        const auto key = value_at(concrete, array, row);
+        append_string(result.data, concrete.field(key));
+      } else {
+        const auto ok = printer.print(out, value_at(concrete, array, row));
+        VAST_ASSERT_CHEAP(ok);
+      }
+    }
+    result.offsets.push_back(result.data.size());
+  };
+  caf::visit(f, type);
+  return result;
+}
+
+auto column_at(const arrow::RecordBatch& batch, const offset& index)
+  -> std::shared_ptr<arrow::Array> {
+  VAST_ASSERT(!index.empty());
+  auto result = batch.column(detail::narrow_cast<int>(index[0]));
+  for (size_t i = 1; i < index.size(); ++i)
+    result = caf::get<type_to_arrow_array_t<record_type>>(*result).field(
+      detail::narrow_cast<int>(index[i]));
+  return result;
+}
+
+} // namespace
+
+columnar_json_printer::columnar_json_printer(type schema)
+  : schema_{std::move(schema)} {
+  auto pending = std::string{};
+  compile(caf::get<record_type>(schema_), {}, pending);
+  pending += '\n';
+  flush(pending);
+}
+
+auto columnar_json_printer::schema() const -> const type& {
+  return schema_;
+}
+
+void columnar_json_printer::print(const table_slice& slice,
+                                  std::vector<char>& buffer) const {
+  VAST_ASSERT(slice.schema() == schema_);
+  const auto rows = slice.rows();
+  if (rows == 0)
+    return;
+  const auto batch = to_record_batch(slice);
+  auto columns = std::vector<formatted_column>{};
+  columns.reserve(columns_.size());
+  auto size = size_t{0};
+  for (const auto& column : columns_) {
+    columns.push_back(
+      format_column(column.type, *column_at(*batch, column.index)));
+    size += columns.back().data.size();
+  }
+  auto records = std::vector<std::shared_ptr<arrow::Array>>{};
+  records.reserve(records_.size());
+  for (const auto& index : records_)
+    records.push_back(column_at(*batch, index));
+  for (const auto& literal : literals_)
+    size += literal.size() * rows;
+  buffer.reserve(buffer.size() + size);
+  const auto append = [&](std::string_view str) {
+    buffer.insert(buffer.end(), str.begin(), str.end());
+  };
+  for (size_t row = 0; row < rows; ++row) {
+    const auto array_row = detail::narrow_cast<int64_t>(row);
+    for (size_t i = 0; i < program_.size();) {
+      const auto& step = program_[i++];
+      switch (step.kind) {
+        case instruction::kind::literal:
+          append(literals_[step.index]);
+          break;
+        case instruction::kind::column:
+          append(columns[step.index].at(row));
+          break;
+        case instruction::kind::record:
+          if (records[step.index]->IsNull(array_row)) {
+            append("null");
+            i = step.skip;
+          }
+          break;
+      }
+    }
+  }
+}
+
+void columnar_json_printer::compile(const record_type& record,
+                                    const offset& index,
+                                    std::string& pending) {
+  pending += '{';
+  auto field_index = index;
+  field_index.push_back(0);
+  for (const auto& field : record.fields()) {
+    if (field_index.back() > 0)
+      pending += ", ";
+    append_string(pending, field.name);
+    pending += ": ";
+    flush(pending);
+    if (const auto* nested = caf::get_if<record_type>(&field.type)) {
+      const auto step = program_.size();
+      program_.push_back({instruction::kind::record, records_.size(), {}});
+      records_.push_back(field_index);
+      compile(*nested, field_index, pending);
+      flush(pending);
+      program_[step].skip = program_.size();
+    } else {
+      program_.push_back({instruction::kind::column, columns_.size(), {}});
+      columns_.push_back({field.type, field_index});
+    }
+    ++field_index.back();
+  }
+  pending += '}';
+}
+
+void columnar_json_printer::flush(std::string& pending) {
+  if (pending.empty())
+    return;
+  program_.push_back({instruction::kind::literal, literals_.size(), {}});
+  literals_.push_back(std::exchange(pending, {}));
+}
+
+} // namespace vast
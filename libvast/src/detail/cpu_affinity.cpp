@@ -0,0 +1,137 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/detail/cpu_affinity.hpp"
+
+#include "vast/config.hpp"
+#include "vast/error.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <thread>
+
+#if VAST_LINUX
+#  include <cstring>
+#  include <filesystem>
+#  include <fstream>
+#  include <pthread.h>
+#  include <sched.h>
+#  include <string>
+#endif
+
+namespace vast::detail {
+
+namespace {
+
+#if VAST_LINUX
+
+/// Parses a CPU list like "0-3,8,10-11" as used by sysfs.
+std::vector<size_t> parse_cpu_list(const std::string& str) {
+  auto result = std::vector<size_t>{};
+  auto pos = size_t{0};
+  while (pos < str.size()) {
+    auto end = str.find(',', pos);
+    if (end == std::string::npos)
+      end = str.size();
+    const auto range = str.substr(pos, end - pos);
+    pos = end + 1;
+    if (range.empty())
+      continue;
+    try {
+      const auto dash = range.find('-');
+      const auto first = std::stoul(range.substr(0, dash));
+      const auto last
+        = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+      for (auto cpu = first; cpu <= last; ++cpu)
+        result.push_back(cpu);
+    } catch (const std::exception&) {
+      return {};
+    }
+  }
+  return result;
+}
+
+#endif
+
+} // namespace
+
+std::vector<size_t> numa_ordered_cpus() {
+#if VAST_LINUX
+  auto allowed = cpu_set_t{};
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    auto result = std::vector<size_t>{};
+    auto is_allowed = [&](size_t cpu) {
+      return cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed);
+    };
+    auto add = [&](size_t cpu) {
+      if (is_allowed(cpu)
+          && std::find(result.begin(), result.end(), cpu) == result.end())
+        result.push_back(cpu);
+    };
+    // The nodes appear in directory order, which we sort numerically.
+    auto nodes = std::vector<std::pair<size_t, std::filesystem::path>>{};
+    auto err = std::error_code{};
+    for (const auto& entry : std::filesystem::directory_iterator{
+           "/sys/devices/system/node", err}) {
+      const auto name = entry.path().filename().string();
+      if (!name.starts_with("node") || name.size() == 4)
+        continue;
+      try {
+        nodes.emplace_back(std::stoul(name.substr(4)), entry.path());
+      } catch (const std::exception&) {
+        continue;
+      }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    for (const auto& [_, path] : nodes) {
+      auto file = std::ifstream{path / "cpulist"};
+      auto list = std::string{};
+      if (std::getline(file, list))
+        for (auto cpu : parse_cpu_list(list))
+          add(cpu);
+    }
+    // Without NUMA information, we fall back to the numeric order.
+    for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+      add(cpu);
+    if (!result.empty())
+      return result;
+  }
+#endif
+  auto result = std::vector<size_t>{};
+  for (size_t cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u);
+       ++cpu)
+    result.push_back(cpu);
+  return result;
+}
+
+caf::error pin_current_thread(size_t cpu) {
+#if VAST_LINUX
+  if (cpu >= CPU_SETSIZE)
+    return caf::make_error(ec::invalid_argument,
+                           fmt::format("CPU {} exceeds the maximum of {}", cpu,
+                                       CPU_SETSIZE - 1));
+  auto set = cpu_set_t{};
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (auto result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+      result != 0)
+    return caf::make_error(ec::system_error,
+                           fmt::format("failed to pin thread to CPU {}: {}",
+                                       cpu, std::strerror(result)));
+  return caf::none;
+#else
+  return caf::make_error(ec::unimplemented,
+                         fmt::format("cannot pin thread to CPU {} on this "
+                                     "platform",
+                                     cpu));
+#endif
+}
+
+} // namespace vast::detail
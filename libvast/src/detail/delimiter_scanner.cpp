@@ -0,0 +1,94 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/detail/delimiter_scanner.hpp"
+
+#include "vast/detail/assert.hpp"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#endif
+
+namespace vast::detail {
+
+namespace {
+
+#if defined(__AVX2__)
+
+/// Returns the bitmask of a full block.
+auto block_mask(const char* data, char first, char second) noexcept
+  -> uint64_t {
+  const auto a = _mm256_set1_epi8(first);
+  const auto b = _mm256_set1_epi8(second);
+  const auto half_mask = [&](const char* half) {
+    const auto bytes
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(half));
+    const auto matches = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, a),
+                                         _mm256_cmpeq_epi8(bytes, b));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(matches));
+  };
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return uint64_t{half_mask(data)} | (uint64_t{half_mask(data + 32)} << 32);
+}
+
+#else
+
+/// Returns the bitmask of a full block.
+auto block_mask(const char* data, char first, char second) noexcept
+  -> uint64_t {
+  auto result = uint64_t{0};
+  for (size_t i = 0; i < delimiter_scanner::block_size; ++i) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const auto c = data[i];
+    result |= uint64_t{c == first || c == second} << i;
+  }
+  return result;
+}
+
+#endif
+
+} // namespace
+
+delimiter_scanner::delimiter_scanner(char delimiter) noexcept
+  : delimiter_scanner{delimiter, delimiter} {
+}
+
+delimiter_scanner::delimiter_scanner(char first, char second) noexcept
+  : first_{first}, second_{second} {
+}
+
+auto delimiter_scanner::mask(const char* data, size_t size) const noexcept
+  -> uint64_t {
+  VAST_ASSERT(size <= block_size);
+  if (size == block_size)
+    return block_mask(data, first_, second_);
+  // Copy the tail of a buffer into a block of its own, so that we never read
+  // past its end. The padding may contain delimiters, so we clear their bits.
+  char block[block_size] = {};
+  std::memcpy(block, data, size);
+  return block_mask(block, first_, second_) & ((uint64_t{1} << size) - 1);
+}
+
+void delimiter_scanner::split(std::string_view buffer,
+                              std::vector<std::string_view>& result) const {
+  result.clear();
+  auto cursor = delimiter_cursor{*this, buffer};
+  auto begin = size_t{0};
+  for (auto pos = cursor.next(); pos != delimiter_cursor::npos;
+       pos = cursor.next()) {
+    result.push_back(buffer.substr(begin, pos - begin));
+    begin = pos + 1;
+  }
+  if (begin != buffer.size())
+    result.push_back(buffer.substr(begin));
+}
+
+} // namespace vast::detail
@@ -16,10 +16,15 @@
 #include "vast/logger.hpp"
 #include "vast/table_slice.hpp"
 #include "vast/type.hpp"
+#include "vast/word.hpp"
 
+#include <arrow/array.h>
 #include <arrow/record_batch.h>
 
+#include <algorithm>
+#include <bit>
 #include <cstddef>
+#include <cstring>
 #include <regex>
 #include <span>
 
@@ -214,20 +219,133 @@ struct cell_evaluator<relational_operator::not_ni> {
   }
 };
 
+// -- vectorized column evaluation ---------------------------------------------
+//
+// The column evaluators below operate on the raw buffers of fixed-width and
+// string arrays. Rather than appending to the result bitmap one row at a time,
+// they compute the predicate for blocks of 64 rows at once, combine the result
+// with the validity bitmap of the array using word-level operations, and append
+// whole blocks to the result, which is finally intersected with the selection.
+
+static_assert(std::endian::native == std::endian::little,
+              "vectorized evaluation assumes little-endian Arrow bitmaps");
+
+using block_word = word<ids::block_type>;
+
+/// Loads up to 64 bits from an Arrow bitmap starting at an arbitrary bit
+/// offset into the least significant bits of a block.
+/// @pre `0 < n && n <= 64`
+ids::block_type
+load_bits(const uint8_t* bitmap, int64_t bit_offset, int64_t n) noexcept {
+  VAST_ASSERT(n > 0 && n <= 64);
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const auto* first = bitmap + (bit_offset / 8);
+  const auto shift = bit_offset % 8;
+  const auto num_bytes = (shift + n + 7) / 8;
+  auto result = ids::block_type{0};
+  std::memcpy(&result, first, std::min<int64_t>(num_bytes, 8));
+  result >>= shift;
+  if (num_bytes > 8)
+    result |= ids::block_type{first[8]} << (64 - shift);
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return result & block_word::lsb_fill(n);
+}
+
+/// Returns the validity bits for the rows `[row, row + n)` of an array.
+ids::block_type
+validity_block(const arrow::Array& array, int64_t row, int64_t n) noexcept {
+  const auto* validity = array.null_bitmap_data();
+  if (!validity)
+    return block_word::lsb_fill(n);
+  return load_bits(validity, array.offset() + row, n);
+}
+
+/// Creates a bitmap for an array that has *offset* leading unset bits followed
+/// by one bit per row of the array, computed in blocks of 64 rows by *f*.
+ids make_blockwise_ids(id offset, const arrow::Array& array, auto&& f) {
+  auto result = ids{};
+  result.append(false, offset);
+  const auto length = array.length();
+  for (auto row = int64_t{0}; row < length; row += block_word::width) {
+    const auto n = std::min<int64_t>(block_word::width, length - row);
+    result.append_block(f(row, n), n);
+  }
+  return result;
+}
+
+/// Compares *n* consecutive values against a scalar, returning the results as
+/// a block. The loop is branch-free so that the compiler can vectorize it.
+template <relational_operator Op, class T>
+ids::block_type compare_block(const T* values, int64_t n, T rhs) noexcept {
+  auto result = ids::block_type{0};
+  for (auto i = int64_t{0}; i < n; ++i) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const auto lhs = values[i];
+    bool match = false;
+    if constexpr (Op == relational_operator::equal)
+      match = lhs == rhs;
+    else if constexpr (Op == relational_operator::not_equal)
+      match = lhs != rhs;
+    else if constexpr (Op == relational_operator::less)
+      match = lhs < rhs;
+    else if constexpr (Op == relational_operator::less_equal)
+      match = lhs <= rhs;
+    else if constexpr (Op == relational_operator::greater)
+      match = lhs > rhs;
+    else if constexpr (Op == relational_operator::greater_equal)
+      match = lhs >= rhs;
+    else
+      static_assert(detail::always_false_v<T>, "unsupported operator");
+    result |= ids::block_type{match} << i;
+  }
+  return result;
+}
+
+/// The relational operators that compare two values of the same type.
+template <relational_operator Op>
+inline constexpr auto is_comparison_v
+  = Op == relational_operator::equal || Op == relational_operator::not_equal
+    || Op == relational_operator::less
+    || Op == relational_operator::less_equal
+    || Op == relational_operator::greater
+    || Op == relational_operator::greater_equal;
+
+/// The types whose arrays are backed by a single buffer of fixed-width
+/// numeric values.
+template <class Type>
+inline constexpr auto is_fixed_width_v
+  = detail::is_any_v<Type, int64_type, uint64_type, double_type, duration_type,
+                     time_type>;
+
+/// Lowers a scalar to the physical representation used by Arrow.
+auto to_physical(const auto& x) noexcept {
+  using value_type = std::decay_t<decltype(x)>;
+  if constexpr (std::is_same_v<value_type, duration>)
+    return x.count();
+  else if constexpr (std::is_same_v<value_type, time>)
+    return x.time_since_epoch().count();
+  else
+    return x;
+}
+
 // The default implementation for the column evaluator that dispatches to the
 // cell evaluator for every relevant row.
 template <relational_operator Op, concrete_type LhsType, class Rhs>
 struct column_evaluator {
   static ids evaluate(LhsType type, id offset, const arrow::Array& array,
                       const Rhs& rhs, const ids& selection) noexcept {
+    // Null values never match, so we can remove them from the selection
+    // upfront rather than checking every row individually.
+    const auto valid
+      = make_blockwise_ids(offset, array,
+                           [&](int64_t row, int64_t n) {
+                             return validity_block(array, row, n);
+                           })
+        & selection;
     ids result{};
-    for (auto id : select(selection)) {
+    for (auto id : select(valid)) {
       VAST_ASSERT(id >= offset);
       const auto row = detail::narrow_cast<int64_t>(id - offset);
-      // TODO: Instead of this in the loop, do selection &= array.null_bitmap
-      // outside of it.
-      if (array.IsNull(row))
-        continue;
       result.append(false, id - result.size());
       result.append(
         cell_evaluator<Op>::evaluate(value_at(type, array, row), rhs), 1u);
@@ -243,20 +361,11 @@ struct column_evaluator<relational_operator::equal, LhsType, caf::none_t> {
   static ids
   evaluate([[maybe_unused]] LhsType type, id offset, const arrow::Array& array,
            [[maybe_unused]] caf::none_t rhs, const ids& selection) noexcept {
-    // TODO: This entire loop semantically is just selection &
-    // ~array.null_bitmap, but we cannot do bitwise operations with Arrow's
-    // bitmaps yet.
-    ids result{};
-    for (auto id : select(selection)) {
-      VAST_ASSERT(id >= offset);
-      const auto row = detail::narrow_cast<int64_t>(id - offset);
-      if (!array.IsNull(row))
-        continue;
-      result.append(false, id - result.size());
-      result.append(true, 1u);
-    }
-    result.append(false, offset + array.length() - result.size());
-    return result;
+    auto result
+      = make_blockwise_ids(offset, array, [&](int64_t row, int64_t n) {
+          return ~validity_block(array, row, n) & block_word::lsb_fill(n);
+        });
+    return result & selection;
   }
 };
 
@@ -266,20 +375,11 @@ struct column_evaluator<relational_operator::not_equal, LhsType, caf::none_t> {
   static ids
   evaluate([[maybe_unused]] LhsType type, id offset, const arrow::Array& array,
            [[maybe_unused]] caf::none_t rhs, const ids& selection) noexcept {
-    // TODO: This entire loop semantically is just selection &
-    // array.null_bitmap, but we cannot do bitwise operations with Arrow's
-    // bitmaps yet.
-    ids result{};
-    for (auto id : select(selection)) {
-      VAST_ASSERT(id >= offset);
-      const auto row = detail::narrow_cast<int64_t>(id - offset);
-      if (array.IsNull(row))
-        continue;
-      result.append(false, id - result.size());
-      result.append(true, 1u);
-    }
-    result.append(false, offset + array.length() - result.size());
-    return result;
+    auto result
+      = make_blockwise_ids(offset, array, [&](int64_t row, int64_t n) {
+          return validity_block(array, row, n);
+        });
+    return result & selection;
   }
 };
 
@@ -312,6 +412,171 @@ struct column_evaluator<Op, enumeration_type, std::string> {
   }
 };
 
+// Compare fixed-width numeric columns in blocks over the raw values buffer.
+template <relational_operator Op, concrete_type LhsType, class Rhs>
+  requires(is_comparison_v<Op> && is_fixed_width_v<LhsType>
+           && std::is_same_v<Rhs, type_to_data_t<LhsType>>)
+struct column_evaluator<Op, LhsType, Rhs> {
+  static ids
+  evaluate([[maybe_unused]] LhsType type, id offset, const arrow::Array& array,
+           const Rhs& rhs, const ids& selection) noexcept {
+    const auto& typed_array = caf::get<type_to_arrow_array_t<LhsType>>(array);
+    const auto* values = typed_array.raw_values();
+    const auto physical_rhs
+      = static_cast<std::decay_t<decltype(*values)>>(to_physical(rhs));
+    auto result
+      = make_blockwise_ids(offset, array, [&](int64_t row, int64_t n) {
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+          return compare_block<Op>(values + row, n, physical_rhs)
+                 & validity_block(array, row, n);
+        });
+    return result & selection;
+  }
+};
+
+// Compare boolean columns by combining the bit-packed values with the validity
+// bitmap directly.
+template <relational_operator Op>
+  requires(Op == relational_operator::equal
+           || Op == relational_operator::not_equal)
+struct column_evaluator<Op, bool_type, bool> {
+  static ids
+  evaluate(bool_type, id offset, const arrow::Array& array, bool rhs,
+           const ids& selection) noexcept {
+    const auto& typed_array = caf::get<type_to_arrow_array_t<bool_type>>(array);
+    const auto* values = typed_array.values()->data();
+    const auto invert = rhs != (Op == relational_operator::equal);
+    auto result
+      = make_blockwise_ids(offset, array, [&](int64_t row, int64_t n) {
+          auto block = load_bits(values, array.offset() + row, n);
+          if (invert)
+            block = ~block & block_word::lsb_fill(n);
+          return block & validity_block(array, row, n);
+        });
+    return result & selection;
+  }
+};
+
+/// The relational operators that test whether one string contains another.
+template <relational_operator Op>
+inline constexpr auto is_substring_v
+  = Op == relational_operator::in || Op == relational_operator::not_in
+    || Op == relational_operator::ni || Op == relational_operator::not_ni;
+
+/// Compares a string from a column against a scalar string with the semantics
+/// of the cell evaluator.
+template <relational_operator Op>
+bool match_string(std::string_view lhs, std::string_view rhs) noexcept {
+  if constexpr (Op == relational_operator::equal)
+    return lhs.size() == rhs.size()
+           && std::memcmp(lhs.data(), rhs.data(), rhs.size()) == 0;
+  else if constexpr (Op == relational_operator::not_equal)
+    return !match_string<relational_operator::equal>(lhs, rhs);
+  else if constexpr (Op == relational_operator::less)
+    return lhs < rhs;
+  else if constexpr (Op == relational_operator::less_equal)
+    return lhs <= rhs;
+  else if constexpr (Op == relational_operator::greater)
+    return lhs > rhs;
+  else if constexpr (Op == relational_operator::greater_equal)
+    return lhs >= rhs;
+  else if constexpr (Op == relational_operator::in)
+    return rhs.find(lhs) != std::string_view::npos;
+  else if constexpr (Op == relational_operator::not_in)
+    return !match_string<relational_operator::in>(lhs, rhs);
+  else if constexpr (Op == relational_operator::ni)
+    return lhs.find(rhs) != std::string_view::npos;
+  else if constexpr (Op == relational_operator::not_ni)
+    return !match_string<relational_operator::ni>(lhs, rhs);
+  else
+    static_assert(detail::always_false_v<decltype(lhs)>,
+                  "unsupported operator");
+}
+
+// Compare string columns with a string by reading the values straight from the
+// offsets and data buffers. Equality checks the length before comparing the
+// bytes.
+template <relational_operator Op>
+  requires(is_comparison_v<Op> || is_substring_v<Op>)
+struct column_evaluator<Op, string_type, std::string> {
+  static ids
+  evaluate(string_type, id offset, const arrow::Array& array,
+           const std::string& rhs, const ids& selection) noexcept {
+    const auto& typed_array
+      = caf::get<type_to_arrow_array_t<string_type>>(array);
+    const auto* offsets = typed_array.raw_value_offsets();
+    const auto* data = typed_array.raw_data();
+    const auto rhs_view = std::string_view{rhs};
+    auto result
+      = make_blockwise_ids(offset, array, [&](int64_t row, int64_t n) {
+          auto block = ids::block_type{0};
+          for (auto i = int64_t{0}; i < n; ++i) {
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            const auto begin = offsets[row + i];
+            const auto lhs = std::string_view{
+              reinterpret_cast<const char*>(data + begin),
+              detail::narrow_cast<size_t>(offsets[row + i + 1] - begin)};
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            block |= ids::block_type{match_string<Op>(lhs, rhs_view)} << i;
+          }
+          return block & validity_block(array, row, n);
+        });
+    return result & selection;
+  }
+};
+
+// Compare enumeration columns with a resolved key in blocks over the raw
+// dictionary indices, which are the internal representation of the keys.
+template <relational_operator Op>
+  requires(is_comparison_v<Op>)
+struct column_evaluator<Op, enumeration_type, view<enumeration>> {
+  static ids evaluate(enumeration_type, id offset, const arrow::Array& array,
+                      view<enumeration> rhs, const ids& selection) noexcept {
+    const auto& indices = static_cast<const arrow::UInt8Array&>(
+      *caf::get<type_to_arrow_array_t<enumeration_type>>(array)
+         .storage()
+         ->indices());
+    const auto* values = indices.raw_values();
+    auto result
+      = make_blockwise_ids(offset, array, [&](int64_t row, int64_t n) {
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+          return compare_block<Op>(values + row, n, uint8_t{rhs})
+                 & validity_block(array, row, n);
+        });
+    return result & selection;
+  }
+};
+
+// Compare IP address columns for (in)equality on the 16-byte storage.
+template <relational_operator Op>
+  requires(Op == relational_operator::equal
+           || Op == relational_operator::not_equal)
+struct column_evaluator<Op, ip_type, ip> {
+  static ids evaluate(ip_type, id offset, const arrow::Array& array,
+                      const ip& rhs, const ids& selection) noexcept {
+    const auto& storage
+      = *caf::get<type_to_arrow_array_t<ip_type>>(array).storage();
+    VAST_ASSERT(storage.byte_width() == 16);
+    const auto* values = storage.raw_values();
+    const auto rhs_bytes = as_bytes(rhs);
+    auto result
+      = make_blockwise_ids(offset, array, [&](int64_t row, int64_t n) {
+          auto block = ids::block_type{0};
+          for (auto i = int64_t{0}; i < n; ++i) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            const auto* lhs_bytes = values + ((row + i) * 16);
+            const auto match
+              = std::memcmp(lhs_bytes, rhs_bytes.data(), 16) == 0;
+            block |= ids::block_type{match} << i;
+          }
+          if constexpr (Op == relational_operator::not_equal)
+            block = ~block & block_word::lsb_fill(n);
+          return block & validity_block(array, row, n);
+        });
+    return result & selection;
+  }
+};
+
 // A utility function for evaluating meta extractors in predicates. This is
 // always a yes or no question per batch, so the function does not have to deal
 // with bitmaps at all.
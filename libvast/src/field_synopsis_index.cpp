@@ -0,0 +1,393 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/field_synopsis_index.hpp"
+
+#include "vast/detail/assert.hpp"
+#include "vast/min_max_synopsis.hpp"
+#include "vast/partition_synopsis.hpp"
+#include "vast/sketch/split_block_bloom_filter.hpp"
+#include "vast/split_block_string_synopsis.hpp"
+#include "vast/synopsis.hpp"
+#include "vast/type.hpp"
+
+#include <optional>
+
+namespace vast {
+
+namespace {
+
+/// Invokes a function for the given positions, or for all positions in
+/// `[0, size)` if *positions* is null.
+template <class Function>
+void for_each_position(size_t size, const std::vector<size_t>* positions,
+                       Function f) {
+  if (!positions) {
+    for (size_t i = 0; i < size; ++i)
+      f(i);
+    return;
+  }
+  for (auto i : *positions)
+    f(i);
+}
+
+/// Selects all partitions whose time bounds satisfy a binary predicate. If
+/// `SkipNulls` is true, partitions that may have nulls are never selected.
+template <bool SkipNulls = false, class Predicate>
+void scan_time_bounds(const field_synopsis_index::column& column,
+                      std::span<const size_t> slots,
+                      const std::vector<size_t>* positions,
+                      std::vector<uint8_t>& selected, Predicate pred) {
+  VAST_ASSERT(column.has_time_bounds);
+  const auto* min_times = column.min_times.data();
+  const auto* max_times = column.max_times.data();
+  const auto* nulls = column.nulls.data();
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const auto select = [&](size_t i) {
+    const auto slot = slots[i];
+    auto result = static_cast<uint8_t>(pred(min_times[slot], max_times[slot]));
+    if constexpr (SkipNulls)
+      result &= static_cast<uint8_t>(nulls[slot] ^ 1);
+    selected[i] |= result;
+  };
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  if (!positions) {
+    for (size_t i = 0; i < selected.size(); ++i)
+      select(i);
+    return;
+  }
+  for (auto i : *positions)
+    select(i);
+}
+
+/// Computes the digests of the strings that a predicate looks for, if the
+/// split-block string synopses can answer the predicate.
+std::optional<std::vector<uint64_t>>
+string_digests(relational_operator op, data_view rhs) {
+  if (op == relational_operator::equal) {
+    if (const auto* x = caf::get_if<view<std::string>>(&rhs))
+      return std::vector{split_block_string_synopsis::digest(*x)};
+    return std::nullopt;
+  }
+  if (op == relational_operator::in) {
+    const auto* xs = caf::get_if<view<list>>(&rhs);
+    if (!xs)
+      return std::nullopt;
+    auto result = std::vector<uint64_t>{};
+    for (auto x : **xs) {
+      if (caf::holds_alternative<view<caf::none_t>>(x))
+        return std::nullopt;
+      if (const auto* str = caf::get_if<view<std::string>>(&x))
+        result.push_back(split_block_string_synopsis::digest(*str));
+    }
+    return result;
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+void field_synopsis_index::insert(size_t position,
+                                  const partition_synopsis& synopsis) {
+  VAST_ASSERT(position <= slots_.size());
+  auto slot = num_slots_;
+  if (free_slots_.empty()) {
+    // Append a slot to all columns. Its entries start out empty.
+    ++num_slots_;
+    for (auto& column : columns_) {
+      column.present.push_back(false);
+      column.synopses.push_back(nullptr);
+      column.filters.emplace_back();
+      column.nulls.push_back(1);
+      if (column.has_time_bounds) {
+        column.min_times.push_back(time::max());
+        column.max_times.push_back(time::min());
+      }
+    }
+  } else {
+    // The entries of free slots were reset when they were freed.
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  }
+  slots_.insert(slots_.begin() + static_cast<std::ptrdiff_t>(position), slot);
+  assign(slot, synopsis);
+}
+
+void field_synopsis_index::replace(size_t position,
+                                   const partition_synopsis& synopsis) {
+  VAST_ASSERT(position < slots_.size());
+  const auto slot = slots_[position];
+  reset(slot);
+  assign(slot, synopsis);
+}
+
+void field_synopsis_index::erase(size_t position) {
+  VAST_ASSERT(position < slots_.size());
+  const auto slot = slots_[position];
+  reset(slot);
+  slots_.erase(slots_.begin() + static_cast<std::ptrdiff_t>(position));
+  free_slots_.push_back(slot);
+}
+
+size_t field_synopsis_index::size() const noexcept {
+  return slots_.size();
+}
+
+const std::vector<field_synopsis_index::column>&
+field_synopsis_index::columns() const noexcept {
+  return columns_;
+}
+
+std::span<const size_t>
+field_synopsis_index::resolve(std::string_view key) const {
+  const auto it = suffixes_.find(key);
+  if (it == suffixes_.end())
+    return {};
+  return it->second;
+}
+
+void field_synopsis_index::lookup(const column& column, relational_operator op,
+                                  data_view rhs,
+                                  const std::vector<size_t>* positions,
+                                  std::vector<uint8_t>& selected) const {
+  VAST_ASSERT(selected.size() == slots_.size());
+  // Range and point lookups for time synopses compare the contiguous bounds
+  // directly, which avoids a virtual function call per partition and allows
+  // the compiler to vectorize the loop. Partitions that lack the field have
+  // empty bounds, so they never match.
+  if (column.has_time_bounds) {
+    if (const auto* x = caf::get_if<view<time>>(&rhs)) {
+      const auto value = *x;
+      switch (op) {
+        case relational_operator::equal:
+          return scan_time_bounds(column, slots_, positions, selected,
+                                  [value](time min, time max) {
+                                    return min <= value && value <= max;
+                                  });
+        case relational_operator::less:
+          return scan_time_bounds(column, slots_, positions, selected,
+                                  [value](time min, time) {
+                                    return min < value;
+                                  });
+        case relational_operator::less_equal:
+          return scan_time_bounds(column, slots_, positions, selected,
+                                  [value](time min, time) {
+                                    return min <= value;
+                                  });
+        case relational_operator::greater:
+          return scan_time_bounds(column, slots_, positions, selected,
+                                  [value](time, time max) {
+                                    return max > value;
+                                  });
+        case relational_operator::greater_equal:
+          return scan_time_bounds(column, slots_, positions, selected,
+                                  [value](time, time max) {
+                                    return max >= value;
+                                  });
+        default:
+          break;
+      }
+    }
+  }
+  const auto probe = [&](size_t i) {
+    const auto slot = slots_[i];
+    if (selected[i] || !column.present[slot])
+      return;
+    // The partition cannot be ruled out if it has no synopsis at all.
+    const auto* synopsis = column.synopses[slot];
+    if (!synopsis) {
+      selected[i] = 1;
+      return;
+    }
+    const auto result = synopsis->lookup(op, rhs);
+    if (!result || *result)
+      selected[i] = 1;
+  };
+  // String lookups probe the split-block Bloom filters of all partitions at
+  // once, which hashes every looked up value only once and avoids a virtual
+  // function call per partition. Partitions whose synopses have no such
+  // filter, e.g., because they were created by an older version, fall back to
+  // probing their synopses one by one.
+  if (column.num_filters > 0) {
+    if (const auto digests = string_digests(op, rhs)) {
+      // Without positions, we probe the filters of all slots in place. The
+      // filters of free slots are empty, and their hits are never read.
+      auto filters = std::span{column.filters};
+      auto gathered_filters = std::vector<std::span<const uint32_t>>{};
+      if (positions) {
+        gathered_filters.reserve(positions->size());
+        for (auto i : *positions)
+          gathered_filters.push_back(column.filters[slots_[i]]);
+        filters = gathered_filters;
+      }
+      auto hits = std::vector<uint8_t>(filters.size(), 0);
+      for (const auto digest : *digests)
+        sketch::lookup(digest, filters, hits);
+      const auto n = positions ? positions->size() : slots_.size();
+      for (size_t j = 0; j < n; ++j) {
+        const auto i = positions ? (*positions)[j] : j;
+        const auto k = positions ? j : slots_[i];
+        if (filters[k].empty())
+          probe(i);
+        else
+          selected[i] |= hits[k];
+      }
+      return;
+    }
+  }
+  for_each_position(slots_.size(), positions, probe);
+}
+
+void field_synopsis_index::lookup_all(const column& column,
+                                      relational_operator op, data_view rhs,
+                                      const std::vector<size_t>* positions,
+                                      std::vector<uint8_t>& selected) const {
+  VAST_ASSERT(selected.size() == slots_.size());
+  // Same as above, but all values must satisfy the predicate. Partitions that
+  // lack the field or have no values for it have min > max and never match,
+  // and neither do partitions that may have nulls for the field.
+  if (column.has_time_bounds) {
+    if (const auto* x = caf::get_if<view<time>>(&rhs)) {
+      const auto value = *x;
+      switch (op) {
+        case relational_operator::equal:
+          return scan_time_bounds<true>(
+            column, slots_, positions, selected, [value](time min, time max) {
+              return min == value && max == value;
+            });
+        case relational_operator::not_equal:
+          return scan_time_bounds<true>(
+            column, slots_, positions, selected, [value](time min, time max) {
+              return min <= max && (value < min || max < value);
+            });
+        case relational_operator::less:
+          return scan_time_bounds<true>(
+            column, slots_, positions, selected, [value](time min, time max) {
+              return min <= max && max < value;
+            });
+        case relational_operator::less_equal:
+          return scan_time_bounds<true>(
+            column, slots_, positions, selected, [value](time min, time max) {
+              return min <= max && max <= value;
+            });
+        case relational_operator::greater:
+          return scan_time_bounds<true>(
+            column, slots_, positions, selected, [value](time min, time max) {
+              return min <= max && min > value;
+            });
+        case relational_operator::greater_equal:
+          return scan_time_bounds<true>(
+            column, slots_, positions, selected, [value](time min, time max) {
+              return min <= max && min >= value;
+            });
+        default:
+          break;
+      }
+    }
+  }
+  const auto probe = [&](size_t i) {
+    const auto slot = slots_[i];
+    if (selected[i] || !column.present[slot] || column.nulls[slot])
+      return;
+    const auto* synopsis = column.synopses[slot];
+    if (synopsis && synopsis->exact_lookup(op, rhs) == synopsis_match::all)
+      selected[i] = 1;
+  };
+  for_each_position(slots_.size(), positions, probe);
+}
+
+field_synopsis_index::column&
+field_synopsis_index::column_for(const qualified_record_field& field) {
+  if (auto it = column_positions_.find(field); it != column_positions_.end())
+    return columns_[it->second];
+  const auto index = columns_.size();
+  auto& result = columns_.emplace_back();
+  result.field = field;
+  result.present.resize(num_slots_, false);
+  result.synopses.resize(num_slots_, nullptr);
+  result.filters.resize(num_slots_);
+  result.nulls.resize(num_slots_, 1);
+  result.has_time_bounds = true;
+  result.min_times.resize(num_slots_, time::max());
+  result.max_times.resize(num_slots_, time::min());
+  column_positions_.emplace(field, index);
+  // Register the column for all dot-separated suffixes of its fully qualified
+  // name, which are exactly the field extractor keys that resolve to it.
+  const auto name = field.name();
+  auto suffix = std::string_view{name};
+  while (true) {
+    suffixes_[std::string{suffix}].push_back(index);
+    const auto dot = suffix.find('.');
+    if (dot == std::string_view::npos)
+      break;
+    suffix.remove_prefix(dot + 1);
+  }
+  return result;
+}
+
+void field_synopsis_index::reset(size_t slot) {
+  for (auto& column : columns_) {
+    column.present[slot] = false;
+    column.synopses[slot] = nullptr;
+    if (!column.filters[slot].empty())
+      --column.num_filters;
+    column.filters[slot] = {};
+    column.nulls[slot] = 1;
+    if (column.has_time_bounds) {
+      column.min_times[slot] = time::max();
+      column.max_times[slot] = time::min();
+    }
+  }
+}
+
+void field_synopsis_index::assign(size_t slot,
+                                  const partition_synopsis& synopsis) {
+  // The entries of the slot are reset already, so we only need to fill in
+  // those for the fields that the partition has.
+  for (const auto& [field, field_synopsis] : synopsis.field_synopses_) {
+    const auto* effective_synopsis = field_synopsis.get();
+    if (!effective_synopsis) {
+      // We need to prune the type's metadata here by converting it to a
+      // concrete type and back, because the type synopses are looked up
+      // independent from names and attributes.
+      auto prune = []<concrete_type T>(const T& x) {
+        return type{x};
+      };
+      const auto cleaned_type = caf::visit(prune, field.type());
+      if (auto it = synopsis.type_synopses_.find(cleaned_type);
+          it != synopsis.type_synopses_.end())
+        effective_synopsis = it->second.get();
+    }
+    auto& column = column_for(field);
+    column.present[slot] = true;
+    column.synopses[slot] = effective_synopsis;
+    column.nulls[slot] = static_cast<uint8_t>(synopsis.may_have_nulls(field));
+    if (const auto* string_synopsis
+        = dynamic_cast<const split_block_string_synopsis*>(effective_synopsis)) {
+      column.filters[slot] = string_synopsis->filter().blocks();
+      ++column.num_filters;
+    }
+  }
+  for (auto& column : columns_) {
+    if (!column.has_time_bounds)
+      continue;
+    const auto* time_bounds
+      = dynamic_cast<const min_max_synopsis<time>*>(column.synopses[slot]);
+    if (column.present[slot] && !time_bounds) {
+      // This column cannot use the contiguous time bounds anymore.
+      column.has_time_bounds = false;
+      column.min_times = {};
+      column.max_times = {};
+      continue;
+    }
+    column.min_times[slot] = time_bounds ? time_bounds->min() : time::max();
+    column.max_times[slot] = time_bounds ? time_bounds->max() : time::min();
+  }
+}
+
+} // namespace vast
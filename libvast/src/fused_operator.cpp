@@ -0,0 +1,233 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/fused_operator.hpp"
+
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/cast.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/expression.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace vast {
+
+fused_batch::fused_batch(table_slice slice)
+  : schema_{slice.schema()},
+    batch_{to_record_batch(slice)},
+    slice_{std::move(slice)},
+    offset_{slice_.offset()},
+    import_time_{slice_.import_time()} {
+  VAST_ASSERT(slice_.rows() > 0);
+}
+
+auto fused_batch::schema() const -> const type& {
+  return schema_;
+}
+
+auto fused_batch::empty() const -> bool {
+  return batch_ == nullptr;
+}
+
+void fused_batch::discard() {
+  schema_ = {};
+  batch_ = {};
+  slice_ = {};
+  selection_ = {};
+}
+
+void fused_batch::filter(const expression& expr) {
+  if (empty())
+    return;
+  const auto& slice = unfiltered();
+  const auto first = offset_ == invalid_id ? 0 : offset_;
+  auto selection
+    = evaluate(expr, slice,
+               selection_ ? *selection_
+                          : make_ids({{first, first + slice.rows()}}));
+  if (!any(selection)) {
+    discard();
+    return;
+  }
+  // Keeping all rows is the common case, which requires no filtering later.
+  if (rank(selection) == slice.rows())
+    selection_ = {};
+  else
+    selection_ = std::move(selection);
+}
+
+auto fused_batch::slice() -> const table_slice& {
+  if (empty())
+    return slice_;
+  if (selection_) {
+    auto filtered = vast::filter(unfiltered(), *selection_);
+    if (!filtered) {
+      discard();
+      return slice_;
+    }
+    batch_ = to_record_batch(*filtered);
+    offset_ = filtered->offset();
+    slice_ = std::move(*filtered);
+    selection_ = {};
+  }
+  return unfiltered();
+}
+
+void fused_batch::transform_columns(
+  const std::vector<indexed_transformation>& transformations) {
+  if (empty())
+    return;
+  auto [schema, batch]
+    = vast::transform_columns(schema_, batch_, transformations);
+  if (!schema) {
+    discard();
+    return;
+  }
+  schema_ = std::move(schema);
+  batch_ = std::move(batch);
+  slice_ = {};
+}
+
+void fused_batch::select_columns(const std::vector<offset>& indices) {
+  if (empty())
+    return;
+  auto [schema, batch] = vast::select_columns(schema_, batch_, indices);
+  if (!schema) {
+    discard();
+    return;
+  }
+  schema_ = std::move(schema);
+  batch_ = std::move(batch);
+  slice_ = {};
+}
+
+void fused_batch::cast(const type& schema) {
+  if (empty() || schema_ == schema)
+    return;
+  slice_ = vast::cast(unfiltered(), schema);
+  schema_ = slice_.schema();
+  batch_ = to_record_batch(slice_);
+}
+
+auto fused_batch::finish() && -> table_slice {
+  if (empty())
+    return {};
+  return slice();
+}
+
+auto fused_batch::unfiltered() -> const table_slice& {
+  VAST_ASSERT(!empty());
+  if (slice_.encoding() == table_slice_encoding::none) {
+    slice_ = table_slice{batch_, schema_};
+    slice_.offset(offset_);
+    slice_.import_time(import_time_);
+  }
+  return slice_;
+}
+
+auto is_fusable(const operator_base& op) -> bool {
+  const auto* fusable = dynamic_cast<const fusable_operator*>(&op);
+  return fusable != nullptr && fusable->fusable();
+}
+
+namespace {
+
+/// Passes every batch through all operators, preparing each operator once per
+/// schema that reaches it.
+auto run_fused(generator<table_slice> input, std::vector<operator_ptr> ops,
+               operator_control_plane& ctrl) -> generator<table_slice> {
+  auto steps = std::vector<std::unordered_map<type, fused_step>>(ops.size());
+  for (auto&& slice : input) {
+    if (slice.rows() == 0) {
+      co_yield {};
+      continue;
+    }
+    auto batch = fused_batch{std::move(slice)};
+    for (size_t i = 0; i < ops.size() && !batch.empty(); ++i) {
+      auto it = steps[i].find(batch.schema());
+      if (it == steps[i].end()) {
+        const auto& op = dynamic_cast<const fusable_operator&>(*ops[i]);
+        auto step = op.fuse(batch.schema(), ctrl);
+        if (!step) {
+          ctrl.abort(step.error());
+          co_return;
+        }
+        it = steps[i].try_emplace(it, batch.schema(), std::move(*step));
+      }
+      it->second(batch);
+    }
+    co_yield std::move(batch).finish();
+  }
+}
+
+auto copy_operators(const std::vector<operator_ptr>& ops)
+  -> std::vector<operator_ptr> {
+  auto result = std::vector<operator_ptr>{};
+  result.reserve(ops.size());
+  for (const auto& op : ops)
+    result.push_back(op->copy());
+  return result;
+}
+
+} // namespace
+
+fused_operator::fused_operator(std::vector<operator_ptr> ops)
+  : ops_{std::move(ops)} {
+  VAST_ASSERT(!ops_.empty());
+  VAST_ASSERT(std::all_of(ops_.begin(), ops_.end(), [](const auto& op) {
+    return is_fusable(*op);
+  }));
+}
+
+auto fused_operator::instantiate(operator_input input,
+                                 operator_control_plane& ctrl) const
+  -> caf::expected<operator_output> {
+  auto* slices = std::get_if<generator<table_slice>>(&input);
+  if (!slices)
+    return caf::make_error(ec::type_clash,
+                           fmt::format("'{}' does not accept {} as input",
+                                       to_string(), operator_type_name(input)));
+  // The output owns copies of the operators, so that it does not depend on
+  // the lifetime of this operator.
+  return run_fused(std::move(*slices), copy_operators(ops_), ctrl);
+}
+
+auto fused_operator::copy() const -> operator_ptr {
+  return std::make_unique<fused_operator>(copy_operators(ops_));
+}
+
+auto fused_operator::to_string() const -> std::string {
+  return fmt::to_string(fmt::join(ops_, " | "));
+}
+
+auto fused_operator::predicate_pushdown(expression const& expr) const
+  -> std::optional<std::pair<expression, operator_ptr>> {
+  return pipeline{copy_operators(ops_)}.predicate_pushdown(expr);
+}
+
+auto fused_operator::location() const -> operator_location {
+  return ops_.front()->location();
+}
+
+auto fused_operator::parallelism() const -> operator_parallelism {
+  return operator_parallelism::stateless;
+}
+
+auto fused_operator::infer_type_impl(operator_type input) const
+  -> caf::expected<operator_type> {
+  if (!input.is<table_slice>())
+    return caf::make_error(ec::type_clash,
+                           fmt::format("'{}' does not accept {} as input",
+                                       to_string(), operator_type_name(input)));
+  return operator_type{tag_v<table_slice>};
+}
+
+} // namespace vast
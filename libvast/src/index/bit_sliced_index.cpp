@@ -0,0 +1,360 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/index/bit_sliced_index.hpp"
+
+#include "vast/detail/assert.hpp"
+#include "vast/error.hpp"
+#include "vast/fbs/value_index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#endif
+
+namespace vast {
+
+namespace {
+
+/// The number of words that a lookup refines over all slices at once. The
+/// comparison state of a block and the corresponding words of a slice fit
+/// into the L1 cache.
+constexpr auto block_words = size_t{64};
+
+constexpr auto all_ones = ~uint64_t{0};
+
+size_t num_words(size_t num_bits) noexcept {
+  return (num_bits + 63) / 64;
+}
+
+// -- range kernels ------------------------------------------------------------
+//
+// The O'Neil range algorithm maintains the keys that are equal to, less than,
+// and greater than the looked up key in the bits examined so far. Every slice
+// moves the equal keys whose bit differs from the bit of the looked up key to
+// the less or greater set.
+
+#if defined(__AVX2__)
+
+__m256i load(const uint64_t* x) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x));
+}
+
+void store(uint64_t* x, __m256i value) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(x), value);
+}
+
+/// Refines the state with a slice for which the looked up key has a one:
+/// `lt |= eq & ~s` and `eq &= s`.
+void refine_one(uint64_t* lt, uint64_t* eq, const uint64_t* s,
+                size_t n) noexcept {
+  auto i = size_t{0};
+  for (; i + 4 <= n; i += 4) {
+    const auto slice = load(s + i);
+    const auto equal = load(eq + i);
+    store(lt + i, _mm256_or_si256(load(lt + i),
+                                  _mm256_andnot_si256(slice, equal)));
+    store(eq + i, _mm256_and_si256(equal, slice));
+  }
+  for (; i < n; ++i) {
+    lt[i] |= eq[i] & ~s[i];
+    eq[i] &= s[i];
+  }
+}
+
+/// Refines the state with a slice for which the looked up key has a zero:
+/// `gt |= eq & s` and `eq &= ~s`.
+void refine_zero(uint64_t* gt, uint64_t* eq, const uint64_t* s,
+                 size_t n) noexcept {
+  auto i = size_t{0};
+  for (; i + 4 <= n; i += 4) {
+    const auto slice = load(s + i);
+    const auto equal = load(eq + i);
+    store(gt + i,
+          _mm256_or_si256(load(gt + i), _mm256_and_si256(equal, slice)));
+    store(eq + i, _mm256_andnot_si256(slice, equal));
+  }
+  for (; i < n; ++i) {
+    gt[i] |= eq[i] & s[i];
+    eq[i] &= ~s[i];
+  }
+}
+
+#else
+
+void refine_one(uint64_t* lt, uint64_t* eq, const uint64_t* s,
+                size_t n) noexcept {
+  for (size_t i = 0; i < n; ++i) {
+    lt[i] |= eq[i] & ~s[i];
+    eq[i] &= s[i];
+  }
+}
+
+void refine_zero(uint64_t* gt, uint64_t* eq, const uint64_t* s,
+                 size_t n) noexcept {
+  for (size_t i = 0; i < n; ++i) {
+    gt[i] |= eq[i] & s[i];
+    eq[i] &= ~s[i];
+  }
+}
+
+#endif
+
+uint64_t compose(relational_operator op, uint64_t lt, uint64_t gt,
+                 uint64_t eq) noexcept {
+  switch (op) {
+    case relational_operator::equal:
+      return eq;
+    case relational_operator::not_equal:
+      return ~eq;
+    case relational_operator::less:
+      return lt;
+    case relational_operator::less_equal:
+      return lt | eq;
+    case relational_operator::greater:
+      return gt;
+    case relational_operator::greater_equal:
+      return gt | eq;
+    default:
+      VAST_ASSERT(false, "unsupported operator for bit slices");
+      return 0;
+  }
+}
+
+bool any(const std::vector<uint64_t>& words) noexcept {
+  return std::any_of(words.begin(), words.end(), [](uint64_t x) {
+    return x != 0;
+  });
+}
+
+} // namespace
+
+void bit_slices::append(uint64_t key, size_t pos) {
+  VAST_ASSERT(pos >= size_);
+  if (constant_mask_ != 0)
+    expand();
+  size_ = pos + 1;
+  const auto n = num_words(size_);
+  if (slices_[0].size() != n)
+    for (auto& slice : slices_)
+      slice.resize(n);
+  const auto word = pos / 64;
+  const auto bit = uint64_t{1} << (pos % 64);
+  for (; key != 0; key &= key - 1)
+    slices_[std::countr_zero(key)][word] |= bit;
+}
+
+size_t bit_slices::size() const noexcept {
+  return size_;
+}
+
+ewah_bitmap bit_slices::lookup(relational_operator op, uint64_t key) const {
+  const auto n = num_words(size_);
+  auto result = ewah_bitmap{};
+  auto lt = std::array<uint64_t, block_words>{};
+  auto gt = std::array<uint64_t, block_words>{};
+  auto eq = std::array<uint64_t, block_words>{};
+  for (size_t first = 0; first < n; first += block_words) {
+    const auto count = std::min(block_words, n - first);
+    std::fill_n(lt.begin(), count, 0);
+    std::fill_n(gt.begin(), count, 0);
+    std::fill_n(eq.begin(), count, all_ones);
+    for (auto i = num_slices; i-- > 0;) {
+      const auto bit = uint64_t{1} << i;
+      const auto key_bit = (key & bit) != 0;
+      if (constant_mask_ & bit) {
+        if (((constant_bits_ & bit) != 0) == key_bit)
+          continue;
+        // All keys differ from the looked up key in this bit, so none of the
+        // less significant slices can change the outcome.
+        auto& target = key_bit ? lt : gt;
+        for (size_t j = 0; j < count; ++j) {
+          target[j] |= eq[j];
+          eq[j] = 0;
+        }
+        break;
+      }
+      const auto* slice = slices_[i].data() + first;
+      if (key_bit)
+        refine_one(lt.data(), eq.data(), slice, count);
+      else
+        refine_zero(gt.data(), eq.data(), slice, count);
+    }
+    for (size_t j = 0; j < count; ++j) {
+      const auto is_last = first + j + 1 == n && size_ % 64 != 0;
+      result.append_block(compose(op, lt[j], gt[j], eq[j]),
+                          is_last ? size_ % 64 : 64);
+    }
+  }
+  return result;
+}
+
+__uint128_t bit_slices::sum(std::span<const uint64_t> selection) const {
+  const auto n = std::min(selection.size(), num_words(size_));
+  auto selected = uint64_t{0};
+  for (size_t j = 0; j < n; ++j)
+    selected += std::popcount(selection[j]);
+  auto result = __uint128_t{0};
+  for (size_t i = 0; i < num_slices; ++i) {
+    const auto bit = uint64_t{1} << i;
+    auto count = uint64_t{0};
+    if (constant_mask_ & bit) {
+      if (constant_bits_ & bit)
+        count = selected;
+    } else {
+      for (size_t j = 0; j < n; ++j)
+        count += std::popcount(selection[j] & slices_[i][j]);
+    }
+    result += static_cast<__uint128_t>(count) << i;
+  }
+  return result;
+}
+
+std::optional<uint64_t>
+bit_slices::min(std::span<const uint64_t> selection) const {
+  // Narrow down the candidates to the keys with a zero in every slice where
+  // at least one candidate has a zero, starting at the most significant slice.
+  auto candidates = std::vector<uint64_t>(num_words(size_));
+  std::copy_n(selection.begin(), std::min(selection.size(), candidates.size()),
+              candidates.begin());
+  if (!any(candidates))
+    return std::nullopt;
+  auto result = uint64_t{0};
+  auto zeros = std::vector<uint64_t>(candidates.size());
+  for (auto i = num_slices; i-- > 0;) {
+    const auto bit = uint64_t{1} << i;
+    if (constant_mask_ & bit) {
+      result |= constant_bits_ & bit;
+      continue;
+    }
+    for (size_t j = 0; j < candidates.size(); ++j)
+      zeros[j] = candidates[j] & ~slices_[i][j];
+    if (any(zeros))
+      candidates.swap(zeros);
+    else
+      result |= bit;
+  }
+  return result;
+}
+
+std::optional<uint64_t>
+bit_slices::max(std::span<const uint64_t> selection) const {
+  // Narrow down the candidates to the keys with a one in every slice where at
+  // least one candidate has a one, starting at the most significant slice.
+  auto candidates = std::vector<uint64_t>(num_words(size_));
+  std::copy_n(selection.begin(), std::min(selection.size(), candidates.size()),
+              candidates.begin());
+  if (!any(candidates))
+    return std::nullopt;
+  auto result = uint64_t{0};
+  auto ones = std::vector<uint64_t>(candidates.size());
+  for (auto i = num_slices; i-- > 0;) {
+    const auto bit = uint64_t{1} << i;
+    if (constant_mask_ & bit) {
+      result |= constant_bits_ & bit;
+      continue;
+    }
+    for (size_t j = 0; j < candidates.size(); ++j)
+      ones[j] = candidates[j] & slices_[i][j];
+    if (any(ones)) {
+      candidates.swap(ones);
+      result |= bit;
+    }
+  }
+  return result;
+}
+
+void bit_slices::compact(std::span<const uint64_t> valid) {
+  const auto n = std::min(valid.size(), num_words(size_));
+  for (size_t i = 0; i < num_slices; ++i) {
+    const auto bit = uint64_t{1} << i;
+    if (constant_mask_ & bit)
+      continue;
+    auto ones = false;
+    auto zeros = false;
+    for (size_t j = 0; j < n && !(ones && zeros); ++j) {
+      ones = ones || (valid[j] & slices_[i][j]) != 0;
+      zeros = zeros || (valid[j] & ~slices_[i][j]) != 0;
+    }
+    if (ones && zeros)
+      continue;
+    constant_mask_ |= bit;
+    if (ones)
+      constant_bits_ |= bit;
+    slices_[i] = {};
+  }
+}
+
+void bit_slices::expand() {
+  const auto n = num_words(size_);
+  // Clear the bits past the end so that appending keeps them intact.
+  const auto last_word
+    = size_ % 64 == 0 ? all_ones : (uint64_t{1} << (size_ % 64)) - 1;
+  for (size_t i = 0; i < num_slices; ++i) {
+    const auto bit = uint64_t{1} << i;
+    if (!(constant_mask_ & bit))
+      continue;
+    slices_[i].assign(n, constant_bits_ & bit ? all_ones : 0);
+    if (n > 0)
+      slices_[i].back() &= last_word;
+  }
+  constant_mask_ = 0;
+  constant_bits_ = 0;
+}
+
+size_t bit_slices::memusage() const {
+  auto acc = sizeof(*this);
+  for (const auto& slice : slices_)
+    acc += slice.capacity() * sizeof(uint64_t);
+  return acc;
+}
+
+auto pack(flatbuffers::FlatBufferBuilder& builder, const bit_slices& from,
+          flatbuffers::Offset<fbs::value_index::detail::ValueIndexBase>
+            base_offset)
+  -> flatbuffers::Offset<fbs::value_index::BitSlicedIndex> {
+  auto words = std::vector<uint64_t>{};
+  words.reserve(std::popcount(~from.constant_mask_) * num_words(from.size_));
+  for (size_t i = 0; i < bit_slices::num_slices; ++i)
+    if (!(from.constant_mask_ & (uint64_t{1} << i)))
+      words.insert(words.end(), from.slices_[i].begin(), from.slices_[i].end());
+  return fbs::value_index::CreateBitSlicedIndexDirect(
+    builder, base_offset, from.size_, from.constant_mask_, from.constant_bits_,
+    &words);
+}
+
+auto unpack(const fbs::value_index::BitSlicedIndex& from, bit_slices& to)
+  -> caf::error {
+  const auto n = num_words(from.size());
+  const auto num_stored = static_cast<size_t>(std::popcount(
+    ~from.constant_mask()));
+  if (from.words()->size() != num_stored * n)
+    return caf::make_error(ec::format_error,
+                           "bit-sliced index has a mismatching number of "
+                           "words");
+  to.size_ = from.size();
+  to.constant_mask_ = from.constant_mask();
+  to.constant_bits_ = from.constant_bits() & from.constant_mask();
+  auto word = from.words()->begin();
+  for (size_t i = 0; i < bit_slices::num_slices; ++i) {
+    if (to.constant_mask_ & (uint64_t{1} << i)) {
+      to.slices_[i] = {};
+      continue;
+    }
+    to.slices_[i].assign(word, word + n);
+    word += n;
+  }
+  return caf::none;
+}
+
+} // namespace vast
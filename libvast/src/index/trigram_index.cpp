@@ -0,0 +1,273 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/index/trigram_index.hpp"
+
+#include "vast/bitmap_algorithms.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/inspection_common.hpp"
+#include "vast/detail/overload.hpp"
+#include "vast/fbs/value_index.hpp"
+#include "vast/hash/hash.hpp"
+#include "vast/index/container_lookup.hpp"
+#include "vast/type.hpp"
+
+#include <caf/settings.hpp>
+#include <re2/filtered_re2.h>
+#include <re2/re2.h>
+
+#include <algorithm>
+#include <optional>
+
+namespace vast {
+
+namespace {
+
+/// The minimum length of a literal substring of a regular expression that can
+/// be looked up in the index.
+constexpr auto trigram_size = size_t{3};
+
+uint32_t fold(char c) {
+  const auto x = static_cast<uint8_t>(c);
+  return x >= 'A' && x <= 'Z' ? x + ('a' - 'A') : x;
+}
+
+/// Collects the distinct case-folded trigrams of a string in ascending order.
+std::vector<uint32_t> trigrams(std::string_view str) {
+  auto result = std::vector<uint32_t>{};
+  if (str.size() < trigram_size)
+    return result;
+  result.reserve(str.size() - trigram_size + 1);
+  for (size_t i = 0; i + trigram_size <= str.size(); ++i)
+    result.push_back(fold(str[i]) << 16 | fold(str[i + 1]) << 8
+                     | fold(str[i + 2]));
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+} // namespace
+
+trigram_index::trigram_index(vast::type t, caf::settings opts)
+  : value_index{std::move(t), std::move(opts)} {
+  // nop
+}
+
+bool trigram_index::inspect_impl(supported_inspectors& inspector) {
+  return value_index::inspect_impl(inspector)
+         && std::visit(
+           [this](auto visitor) {
+             return detail::apply_all(visitor.get(), postings_, digests_);
+           },
+           inspector);
+}
+
+bool trigram_index::append_impl(data_view x, id pos) {
+  auto str = caf::get_if<view<std::string>>(&x);
+  if (!str)
+    return false;
+  digests_.resize(pos);
+  digests_.push_back(hash(*str));
+  for (auto trigram : trigrams(*str)) {
+    auto& posting = postings_[trigram];
+    posting.append_bits(false, pos - posting.size());
+    posting.append_bit(true);
+  }
+  return true;
+}
+
+caf::expected<ids>
+trigram_index::lookup_impl(relational_operator op, data_view x) const {
+  auto f = detail::overload{
+    [&](auto x) -> caf::expected<ids> {
+      return caf::make_error(ec::type_clash, materialize(x));
+    },
+    [&](view<pattern> x) -> caf::expected<ids> {
+      switch (op) {
+        default:
+          return caf::make_error(ec::unsupported_operator, op);
+        case relational_operator::equal:
+          return lookup_pattern(x);
+        case relational_operator::not_equal:
+          return ids{offset(), true};
+      }
+    },
+    [&](view<std::string> str) -> caf::expected<ids> {
+      switch (op) {
+        default:
+          return caf::make_error(ec::unsupported_operator, op);
+        case relational_operator::equal:
+          return ids{lookup_digest(str)};
+        case relational_operator::not_equal: {
+          auto result = lookup_digest(str);
+          result.flip();
+          return ids{std::move(result)};
+        }
+        case relational_operator::ni:
+          // Substrings shorter than a trigram occur in any string.
+          if (str.size() < trigram_size)
+            return ids{offset(), true};
+          return ids{lookup_trigrams(str)};
+        case relational_operator::not_ni:
+          // The absence of a trigram does not rule out any string.
+          return ids{offset(), true};
+      }
+    },
+    [&](view<list> xs) {
+      return detail::container_lookup(*this, op, xs);
+    },
+  };
+  return caf::visit(f, x);
+}
+
+ewah_bitmap trigram_index::lookup_trigrams(std::string_view str) const {
+  VAST_ASSERT(str.size() >= trigram_size);
+  auto result = std::optional<ewah_bitmap>{};
+  for (auto trigram : trigrams(str)) {
+    auto posting = postings_.find(trigram);
+    if (posting == postings_.end())
+      return {};
+    if (!result)
+      result = posting->second;
+    else
+      *result &= posting->second;
+    if (all<0>(*result))
+      return {};
+  }
+  VAST_ASSERT(result);
+  return std::move(*result);
+}
+
+ewah_bitmap trigram_index::lookup_digest(std::string_view str) const {
+  const auto digest = hash(str);
+  auto result = ewah_bitmap{};
+  for (auto x : digests_)
+    result.append_bit(x == digest);
+  return result;
+}
+
+ids trigram_index::lookup_pattern(view<pattern> x) const {
+  // RE2 decomposes the regular expression into a set of lower-case literal
+  // substrings (atoms) and a boolean formula over them that must hold for any
+  // matching string. We only learn the formula by asking which regular
+  // expressions may match for a given set of atoms, so we enumerate the sets
+  // of atoms that occur in the index and combine the candidates of all
+  // minimal sets that satisfy the formula.
+  auto filter = re2::FilteredRE2{static_cast<int>(trigram_size)};
+  auto options = re2::RE2::Options{re2::RE2::CannedOptions::Quiet};
+  options.set_case_sensitive(!x.case_insensitive());
+  auto regex_id = 0;
+  const auto str = x.string();
+  if (filter.Add(re2::StringPiece{str.data(), str.size()}, options, &regex_id)
+      != re2::RE2::NoError)
+    return ids{offset(), true};
+  auto atoms = std::vector<std::string>{};
+  filter.Compile(&atoms);
+  auto atom_ids = std::vector<int>{};
+  auto atom_candidates = std::vector<ewah_bitmap>{};
+  for (size_t i = 0; i < atoms.size(); ++i) {
+    // RE2 lower-cases atoms according to Unicode, but the index only folds
+    // ASCII characters, so we cannot narrow down the candidates for atoms
+    // with other characters.
+    const auto is_ascii = std::all_of(atoms[i].begin(), atoms[i].end(),
+                                      [](char c) {
+                                        return static_cast<uint8_t>(c) < 0x80;
+                                      });
+    auto candidates = atoms[i].size() >= trigram_size && is_ascii
+                        ? lookup_trigrams(atoms[i])
+                        : ewah_bitmap{offset(), true};
+    if (all<0>(candidates))
+      continue;
+    atom_ids.push_back(static_cast<int>(i));
+    atom_candidates.push_back(std::move(candidates));
+  }
+  if (atom_ids.size() > max_pattern_atoms)
+    return ids{offset(), true};
+  // Every superset of a satisfying set of atoms satisfies the formula as well,
+  // and numerical order visits all subsets of a set before the set itself.
+  auto result = ewah_bitmap{};
+  auto satisfying = std::vector<uint32_t>{};
+  auto matched = std::vector<int>{};
+  auto potentials = std::vector<int>{};
+  for (uint32_t subset = 0; subset < (uint32_t{1} << atom_ids.size());
+       ++subset) {
+    if (std::any_of(satisfying.begin(), satisfying.end(), [&](uint32_t x) {
+          return (subset & x) == x;
+        }))
+      continue;
+    matched.clear();
+    for (size_t i = 0; i < atom_ids.size(); ++i)
+      if (subset & (uint32_t{1} << i))
+        matched.push_back(atom_ids[i]);
+    potentials.clear();
+    filter.AllPotentials(matched, &potentials);
+    if (potentials.empty())
+      continue;
+    // The regular expression may match without any of its atoms.
+    if (subset == 0)
+      return ids{offset(), true};
+    satisfying.push_back(subset);
+    auto conjunction = std::optional<ewah_bitmap>{};
+    for (size_t i = 0; i < atom_ids.size(); ++i) {
+      if (!(subset & (uint32_t{1} << i)))
+        continue;
+      if (!conjunction)
+        conjunction = atom_candidates[i];
+      else
+        *conjunction &= atom_candidates[i];
+    }
+    result |= *conjunction;
+  }
+  return ids{std::move(result)};
+}
+
+size_t trigram_index::memusage_impl() const {
+  auto acc = digests_.size() * sizeof(uint64_t);
+  for (const auto& [trigram, posting] : postings_)
+    acc += sizeof(trigram) + posting.memusage();
+  return acc;
+}
+
+flatbuffers::Offset<fbs::ValueIndex> trigram_index::pack_impl(
+  flatbuffers::FlatBufferBuilder& builder,
+  flatbuffers::Offset<fbs::value_index::detail::ValueIndexBase> base_offset) {
+  auto trigrams = std::vector<uint32_t>{};
+  trigrams.reserve(postings_.size());
+  auto posting_offsets
+    = std::vector<flatbuffers::Offset<fbs::bitmap::EWAHBitmap>>{};
+  posting_offsets.reserve(postings_.size());
+  for (const auto& [trigram, posting] : postings_) {
+    trigrams.push_back(trigram);
+    posting_offsets.push_back(pack(builder, posting));
+  }
+  const auto trigram_index_offset = fbs::value_index::CreateTrigramIndexDirect(
+    builder, base_offset, &digests_, &trigrams, &posting_offsets);
+  return fbs::CreateValueIndex(builder, fbs::value_index::ValueIndex::trigram,
+                               trigram_index_offset.Union());
+}
+
+caf::error trigram_index::unpack_impl(const fbs::ValueIndex& from) {
+  const auto* from_trigram = from.value_index_as_trigram();
+  VAST_ASSERT(from_trigram);
+  if (from_trigram->trigrams()->size() != from_trigram->postings()->size())
+    return caf::make_error(ec::format_error,
+                           "trigram index has mismatching trigrams and "
+                           "postings");
+  digests_.assign(from_trigram->digests()->begin(),
+                  from_trigram->digests()->end());
+  postings_.clear();
+  postings_.reserve(from_trigram->trigrams()->size());
+  for (size_t i = 0; i < from_trigram->trigrams()->size(); ++i) {
+    auto& posting = postings_[from_trigram->trigrams()->Get(i)];
+    if (auto err = unpack(*from_trigram->postings()->Get(i), posting))
+      return err;
+  }
+  return caf::none;
+}
+
+} // namespace vast
@@ -8,6 +8,7 @@
 
 #include "vast/index_config.hpp"
 
+#include "vast/error.hpp"
 #include "vast/qualified_record_field.hpp"
 
 #include <fmt/format.h>
@@ -65,4 +66,62 @@ bool should_create_partition_index(
   return true;
 }
 
+std::string_view
+index_bitmap_encoding(const qualified_record_field& index_qf,
+                      const std::vector<index_config::rule>& rules) {
+  for (const auto& rule : rules) {
+    if (should_use_rule(rule.targets, index_qf))
+      return rule.bitmap;
+  }
+  return defaults::system::bitmap_encoding;
+}
+
+std::string_view
+index_string_kind(const qualified_record_field& index_qf,
+                  const std::vector<index_config::rule>& rules) {
+  for (const auto& rule : rules) {
+    if (should_use_rule(rule.targets, index_qf))
+      return rule.string_index;
+  }
+  return defaults::system::string_index;
+}
+
+std::string_view
+index_arithmetic_kind(const qualified_record_field& index_qf,
+                      const std::vector<index_config::rule>& rules) {
+  for (const auto& rule : rules) {
+    if (should_use_rule(rule.targets, index_qf))
+      return rule.arithmetic_index;
+  }
+  return defaults::system::arithmetic_index;
+}
+
+caf::error validate(const index_config& config) {
+  for (const auto& rule : config.rules) {
+    if (rule.bitmap != "ewah" && rule.bitmap != "roaring")
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("invalid bitmap encoding '{}' for "
+                                         "index rule targets {}: expected "
+                                         "'ewah' or 'roaring'",
+                                         rule.bitmap,
+                                         fmt::join(rule.targets, ", ")));
+    if (rule.string_index != "bitslice" && rule.string_index != "trigram")
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("invalid string index '{}' for index "
+                                         "rule targets {}: expected "
+                                         "'bitslice' or 'trigram'",
+                                         rule.string_index,
+                                         fmt::join(rule.targets, ", ")));
+    if (rule.arithmetic_index != "range"
+        && rule.arithmetic_index != "bit-sliced")
+      return caf::make_error(ec::invalid_configuration,
+                             fmt::format("invalid arithmetic index '{}' for "
+                                         "index rule targets {}: expected "
+                                         "'range' or 'bit-sliced'",
+                                         rule.arithmetic_index,
+                                         fmt::join(rule.targets, ", ")));
+  }
+  return {};
+}
+
 } // namespace vast
@@ -0,0 +1,185 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/operator_queue.hpp"
+
+#include "vast/detail/assert.hpp"
+
+#include <optional>
+
+namespace vast {
+
+template <operator_input_batch T>
+operator_queue<T>::operator_queue(size_t capacity, size_t producers,
+                                  size_t consumers)
+  : queue_{capacity}, producers_{producers}, consumers_{consumers} {
+  VAST_ASSERT(producers > 0);
+  VAST_ASSERT(consumers > 0);
+}
+
+template <operator_input_batch T>
+bool operator_queue<T>::push(T x) {
+  auto e = entry{std::move(x), next_sequence_.fetch_add(1), clock::now()};
+  return push(e, std::nullopt) == operator_queue_status::ok;
+}
+
+template <operator_input_batch T>
+bool operator_queue<T>::push(T x, uint64_t sequence) {
+  auto e = entry{std::move(x), sequence, clock::now()};
+  return push(e, std::nullopt) == operator_queue_status::ok;
+}
+
+template <operator_input_batch T>
+operator_queue_status
+operator_queue<T>::push(T& x, uint64_t sequence,
+                        std::chrono::steady_clock::duration timeout) {
+  auto e = entry{std::move(x), sequence, clock::now()};
+  const auto result = push(e, e.pushed + timeout);
+  if (result != operator_queue_status::ok)
+    x = std::move(e.batch);
+  return result;
+}
+
+template <operator_input_batch T>
+operator_queue_status
+operator_queue<T>::pop(T& x, std::chrono::steady_clock::duration timeout) {
+  auto sequence = uint64_t{};
+  return pop(x, sequence, timeout);
+}
+
+template <operator_input_batch T>
+operator_queue_status
+operator_queue<T>::pop(T& x, uint64_t& sequence,
+                       std::chrono::steady_clock::duration timeout) {
+  auto e = entry{};
+  auto deadline = std::optional<clock::time_point>{};
+  while (!queue_.try_pop(e)) {
+    if (closed_.load()) {
+      // The producer may have appended a last batch before closing.
+      if (queue_.try_pop(e))
+        break;
+      return operator_queue_status::closed;
+    }
+    const auto now = clock::now();
+    if (!deadline)
+      deadline = now + timeout;
+    else if (now >= *deadline)
+      return operator_queue_status::timeout;
+    empty_waits_.fetch_add(1, std::memory_order_relaxed);
+    auto lock = std::unique_lock{mutex_};
+    waiting_consumers_.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    not_empty_.wait_until(lock, *deadline, [&] {
+      return closed_.load() || queue_.size() > 0;
+    });
+    waiting_consumers_.fetch_sub(1);
+  }
+  notify(waiting_producers_, not_full_);
+  const auto latency
+    = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now()
+                                                           - e.pushed)
+        .count();
+  batches_.fetch_add(1, std::memory_order_relaxed);
+  total_latency_.fetch_add(latency, std::memory_order_relaxed);
+  auto max = max_latency_.load(std::memory_order_relaxed);
+  while (latency > max
+         && !max_latency_.compare_exchange_weak(max, latency,
+                                                std::memory_order_relaxed)) {
+    // nop
+  }
+  x = std::move(e.batch);
+  sequence = e.sequence;
+  return operator_queue_status::ok;
+}
+
+template <operator_input_batch T>
+void operator_queue<T>::close() {
+  VAST_ASSERT(producers_.load() > 0);
+  if (producers_.fetch_sub(1) > 1)
+    return;
+  closed_.store(true);
+  auto lock = std::lock_guard{mutex_};
+  not_empty_.notify_all();
+}
+
+template <operator_input_batch T>
+void operator_queue<T>::cancel() {
+  VAST_ASSERT(consumers_.load() > 0);
+  if (consumers_.fetch_sub(1) > 1)
+    return;
+  cancelled_.store(true);
+  auto lock = std::lock_guard{mutex_};
+  not_full_.notify_all();
+}
+
+template <operator_input_batch T>
+operator_queue_metrics operator_queue<T>::metrics() const {
+  return {
+    .batches = batches_.load(),
+    .total_latency = std::chrono::nanoseconds{total_latency_.load()},
+    .max_latency = std::chrono::nanoseconds{max_latency_.load()},
+    .full_waits = full_waits_.load(),
+    .empty_waits = empty_waits_.load(),
+  };
+}
+
+template <operator_input_batch T>
+operator_queue_status
+operator_queue<T>::push(entry& e, std::optional<clock::time_point> deadline) {
+  VAST_ASSERT(!closed_.load());
+  while (!queue_.try_push(std::move(e))) {
+    if (cancelled_.load())
+      return operator_queue_status::closed;
+    if (deadline && clock::now() >= *deadline)
+      return operator_queue_status::timeout;
+    full_waits_.fetch_add(1, std::memory_order_relaxed);
+    auto lock = std::unique_lock{mutex_};
+    waiting_producers_.fetch_add(1);
+    // Pairs with the fence in `pop`: either the consumer sees that we are
+    // waiting, or we see the slot that it freed.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto ready = [&] {
+      return cancelled_.load() || queue_.size() < queue_.capacity();
+    };
+    if (deadline)
+      not_full_.wait_until(lock, *deadline, ready);
+    else
+      not_full_.wait(lock, ready);
+    waiting_producers_.fetch_sub(1);
+  }
+  notify(waiting_consumers_, not_empty_);
+  return operator_queue_status::ok;
+}
+
+template <operator_input_batch T>
+void operator_queue<T>::notify(std::atomic<size_t>& waiting,
+                               std::condition_variable& cv) {
+  // Pairs with the fence in the waiting thread, see `push`.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting.load() == 0)
+    return;
+  auto lock = std::lock_guard{mutex_};
+  cv.notify_all();
+}
+
+template class operator_queue<table_slice>;
+template class operator_queue<chunk_ptr>;
+
+auto make_operator_queue(operator_type type, size_t capacity)
+  -> operator_queue_ptr {
+  return std::visit(
+    [&]<class T>(tag<T>) -> operator_queue_ptr {
+      if constexpr (std::is_same_v<T, void>)
+        return {};
+      else
+        return std::make_shared<operator_queue<T>>(capacity);
+    },
+    type);
+}
+
+} // namespace vast
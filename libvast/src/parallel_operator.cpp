@@ -0,0 +1,520 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/parallel_operator.hpp"
+
+#include "vast/defaults.hpp"
+#include "vast/detail/assert.hpp"
+#include "vast/detail/cpu_affinity.hpp"
+#include "vast/error.hpp"
+#include "vast/logger.hpp"
+#include "vast/modules.hpp"
+#include "vast/operator_control_plane.hpp"
+#include "vast/operator_queue.hpp"
+
+#include <caf/settings.hpp>
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace vast {
+
+namespace {
+
+auto empty(const table_slice& slice) -> bool {
+  return slice.rows() == 0;
+}
+
+auto empty(const chunk_ptr& chunk) -> bool {
+  return !chunk || chunk->size() == 0;
+}
+
+/// The control plane of a single instance of a parallel operator. Instances
+/// run outside of an actor, so they report errors back to the thread that
+/// merges their output.
+class instance_control_plane final : public operator_control_plane {
+public:
+  instance_control_plane(const operator_base& op, system::node_actor node)
+    : op_{op}, node_{std::move(node)} {
+  }
+
+  auto get_error() const -> caf::error {
+    return error_;
+  }
+
+  auto self() noexcept -> system::execution_node_actor::base& override {
+    die("not implemented");
+  }
+
+  auto node() noexcept -> system::node_actor override {
+    return node_;
+  }
+
+  auto abort(caf::error error) noexcept -> void override {
+    VAST_ASSERT(error != caf::none);
+    error_ = std::move(error);
+  }
+
+  auto warn(caf::error err) noexcept -> void override {
+    VAST_WARN("[WARN] {}: {}", op_.to_string(), err);
+  }
+
+  auto emit(table_slice) noexcept -> void override {
+    die("not implemented");
+  }
+
+  auto schemas() const noexcept -> const std::vector<type>& override {
+    return vast::modules::schemas();
+  }
+
+  auto concepts() const noexcept -> const concepts_map& override {
+    return vast::modules::concepts();
+  }
+
+private:
+  const operator_base& op_;
+  system::node_actor node_;
+  caf::error error_{};
+};
+
+/// Feeds an instance with batches from its input queue, and remembers the
+/// sequence number of the batch that the instance currently processes.
+template <class Input, class Output>
+auto instance_input(std::shared_ptr<operator_queue<Input>> input,
+                    std::shared_ptr<operator_queue<Output>> output,
+                    std::optional<uint64_t>& current) -> generator<Input> {
+  // An operator only requests the next batch after it yielded all output for
+  // the previous batch, which we mark with an empty batch in the output. This
+  // also applies when no next batch arrives in time, as otherwise the merge
+  // would hold back the output for the previous batch until it does.
+  auto finish_current = [&] {
+    if (current)
+      (void)output->push(Output{}, *current);
+    current.reset();
+  };
+  auto batch = Input{};
+  auto sequence = uint64_t{};
+  while (true) {
+    switch (input->pop(batch, sequence, defaults::exec::queue_poll_interval)) {
+      case operator_queue_status::ok:
+        finish_current();
+        current = sequence;
+        co_yield std::move(batch);
+        batch = Input{};
+        break;
+      case operator_queue_status::timeout:
+        finish_current();
+        co_yield Input{};
+        break;
+      case operator_queue_status::closed:
+        finish_current();
+        co_return;
+    }
+  }
+}
+
+template <class Input, class Output>
+auto run_instance(const operator_base& op, system::node_actor node,
+                  const std::shared_ptr<operator_queue<Input>>& input,
+                  const std::shared_ptr<operator_queue<Output>>& output)
+  -> caf::error {
+  auto ctrl = instance_control_plane{op, std::move(node)};
+  auto current = std::optional<uint64_t>{};
+  auto instance
+    = op.instantiate(instance_input(input, output, current), ctrl);
+  if (!instance)
+    return std::move(instance.error());
+  auto* gen = std::get_if<generator<Output>>(&*instance);
+  if (!gen)
+    return caf::make_error(ec::logic_error,
+                           fmt::format("an instance of '{}' does not produce "
+                                       "{}",
+                                       op.to_string(),
+                                       operator_type_name<Output>()));
+  for (auto&& batch : *gen) {
+    if (auto error = ctrl.get_error())
+      return error;
+    if (empty(batch))
+      continue;
+    // Output that an operator yields before its first input belongs to the
+    // first batch.
+    if (!output->push(std::move(batch), current.value_or(0)))
+      return {};
+  }
+  return ctrl.get_error();
+}
+
+/// The instances of a parallel operator together with the queues that
+/// connect them to the thread that runs the parallel operator.
+template <class Input, class Output>
+class instance_group {
+public:
+  instance_group(const operator_base& op, size_t instances, bool per_schema,
+                 bool pinned, system::node_actor node) {
+    VAST_ASSERT(instances > 0);
+    const auto capacity = defaults::exec::queue_capacity;
+    if (per_schema) {
+      for (size_t i = 0; i < instances; ++i)
+        inputs_.push_back(std::make_shared<operator_queue<Input>>(capacity));
+    } else {
+      inputs_.push_back(std::make_shared<operator_queue<Input>>(
+        capacity * instances, 1, instances));
+    }
+    output_ = std::make_shared<operator_queue<Output>>(capacity * instances,
+                                                       instances);
+    const auto cpus
+      = pinned ? detail::numa_ordered_cpus() : std::vector<size_t>{};
+    threads_.reserve(instances);
+    for (size_t i = 0; i < instances; ++i) {
+      auto cpu = cpus.empty() ? std::optional<size_t>{}
+                              : std::optional{cpus[i % cpus.size()]};
+      threads_.emplace_back([this, node, cpu, op = op.copy(),
+                             input = inputs_[i % inputs_.size()]] {
+        if (cpu) {
+          if (auto error = detail::pin_current_thread(*cpu))
+            VAST_DEBUG("running instance of '{}' unpinned: {}",
+                       op->to_string(), error);
+        }
+        auto error = run_instance(*op, node, input, output_);
+        input->cancel();
+        output_->close();
+        if (error) {
+          auto lock = std::lock_guard{mutex_};
+          if (!error_)
+            error_ = std::move(error);
+        }
+      });
+    }
+  }
+
+  instance_group(const instance_group&) = delete;
+  auto operator=(const instance_group&) -> instance_group& = delete;
+
+  ~instance_group() noexcept {
+    close_inputs();
+    output_->cancel();
+    join();
+  }
+
+  /// Returns the queue for the instance that processes *batch*.
+  auto route(const Input& batch) -> operator_queue<Input>& {
+    if constexpr (std::is_same_v<Input, table_slice>) {
+      if (inputs_.size() > 1)
+        return *inputs_[std::hash<type>{}(batch.schema()) % inputs_.size()];
+    }
+    return *inputs_.front();
+  }
+
+  /// Returns the queue that contains the output of all instances.
+  auto output() -> operator_queue<Output>& {
+    return *output_;
+  }
+
+  /// Signals the instances that no more input follows.
+  void close_inputs() {
+    if (std::exchange(inputs_closed_, true))
+      return;
+    for (const auto& input : inputs_)
+      input->close();
+  }
+
+  /// Waits for all instances to finish.
+  void join() {
+    for (auto& thread : threads_)
+      if (thread.joinable())
+        thread.join();
+  }
+
+  /// Returns the first error that an instance reported.
+  auto error() -> caf::error {
+    auto lock = std::lock_guard{mutex_};
+    return error_;
+  }
+
+private:
+  std::vector<std::shared_ptr<operator_queue<Input>>> inputs_;
+  std::shared_ptr<operator_queue<Output>> output_;
+  bool inputs_closed_ = false;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  caf::error error_;
+};
+
+/// Merges the output of the instances of a parallel operator.
+template <class Output>
+class output_merger {
+public:
+  /// Creates a merger.
+  /// @param ordered Whether to release output in the order of the input.
+  /// @param max_backlog The maximum number of input batches after the oldest
+  /// unfinished one that may be in flight when preserving order.
+  output_merger(bool ordered, uint64_t max_backlog)
+    : ordered_{ordered}, max_backlog_{max_backlog} {
+  }
+
+  /// Checks whether the input batch with the given sequence number may be
+  /// handed to an instance. When preserving order, the merger must hold back
+  /// the output of all batches after the oldest unfinished one, so a single
+  /// slow batch would otherwise let the output of all other instances pile up
+  /// without bound.
+  auto accepts(uint64_t sequence) const -> bool {
+    return !ordered_ || sequence < next_ + max_backlog_;
+  }
+
+  /// Adds a batch that an instance produced for the input batch with the given
+  /// sequence number. An empty batch marks that the instance yielded all of
+  /// its output for that input batch.
+  void add(Output batch, uint64_t sequence) {
+    if (!ordered_ || sequence < next_) {
+      if (!empty(batch))
+        ready_.push_back(std::move(batch));
+      return;
+    }
+    auto& entry = pending_[sequence];
+    if (empty(batch))
+      entry.done = true;
+    else
+      entry.batches.push_back(std::move(batch));
+    auto it = pending_.begin();
+    while (it != pending_.end() && it->first == next_ && it->second.done) {
+      release(it->second);
+      it = pending_.erase(it);
+      ++next_;
+    }
+  }
+
+  /// Releases all pending batches in order, regardless of whether their
+  /// instances finished them.
+  void flush() {
+    for (auto& [_, entry] : pending_)
+      release(entry);
+    pending_.clear();
+  }
+
+  /// Removes the batches that may leave the parallel operator.
+  auto take() -> std::vector<Output> {
+    return std::exchange(ready_, {});
+  }
+
+private:
+  struct pending {
+    std::vector<Output> batches = {};
+    bool done = false;
+  };
+
+  void release(pending& entry) {
+    ready_.insert(ready_.end(), std::make_move_iterator(entry.batches.begin()),
+                  std::make_move_iterator(entry.batches.end()));
+  }
+
+  bool ordered_;
+  uint64_t max_backlog_;
+  uint64_t next_ = 0;
+  std::map<uint64_t, pending> pending_;
+  std::vector<Output> ready_;
+};
+
+template <class Input, class Output>
+auto run_parallel(generator<Input> input, operator_control_plane& ctrl,
+                  const operator_base& op, size_t instances, bool per_schema,
+                  bool ordered, bool pinned) -> generator<Output> {
+  auto group = instance_group<Input, Output>{op, instances, per_schema, pinned,
+                                             ctrl.node()};
+  auto merger = output_merger<Output>{
+    ordered, defaults::exec::queue_capacity * instances};
+  auto batch = Output{};
+  auto sequence = uint64_t{};
+  auto next = uint64_t{0};
+  auto abandoned = false;
+  for (auto&& x : input) {
+    if (!empty(x)) {
+      auto& queue = group.route(x);
+      const auto current = next++;
+      while (true) {
+        if (merger.accepts(current)) {
+          const auto status
+            = queue.push(x, current, std::chrono::steady_clock::duration{});
+          if (status == operator_queue_status::ok)
+            break;
+          if (status == operator_queue_status::closed) {
+            abandoned = true;
+            break;
+          }
+        }
+        // All instances are busy, or the merger holds back too much output.
+        // Every instance marks the end of a batch in its output right before
+        // it takes the next one or runs out of input, so we forward their
+        // output until a slot becomes free and the oldest batch is done.
+        const auto status = group.output().pop(
+          batch, sequence, defaults::exec::queue_poll_interval);
+        if (status == operator_queue_status::ok)
+          merger.add(std::move(batch), sequence);
+        if (status == operator_queue_status::closed) {
+          abandoned = true;
+          break;
+        }
+        for (auto& y : merger.take())
+          co_yield std::move(y);
+      }
+      if (abandoned)
+        break;
+    }
+    while (group.output().pop(batch, sequence,
+                              std::chrono::steady_clock::duration{})
+           == operator_queue_status::ok)
+      merger.add(std::move(batch), sequence);
+    if (auto error = group.error()) {
+      ctrl.abort(std::move(error));
+      co_return;
+    }
+    auto ready = merger.take();
+    if (ready.empty())
+      co_yield {};
+    for (auto& y : ready)
+      co_yield std::move(y);
+  }
+  group.close_inputs();
+  while (true) {
+    const auto status = group.output().pop(
+      batch, sequence, defaults::exec::queue_poll_interval);
+    if (status == operator_queue_status::closed)
+      break;
+    if (status == operator_queue_status::ok)
+      merger.add(std::move(batch), sequence);
+    auto ready = merger.take();
+    if (ready.empty())
+      co_yield {};
+    for (auto& y : ready)
+      co_yield std::move(y);
+  }
+  group.join();
+  if (auto error = group.error()) {
+    ctrl.abort(std::move(error));
+    co_return;
+  }
+  merger.flush();
+  for (auto& y : merger.take())
+    co_yield std::move(y);
+}
+
+auto configured_instances(const caf::settings& options,
+                          std::optional<uint64_t> instances = {}) -> uint64_t {
+  auto result = instances.value_or(caf::get_or(
+    options, "vast.exec.parallelism", defaults::exec::parallelism));
+  if (result == 0)
+    result = std::max(std::thread::hardware_concurrency(), 1u);
+  return result;
+}
+
+} // namespace
+
+parallel_operator::parallel_operator(operator_ptr op, size_t instances,
+                                     bool ordered, bool pinned)
+  : op_{std::move(op)},
+    instances_{instances},
+    ordered_{ordered},
+    pinned_{pinned} {
+  VAST_ASSERT(op_);
+  VAST_ASSERT(op_->parallelism() != operator_parallelism::none);
+  VAST_ASSERT(instances_ > 0);
+}
+
+auto parallel_operator::instantiate(operator_input input,
+                                    operator_control_plane& ctrl) const
+  -> caf::expected<operator_output> {
+  auto output = op_->infer_type(to_operator_type(input));
+  if (!output)
+    return std::move(output.error());
+  const auto per_schema
+    = op_->parallelism() == operator_parallelism::per_schema;
+  return std::visit(
+    [&]<class Input, class Output>(
+      Input& gen, tag<Output>) -> caf::expected<operator_output> {
+      if constexpr (std::is_same_v<Input, std::monostate>
+                    || std::is_same_v<Output, void>) {
+        // Sources and sinks have no batches to distribute or to merge.
+        return op_->instantiate(std::move(gen), ctrl);
+      } else {
+        using batch_type = typename Input::value_type;
+        // Bytes have no schema to partition by.
+        if (per_schema && std::is_same_v<batch_type, chunk_ptr>)
+          return op_->instantiate(std::move(gen), ctrl);
+        return run_parallel<batch_type, Output>(
+          std::move(gen), ctrl, *op_, instances_, per_schema, ordered_,
+          pinned_);
+      }
+    },
+    input, *output);
+}
+
+auto parallel_operator::copy() const -> operator_ptr {
+  return std::make_unique<parallel_operator>(op_->copy(), instances_,
+                                             ordered_, pinned_);
+}
+
+auto parallel_operator::to_string() const -> std::string {
+  return op_->to_string();
+}
+
+auto parallel_operator::location() const -> operator_location {
+  return op_->location();
+}
+
+auto parallel_operator::detached() const -> bool {
+  // The operator blocks while it waits for its instances.
+  return true;
+}
+
+auto parallel_operator::infer_type_impl(operator_type input) const
+  -> caf::expected<operator_type> {
+  return op_->infer_type(input);
+}
+
+auto parallelize(operator_ptr op, const caf::settings& options,
+                 std::optional<uint64_t> instances) -> operator_ptr {
+  if (op->parallelism() == operator_parallelism::none)
+    return op;
+  const auto effective_instances = configured_instances(options, instances);
+  if (effective_instances <= 1)
+    return op;
+  const auto ordered = caf::get_or(options, "vast.exec.preserve-order",
+                                   defaults::exec::preserve_order);
+  const auto pinned = caf::get_or(options, "vast.exec.pin-threads",
+                                  defaults::exec::pin_threads);
+  return std::make_unique<parallel_operator>(
+    std::move(op), effective_instances, ordered, pinned);
+}
+
+auto parallelize(std::vector<operator_ptr> ops, const caf::settings& options)
+  -> std::vector<operator_ptr> {
+  if (configured_instances(options) <= 1)
+    return ops;
+  auto result = std::vector<operator_ptr>{};
+  auto is_stateless = [](const operator_ptr& op) {
+    return op->parallelism() == operator_parallelism::stateless;
+  };
+  for (auto it = ops.begin(); it != ops.end();) {
+    const auto end = std::find_if_not(it, ops.end(), is_stateless);
+    if (std::distance(it, end) > 1) {
+      result.push_back(std::make_unique<pipeline>(std::vector<operator_ptr>{
+        std::make_move_iterator(it), std::make_move_iterator(end)}));
+      it = end;
+    } else {
+      result.push_back(std::move(*it));
+      ++it;
+    }
+  }
+  for (auto& op : result)
+    op = parallelize(std::move(op), options);
+  return result;
+}
+
+} // namespace vast
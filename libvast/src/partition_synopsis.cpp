@@ -14,6 +14,8 @@
 #include "vast/index_config.hpp"
 #include "vast/synopsis_factory.hpp"
 
+#include <fmt/format.h>
+
 namespace vast {
 
 partition_synopsis::partition_synopsis(partition_synopsis&& that) noexcept {
@@ -24,6 +26,7 @@ partition_synopsis::partition_synopsis(partition_synopsis&& that) noexcept {
   schema = std::exchange(that.schema, {});
   type_synopses_ = std::exchange(that.type_synopses_, {});
   field_synopses_ = std::exchange(that.field_synopses_, {});
+  null_fields_ = std::exchange(that.null_fields_, {});
   memusage_.store(that.memusage_.exchange(0));
 }
 
@@ -37,6 +40,7 @@ partition_synopsis::operator=(partition_synopsis&& that) noexcept {
     schema = std::exchange(that.schema, {});
     type_synopses_ = std::exchange(that.type_synopses_, {});
     field_synopses_ = std::exchange(that.field_synopses_, {});
+    null_fields_ = std::exchange(that.null_fields_, {});
     memusage_.store(that.memusage_.exchange(0));
   }
   return *this;
@@ -114,7 +118,9 @@ void partition_synopsis::add(const table_slice& slice,
     = get_type_fprate(fp_rates, vast::type{ip_type{}});
   for (size_t col = 0; col < slice.columns(); ++col, ++leaf_it) {
     auto&& leaf = *leaf_it;
+    auto field = qualified_record_field{schema, leaf.index};
     auto add_column = [&](const synopsis_ptr& syn) {
+      auto has_nulls = false;
       for (size_t row = 0; row < slice.rows(); ++row) {
         auto view = slice.at(row, col, leaf.field.type);
         // TODO: It would probably make sense to allow `null` in the
@@ -122,11 +128,14 @@ void partition_synopsis::add(const table_slice& slice,
         // like normal queries.
         if (!caf::holds_alternative<caf::none_t>(view))
           syn->add(std::move(view));
+        else
+          has_nulls = true;
       }
+      if (has_nulls && null_fields_)
+        null_fields_->insert(field);
     };
     // Make a field synopsis if it was configured.
-    if (auto key = qualified_record_field{schema, leaf.index};
-        auto fprate = get_field_fprate(fp_rates, key)) {
+    if (auto key = field; auto fprate = get_field_fprate(fp_rates, key)) {
       // Locate the relevant synopsis.
       auto it = field_synopses_.find(key);
       if (it == field_synopses_.end()) {
@@ -164,6 +173,11 @@ void partition_synopsis::add(const table_slice& slice,
   }
 }
 
+bool partition_synopsis::may_have_nulls(
+  const qualified_record_field& field) const {
+  return !null_fields_ || null_fields_->contains(field);
+}
+
 size_t partition_synopsis::memusage() const {
   size_t result = memusage_;
   if (result == size_t{0}) {
@@ -199,6 +213,7 @@ partition_synopsis* partition_synopsis::copy() const {
     else
       result->field_synopses_[field] = nullptr;
   }
+  result->null_fields_ = null_fields_;
   return result.release();
 }
 
@@ -223,6 +238,21 @@ pack(flatbuffers::FlatBufferBuilder& builder, const partition_synopsis& x) {
   auto schema_bytes = as_bytes(x.schema);
   auto schema_vector = builder.CreateVector(
     reinterpret_cast<const uint8_t*>(schema_bytes.data()), schema_bytes.size());
+  auto null_fields_vector
+    = flatbuffers::Offset<flatbuffers::Vector<uint64_t>>{};
+  if (x.null_fields_ && x.schema) {
+    const auto& schema = caf::get<record_type>(x.schema);
+    auto null_fields = std::vector<uint64_t>{};
+    null_fields.reserve(x.null_fields_->size());
+    auto flat_index = uint64_t{0};
+    for (auto&& leaf : schema.leaves()) {
+      const auto field = qualified_record_field{x.schema, leaf.index};
+      if (x.null_fields_->contains(field))
+        null_fields.push_back(flat_index);
+      ++flat_index;
+    }
+    null_fields_vector = builder.CreateVector(null_fields);
+  }
   fbs::partition_synopsis::LegacyPartitionSynopsisBuilder ps_builder(builder);
   ps_builder.add_synopses(synopses_vector);
   vast::fbs::uinterval id_range{0, x.events};
@@ -233,6 +263,8 @@ pack(flatbuffers::FlatBufferBuilder& builder, const partition_synopsis& x) {
   ps_builder.add_import_time_range(&import_time_range);
   ps_builder.add_version(x.version);
   ps_builder.add_schema(schema_vector);
+  if (!null_fields_vector.IsNull())
+    ps_builder.add_null_fields(null_fields_vector);
   return ps_builder.Finish();
 }
 
@@ -285,6 +317,21 @@ caf::error unpack(const fbs::partition_synopsis::LegacyPartitionSynopsis& x,
     ps.schema = type{chunk::copy(as_bytes(*schema))};
   if (!x.synopses())
     return caf::make_error(ec::format_error, "missing synopses");
+  ps.null_fields_ = std::nullopt;
+  if (const auto* null_fields = x.null_fields(); null_fields && ps.schema) {
+    const auto& schema = caf::get<record_type>(ps.schema);
+    const auto num_leaves = schema.num_leaves();
+    ps.null_fields_.emplace();
+    for (const auto flat_index : *null_fields) {
+      if (flat_index >= num_leaves)
+        return caf::make_error(ec::format_error,
+                               fmt::format("null field index {} is out of "
+                                           "bounds for schema with {} fields",
+                                           flat_index, num_leaves));
+      ps.null_fields_->emplace(ps.schema,
+                               schema.resolve_flat_index(flat_index));
+    }
+  }
   return unpack_(*x.synopses(), ps);
 }
 
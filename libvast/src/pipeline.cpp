@@ -9,6 +9,7 @@
 #include "vast/pipeline.hpp"
 
 #include "vast/collect.hpp"
+#include "vast/fused_operator.hpp"
 #include "vast/modules.hpp"
 #include "vast/plugin.hpp"
 
@@ -53,6 +54,22 @@ private:
   caf::error error_{};
 };
 
+namespace {
+
+/// Returns the end of the run of fusable operators that starts at *begin*.
+/// All operators of a run share the same location.
+template <class Iterator>
+auto fusable_run_end(Iterator begin, Iterator end) -> Iterator {
+  if (begin == end || !is_fusable(**begin))
+    return begin;
+  const auto location = (*begin)->location();
+  return std::find_if_not(std::next(begin), end, [&](const operator_ptr& op) {
+    return is_fusable(*op) && op->location() == location;
+  });
+}
+
+} // namespace
+
 pipeline::pipeline(std::vector<operator_ptr> operators) {
   operators_.reserve(operators.size());
   for (auto&& op : operators) {
@@ -64,6 +81,7 @@ pipeline::pipeline(std::vector<operator_ptr> operators) {
       operators_.push_back(std::move(op));
     }
   }
+  push_down_limits();
 }
 
 auto pipeline::parse(std::string_view repr) -> caf::expected<pipeline> {
@@ -107,6 +125,7 @@ void pipeline::append(operator_ptr op) {
   } else {
     operators_.push_back(std::move(op));
   }
+  push_down_limits();
 }
 
 void pipeline::prepend(operator_ptr op) {
@@ -117,6 +136,42 @@ void pipeline::prepend(operator_ptr op) {
   } else {
     operators_.insert(operators_.begin(), std::move(op));
   }
+  push_down_limits();
+}
+
+void pipeline::push_down_limits() {
+  auto it = operators_.begin();
+  while (it != operators_.end() && std::next(it) != operators_.end()) {
+    const auto next = std::next(it);
+    if (const auto limit = (*next)->row_limit()) {
+      if (auto replacement = (*it)->limit_pushdown(*limit)) {
+        // The replacement may be able to absorb yet another limit.
+        *it = std::move(replacement);
+        operators_.erase(next);
+        continue;
+      }
+    }
+    ++it;
+  }
+}
+
+auto pipeline::fuse(std::vector<operator_ptr> ops)
+  -> std::vector<operator_ptr> {
+  auto result = std::vector<operator_ptr>{};
+  result.reserve(ops.size());
+  for (auto it = ops.begin(); it != ops.end();) {
+    const auto end = fusable_run_end(it, ops.end());
+    if (std::distance(it, end) > 1) {
+      auto run = std::vector<operator_ptr>{std::make_move_iterator(it),
+                                           std::make_move_iterator(end)};
+      result.push_back(std::make_unique<fused_operator>(std::move(run)));
+      it = end;
+    } else {
+      result.push_back(std::move(*it));
+      ++it;
+    }
+  }
+  return result;
 }
 
 auto pipeline::unwrap() && -> std::vector<operator_ptr> {
@@ -157,11 +212,23 @@ auto pipeline::instantiate(operator_input input,
   auto it = operators_.begin();
   auto end = operators_.end();
   while (true) {
-    auto output = (*it)->instantiate(std::move(input), control);
+    // Adjacent fusable operators run as one. The fused operator is only a
+    // temporary, as its output owns copies of the operators.
+    const auto run_end = fusable_run_end(it, end);
+    auto output = [&]() -> caf::expected<operator_output> {
+      if (std::distance(it, run_end) > 1) {
+        auto ops = std::vector<operator_ptr>{};
+        ops.reserve(std::distance(it, run_end));
+        for (; it != run_end; ++it)
+          ops.push_back((*it)->copy());
+        return fused_operator{std::move(ops)}.instantiate(std::move(input),
+                                                          control);
+      }
+      return (*it++)->instantiate(std::move(input), control);
+    }();
     if (!output) {
       return output.error();
     }
-    ++it;
     if (it == end) {
       return output;
     }
@@ -181,6 +248,15 @@ auto pipeline::instantiate(operator_input input,
   }
 }
 
+auto pipeline::parallelism() const -> operator_parallelism {
+  if (operators_.empty())
+    return operator_parallelism::none;
+  for (const auto& op : operators_)
+    if (op->parallelism() != operator_parallelism::stateless)
+      return operator_parallelism::none;
+  return operator_parallelism::stateless;
+}
+
 auto pipeline::predicate_pushdown(const expression& expr) const
   -> std::optional<std::pair<expression, operator_ptr>> {
   auto result = predicate_pushdown_pipeline(expr);
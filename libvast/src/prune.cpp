@@ -21,7 +21,8 @@ struct pruner {
     return disjunction{run(d)};
   }
   expression operator()(const negation& n) const {
-    return negation{caf::visit(*this, n.expr())};
+    auto inner = pruner{unprunable_fields_, !negated_};
+    return negation{caf::visit(inner, n.expr())};
   }
   expression operator()(const predicate& p) const {
     return p;
@@ -34,6 +35,14 @@ struct pruner {
     std::vector<vast::predicate*> memo;
     for (const auto& operand : connective) {
       bool optimized = false;
+      // Replacing predicates with `:string` widens the set of partitions
+      // they select. Below a negation that would narrow the set of partitions
+      // the negated expression selects, causing the catalog to miss
+      // partitions now that it can prune with negated predicates.
+      if (negated_) {
+        result.push_back(caf::visit(*this, operand));
+        continue;
+      }
       if (const auto* pred = caf::get_if<predicate>(&operand)) {
         if (caf::holds_alternative<field_extractor>(pred->lhs)
             || (caf::holds_alternative<type_extractor>(pred->lhs)
@@ -71,6 +80,9 @@ struct pruner {
   }
 
   detail::heterogeneous_string_hashset const& unprunable_fields_;
+
+  /// Whether the pruner runs below an odd number of negations.
+  bool negated_ = false;
 };
 
 // Runs the `pruner` and `hoister` until the input is unchanged.
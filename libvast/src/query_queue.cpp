@@ -9,31 +9,82 @@
 #include "vast/query_queue.hpp"
 
 #include "vast/detail/algorithms.hpp"
+#include "vast/detail/assert.hpp"
 #include "vast/system/catalog.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
 namespace vast {
 
 namespace {
+
+/// The amount by which every scheduled partition pushes back the deadline of a
+/// query with normal priority. Queries with a lower priority get
+/// proportionally more slack.
+constexpr auto normal_priority_slack = std::chrono::milliseconds{100};
+
+/// The maximum factor by which the slack of a low-priority query exceeds that
+/// of a query with normal priority. Without a bound, a low-priority query
+/// would wait for up to 1000 partitions of every normal query that arrived
+/// after it.
+constexpr auto max_slack_factor = duration::rep{10};
+
 std::size_t memusage(const std::vector<query_queue::entry>& entries) {
   return std::accumulate(cbegin(entries), cend(entries), std::size_t{0u},
                          [](const auto& accumulated, const auto& current) {
                            return accumulated + current.memusage();
                          });
 }
+
+std::size_t
+memusage(const std::unordered_map<uuid, query_queue::entry>& entries) {
+  return std::accumulate(cbegin(entries), cend(entries), std::size_t{0u},
+                         [](const auto& accumulated, const auto& current) {
+                           return accumulated + sizeof(current.first)
+                                  + current.second.memusage();
+                         });
+}
+
 } // namespace
 
-bool operator<(const query_queue::entry& lhs,
-               const query_queue::entry& rhs) noexcept {
-  const auto lhs_num_queries = lhs.queries.size();
-  const auto rhs_num_queries = rhs.queries.size();
-  return std::tie(lhs.priority, lhs_num_queries)
-         < std::tie(rhs.priority, rhs_num_queries);
+time query_state::deadline() const {
+  VAST_ASSERT(!query_contexts_per_type.empty());
+  const auto priority = std::max(
+    query_contexts_per_type.begin()->second.priority, uint64_t{1});
+  const auto slack
+    = std::min(duration{normal_priority_slack}
+                 * static_cast<duration::rep>(query_context::priority::normal)
+                 / static_cast<duration::rep>(priority),
+               duration{normal_priority_slack} * max_slack_factor);
+  return arrival + slack * (duration::rep{1} + scheduled_partitions);
+}
+
+query_queue::query_queue(std::function<time()> clock)
+  : clock_{std::move(clock)} {
+  VAST_ASSERT(clock_);
 }
 
 bool operator==(const query_queue::entry& lhs, const uuid& rhs) noexcept {
   return lhs.partition == rhs;
 }
 
+bool query_queue::schedule_key::after(const schedule_key& lhs,
+                                     const schedule_key& rhs) noexcept {
+  if (lhs.deadline != rhs.deadline)
+    return lhs.deadline > rhs.deadline;
+  if (lhs.num_queries != rhs.num_queries)
+    return lhs.num_queries < rhs.num_queries;
+  return rhs.partition < lhs.partition;
+}
+
+bool query_queue::schedule_key::same(const schedule_key& lhs,
+                                    const schedule_key& rhs) noexcept {
+  return lhs.deadline == rhs.deadline && lhs.num_queries == rhs.num_queries
+         && lhs.partition == rhs.partition;
+}
+
 size_t query_queue::num_partitions() const {
   return partitions.size() + inactive_partitions.size();
 }
@@ -47,15 +98,15 @@ size_t query_queue::num_queries() const {
 }
 
 [[nodiscard]] bool query_queue::reachable(const uuid& qid) const {
-  auto run = [&](const auto& ps) {
-    return std::any_of(ps.begin(), ps.end(), [&](const auto& x) {
-      return std::any_of(x.queries.begin(), x.queries.end(),
-                         [&](const auto& q) {
-                           return qid == q;
-                         });
-    });
+  auto has_query = [&](const entry& x) {
+    return detail::contains(x.queries, qid);
   };
-  return run(partitions) || run(inactive_partitions);
+  return std::any_of(partitions.begin(), partitions.end(),
+                     [&](const auto& x) {
+                       return has_query(x.second);
+                     })
+         || std::any_of(inactive_partitions.begin(), inactive_partitions.end(),
+                        has_query);
 }
 
 [[nodiscard]] uuid query_queue::create_query_id() const {
@@ -82,42 +133,44 @@ query_queue::insert(query_state&& query_state,
     return caf::make_error(ec::unspecified, "the candidate set size must match "
                                             "the query state");
   auto qid = query_state.query_contexts_per_type.begin()->second.id;
+  query_state.arrival = clock_();
   auto [query_state_it, emplace_success]
     = queries_.emplace(qid, std::move(query_state));
   if (!emplace_success)
     return caf::make_error(ec::unspecified, "A query with this ID exists "
                                             "already");
+  const auto priority
+    = query_state_it->second.query_contexts_per_type.begin()->second.priority;
   for (const auto& [schema, cand_info] : candidates.candidate_infos) {
     for (const auto& cand : cand_info.partition_infos) {
-      auto it = std::find(partitions.begin(), partitions.end(), cand.uuid);
-      if (it != partitions.end()) {
-        it->priority += query_state_it->second.query_contexts_per_type.begin()
-                          ->second.priority;
-        it->queries.push_back(qid);
+      if (auto it = partitions.find(cand.uuid); it != partitions.end()) {
+        it->second.priority += priority;
+        it->second.queries.push_back(qid);
         VAST_ASSERT(!detail::contains(inactive_partitions, cand.uuid),
                     "A partition must not be active and inactive at the same "
                     "time");
+        schedule(it->second);
         continue;
       }
-      it = std::find(inactive_partitions.begin(), inactive_partitions.end(),
-                     cand.uuid);
+      auto it = std::find(inactive_partitions.begin(),
+                          inactive_partitions.end(), cand.uuid);
       if (it != inactive_partitions.end()) {
-        it->priority += query_state_it->second.query_contexts_per_type.begin()
-                          ->second.priority;
+        it->priority += priority;
         it->queries.push_back(qid);
-        partitions.push_back(std::move(*it));
-
+        const auto& partition
+          = partitions.emplace(cand.uuid, std::move(*it)).first->second;
         inactive_partitions.erase(it);
+        schedule(partition);
         continue;
       }
-      partitions.push_back(query_queue::entry{
-        cand.uuid, schema,
-        query_state_it->second.query_contexts_per_type.begin()->second.priority,
-        std::vector{qid}, false});
+      const auto& partition
+        = partitions
+            .emplace(cand.uuid, query_queue::entry{cand.uuid, schema, priority,
+                                                   std::vector{qid}, false})
+            .first->second;
+      schedule(partition);
     }
   }
-  // TODO: Insertion sort should be better.
-  std::sort(partitions.begin(), partitions.end());
   return caf::none;
 }
 
@@ -127,19 +180,23 @@ query_queue::activate(const uuid& qid, uint32_t num_partitions) {
   if (it == queries_.end())
     return caf::make_error(ec::unspecified, "cannot activate unknown query");
   it->second.requested_partitions += num_partitions;
+  // The query may have been inactive, in which case the active partitions
+  // that it shares with other queries may move forward in the schedule.
+  for (const auto& [_, partition] : partitions)
+    if (detail::contains(partition.queries, qid))
+      schedule(partition);
   // Go over all currently inactive partitions and splice those relevant for
   // `qid` back into the active queue.
   auto new_inactive = std::vector<query_queue::entry>{};
-  std::partition_copy(std::make_move_iterator(inactive_partitions.begin()),
-                      std::make_move_iterator(inactive_partitions.end()),
-                      std::back_inserter(partitions),
-                      std::back_inserter(new_inactive), [&](const auto& p) {
-                        return std::find(p.queries.begin(), p.queries.end(),
-                                         qid)
-                               != p.queries.end();
-                      });
+  for (auto& partition : inactive_partitions) {
+    if (!detail::contains(partition.queries, qid)) {
+      new_inactive.push_back(std::move(partition));
+      continue;
+    }
+    const auto id = partition.partition;
+    schedule(partitions.emplace(id, std::move(partition)).first->second);
+  }
   inactive_partitions = std::move(new_inactive);
-  std::sort(partitions.begin(), partitions.end());
   return caf::none;
 }
 
@@ -149,36 +206,30 @@ query_queue::activate(const uuid& qid, uint32_t num_partitions) {
   if (it == queries_.end())
     return caf::make_error(ec::unspecified, "cannot remove unknown query");
   queries_.erase(it);
-  auto run = [&](auto& queue) {
-    auto it = queue.begin();
-    while (it < queue.end()) {
-      auto queries_it = std::find(it->queries.begin(), it->queries.end(), qid);
-      if (queries_it == it->queries.end()) {
-        ++it;
-        continue;
-      }
-      it->queries.erase(queries_it);
-      if (it->queries.empty())
-        it = queue.erase(it);
-      else
-        ++it;
-    }
-  };
-  run(partitions);
-  run(inactive_partitions);
+  // Removing a query only ever pushes partitions back in the schedule, so
+  // there is no need to update it here.
+  std::erase_if(partitions, [&](auto& x) {
+    auto& queries = x.second.queries;
+    std::erase(queries, qid);
+    return queries.empty();
+  });
+  std::erase_if(inactive_partitions, [&](auto& x) {
+    std::erase(x.queries, qid);
+    return x.queries.empty();
+  });
   return caf::none;
 }
 
 bool query_queue::mark_partition_erased(const uuid& pid) {
-  auto it = std::find(partitions.begin(), partitions.end(), pid);
-  if (it != partitions.end()) {
-    it->erased = true;
+  if (auto it = partitions.find(pid); it != partitions.end()) {
+    it->second.erased = true;
     VAST_ASSERT_CHEAP(!detail::contains(inactive_partitions, pid),
                       "A partition must not be active and inactive at the same "
                       "time");
     return true;
   }
-  it = std::find(inactive_partitions.begin(), inactive_partitions.end(), pid);
+  auto it
+    = std::find(inactive_partitions.begin(), inactive_partitions.end(), pid);
   if (it != inactive_partitions.end()) {
     it->erased = true;
     return true;
@@ -186,10 +237,46 @@ bool query_queue::mark_partition_erased(const uuid& pid) {
   return false;
 }
 
+query_queue::schedule_key
+query_queue::make_schedule_key(const entry& partition) const {
+  // Partitions without active queries sort last, so that they are deactivated
+  // only once no other partition can be scheduled.
+  auto result = schedule_key{time::max(), partition.queries.size(),
+                             partition.partition};
+  for (const auto& qid : partition.queries) {
+    const auto it = queries_.find(qid);
+    if (it == queries_.end())
+      continue;
+    const auto& query_state = it->second;
+    if (query_state.requested_partitions > query_state.scheduled_partitions)
+      result.deadline = std::min(result.deadline, query_state.deadline());
+  }
+  return result;
+}
+
+void query_queue::schedule(const entry& partition) {
+  schedule_.push_back(make_schedule_key(partition));
+  std::push_heap(schedule_.begin(), schedule_.end(), schedule_key::after);
+}
+
 std::optional<query_queue::entry> query_queue::next() {
-  while (!partitions.empty()) {
-    auto result = std::move(partitions.back());
-    partitions.pop_back();
+  while (!schedule_.empty()) {
+    std::pop_heap(schedule_.begin(), schedule_.end(), schedule_key::after);
+    const auto key = schedule_.back();
+    schedule_.pop_back();
+    auto partition = partitions.find(key.partition);
+    if (partition == partitions.end())
+      continue;
+    // The key at the top of the heap is a lower bound. If it is outdated, we
+    // put the partition back with its actual key and look again.
+    if (auto actual = make_schedule_key(partition->second); actual != key) {
+      VAST_ASSERT(!after(key, actual));
+      schedule_.push_back(actual);
+      std::push_heap(schedule_.begin(), schedule_.end(), schedule_key::after);
+      continue;
+    }
+    auto result = std::move(partition->second);
+    partitions.erase(partition);
     auto active
       = entry{result.partition, result.schema, 0ull, {}, result.erased};
     auto inactive
@@ -270,7 +357,8 @@ std::size_t query_queue::memusage() const {
     usage += sizeof(uid) + query_state.memusage();
   }
   return usage + vast::memusage(partitions)
-         + vast::memusage(inactive_partitions);
+         + vast::memusage(inactive_partitions)
+         + schedule_.capacity() * sizeof(schedule_key);
 }
 
 } // namespace vast
@@ -0,0 +1,725 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/roaring_bitmap.hpp"
+
+#include "vast/error.hpp"
+#include "vast/fbs/bitmap.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace vast {
+
+namespace {
+
+using block_type = roaring_bitmap::block_type;
+using container = roaring_bitmap::container;
+using container_kind = roaring_bitmap::container_kind;
+using word_type = roaring_bitmap::word_type;
+
+constexpr auto bitset_size = roaring_bitmap::bitset_size;
+constexpr auto max_array_size = roaring_bitmap::max_array_size;
+constexpr auto chunk_size = static_cast<uint32_t>(roaring_bitmap::chunk_size);
+
+// -- bitset kernels -----------------------------------------------------------
+//
+// The kernels below operate on complete bitset containers. Their loops have a
+// fixed trip count and no dependencies between iterations, which allows the
+// compiler to vectorize them for the target instruction set.
+
+/// Computes the bitwise AND of two bitsets in place.
+/// @returns The cardinality of the result.
+uint32_t and_bitsets(block_type* lhs, const block_type* rhs) noexcept {
+  for (size_t i = 0; i < bitset_size; ++i)
+    lhs[i] &= rhs[i];
+  auto result = uint32_t{0};
+  for (size_t i = 0; i < bitset_size; ++i)
+    result += std::popcount(lhs[i]);
+  return result;
+}
+
+/// Computes the bitwise OR of two bitsets in place.
+/// @returns The cardinality of the result.
+uint32_t or_bitsets(block_type* lhs, const block_type* rhs) noexcept {
+  for (size_t i = 0; i < bitset_size; ++i)
+    lhs[i] |= rhs[i];
+  auto result = uint32_t{0};
+  for (size_t i = 0; i < bitset_size; ++i)
+    result += std::popcount(lhs[i]);
+  return result;
+}
+
+/// Sets the bits in *[first, last)* of a bitset.
+void set_range(std::vector<block_type>& words, uint32_t first, uint32_t last) {
+  if (first >= last)
+    return;
+  const auto first_word = first / word_type::width;
+  const auto last_word = (last - 1) / word_type::width;
+  const auto first_mask = word_type::all << (first % word_type::width);
+  const auto last_mask
+    = word_type::all >> (word_type::width - 1 - (last - 1) % word_type::width);
+  if (first_word == last_word) {
+    words[first_word] |= first_mask & last_mask;
+    return;
+  }
+  words[first_word] |= first_mask;
+  for (auto i = first_word + 1; i < last_word; ++i)
+    words[i] = word_type::all;
+  words[last_word] |= last_mask;
+}
+
+/// Finds the next bit of a given value in a bitset at or after a position.
+/// @returns The position of the bit, or the chunk size if there is none.
+template <bool Bit>
+uint32_t find_next(const std::vector<block_type>& words, uint32_t position) {
+  if (position >= chunk_size)
+    return chunk_size;
+  auto index = position / word_type::width;
+  const auto read = [&](size_t i) {
+    return Bit ? words[i] : ~words[i];
+  };
+  auto word = read(index) & (word_type::all << (position % word_type::width));
+  while (word == 0) {
+    if (++index == bitset_size)
+      return chunk_size;
+    word = read(index);
+  }
+  return index * word_type::width + std::countr_zero(word);
+}
+
+// -- container conversions ----------------------------------------------------
+
+/// Returns the contents of a container as bitset words.
+std::vector<block_type> to_words(const container& x) {
+  if (x.kind == container_kind::bitset)
+    return x.words;
+  auto result = std::vector<block_type>(bitset_size);
+  if (x.kind == container_kind::array) {
+    for (const auto value : x.values)
+      result[value / word_type::width] |= word_type::mask(value
+                                                          % word_type::width);
+  } else {
+    for (size_t i = 0; i < x.values.size(); i += 2)
+      set_range(result, x.values[i],
+                uint32_t{x.values[i]} + x.values[i + 1] + 1);
+  }
+  return result;
+}
+
+/// Creates a container of a given kind from bitset words.
+container
+from_words(std::vector<block_type> words, uint32_t cardinality,
+           container_kind kind) {
+  auto result = container{};
+  result.kind = kind;
+  result.cardinality = cardinality;
+  switch (kind) {
+    case container_kind::array: {
+      result.values.reserve(cardinality);
+      for (size_t i = 0; i < bitset_size; ++i)
+        for (auto word = words[i]; word != 0; word &= word - 1)
+          result.values.push_back(
+            static_cast<uint16_t>(i * word_type::width
+                                  + std::countr_zero(word)));
+      break;
+    }
+    case container_kind::bitset: {
+      result.words = std::move(words);
+      break;
+    }
+    case container_kind::run: {
+      auto position = find_next<true>(words, 0);
+      while (position < chunk_size) {
+        const auto end = find_next<false>(words, position);
+        result.values.push_back(static_cast<uint16_t>(position));
+        result.values.push_back(static_cast<uint16_t>(end - position - 1));
+        position = find_next<true>(words, end);
+      }
+      break;
+    }
+  }
+  return result;
+}
+
+/// Counts the number of runs of 1-bits in a container.
+size_t count_runs(const container& x) {
+  switch (x.kind) {
+    case container_kind::array: {
+      auto result = size_t{0};
+      for (size_t i = 0; i < x.values.size(); ++i)
+        if (i == 0 || x.values[i] != x.values[i - 1] + 1)
+          ++result;
+      return result;
+    }
+    case container_kind::bitset: {
+      // A run starts at every 1-bit whose predecessor is a 0-bit.
+      auto result = size_t{0};
+      auto carry = block_type{0};
+      for (const auto word : x.words) {
+        result += std::popcount(word & ~((word << 1) | carry));
+        carry = word >> (word_type::width - 1);
+      }
+      return result;
+    }
+    case container_kind::run:
+      return x.values.size() / 2;
+  }
+  __builtin_unreachable();
+}
+
+/// Converts a container into its most compact representation.
+void optimize(container& x) {
+  const auto array_bytes = x.cardinality <= max_array_size
+                             ? x.cardinality * sizeof(uint16_t)
+                             : std::numeric_limits<size_t>::max();
+  const auto run_bytes = count_runs(x) * 2 * sizeof(uint16_t);
+  const auto bitset_bytes = bitset_size * sizeof(block_type);
+  auto kind = container_kind::bitset;
+  if (array_bytes <= run_bytes && array_bytes <= bitset_bytes)
+    kind = container_kind::array;
+  else if (run_bytes < bitset_bytes)
+    kind = container_kind::run;
+  if (kind != x.kind)
+    x = from_words(to_words(x), x.cardinality, kind);
+}
+
+/// Checks whether a container has a 1-bit at a position.
+bool contains(const container& x, uint16_t position) {
+  switch (x.kind) {
+    case container_kind::array:
+      return std::binary_search(x.values.begin(), x.values.end(), position);
+    case container_kind::bitset:
+      return (x.words[position / word_type::width]
+              & word_type::mask(position % word_type::width))
+             != 0;
+    case container_kind::run: {
+      // Find the last run that starts at or before the position.
+      auto first = size_t{0};
+      auto last = x.values.size() / 2;
+      while (first < last) {
+        const auto middle = first + (last - first) / 2;
+        if (x.values[middle * 2] <= position)
+          first = middle + 1;
+        else
+          last = middle;
+      }
+      if (first == 0)
+        return false;
+      const auto start = uint32_t{x.values[(first - 1) * 2]};
+      return position <= start + x.values[(first - 1) * 2 + 1];
+    }
+  }
+  __builtin_unreachable();
+}
+
+/// Sets the bits in *[first, last)* of a container.
+/// @pre All 1-bits of the container are before *first*.
+void add_range_to(container& x, uint32_t first, uint32_t last) {
+  const auto n = last - first;
+  switch (x.kind) {
+    case container_kind::array:
+      if (x.cardinality == 0 && n > 1) {
+        x.kind = container_kind::run;
+        x.values = {static_cast<uint16_t>(first), static_cast<uint16_t>(n - 1)};
+      } else if (x.cardinality + n <= max_array_size) {
+        for (auto i = first; i < last; ++i)
+          x.values.push_back(static_cast<uint16_t>(i));
+      } else {
+        x.words = to_words(x);
+        x.values = {};
+        x.kind = container_kind::bitset;
+        set_range(x.words, first, last);
+      }
+      break;
+    case container_kind::bitset:
+      set_range(x.words, first, last);
+      break;
+    case container_kind::run:
+      if (!x.values.empty()
+          && uint32_t{x.values[x.values.size() - 2]} + x.values.back() + 1
+               == first) {
+        x.values.back() += static_cast<uint16_t>(n);
+      } else {
+        x.values.push_back(static_cast<uint16_t>(first));
+        x.values.push_back(static_cast<uint16_t>(n - 1));
+      }
+      // Too many runs take more space than a bitset.
+      if (x.values.size() > 2 * max_array_size) {
+        x.words = to_words(x);
+        x.values = {};
+        x.kind = container_kind::bitset;
+      }
+      break;
+  }
+  x.cardinality += n;
+}
+
+/// Computes the complement of a container within its first *limit* bits.
+container complement(const container& x, uint32_t limit) {
+  auto words = to_words(x);
+  for (auto& word : words)
+    word = ~word;
+  if (limit % word_type::width != 0)
+    words[limit / word_type::width]
+      &= word_type::lsb_mask(limit % word_type::width);
+  for (auto i = (limit + word_type::width - 1) / word_type::width;
+       i < bitset_size; ++i)
+    words[i] = 0;
+  auto result
+    = from_words(std::move(words), limit - x.cardinality, container_kind::bitset);
+  optimize(result);
+  return result;
+}
+
+// -- container operations -----------------------------------------------------
+
+/// Intersects two sorted arrays of positions.
+std::vector<uint16_t> intersect_arrays(const std::vector<uint16_t>& lhs,
+                                       const std::vector<uint16_t>& rhs) {
+  const auto& small = lhs.size() <= rhs.size() ? lhs : rhs;
+  const auto& large = lhs.size() <= rhs.size() ? rhs : lhs;
+  auto result = std::vector<uint16_t>{};
+  result.reserve(small.size());
+  if (small.size() * 64 < large.size()) {
+    // For very different sizes, searching for every element of the smaller
+    // array in the remainder of the larger one is faster than merging.
+    auto it = large.begin();
+    for (const auto value : small) {
+      it = std::lower_bound(it, large.end(), value);
+      if (it == large.end())
+        break;
+      if (*it == value)
+        result.push_back(value);
+    }
+    return result;
+  }
+  // Otherwise we merge without branching on the comparison, which avoids
+  // mispredictions for interleaved inputs.
+  auto i = size_t{0};
+  auto j = size_t{0};
+  while (i < lhs.size() && j < rhs.size()) {
+    const auto x = lhs[i];
+    const auto y = rhs[j];
+    if (x == y)
+      result.push_back(x);
+    i += x <= y;
+    j += y <= x;
+  }
+  return result;
+}
+
+/// Collects the runs of a run container as half-open intervals.
+std::vector<std::pair<uint32_t, uint32_t>> intervals(const container& x) {
+  auto result = std::vector<std::pair<uint32_t, uint32_t>>{};
+  result.reserve(x.values.size() / 2);
+  for (size_t i = 0; i < x.values.size(); i += 2)
+    result.emplace_back(x.values[i],
+                        uint32_t{x.values[i]} + x.values[i + 1] + 1);
+  return result;
+}
+
+/// Creates a run container from sorted, disjoint half-open intervals.
+container
+from_intervals(const std::vector<std::pair<uint32_t, uint32_t>>& xs) {
+  auto result = container{};
+  result.kind = container_kind::run;
+  result.values.reserve(xs.size() * 2);
+  for (const auto& [first, last] : xs) {
+    result.values.push_back(static_cast<uint16_t>(first));
+    result.values.push_back(static_cast<uint16_t>(last - first - 1));
+    result.cardinality += last - first;
+  }
+  return result;
+}
+
+container intersect(const container& lhs, const container& rhs) {
+  auto result = container{};
+  if (lhs.kind == container_kind::array && rhs.kind == container_kind::array) {
+    result.values = intersect_arrays(lhs.values, rhs.values);
+    result.cardinality = result.values.size();
+    return result;
+  }
+  if (lhs.kind == container_kind::array || rhs.kind == container_kind::array) {
+    // Probing the other container for every element of the array is cheap
+    // for both bitset and run containers.
+    const auto& array = lhs.kind == container_kind::array ? lhs : rhs;
+    const auto& other = lhs.kind == container_kind::array ? rhs : lhs;
+    for (const auto value : array.values)
+      if (contains(other, value))
+        result.values.push_back(value);
+    result.cardinality = result.values.size();
+    return result;
+  }
+  if (lhs.kind == container_kind::run && rhs.kind == container_kind::run) {
+    const auto xs = intervals(lhs);
+    const auto ys = intervals(rhs);
+    auto zs = std::vector<std::pair<uint32_t, uint32_t>>{};
+    auto i = size_t{0};
+    auto j = size_t{0};
+    while (i < xs.size() && j < ys.size()) {
+      const auto first = std::max(xs[i].first, ys[j].first);
+      const auto last = std::min(xs[i].second, ys[j].second);
+      if (first < last)
+        zs.emplace_back(first, last);
+      if (xs[i].second < ys[j].second)
+        ++i;
+      else
+        ++j;
+    }
+    result = from_intervals(zs);
+    optimize(result);
+    return result;
+  }
+  auto words = to_words(lhs);
+  const auto other = to_words(rhs);
+  const auto cardinality = and_bitsets(words.data(), other.data());
+  result = from_words(std::move(words), cardinality, container_kind::bitset);
+  optimize(result);
+  return result;
+}
+
+container unite(const container& lhs, const container& rhs) {
+  auto result = container{};
+  if (lhs.kind == container_kind::array && rhs.kind == container_kind::array
+      && lhs.cardinality + rhs.cardinality <= max_array_size) {
+    result.values.reserve(lhs.values.size() + rhs.values.size());
+    std::set_union(lhs.values.begin(), lhs.values.end(), rhs.values.begin(),
+                   rhs.values.end(), std::back_inserter(result.values));
+    result.cardinality = result.values.size();
+    return result;
+  }
+  if (lhs.kind == container_kind::run && rhs.kind == container_kind::run) {
+    const auto xs = intervals(lhs);
+    const auto ys = intervals(rhs);
+    auto zs = std::vector<std::pair<uint32_t, uint32_t>>{};
+    zs.reserve(xs.size() + ys.size());
+    std::merge(xs.begin(), xs.end(), ys.begin(), ys.end(),
+               std::back_inserter(zs));
+    // Coalesce overlapping and adjacent intervals.
+    auto out = size_t{0};
+    for (size_t i = 1; i < zs.size(); ++i) {
+      if (zs[i].first <= zs[out].second)
+        zs[out].second = std::max(zs[out].second, zs[i].second);
+      else
+        zs[++out] = zs[i];
+    }
+    zs.resize(zs.empty() ? 0 : out + 1);
+    result = from_intervals(zs);
+    optimize(result);
+    return result;
+  }
+  auto words = to_words(lhs);
+  const auto other = to_words(rhs);
+  const auto cardinality = or_bitsets(words.data(), other.data());
+  result = from_words(std::move(words), cardinality, container_kind::bitset);
+  optimize(result);
+  return result;
+}
+
+} // namespace
+
+bool operator==(const roaring_bitmap::container& x,
+                const roaring_bitmap::container& y) {
+  if (x.cardinality != y.cardinality)
+    return false;
+  if (x.kind == y.kind)
+    return x.values == y.values && x.words == y.words;
+  return to_words(x) == to_words(y);
+}
+
+roaring_bitmap::roaring_bitmap(size_type n, bool bit) {
+  append_bits(bit, n);
+}
+
+bool roaring_bitmap::empty() const {
+  return num_bits_ == 0;
+}
+
+roaring_bitmap::size_type roaring_bitmap::size() const {
+  return num_bits_;
+}
+
+size_t roaring_bitmap::memusage() const {
+  auto result = keys_.capacity() * sizeof(size_type)
+                + containers_.capacity() * sizeof(container);
+  for (const auto& x : containers_)
+    result += x.values.capacity() * sizeof(uint16_t)
+              + x.words.capacity() * sizeof(block_type);
+  return result;
+}
+
+bool roaring_bitmap::operator[](size_type i) const {
+  VAST_ASSERT(i < num_bits_);
+  const auto key = i / chunk_size;
+  const auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  if (it == keys_.end() || *it != key)
+    return false;
+  return contains(containers_[it - keys_.begin()],
+                  static_cast<uint16_t>(i % chunk_size));
+}
+
+void roaring_bitmap::add_range(size_type first, size_type last) {
+  VAST_ASSERT(first >= num_bits_);
+  while (first < last) {
+    const auto key = first / chunk_size;
+    const auto base = key * chunk_size;
+    if (keys_.empty() || keys_.back() != key) {
+      // We never append to a previous chunk again, so this is the time to
+      // pick the best representation for it.
+      if (!containers_.empty())
+        optimize(containers_.back());
+      keys_.push_back(key);
+      containers_.emplace_back();
+    }
+    const auto end = std::min(last - base, chunk_size);
+    add_range_to(containers_.back(), static_cast<uint32_t>(first - base),
+                 static_cast<uint32_t>(end));
+    first = base + end;
+  }
+}
+
+void roaring_bitmap::append_bit(bool bit) {
+  if (bit)
+    add_range(num_bits_, num_bits_ + 1);
+  ++num_bits_;
+}
+
+void roaring_bitmap::append_bits(bool bit, size_type n) {
+  if (bit && n > 0)
+    add_range(num_bits_, num_bits_ + n);
+  num_bits_ += n;
+}
+
+void roaring_bitmap::append_block(block_type bits, size_type n) {
+  VAST_ASSERT(n <= word_type::width);
+  if (n < word_type::width)
+    bits &= word_type::lsb_mask(n);
+  while (bits != 0) {
+    const auto first = std::countr_zero(bits);
+    const auto rest = bits >> first;
+    const auto length = rest == word_type::all
+                          ? static_cast<int>(word_type::width) - first
+                          : std::countr_zero(~rest);
+    add_range(num_bits_ + first, num_bits_ + first + length);
+    bits = first + length == static_cast<int>(word_type::width)
+             ? 0
+             : bits & (word_type::all << (first + length));
+  }
+  num_bits_ += n;
+}
+
+void roaring_bitmap::flip() {
+  auto keys = std::vector<size_type>{};
+  auto containers = std::vector<container>{};
+  if (num_bits_ > 0) {
+    const auto last_key = (num_bits_ - 1) / chunk_size;
+    auto i = size_t{0};
+    for (size_type key = 0; key <= last_key; ++key) {
+      const auto limit = static_cast<uint32_t>(
+        std::min(chunk_size, num_bits_ - key * chunk_size));
+      auto x = container{};
+      if (i < keys_.size() && keys_[i] == key) {
+        x = complement(containers_[i++], limit);
+      } else {
+        x.kind = container_kind::run;
+        x.cardinality = limit;
+        x.values = {0, static_cast<uint16_t>(limit - 1)};
+      }
+      if (x.cardinality == 0)
+        continue;
+      keys.push_back(key);
+      containers.push_back(std::move(x));
+    }
+  }
+  keys_ = std::move(keys);
+  containers_ = std::move(containers);
+}
+
+roaring_bitmap& roaring_bitmap::operator&=(const roaring_bitmap& other) {
+  *this = binary_and(*this, other);
+  return *this;
+}
+
+roaring_bitmap& roaring_bitmap::operator|=(const roaring_bitmap& other) {
+  *this = binary_or(*this, other);
+  return *this;
+}
+
+roaring_bitmap
+binary_and(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  auto result = roaring_bitmap{};
+  result.num_bits_ = std::max(lhs.num_bits_, rhs.num_bits_);
+  auto i = size_t{0};
+  auto j = size_t{0};
+  while (i < lhs.keys_.size() && j < rhs.keys_.size()) {
+    if (lhs.keys_[i] < rhs.keys_[j]) {
+      ++i;
+    } else if (rhs.keys_[j] < lhs.keys_[i]) {
+      ++j;
+    } else {
+      auto x = intersect(lhs.containers_[i], rhs.containers_[j]);
+      if (x.cardinality > 0) {
+        result.keys_.push_back(lhs.keys_[i]);
+        result.containers_.push_back(std::move(x));
+      }
+      ++i;
+      ++j;
+    }
+  }
+  return result;
+}
+
+roaring_bitmap
+binary_or(const roaring_bitmap& lhs, const roaring_bitmap& rhs) {
+  auto result = roaring_bitmap{};
+  result.num_bits_ = std::max(lhs.num_bits_, rhs.num_bits_);
+  result.keys_.reserve(std::max(lhs.keys_.size(), rhs.keys_.size()));
+  result.containers_.reserve(result.keys_.capacity());
+  auto i = size_t{0};
+  auto j = size_t{0};
+  while (i < lhs.keys_.size() || j < rhs.keys_.size()) {
+    if (j == rhs.keys_.size()
+        || (i < lhs.keys_.size() && lhs.keys_[i] < rhs.keys_[j])) {
+      result.keys_.push_back(lhs.keys_[i]);
+      result.containers_.push_back(lhs.containers_[i++]);
+    } else if (i == lhs.keys_.size() || rhs.keys_[j] < lhs.keys_[i]) {
+      result.keys_.push_back(rhs.keys_[j]);
+      result.containers_.push_back(rhs.containers_[j++]);
+    } else {
+      result.keys_.push_back(lhs.keys_[i]);
+      result.containers_.push_back(
+        unite(lhs.containers_[i++], rhs.containers_[j++]));
+    }
+  }
+  return result;
+}
+
+bool operator==(const roaring_bitmap& x, const roaring_bitmap& y) {
+  return x.num_bits_ == y.num_bits_ && x.keys_ == y.keys_
+         && x.containers_ == y.containers_;
+}
+
+auto pack(flatbuffers::FlatBufferBuilder& builder, const roaring_bitmap& from)
+  -> flatbuffers::Offset<fbs::bitmap::RoaringBitmap> {
+  auto containers
+    = std::vector<flatbuffers::Offset<fbs::bitmap::detail::RoaringContainer>>{};
+  containers.reserve(from.containers_.size());
+  for (size_t i = 0; i < from.containers_.size(); ++i) {
+    const auto& x = from.containers_[i];
+    containers.push_back(fbs::bitmap::detail::CreateRoaringContainerDirect(
+      builder, from.keys_[i],
+      static_cast<fbs::bitmap::detail::RoaringContainerKind>(x.kind),
+      x.cardinality, x.values.empty() ? nullptr : &x.values,
+      x.words.empty() ? nullptr : &x.words));
+  }
+  return fbs::bitmap::CreateRoaringBitmapDirect(builder, &containers,
+                                                from.num_bits_);
+}
+
+auto unpack(const fbs::bitmap::RoaringBitmap& from, roaring_bitmap& to)
+  -> caf::error {
+  to.keys_.clear();
+  to.containers_.clear();
+  to.keys_.reserve(from.containers()->size());
+  to.containers_.reserve(from.containers()->size());
+  for (const auto* x : *from.containers()) {
+    auto& result = to.containers_.emplace_back();
+    result.kind = static_cast<roaring_bitmap::container_kind>(x->kind());
+    result.cardinality = x->cardinality();
+    if (x->values())
+      result.values.assign(x->values()->begin(), x->values()->end());
+    if (x->words())
+      result.words.assign(x->words()->begin(), x->words()->end());
+    auto valid = to.keys_.empty() || x->key() > to.keys_.back();
+    switch (result.kind) {
+      case container_kind::array:
+        valid = valid && result.values.size() == result.cardinality;
+        break;
+      case container_kind::bitset:
+        valid = valid && result.words.size() == bitset_size;
+        break;
+      case container_kind::run:
+        valid = valid && result.values.size() % 2 == 0;
+        break;
+      default:
+        valid = false;
+    }
+    if (!valid)
+      return caf::make_error(ec::format_error,
+                             fmt::format("invalid Roaring container with key "
+                                         "{}",
+                                         x->key()));
+    to.keys_.push_back(x->key());
+  }
+  to.num_bits_ = from.num_bits();
+  return caf::none;
+}
+
+roaring_bitmap_range::roaring_bitmap_range(const roaring_bitmap& bm)
+  : bm_{&bm} {
+  scan();
+}
+
+bool roaring_bitmap_range::done() const {
+  return bits_.empty();
+}
+
+void roaring_bitmap_range::next() {
+  VAST_ASSERT(!done());
+  scan();
+}
+
+void roaring_bitmap_range::scan() {
+  const auto size = bm_->num_bits_;
+  if (position_ >= size) {
+    bits_ = {};
+    return;
+  }
+  const auto& keys = bm_->keys_;
+  const auto key = position_ / roaring_bitmap::chunk_size;
+  while (container_ < keys.size() && keys[container_] < key)
+    ++container_;
+  if (container_ == keys.size() || keys[container_] > key) {
+    // Chunks without a container consist of 0-bits only.
+    const auto end
+      = container_ == keys.size()
+          ? size
+          : std::min(size, keys[container_] * roaring_bitmap::chunk_size);
+    bits_ = {word_type::none, end - position_};
+    position_ = end;
+    return;
+  }
+  if (materialized_ != container_) {
+    words_ = to_words(bm_->containers_[container_]);
+    materialized_ = container_;
+  }
+  // Within a container, we always start at a word boundary. We coalesce
+  // homogeneous words into a single sequence.
+  auto index = (position_ % roaring_bitmap::chunk_size) / word_type::width;
+  const auto block = words_[index];
+  auto length = roaring_bitmap::size_type{word_type::width};
+  if (block == word_type::none || block == word_type::all) {
+    while (index + 1 < bitset_size && words_[index + 1] == block) {
+      ++index;
+      length += word_type::width;
+    }
+  }
+  length = std::min(length, size - position_);
+  bits_ = {block, length};
+  position_ += length;
+}
+
+roaring_bitmap_range bit_range(const roaring_bitmap& bm) {
+  return roaring_bitmap_range{bm};
+}
+
+} // namespace vast
@@ -0,0 +1,335 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/sketch/split_block_bloom_filter.hpp"
+
+#include "vast/detail/assert.hpp"
+#include "vast/error.hpp"
+#include "vast/fbs/bloom_filter.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#  include <arm_neon.h>
+#endif
+
+namespace vast::sketch {
+
+namespace {
+
+/// The odd constants that derive the bit position within every word of a
+/// block from the lower half of a digest.
+constexpr auto salts = std::array<uint32_t, split_block_words>{
+  0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+  0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+/// Maps the upper half of a digest to a block using a multiply-shift range
+/// reduction, which avoids the much slower modulo operation.
+/// @pre `num_blocks <= 2^32`
+size_t block_offset(uint64_t digest, size_t num_blocks) noexcept {
+  return static_cast<size_t>(((digest >> 32) * num_blocks) >> 32)
+         * split_block_words;
+}
+
+/// Computes the word masks of a digest, with exactly one bit set per word.
+std::array<uint32_t, split_block_words> make_words(uint64_t digest) noexcept {
+  const auto key = static_cast<uint32_t>(digest);
+  auto result = std::array<uint32_t, split_block_words>{};
+  for (size_t i = 0; i < split_block_words; ++i)
+    result[i] = uint32_t{1} << ((key * salts[i]) >> 27);
+  return result;
+}
+
+// -- probe kernels ------------------------------------------------------------
+//
+// A probe mask holds the word masks of a digest in the native vector registers
+// of the target. Testing a block against a probe mask checks whether all bits
+// of the mask are set in the block.
+
+#if defined(__AVX2__)
+
+using probe_mask = __m256i;
+
+probe_mask make_probe_mask(uint64_t digest) noexcept {
+  const auto salt = _mm256_setr_epi32(
+    static_cast<int>(salts[0]), static_cast<int>(salts[1]),
+    static_cast<int>(salts[2]), static_cast<int>(salts[3]),
+    static_cast<int>(salts[4]), static_cast<int>(salts[5]),
+    static_cast<int>(salts[6]), static_cast<int>(salts[7]));
+  const auto key = _mm256_set1_epi32(static_cast<int>(digest));
+  const auto shifts = _mm256_srli_epi32(_mm256_mullo_epi32(key, salt), 27);
+  return _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+}
+
+bool test_block(const uint32_t* block, const probe_mask& mask) noexcept {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+  return _mm256_testc_si256(bits, mask) != 0;
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+struct probe_mask {
+  uint32x4_t lower;
+  uint32x4_t upper;
+};
+
+probe_mask make_probe_mask(uint64_t digest) noexcept {
+  const auto key = vdupq_n_u32(static_cast<uint32_t>(digest));
+  const auto one = vdupq_n_u32(1);
+  const auto make = [&](const uint32_t* salt) {
+    const auto shifts = vshrq_n_u32(vmulq_u32(key, vld1q_u32(salt)), 27);
+    return vshlq_u32(one, vreinterpretq_s32_u32(shifts));
+  };
+  return {make(salts.data()), make(salts.data() + 4)};
+}
+
+bool test_block(const uint32_t* block, const probe_mask& mask) noexcept {
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const auto missing = vorrq_u32(vbicq_u32(mask.lower, vld1q_u32(block)),
+                                 vbicq_u32(mask.upper, vld1q_u32(block + 4)));
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return vmaxvq_u32(missing) == 0;
+}
+
+#else
+
+using probe_mask = std::array<uint32_t, split_block_words>;
+
+probe_mask make_probe_mask(uint64_t digest) noexcept {
+  return make_words(digest);
+}
+
+bool test_block(const uint32_t* block, const probe_mask& mask) noexcept {
+  auto missing = uint32_t{0};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  for (size_t i = 0; i < split_block_words; ++i)
+    missing |= mask[i] & ~block[i];
+  return missing == 0;
+}
+
+#endif
+
+bool lookup_blocks(std::span<const uint32_t> blocks,
+                   uint64_t digest) noexcept {
+  const auto num_blocks = blocks.size() / split_block_words;
+  if (num_blocks == 0)
+    return false;
+  const auto* block = blocks.data() + block_offset(digest, num_blocks);
+  return test_block(block, make_probe_mask(digest));
+}
+
+} // namespace
+
+double split_block_false_positive_rate(uint64_t n, uint64_t num_blocks) {
+  if (num_blocks == 0)
+    return 1.0;
+  if (n == 0)
+    return 0.0;
+  // The number of digests per block follows a Poisson distribution. After
+  // adding j digests to a block, every word of the block has a given bit set
+  // with probability 1 - (31/32)^j, and a false positive requires the bits of
+  // all eight words to be set. We sum over the bulk of the distribution, and
+  // ignore the negligible tails.
+  const auto lambda = static_cast<double>(n) / static_cast<double>(num_blocks);
+  const auto spread = 10.0 * std::sqrt(lambda) + 10.0;
+  const auto first = static_cast<uint64_t>(std::max(0.0, lambda - spread));
+  const auto last = static_cast<uint64_t>(lambda + spread);
+  const auto log_lambda = std::log(lambda);
+  auto result = 0.0;
+  for (auto j = first; j <= last; ++j) {
+    const auto x = static_cast<double>(j);
+    const auto pmf = std::exp(x * log_lambda - lambda - std::lgamma(x + 1.0));
+    const auto fill = 1.0 - std::pow(31.0 / 32.0, x);
+    result += pmf * std::pow(fill, static_cast<double>(split_block_words));
+  }
+  return std::min(result, 1.0);
+}
+
+caf::expected<split_block_bloom_filter>
+split_block_bloom_filter::make(bloom_filter_config cfg) {
+  if (cfg.k && *cfg.k != split_block_words)
+    return caf::make_error(ec::invalid_argument,
+                           fmt::format("split-block Bloom filters require {} "
+                                       "hash functions",
+                                       split_block_words));
+  if (cfg.n && *cfg.n == 0)
+    return caf::make_error(ec::invalid_argument, "cardinality cannot be 0");
+  if (cfg.p && (*cfg.p <= 0.0 || *cfg.p >= 1.0))
+    return caf::make_error(ec::invalid_argument,
+                           "false-positive probability must be in (0, 1)");
+  // The block selection supports at most 2^32 blocks.
+  constexpr auto max_blocks = uint64_t{1} << 32;
+  auto num_blocks = uint64_t{0};
+  if (!cfg.m && cfg.n && cfg.p) {
+    // The false-positive probability decreases monotonically with the number
+    // of blocks, so we can find the smallest sufficient number of blocks with
+    // an exponential search followed by a binary search.
+    auto upper = uint64_t{1};
+    while (split_block_false_positive_rate(*cfg.n, upper) > *cfg.p) {
+      if (upper >= max_blocks)
+        return caf::make_error(ec::invalid_argument,
+                               fmt::format("cannot satisfy false-positive "
+                                           "probability {} for {} elements",
+                                           *cfg.p, *cfg.n));
+      upper *= 2;
+    }
+    auto lower = upper / 2;
+    while (lower + 1 < upper) {
+      const auto middle = lower + (upper - lower) / 2;
+      if (split_block_false_positive_rate(*cfg.n, middle) > *cfg.p)
+        lower = middle;
+      else
+        upper = middle;
+    }
+    num_blocks = upper;
+  } else if (cfg.m && cfg.n && !cfg.p) {
+    if (*cfg.m == 0)
+      return caf::make_error(ec::invalid_argument, "size cannot be 0");
+    num_blocks = (*cfg.m + split_block_bits - 1) / split_block_bits;
+    if (num_blocks > max_blocks)
+      return caf::make_error(ec::invalid_argument,
+                             fmt::format("size {} exceeds the maximum of {} "
+                                         "bits",
+                                         *cfg.m, max_blocks * split_block_bits));
+  } else {
+    return caf::make_error(ec::invalid_argument,
+                           "failed to evaluate parameters");
+  }
+  return split_block_bloom_filter{{
+    .m = num_blocks * split_block_bits,
+    .n = *cfg.n,
+    .k = split_block_words,
+    .p = split_block_false_positive_rate(*cfg.n, num_blocks),
+  }};
+}
+
+split_block_bloom_filter::split_block_bloom_filter() noexcept
+  : params_{.m = 0, .n = 0, .k = split_block_words, .p = 0.0} {
+  // nop
+}
+
+void split_block_bloom_filter::add(uint64_t digest) noexcept {
+  const auto num_blocks = blocks_.size() / split_block_words;
+  VAST_ASSERT(num_blocks > 0);
+  auto* block = blocks_.data() + block_offset(digest, num_blocks);
+  const auto words = make_words(digest);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  for (size_t i = 0; i < split_block_words; ++i)
+    block[i] |= words[i];
+}
+
+bool split_block_bloom_filter::lookup(uint64_t digest) const noexcept {
+  return lookup_blocks(blocks_, digest);
+}
+
+const bloom_filter_params&
+split_block_bloom_filter::parameters() const noexcept {
+  return params_;
+}
+
+std::span<const uint32_t> split_block_bloom_filter::blocks() const noexcept {
+  return blocks_;
+}
+
+bool operator==(const split_block_bloom_filter& x,
+                const split_block_bloom_filter& y) noexcept {
+  return x.params_.m == y.params_.m && x.params_.n == y.params_.n
+         && x.params_.k == y.params_.k && x.params_.p == y.params_.p
+         && x.blocks_ == y.blocks_;
+}
+
+size_t mem_usage(const split_block_bloom_filter& x) {
+  return sizeof(x) + x.blocks_.capacity() * sizeof(uint32_t);
+}
+
+caf::expected<frozen_split_block_bloom_filter>
+freeze(const split_block_bloom_filter& x) {
+  constexpr auto fixed_size = 64;
+  const auto expected_size = fixed_size + x.blocks_.size() * sizeof(uint32_t);
+  // FlatBuffers <= 1.11 does not correctly use '::flatbuffers::soffset_t' over
+  // 'soffset_t' in FLATBUFFERS_MAX_BUFFER_SIZE.
+  using ::flatbuffers::soffset_t;
+  if (expected_size >= FLATBUFFERS_MAX_BUFFER_SIZE)
+    return caf::make_error(
+      ec::invalid_argument,
+      fmt::format("frozen size {} exceeds max flatbuffer size of {} bytes",
+                  expected_size, FLATBUFFERS_MAX_BUFFER_SIZE));
+  flatbuffers::FlatBufferBuilder builder{expected_size};
+  const auto params = fbs::BloomFilterParameters{x.params_.m, x.params_.n,
+                                                 x.params_.k, x.params_.p};
+  const auto blocks_offset
+    = builder.CreateVector(x.blocks_.data(), x.blocks_.size());
+  const auto filter_offset
+    = fbs::CreateSplitBlockBloomFilter(builder, &params, blocks_offset);
+  builder.Finish(filter_offset);
+  return frozen_split_block_bloom_filter{chunk::make(builder.Release())};
+}
+
+split_block_bloom_filter::split_block_bloom_filter(bloom_filter_params params)
+  : params_{params}, blocks_(params.m / split_block_bits * split_block_words) {
+  VAST_ASSERT(params.m > 0);
+  VAST_ASSERT(params.m % split_block_bits == 0);
+}
+
+frozen_split_block_bloom_filter::frozen_split_block_bloom_filter(
+  chunk_ptr table) noexcept
+  : table_{std::move(table)} {
+  VAST_ASSERT(table_ != nullptr);
+  VAST_ASSERT(table_->data() != nullptr);
+  const auto* root
+    = flatbuffers::GetRoot<fbs::SplitBlockBloomFilter>(table_->data());
+  params_.m = root->parameters()->m();
+  params_.n = root->parameters()->n();
+  params_.k = root->parameters()->k();
+  params_.p = root->parameters()->p();
+  blocks_ = std::span{root->blocks()->data(), root->blocks()->size()};
+  VAST_ASSERT(blocks_.size() % split_block_words == 0);
+}
+
+bool frozen_split_block_bloom_filter::lookup(uint64_t digest) const noexcept {
+  return lookup_blocks(blocks_, digest);
+}
+
+const bloom_filter_params&
+frozen_split_block_bloom_filter::parameters() const noexcept {
+  return params_;
+}
+
+std::span<const uint32_t>
+frozen_split_block_bloom_filter::blocks() const noexcept {
+  return blocks_;
+}
+
+size_t mem_usage(const frozen_split_block_bloom_filter& x) noexcept {
+  return sizeof(x) + x.table_->size();
+}
+
+void lookup(uint64_t digest, std::span<const std::span<const uint32_t>> filters,
+            std::span<uint8_t> result) noexcept {
+  VAST_ASSERT(filters.size() == result.size());
+  const auto mask = make_probe_mask(digest);
+  // There are no dependencies between the iterations, so the memory accesses
+  // for the blocks of subsequent filters overlap.
+  for (size_t i = 0; i < filters.size(); ++i) {
+    const auto num_blocks = filters[i].size() / split_block_words;
+    if (num_blocks == 0)
+      continue;
+    const auto* block = filters[i].data() + block_offset(digest, num_blocks);
+    result[i] |= static_cast<uint8_t>(test_block(block, mask));
+  }
+}
+
+} // namespace vast::sketch
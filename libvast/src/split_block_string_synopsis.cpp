@@ -0,0 +1,121 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/split_block_string_synopsis.hpp"
+
+#include "vast/detail/assert.hpp"
+#include "vast/hash/hash.hpp"
+#include "vast/hash/xxhash.hpp"
+#include "vast/logger.hpp"
+#include "vast/type.hpp"
+
+namespace vast {
+
+split_block_string_synopsis::split_block_string_synopsis(
+  vast::type x, sketch::split_block_bloom_filter filter)
+  : synopsis{std::move(x)}, filter_{std::move(filter)} {
+  VAST_ASSERT(caf::holds_alternative<string_type>(type()));
+}
+
+uint64_t split_block_string_synopsis::digest(std::string_view x) noexcept {
+  // The digests are persisted as part of the filter, so we must not depend on
+  // the default hash algorithm here.
+  return hash<xxh3_64>(x);
+}
+
+synopsis_ptr split_block_string_synopsis::clone() const {
+  return std::make_unique<split_block_string_synopsis>(type(), filter_);
+}
+
+void split_block_string_synopsis::add(data_view x) {
+  VAST_ASSERT(caf::holds_alternative<view<std::string>>(x), "invalid data");
+  filter_.add(digest(caf::get<view<std::string>>(x)));
+}
+
+std::optional<bool>
+split_block_string_synopsis::lookup(relational_operator op,
+                                    data_view rhs) const {
+  switch (op) {
+    default:
+      return {};
+    case relational_operator::equal:
+      if (caf::holds_alternative<view<caf::none_t>>(rhs)
+          || caf::holds_alternative<view<pattern>>(rhs))
+        return {};
+      if (const auto* x = caf::get_if<view<std::string>>(&rhs))
+        return filter_.lookup(digest(*x));
+      return false;
+    case relational_operator::in: {
+      if (const auto* xs = caf::get_if<view<list>>(&rhs)) {
+        for (auto x : **xs) {
+          if (caf::holds_alternative<view<caf::none_t>>(x))
+            return {};
+          if (const auto* str = caf::get_if<view<std::string>>(&x))
+            if (filter_.lookup(digest(*str)))
+              return true;
+        }
+        return false;
+      }
+      return {};
+    }
+  }
+}
+
+bool split_block_string_synopsis::equals(const synopsis& other) const noexcept {
+  if (typeid(other) != typeid(split_block_string_synopsis))
+    return false;
+  const auto& rhs = static_cast<const split_block_string_synopsis&>(other);
+  return type() == rhs.type() && filter_ == rhs.filter_;
+}
+
+size_t split_block_string_synopsis::memusage() const {
+  return mem_usage(filter_);
+}
+
+bool split_block_string_synopsis::inspect_impl(
+  supported_inspectors& inspector) {
+  return std::visit(
+    [this](auto inspector) {
+      return inspector.get().apply(filter_);
+    },
+    inspector);
+}
+
+const sketch::split_block_bloom_filter&
+split_block_string_synopsis::filter() const noexcept {
+  return filter_;
+}
+
+bool has_split_block_layout(const type& type) {
+  return type.attribute(split_block_string_synopsis::layout_attribute)
+         == split_block_string_synopsis::layout;
+}
+
+synopsis_ptr make_split_block_string_synopsis(vast::type type,
+                                              bloom_filter_parameters params) {
+  VAST_ASSERT(caf::holds_alternative<string_type>(type));
+  if (!params.n || !params.p)
+    return nullptr;
+  auto filter = sketch::split_block_bloom_filter::make({
+    .n = *params.n,
+    .p = *params.p,
+  });
+  if (!filter) {
+    VAST_WARN("{} failed to construct Bloom filter: {}", __func__,
+              filter.error());
+    return nullptr;
+  }
+  if (!has_split_block_layout(type))
+    type = vast::type{type,
+                      {{split_block_string_synopsis::layout_attribute,
+                        split_block_string_synopsis::layout}}};
+  return std::make_unique<split_block_string_synopsis>(std::move(type),
+                                                       std::move(*filter));
+}
+
+} // namespace vast
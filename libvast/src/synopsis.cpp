@@ -58,6 +58,14 @@ const vast::type& synopsis::type() const {
   return type_;
 }
 
+synopsis_match
+synopsis::exact_lookup(relational_operator op, data_view rhs) const {
+  // A regular lookup may have false positives, but never false negatives.
+  if (auto result = lookup(op, rhs); result && !*result)
+    return synopsis_match::none;
+  return synopsis_match::maybe;
+}
+
 synopsis_ptr synopsis::shrink() const {
   return nullptr;
 }
@@ -400,12 +400,25 @@ active_partition_actor::behavior_type active_partition(
           if (should_skip_index_creation(
                 field.type, qf, self->state.synopsis_index_config.rules))
             continue;
+          auto field_opts = index_opts;
+          if (auto encoding = index_bitmap_encoding(
+                qf, self->state.synopsis_index_config.rules);
+              encoding != defaults::system::bitmap_encoding)
+            caf::put(field_opts, "bitmap", std::string{encoding});
+          if (auto kind = index_string_kind(
+                qf, self->state.synopsis_index_config.rules);
+              kind != defaults::system::string_index)
+            caf::put(field_opts, "string-index", std::string{kind});
+          if (auto kind = index_arithmetic_kind(
+                qf, self->state.synopsis_index_config.rules);
+              kind != defaults::system::arithmetic_index)
+            caf::put(field_opts, "arithmetic-index", std::string{kind});
           auto value_index
-            = factory<vast::value_index>::make(field.type, index_opts);
+            = factory<vast::value_index>::make(field.type, field_opts);
           if (!value_index) {
             VAST_WARN("{} failed to spawn active indexer with options {} for "
                       "field {}: value index missing",
-                      *self, index_opts, field);
+                      *self, field_opts, field);
             continue;
           }
           idx = self->spawn(active_indexer, column_idx, std::move(value_index));
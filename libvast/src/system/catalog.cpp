@@ -22,6 +22,7 @@
 #include "vast/error.hpp"
 #include "vast/expression.hpp"
 #include "vast/fbs/type_registry.hpp"
+#include "vast/field_synopsis_index.hpp"
 #include "vast/flatbuffer.hpp"
 #include "vast/io/read.hpp"
 #include "vast/io/save.hpp"
@@ -42,10 +43,63 @@
 #include <caf/detail/set_thread_name.hpp>
 #include <caf/expected.hpp>
 
+#include <algorithm>
+#include <numeric>
+#include <span>
 #include <type_traits>
 
 namespace vast::system {
 
+namespace {
+
+/// Estimates the relative cost of looking up an expression in the catalog,
+/// taking into account both how expensive it is to probe the synopses for it,
+/// and how likely it is to prune partitions. Used to order the operands of
+/// conjunctions such that cheap and selective operands restrict the set of
+/// candidates for the remaining operands.
+int estimate_lookup_cost(const expression& expr) {
+  auto f = detail::overload{
+    [](const predicate& x) {
+      // Meta extractors operate on partition metadata only.
+      if (caf::holds_alternative<meta_extractor>(x.lhs))
+        return 0;
+      switch (x.op) {
+        case relational_operator::equal:
+        case relational_operator::in:
+          // Point lookups are what the synopses are best at.
+          return 1;
+        case relational_operator::less:
+        case relational_operator::less_equal:
+        case relational_operator::greater:
+        case relational_operator::greater_equal:
+          return 2;
+        case relational_operator::not_equal:
+        case relational_operator::not_in:
+        case relational_operator::ni:
+        case relational_operator::not_ni:
+          // Synopses rarely rule out partitions for these.
+          return 4;
+      }
+      __builtin_unreachable();
+    },
+    [](const conjunction&) {
+      return 2;
+    },
+    [](const disjunction&) {
+      return 3;
+    },
+    [](const negation&) {
+      return 4;
+    },
+    [](caf::none_t) {
+      return 5;
+    },
+  };
+  return caf::visit(f, expr);
+}
+
+} // namespace
+
 void catalog_state::create_from(
   std::unordered_map<uuid, partition_synopsis_ptr>&& ps) {
   std::unordered_map<vast::type,
@@ -62,26 +116,46 @@ void catalog_state::create_from(
                  const std::pair<uuid, partition_synopsis_ptr>& rhs) {
                 return lhs.first < rhs.first;
               });
-    synopses_per_type[type]
+    auto& partition_synopses = synopses_per_type[type];
+    partition_synopses
       = decltype(synopses_per_type)::value_type::second_type::make_unsafe(
         std::move(flat_data));
+    auto& index = field_synopses_per_type[type];
+    index = {};
+    for (const auto& [_, synopsis] : partition_synopses)
+      index.insert(index.size(), *synopsis);
   }
 }
 
 void catalog_state::merge(const uuid& partition, partition_synopsis_ptr ps) {
   update_unprunable_fields(*ps);
-  synopses_per_type[ps->schema][partition] = std::move(ps);
+  const auto schema = ps->schema;
+  auto& partition_synopses = synopses_per_type[schema];
+  auto& index = field_synopses_per_type[schema];
+  if (auto it = partition_synopses.find(partition);
+      it != partition_synopses.end()) {
+    it->second = std::move(ps);
+    index.replace(it - partition_synopses.begin(), *it->second);
+    return;
+  }
+  const auto it = partition_synopses.emplace(partition, std::move(ps)).first;
+  index.insert(it - partition_synopses.begin(), *it->second);
 }
 
 void catalog_state::erase(const uuid& partition) {
   for (auto& [type, uuid_synopsis_map] : synopses_per_type) {
-    auto erased = uuid_synopsis_map.erase(partition);
-    if (erased) {
-      if (uuid_synopsis_map.empty()) {
-        synopses_per_type.erase(type);
-      }
-      return;
+    auto it = uuid_synopsis_map.find(partition);
+    if (it == uuid_synopsis_map.end())
+      continue;
+    const auto position = it - uuid_synopsis_map.begin();
+    uuid_synopsis_map.erase(it);
+    if (uuid_synopsis_map.empty()) {
+      field_synopses_per_type.erase(type);
+      synopses_per_type.erase(type);
+    } else {
+      field_synopses_per_type[type].erase(position);
     }
+    return;
   }
 }
 
@@ -116,238 +190,309 @@ catalog_state::lookup(const expression& expr) const {
 }
 
 catalog_lookup_result::candidate_info
-catalog_state::lookup_impl(const expression& expr, const type& schema) const {
+catalog_state::lookup_impl(const expression& expr, const type& schema,
+                           const std::vector<partition_info>* candidates) const {
   VAST_ASSERT(!caf::holds_alternative<caf::none_t>(expr));
   auto synopsis_map_per_type_it = synopses_per_type.find(schema);
   VAST_ASSERT(synopsis_map_per_type_it != synopses_per_type.end());
   const auto& partition_synopses = synopsis_map_per_type_it->second;
+  VAST_ASSERT(!candidates
+              || std::is_sorted(candidates->begin(), candidates->end()));
   // The partition UUIDs must be sorted, otherwise the invariants of the
   // inplace union and intersection algorithms are violated, leading to
   // wrong results. So all places where we return an assembled set must
   // ensure the post-condition of returning a sorted list. We currently
   // rely on `flat_map` already traversing them in the correct order, so
-  // no separate sorting step is required.
+  // no separate sorting step is required. The same holds for the candidates,
+  // which are always a subset of the partitions in the map.
+  // The function object receives the position of the partition in the map
+  // alongside the partition ID and synopsis.
+  auto for_each_candidate = [&](auto&& f) {
+    if (!candidates) {
+      auto position = size_t{0};
+      for (const auto& [partition_id, synopsis] : partition_synopses)
+        f(position++, partition_id, synopsis);
+      return;
+    }
+    for (const auto& candidate : *candidates) {
+      const auto it = partition_synopses.find(candidate.uuid);
+      VAST_ASSERT(it != partition_synopses.end());
+      f(static_cast<size_t>(it - partition_synopses.begin()), it->first,
+        it->second);
+    }
+  };
   auto memoized_partitions = catalog_lookup_result::candidate_info{};
   auto all_partitions = [&] {
     if (!memoized_partitions.partition_infos.empty()
         || partition_synopses.empty())
       return memoized_partitions;
-    for (const auto& [partition_id, synopsis] : partition_synopses) {
-      memoized_partitions.exp = expr;
-      memoized_partitions.partition_infos.emplace_back(partition_id, *synopsis);
+    memoized_partitions.exp = expr;
+    if (candidates) {
+      memoized_partitions.partition_infos = *candidates;
+      return memoized_partitions;
     }
+    for (const auto& [partition_id, synopsis] : partition_synopses)
+      memoized_partitions.partition_infos.emplace_back(partition_id, *synopsis);
     return memoized_partitions;
   };
-  auto f = detail::overload{
-    [&](const conjunction& x) -> catalog_lookup_result::candidate_info {
-      VAST_ASSERT(!x.empty());
-      auto i = x.begin();
-      auto result = lookup_impl(*i, schema);
-      if (!result.partition_infos.empty())
-        for (++i; i != x.end(); ++i) {
-          // TODO: A conjunction means that we can restrict the lookup to the
-          // remaining candidates. This could be achived by passing the `result`
-          // set to `lookup` along with the child expression.
-          auto xs = lookup_impl(*i, schema);
-          if (xs.partition_infos.empty())
-            return xs; // short-circuit
-          detail::inplace_intersect(result.partition_infos, xs.partition_infos);
+  // Returns all candidates that are not in the sorted list of *selected*
+  // partitions.
+  auto complement = [&](const std::vector<partition_info>& selected) {
+    auto result = std::vector<partition_info>{};
+    auto it = selected.begin();
+    for_each_candidate([&](size_t, const uuid& partition_id,
+                           const partition_synopsis_ptr& synopsis) {
+      if (it != selected.end() && it->uuid == partition_id) {
+        ++it;
+        return;
+      }
+      result.emplace_back(partition_id, *synopsis);
+    });
+    VAST_ASSERT(it == selected.end());
+    return result;
+  };
+  // Looks up a predicate. If *negated* is true, looks up the negation of the
+  // predicate instead, which can only prune partitions for which the synopses
+  // show that all values satisfy the predicate.
+  auto lookup_predicate
+    = [&](const predicate& x,
+          bool negated) -> catalog_lookup_result::candidate_info {
+    // Performs a lookup on all *matching* columns of the field synopsis
+    // index with operator and data from the predicate of the expression.
+    // The match function uses a qualified_record_field to determine whether
+    // the column should be queried. A partition is a candidate if any of
+    // the matching columns cannot rule it out, or for negated predicates if
+    // none of the matching columns show that all values satisfy the
+    // predicate.
+    auto search = [&](std::span<const size_t> columns, auto match) {
+      VAST_ASSERT(caf::holds_alternative<data>(x.rhs));
+      const auto& rhs = caf::get<data>(x.rhs);
+      const auto index_it = field_synopses_per_type.find(schema);
+      VAST_ASSERT(index_it != field_synopses_per_type.end());
+      const auto& index = index_it->second;
+      VAST_ASSERT(index.size() == partition_synopses.size());
+      auto positions = std::optional<std::vector<size_t>>{};
+      if (candidates) {
+        positions.emplace();
+        positions->reserve(candidates->size());
+        for_each_candidate(
+          [&](size_t position, const uuid&, const partition_synopsis_ptr&) {
+            positions->push_back(position);
+          });
+      }
+      auto selected = std::vector<uint8_t>(index.size(), 0);
+      for (auto column : columns) {
+        const auto& indexed_column = index.columns()[column];
+        if (!match(indexed_column.field))
+          continue;
+        if (negated)
+          index.lookup_all(indexed_column, x.op, make_view(rhs),
+                           positions ? &*positions : nullptr, selected);
+        else
+          index.lookup(indexed_column, x.op, make_view(rhs),
+                       positions ? &*positions : nullptr, selected);
+      }
+      catalog_lookup_result::candidate_info result;
+      for_each_candidate([&](size_t position, const uuid& part_id,
+                             const partition_synopsis_ptr& part_syn) {
+        if (static_cast<bool>(selected[position]) != negated)
+          result.partition_infos.emplace_back(part_id, *part_syn);
+      });
+      VAST_DEBUG("{} checked {} partitions for {}predicate {} and got {} "
+                 "results",
+                 detail::pretty_type_name(this),
+                 candidates ? candidates->size() : partition_synopses.size(),
+                 negated ? "negated " : "", x, result.partition_infos.size());
+      // Some calling paths require the result to be sorted.
+      VAST_ASSERT(std::is_sorted(result.partition_infos.begin(),
+                                 result.partition_infos.end()));
+      return result;
+    };
+    // Searches all columns of the field synopsis index.
+    auto search_all = [&](auto match) {
+      const auto& index = field_synopses_per_type.at(schema);
+      auto columns = std::vector<size_t>(index.columns().size());
+      std::iota(columns.begin(), columns.end(), size_t{0});
+      return search(columns, std::move(match));
+    };
+    auto extract_expr = detail::overload{
+      [&](const meta_extractor& lhs,
+          const data& d) -> catalog_lookup_result::candidate_info {
+        if (lhs.kind == meta_extractor::type) {
+          // We don't have to look into the synopses for type queries, just
+          // at the schema names.
+          catalog_lookup_result::candidate_info result;
+          // The schema name is the same for all fields of a partition, so
+          // this lookup is exact and we can simply invert it for negations.
+          for_each_candidate([&](size_t, const uuid& part_id,
+                                 const partition_synopsis_ptr& part_syn) {
+            const auto matches = std::any_of(
+              part_syn->field_synopses_.begin(),
+              part_syn->field_synopses_.end(), [&](const auto& field) {
+                // TODO: provide an overload for view of evaluate() so that
+                // we can use string_view here. Fortunately type names are
+                // short, so we're probably not hitting the allocator due to
+                // SSO.
+                return evaluate(std::string{field.first.schema_name()}, x.op,
+                                d);
+              });
+            if (matches != negated) {
+              result.exp = expr;
+              result.partition_infos.emplace_back(part_id, *part_syn);
+            }
+          });
           VAST_ASSERT(std::is_sorted(result.partition_infos.begin(),
                                      result.partition_infos.end()));
+          return result;
+        }
+        if (lhs.kind == meta_extractor::import_time) {
+          catalog_lookup_result::candidate_info result;
+          for_each_candidate([&](size_t, const uuid& part_id,
+                                 const partition_synopsis_ptr& part_syn) {
+            VAST_ASSERT(part_syn->min_import_time
+                          <= part_syn->max_import_time,
+                        "encountered empty or moved-from partition synopsis");
+            auto ts = time_synopsis{
+              part_syn->min_import_time,
+              part_syn->max_import_time,
+            };
+            const auto match = ts.exact_lookup(x.op, caf::get<vast::time>(d));
+            if (match
+                != (negated ? synopsis_match::all : synopsis_match::none)) {
+              result.exp = expr;
+              result.partition_infos.emplace_back(part_id, *part_syn);
+            }
+          });
+          VAST_ASSERT(std::is_sorted(result.partition_infos.begin(),
+                                     result.partition_infos.end()));
+          return result;
         }
+        VAST_WARN("{} cannot process meta extractor: {}",
+                  detail::pretty_type_name(this), lhs.kind);
+        return all_partitions();
+      },
+      [&](const field_extractor& lhs,
+          const data& d) -> catalog_lookup_result::candidate_info {
+        // The field synopsis index resolves the field name for us, so we
+        // only need to check whether the field is compatible with the
+        // predicate.
+        auto pred = [&](const auto& field) {
+          VAST_ASSERT(!field.is_standalone_type());
+          return compatible(field.type(), x.op, d);
+        };
+        const auto& index = field_synopses_per_type.at(schema);
+        return search(index.resolve(lhs.field), pred);
+      },
+      [&](const type_extractor& lhs,
+          const data& d) -> catalog_lookup_result::candidate_info {
+        auto result = [&] {
+          if (!lhs.type) {
+            auto pred = [&](auto& field) {
+              const auto type = field.type();
+              for (const auto& name : type.names())
+                if (name == lhs.type.name())
+                  return compatible(type, x.op, d);
+              return false;
+            };
+            return search_all(pred);
+          }
+          auto pred = [&](auto& field) {
+            return congruent(field.type(), lhs.type);
+          };
+          return search_all(pred);
+        }();
+        return result;
+      },
+      [&](const auto&, const auto&) -> catalog_lookup_result::candidate_info {
+        VAST_WARN("{} cannot process predicate: {}",
+                  detail::pretty_type_name(this), x);
+        return all_partitions();
+      },
+    };
+    return caf::visit(extract_expr, x.lhs, x.rhs);
+  };
+  auto f = detail::overload{
+    [&](const conjunction& x) -> catalog_lookup_result::candidate_info {
+      VAST_ASSERT(!x.empty());
+      // Look up the operands in order of their estimated cost, restricting
+      // the lookup of every operand to the candidates that survived the
+      // previous operands. This makes the intersection implicit, and ensures
+      // that the expensive operands probe as few synopses as possible.
+      auto operands = std::vector<const expression*>{};
+      operands.reserve(x.size());
+      for (const auto& operand : x)
+        operands.push_back(&operand);
+      std::stable_sort(operands.begin(), operands.end(),
+                       [](const expression* lhs, const expression* rhs) {
+                         return estimate_lookup_cost(*lhs)
+                                < estimate_lookup_cost(*rhs);
+                       });
+      auto i = operands.begin();
+      auto result = lookup_impl(**i, schema, candidates);
+      for (++i; i != operands.end(); ++i) {
+        if (result.partition_infos.empty())
+          return result; // short-circuit
+        result = lookup_impl(**i, schema, &result.partition_infos);
+        VAST_ASSERT(std::is_sorted(result.partition_infos.begin(),
+                                   result.partition_infos.end()));
+      }
       return result;
     },
     [&](const disjunction& x) -> catalog_lookup_result::candidate_info {
+      // Every operand only needs to consider the candidates that none of the
+      // previous operands selected already.
       catalog_lookup_result::candidate_info result;
-      for (const auto& op : x) {
-        // TODO: A disjunction means that we can restrict the lookup to the
-        // set of partitions that are outside of the current result set.
-        auto xs = lookup_impl(op, schema);
-        if (xs.partition_infos.size() == partition_synopses.size())
-          return xs; // short-circuit
+      auto remaining = std::vector<partition_info>{};
+      for (auto i = x.begin(); i != x.end(); ++i) {
+        auto xs = lookup_impl(*i, schema,
+                              i == x.begin() ? candidates : &remaining);
         VAST_ASSERT(
           std::is_sorted(xs.partition_infos.begin(), xs.partition_infos.end()));
         detail::inplace_unify(result.partition_infos, xs.partition_infos);
         VAST_ASSERT(std::is_sorted(result.partition_infos.begin(),
                                    result.partition_infos.end()));
+        remaining = complement(result.partition_infos);
+        if (remaining.empty())
+          return result; // short-circuit
       }
       return result;
     },
-    [&](const negation&) -> catalog_lookup_result::candidate_info {
-      // We cannot handle negations, because a synopsis may return false
-      // positives, and negating such a result may cause false
-      // negatives.
-      // TODO: The above statement seems to only apply to bloom filter
-      // synopses, but it should be possible to handle time or bool synopses.
-      return all_partitions();
-    },
-    [&](const predicate& x) -> catalog_lookup_result::candidate_info {
-      // Performs a lookup on all *matching* synopses with operator and
-      // data from the predicate of the expression. The match function
-      // uses a qualified_record_field to determine whether the synopsis
-      // should be queried.
-      auto search = [&](auto match) {
-        VAST_ASSERT(caf::holds_alternative<data>(x.rhs));
-        const auto& rhs = caf::get<data>(x.rhs);
-        catalog_lookup_result::candidate_info result;
-        // dont iterate through all synopses, rewrite lookup_impl to use a
-        // singular type all synopses loops -> relevant anymore? Use type as
-        // synopses key
-        for (const auto& [part_id, part_syn] : partition_synopses) {
-          for (const auto& [field, syn] : part_syn->field_synopses_) {
-            if (match(field)) {
-              // We need to prune the type's metadata here by converting it to a
-              // concrete type and back, because the type synopses are looked up
-              // independent from names and attributes.
-              auto prune = [&]<concrete_type T>(const T& x) {
-                return type{x};
-              };
-              auto cleaned_type = caf::visit(prune, field.type());
-              // We rely on having a field -> nullptr mapping here for the
-              // fields that don't have their own synopsis.
-              if (syn) {
-                auto opt = syn->lookup(x.op, make_view(rhs));
-                if (!opt || *opt) {
-                  VAST_TRACE("{} selects {} at predicate {}",
-                             detail::pretty_type_name(this), part_id, x);
-                  result.partition_infos.emplace_back(part_id, *part_syn);
-                  break;
-                }
-                // The field has no dedicated synopsis. Check if there is one
-                // for the type in general.
-              } else if (auto it = part_syn->type_synopses_.find(cleaned_type);
-                         it != part_syn->type_synopses_.end() && it->second) {
-                auto opt = it->second->lookup(x.op, make_view(rhs));
-                if (!opt || *opt) {
-                  VAST_TRACE("{} selects {} at predicate {}",
-                             detail::pretty_type_name(this), part_id, x);
-                  result.partition_infos.emplace_back(part_id, *part_syn);
-                  break;
-                }
-              } else {
-                // The catalog couldn't rule out this partition, so we have
-                // to include it in the result set.
-                result.partition_infos.emplace_back(part_id, *part_syn);
-                break;
-              }
-            }
-          }
-        }
-        VAST_DEBUG("{} checked {} partitions for predicate {} and got {} "
-                   "results",
-                   detail::pretty_type_name(this), synopses_per_type.size(), x,
-                   result.partition_infos.size());
-        // Some calling paths require the result to be sorted.
-        VAST_ASSERT(std::is_sorted(result.partition_infos.begin(),
-                                   result.partition_infos.end()));
-        return result;
-      };
-      auto extract_expr = detail::overload{
-        [&](const meta_extractor& lhs,
-            const data& d) -> catalog_lookup_result::candidate_info {
-          if (lhs.kind == meta_extractor::type) {
-            // We don't have to look into the synopses for type queries, just
-            // at the schema names.
-            catalog_lookup_result::candidate_info result;
-            for (const auto& [part_id, part_syn] : partition_synopses) {
-              for (const auto& [fqf, _] : part_syn->field_synopses_) {
-                // TODO: provide an overload for view of evaluate() so that
-                // we can use string_view here. Fortunately type names are
-                // short, so we're probably not hitting the allocator due to
-                // SSO.
-                if (evaluate(std::string{fqf.schema_name()}, x.op, d)) {
-                  result.exp = expr;
-                  result.partition_infos.emplace_back(part_id, *part_syn);
-                  break;
-                }
-              }
-            }
-            VAST_ASSERT(std::is_sorted(result.partition_infos.begin(),
-                                       result.partition_infos.end()));
-            return result;
-          }
-          if (lhs.kind == meta_extractor::import_time) {
-            catalog_lookup_result::candidate_info result;
-            for (const auto& [part_id, part_syn] : partition_synopses) {
-              VAST_ASSERT(part_syn->min_import_time
-                            <= part_syn->max_import_time,
-                          "encountered empty or moved-from partition synopsis");
-              auto ts = time_synopsis{
-                part_syn->min_import_time,
-                part_syn->max_import_time,
-              };
-              auto add = ts.lookup(x.op, caf::get<vast::time>(d));
-              if (!add || *add) {
-                result.exp = expr;
-                result.partition_infos.emplace_back(part_id, *part_syn);
-              }
-            }
-            VAST_ASSERT(std::is_sorted(result.partition_infos.begin(),
-                                       result.partition_infos.end()));
-            return result;
-          }
-          VAST_WARN("{} cannot process meta extractor: {}",
-                    detail::pretty_type_name(this), lhs.kind);
-          return all_partitions();
+    [&](const negation& x) -> catalog_lookup_result::candidate_info {
+      // A synopsis may return false positives, so negating the result of a
+      // regular lookup may cause false negatives. Instead, we push the
+      // negation inwards using De Morgan's laws, and use exact lookups for the
+      // negated predicates.
+      auto g = detail::overload{
+        [&](const conjunction& y) -> catalog_lookup_result::candidate_info {
+          auto operands = disjunction{};
+          operands.reserve(y.size());
+          for (const auto& operand : y)
+            operands.emplace_back(negation{operand});
+          return lookup_impl(expression{std::move(operands)}, schema,
+                             candidates);
         },
-        [&](const field_extractor& lhs,
-            const data& d) -> catalog_lookup_result::candidate_info {
-          auto pred = [&](const auto& field) {
-            auto match_name = [&] {
-              auto field_name = field.field_name();
-              auto key = std::string_view{lhs.field};
-              if (field_name.length() >= key.length()) {
-                auto pos = field_name.length() - key.length();
-                auto sub = field_name.substr(pos);
-                return sub == key && (pos == 0 || field_name[pos - 1] == '.');
-              }
-              auto schema_name = field.schema_name();
-              if (key.length() > schema_name.length() + 1 + field_name.length())
-                return false;
-              auto pos = key.length() - field_name.length();
-              auto second = key.substr(pos);
-              if (second != field_name)
-                return false;
-              if (key[pos - 1] != '.')
-                return false;
-              auto fpos = schema_name.length() - (pos - 1);
-              return key.substr(0, pos - 1) == schema_name.substr(fpos)
-                     && (fpos == 0 || schema_name[fpos - 1] == '.');
-            };
-            if (!match_name())
-              return false;
-            VAST_ASSERT(!field.is_standalone_type());
-            return compatible(field.type(), x.op, d);
-          };
-          return search(pred);
+        [&](const disjunction& y) -> catalog_lookup_result::candidate_info {
+          auto operands = conjunction{};
+          operands.reserve(y.size());
+          for (const auto& operand : y)
+            operands.emplace_back(negation{operand});
+          return lookup_impl(expression{std::move(operands)}, schema,
+                             candidates);
         },
-        [&](const type_extractor& lhs,
-            const data& d) -> catalog_lookup_result::candidate_info {
-          auto result = [&] {
-            if (!lhs.type) {
-              auto pred = [&](auto& field) {
-                const auto type = field.type();
-                for (const auto& name : type.names())
-                  if (name == lhs.type.name())
-                    return compatible(type, x.op, d);
-                return false;
-              };
-              return search(pred);
-            }
-            auto pred = [&](auto& field) {
-              return congruent(field.type(), lhs.type);
-            };
-            return search(pred);
-          }();
-          return result;
+        [&](const negation& y) -> catalog_lookup_result::candidate_info {
+          return lookup_impl(y.expr(), schema, candidates);
+        },
+        [&](const predicate& y) -> catalog_lookup_result::candidate_info {
+          return lookup_predicate(y, true);
         },
-        [&](const auto&, const auto&) -> catalog_lookup_result::candidate_info {
-          VAST_WARN("{} cannot process predicate: {}",
-                    detail::pretty_type_name(this), x);
+        [&](caf::none_t) -> catalog_lookup_result::candidate_info {
           return all_partitions();
         },
       };
-      return caf::visit(extract_expr, x.lhs, x.rhs);
+      return caf::visit(g, x.expr());
+    },
+    [&](const predicate& x) -> catalog_lookup_result::candidate_info {
+      return lookup_predicate(x, false);
     },
     [&](caf::none_t) -> catalog_lookup_result::candidate_info {
       VAST_ERROR("{} received an empty expression",
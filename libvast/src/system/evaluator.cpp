@@ -86,6 +86,12 @@ private:
 
 } // namespace
 
+ids evaluate_predicate_hits(
+  const expression& expr,
+  const evaluator_state::predicate_hits_map& predicate_hits) {
+  return caf::visit(ids_evaluator{predicate_hits}, expr);
+}
+
 evaluator_state::evaluator_state(
   evaluator_actor::stateful_pointer<evaluator_state> self)
   : self{self} {
@@ -125,7 +131,7 @@ void evaluator_state::handle_no_indexer(const offset& position) {
 }
 
 void evaluator_state::evaluate() {
-  auto expr_hits = caf::visit(ids_evaluator{predicate_hits}, expr);
+  auto expr_hits = evaluate_predicate_hits(expr, predicate_hits);
   VAST_DEBUG("{} got predicate_hits: {} expr_hits: {}", *self, predicate_hits,
              expr_hits);
   hits |= expr_hits;
@@ -8,9 +8,12 @@
 
 #include "vast/execution_node.hpp"
 
+#include "vast/defaults.hpp"
+#include "vast/detail/overload.hpp"
 #include "vast/framed.hpp"
 #include "vast/modules.hpp"
 #include "vast/operator_control_plane.hpp"
+#include "vast/operator_queue.hpp"
 
 #include <caf/attach_stream_sink.hpp>
 #include <caf/attach_stream_source.hpp>
@@ -21,7 +24,11 @@
 #include <caf/typed_event_based_actor.hpp>
 #include <caf/typed_response_promise.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <iterator>
+#include <utility>
+#include <vector>
 
 namespace vast {
 
@@ -68,6 +75,49 @@ private:
   system::execution_node_actor::stateful_impl<execution_node_state>& self_;
 };
 
+class queued_control_plane final : public operator_control_plane {
+public:
+  explicit queued_control_plane(const operator_base& op) : op_{op} {
+  }
+
+  auto get_error() const -> caf::error {
+    return error_;
+  }
+
+  auto self() noexcept -> system::execution_node_actor::base& override {
+    die("not implemented");
+  }
+
+  auto node() noexcept -> system::node_actor override {
+    return {};
+  }
+
+  auto abort(caf::error error) noexcept -> void override {
+    VAST_ASSERT(error != caf::none);
+    error_ = std::move(error);
+  }
+
+  auto warn(caf::error err) noexcept -> void override {
+    VAST_WARN("[WARN] {}: {}", op_.to_string(), err);
+  }
+
+  auto emit(table_slice) noexcept -> void override {
+    die("not implemented");
+  }
+
+  auto schemas() const noexcept -> const std::vector<type>& override {
+    return vast::modules::schemas();
+  }
+
+  auto concepts() const noexcept -> const concepts_map& override {
+    return vast::modules::concepts();
+  }
+
+private:
+  const operator_base& op_;
+  caf::error error_{};
+};
+
 auto empty(const table_slice& slice) -> bool {
   return slice.rows() == 0;
 }
@@ -146,6 +196,82 @@ auto generator_for_queue(std::shared_ptr<std::deque<Input>> queue,
   }
 }
 
+template <class Input>
+auto generator_for_operator_queue(std::shared_ptr<operator_queue<Input>> queue)
+  -> generator<Input> {
+  VAST_ASSERT(queue);
+  auto batch = Input{};
+  while (true) {
+    switch (queue->pop(batch, defaults::exec::queue_poll_interval)) {
+      case operator_queue_status::ok:
+        co_yield std::move(batch);
+        batch = Input{};
+        break;
+      case operator_queue_status::timeout:
+        // Give the operator a chance to make progress without input, e.g., to
+        // flush buffered events.
+        co_yield Input{};
+        break;
+      case operator_queue_status::closed:
+        co_return;
+    }
+  }
+}
+
+/// Like the generic overload, but combines consecutive small table slices of
+/// the same schema into one until they reach a target number of rows, so that
+/// an operator does not pay its per-batch overhead for every tiny slice. A
+/// combined slice waits at most for the linger time after its first part
+/// arrived.
+auto generator_for_operator_queue(
+  std::shared_ptr<operator_queue<table_slice>> queue)
+  -> generator<table_slice> {
+  VAST_ASSERT(queue);
+  using clock = std::chrono::steady_clock;
+  constexpr auto batch_rows = defaults::exec::batch_rows;
+  auto pending = std::vector<table_slice>{};
+  auto pending_rows = uint64_t{0};
+  auto deadline = clock::time_point{};
+  auto flush = [&]() -> table_slice {
+    pending_rows = 0;
+    return concatenate(std::exchange(pending, {}));
+  };
+  auto slice = table_slice{};
+  while (true) {
+    const auto timeout
+      = pending.empty()
+          ? clock::duration{defaults::exec::queue_poll_interval}
+          : std::max(clock::duration::zero(), deadline - clock::now());
+    switch (queue->pop(slice, timeout)) {
+      case operator_queue_status::ok: {
+        if (!pending.empty() && slice.schema() != pending.front().schema())
+          co_yield flush();
+        if (pending.empty() && slice.rows() >= batch_rows) {
+          co_yield std::exchange(slice, {});
+          break;
+        }
+        if (pending.empty())
+          deadline = clock::now() + defaults::exec::batch_linger;
+        pending_rows += slice.rows();
+        pending.push_back(std::exchange(slice, {}));
+        if (pending_rows >= batch_rows || clock::now() >= deadline)
+          co_yield flush();
+        break;
+      }
+      case operator_queue_status::timeout:
+        // Either the linger time of the combined slice expired, or the
+        // operator gets a chance to make progress without input, e.g., to
+        // flush buffered events.
+        co_yield pending.empty() ? table_slice{} : flush();
+        break;
+      case operator_queue_status::closed:
+        if (!pending.empty())
+          co_yield flush();
+        co_return;
+    }
+  }
+}
+
 // We need a custom driver to get access to `out` when finalizing.
 template <class Input, class Output>
   requires(!std::same_as<Input, std::monostate>
@@ -383,4 +509,98 @@ auto execution_node(
   };
 }
 
+auto run_queued_execution_node(const operator_base& op,
+                               const operator_queue_ptr& input,
+                               const operator_queue_ptr& output)
+  -> caf::error {
+  const auto description = op.to_string();
+  auto ctrl = queued_control_plane{op};
+  auto run = [&]() -> caf::error {
+    auto instance = op.instantiate(
+      std::visit(detail::overload{
+                   [](std::monostate) -> operator_input {
+                     return std::monostate{};
+                   },
+                   []<class Input>(
+                     const std::shared_ptr<operator_queue<Input>>& queue)
+                     -> operator_input {
+                     return generator_for_operator_queue(queue);
+                   },
+                 },
+                 input),
+      ctrl);
+    if (!instance)
+      return std::move(instance.error());
+    return std::visit(
+      [&]<class Output>(generator<Output>& gen) -> caf::error {
+        if constexpr (std::is_same_v<Output, std::monostate>) {
+          if (!std::holds_alternative<std::monostate>(output))
+            return caf::make_error(ec::logic_error,
+                                   fmt::format("pipeline was already closed "
+                                               "by '{}', but has more "
+                                               "operators afterwards",
+                                               description));
+          for (auto&& x : gen) {
+            (void)x;
+            if (auto error = ctrl.get_error())
+              return error;
+          }
+        } else {
+          const auto* queue
+            = std::get_if<std::shared_ptr<operator_queue<Output>>>(&output);
+          if (!queue)
+            return caf::make_error(ec::logic_error,
+                                   fmt::format("the operator after '{}' does "
+                                               "not accept {}",
+                                               description,
+                                               operator_type_name<Output>()));
+          for (auto&& batch : gen) {
+            if (auto error = ctrl.get_error())
+              return error;
+            if (empty(batch))
+              continue;
+            if (!(*queue)->push(std::move(batch))) {
+              VAST_DEBUG("'{}' stops because the next operator finished",
+                         description);
+              return {};
+            }
+          }
+        }
+        return ctrl.get_error();
+      },
+      *instance);
+  };
+  auto error = run();
+  // Tell the neighbors that this operator neither produces nor consumes
+  // batches anymore.
+  std::visit(detail::overload{
+               [](std::monostate) {},
+               [](const auto& queue) {
+                 queue->close();
+               },
+             },
+             output);
+  std::visit(detail::overload{
+               [](std::monostate) {},
+               [&](const auto& queue) {
+                 queue->cancel();
+                 const auto metrics = queue->metrics();
+                 if (metrics.batches == 0)
+                   return;
+                 using std::chrono::duration_cast, std::chrono::microseconds;
+                 VAST_DEBUG("'{}' received {} batches with a mean queue "
+                            "latency of {} and a maximum of {}; it waited for "
+                            "input {} times, and its predecessor waited for "
+                            "credit {} times",
+                            description, metrics.batches,
+                            duration_cast<microseconds>(metrics.total_latency
+                                                        / metrics.batches),
+                            duration_cast<microseconds>(metrics.max_latency),
+                            metrics.empty_waits, metrics.full_waits);
+               },
+             },
+             input);
+  return error;
+}
+
 } // namespace vast
@@ -19,10 +19,13 @@
 #include "vast/detail/fill_status_map.hpp"
 #include "vast/detail/narrow.hpp"
 #include "vast/detail/tracepoint.hpp"
+#include "vast/die.hpp"
 #include "vast/error.hpp"
 #include "vast/expression.hpp"
 #include "vast/expression_visitors.hpp"
 #include "vast/logger.hpp"
+#include "vast/modules.hpp"
+#include "vast/operator_control_plane.hpp"
 #include "vast/pipeline.hpp"
 #include "vast/query_context.hpp"
 #include "vast/query_options.hpp"
@@ -39,6 +42,62 @@
 
 namespace vast::system {
 
+/// The partial phase of the first operator of a pipeline, which the exporter
+/// runs separately for the results of every batch of partitions that it
+/// requests from the index. The pipeline starts with the final phase instead,
+/// which merges the partial results, so that the exporter holds only the
+/// partial results rather than all events of a partition at a time.
+struct exporter_partial_phase final : operator_control_plane {
+  explicit exporter_partial_phase(operator_ptr op) : op{std::move(op)} {
+  }
+
+  auto self() noexcept -> execution_node_actor::base& override {
+    die("not implemented");
+  }
+
+  auto node() noexcept -> node_actor override {
+    return {};
+  }
+
+  auto abort(caf::error error) noexcept -> void override {
+    VAST_ASSERT(error != caf::none);
+    if (!this->error)
+      this->error = std::move(error);
+  }
+
+  auto warn(caf::error warning) noexcept -> void override {
+    VAST_WARN("{}", warning);
+  }
+
+  auto emit(table_slice) noexcept -> void override {
+    die("not implemented");
+  }
+
+  auto schemas() const noexcept -> const std::vector<type>& override {
+    return modules::schemas();
+  }
+
+  auto concepts() const noexcept -> const concepts_map& override {
+    return modules::concepts();
+  }
+
+  /// The partial phase of the operator.
+  operator_ptr op = {};
+
+  /// The events of the current batch of partitions that the partial phase did
+  /// not consume yet.
+  std::deque<table_slice> input = {};
+
+  /// Whether all events of the current batch of partitions arrived.
+  bool input_done = false;
+
+  /// The running partial phase for the current batch of partitions.
+  std::optional<generator<table_slice>> output = {};
+
+  /// The error that aborted the partial phase, if any.
+  caf::error error = {};
+};
+
 namespace {
 
 void shutdown_stream(
@@ -140,12 +199,88 @@ void continue_execution(exporter_actor::stateful_pointer<exporter_state> self) {
   }
 }
 
+auto partial_phase_input(exporter_partial_phase& phase)
+  -> generator<table_slice> {
+  while (true) {
+    if (!phase.input.empty()) {
+      auto slice = std::move(phase.input.front());
+      phase.input.pop_front();
+      co_yield std::move(slice);
+    } else if (phase.input_done) {
+      co_return;
+    } else {
+      co_yield {};
+    }
+  }
+}
+
+/// Advances the partial phase until it consumed all of its input, or until it
+/// finishes if all events of the current batch of partitions arrived, and
+/// passes its output on to the source of the pipeline.
+auto advance_partial_phase(exporter_partial_phase& phase,
+                           std::deque<table_slice>& source_buffer)
+  -> caf::error {
+  if (!phase.output && phase.input.empty()) {
+    // Nothing to do for a batch of partitions without results.
+    phase.input_done = false;
+    return {};
+  }
+  if (!phase.output) {
+    auto output = phase.op->instantiate(partial_phase_input(phase), phase);
+    if (!output)
+      return std::move(output.error());
+    auto* slices = std::get_if<generator<table_slice>>(&*output);
+    if (!slices)
+      return caf::make_error(ec::logic_error,
+                             fmt::format("partial phase of '{}' does not "
+                                         "return events",
+                                         *phase.op));
+    phase.output = std::move(*slices);
+  }
+  // This call is fine, because we advance the iterator before dereferencing
+  // it.
+  auto it = phase.output->unsafe_current();
+  while (it != phase.output->end()
+         && (phase.input_done || !phase.input.empty())) {
+    ++it;
+    if (phase.error)
+      return phase.error;
+    if (it != phase.output->end() && (*it).rows() > 0)
+      source_buffer.push_back(std::move(*it));
+  }
+  if (phase.input_done) {
+    // Start over with the next batch of partitions.
+    phase.output.reset();
+    phase.input_done = false;
+  }
+  return {};
+}
+
+void run_partial_phase(exporter_actor::stateful_pointer<exporter_state> self) {
+  auto& phase = *self->state.partial_phase;
+  // An aborted partial phase already stopped the result stream.
+  if (phase.error)
+    return;
+  if (auto err = advance_partial_phase(phase, self->state.source_buffer)) {
+    phase.error = err;
+    self->state.result_stream->stop(caf::make_error(
+      ec::unspecified, fmt::format("{} encountered an error during "
+                                   "execution and shuts down: {}",
+                                   *self, err)));
+  }
+}
+
 void provide_to_source(exporter_actor::stateful_pointer<exporter_state> self,
                        table_slice slice) {
   auto& st = self->state;
   VAST_DEBUG("{} relays {} events", *self, slice.rows());
   // Ship the slice and update state.
   st.query_status.shipped += slice.rows();
+  if (st.partial_phase) {
+    st.partial_phase->input.push_back(std::move(slice));
+    run_partial_phase(self);
+    return;
+  }
   self->state.source_buffer.push_back(std::move(slice));
 }
 
@@ -285,6 +420,23 @@ auto exporter(exporter_actor::stateful_pointer<exporter_state> self,
     return exporter_actor::behavior_type::make_empty_behavior();
   }
   expr = std::move(*normalized);
+  // Historical queries receive their results one batch of partitions after
+  // the other, which allows for computing partial results for every batch if
+  // the pipeline starts with an operator that supports this.
+  if (has_historical_option(options) && !has_continuous_option(options)) {
+    auto ops = std::move(pipe).unwrap();
+    if (!ops.empty()) {
+      if (auto split = ops.front()->split_partial()) {
+        VAST_DEBUG("{} runs the partial phase of {} for every batch of "
+                   "partitions",
+                   *self, *ops.front());
+        self->state.partial_phase = std::make_shared<exporter_partial_phase>(
+          std::move(split->first));
+        ops.front() = std::move(split->second);
+      }
+    }
+    pipe = pipeline{std::move(ops)};
+  }
   pipe.prepend(std::make_unique<exporter_source>(self));
   pipe.append(std::make_unique<exporter_sink>(self));
   VAST_DEBUG("{} uses filter {} and pipeline {}", *self, expr, pipe);
@@ -429,6 +581,10 @@ auto exporter(exporter_actor::stateful_pointer<exporter_state> self,
       caf::timespan runtime
         = std::chrono::system_clock::now() - self->state.start;
       self->state.query_status.runtime = runtime;
+      if (self->state.partial_phase) {
+        self->state.partial_phase->input_done = true;
+        run_partial_phase(self);
+      }
       VAST_DEBUG("{} continues execution due partition completion", *self);
       continue_execution(self);
       if (index_exhausted(self->state.query_status)) {
@@ -63,12 +63,14 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <ctime>
 #include <deque>
 #include <filesystem>
 #include <memory>
 #include <numeric>
 #include <span>
+#include <thread>
 #include <unistd.h>
 
 // clang-format off
@@ -306,7 +308,8 @@ partition_actor partition_factory::operator()(const uuid& id) const {
   VAST_DEBUG("{} loads partition {} for path {}", *state_.self, id, path);
   materializations_++;
   return state_.self->spawn(passive_partition, id, state_.accountant,
-                            filesystem_, path);
+                            filesystem_, path,
+                            state_.synopsis_opts.synchronous_evaluation);
 }
 
 size_t partition_factory::materializations() const {
@@ -410,8 +413,9 @@ caf::error index_state::load_from_disk() {
             // result in incorrect index statistics. This depends on whether the
             // statistics where already updated on-disk before VAST crashed or
             // not, which is hard to figure out here.
-            auto partition = self->spawn(passive_partition, uuid, accountant,
-                                         filesystem, path);
+            auto partition
+              = self->spawn(passive_partition, uuid, accountant, filesystem,
+                            path, synopsis_opts.synchronous_evaluation);
             self->request(partition, caf::infinite, atom::erase_v)
               .then(
                 [this, uuid](atom::done) {
@@ -819,6 +823,45 @@ void index_state::add_partition_creation_listener(
 
 // -- query handling ---------------------------------------------------------
 
+namespace {
+
+/// Returns the number of partition lookups that can use the CPU at the same
+/// time.
+size_t lookup_parallelism() {
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+} // namespace
+
+void lookup_concurrency::record(duration latency, bool materialized) {
+  // The exponentially weighted moving averages adapt to a changing workload
+  // within a few dozen lookups.
+  constexpr auto alpha = 0.1;
+  auto update = [&](double& average, double sample) {
+    average = average == 0.0 ? sample : average + alpha * (sample - average);
+  };
+  const auto seconds = std::chrono::duration<double>{latency}.count();
+  update(materialized ? materialized_latency : cached_latency, seconds);
+  materialized_fraction
+    += alpha * ((materialized ? 1.0 : 0.0) - materialized_fraction);
+}
+
+size_t lookup_concurrency::limit(size_t parallelism, size_t max) const {
+  // Lookups on cached partitions tell us how much CPU time a lookup takes.
+  // Without them we cannot estimate the time spent waiting for I/O.
+  if (cached_latency == 0.0)
+    return max;
+  // A lookup that spends a fraction of its time waiting leaves the CPU to
+  // other lookups in the meantime, so we can run `1 + wait / compute` lookups
+  // per core.
+  const auto wait = materialized_fraction
+                    * std::max(materialized_latency - cached_latency, 0.0);
+  const auto target = static_cast<double>(parallelism)
+                      * (1.0 + wait / cached_latency);
+  const auto result = static_cast<size_t>(std::ceil(target));
+  return std::min(max, std::max(size_t{1}, result));
+}
+
 auto index_state::schedule_lookups() -> size_t {
   if (!pending_queries.has_work())
     return 0u;
@@ -828,7 +871,9 @@ auto index_state::schedule_lookups() -> size_t {
     t.stop(num_scheduled);
   });
   const size_t previous_partition_lookups = running_partition_lookups;
-  while (running_partition_lookups < max_concurrent_partition_lookups) {
+  const auto concurrency_limit = partition_lookup_concurrency.limit(
+    lookup_parallelism(), max_concurrent_partition_lookups);
+  while (running_partition_lookups < concurrency_limit) {
     // 1. Get the partition with the highest accumulated priority.
     auto next = pending_queries.next();
     if (!next) {
@@ -857,6 +902,7 @@ auto index_state::schedule_lookups() -> size_t {
                next->queries);
     // 2. Acquire the actor for the selected partition, potentially materializing
     //    it from its persisted state.
+    auto materialized = false;
     auto acquire = [&](const uuid& partition_id) -> partition_actor {
       // We need to first check whether the ID is the active partition or one
       // of our unpersisted ones. Only then can we dispatch to our LRU cache.
@@ -874,6 +920,7 @@ auto index_state::schedule_lookups() -> size_t {
           part = it->second.second;
         } else if (auto it = persisted_partitions.find(partition_id);
                    it != persisted_partitions.end()) {
+          materialized = !inmem_partitions.contains(partition_id);
           part = inmem_partitions.get_or_load(partition_id);
         }
       }
@@ -932,10 +979,15 @@ auto index_state::schedule_lookups() -> size_t {
         ->request(partition_actor, defaults::system::scheduler_timeout,
                   atom::query_v, context_it->second)
         .then(
-          [this, handle_completion, qid, pid = next->partition](uint64_t n) {
+          [this, handle_completion, qid, pid = next->partition, materialized,
+           start = std::chrono::steady_clock::now()](uint64_t n) {
             VAST_DEBUG("{} received {} results for query {} from partition "
                        "{}",
                        *self, n, qid, pid);
+            partition_lookup_concurrency.record(
+              std::chrono::duration_cast<duration>(
+                std::chrono::steady_clock::now() - start),
+              materialized);
             handle_completion();
           },
           [this, handle_completion, qid,
@@ -1003,6 +1055,9 @@ void index_state::send_report() {
       {"scheduler.partition.remaining-capacity",
        max_concurrent_partition_lookups - running_partition_lookups},
       {"scheduler.partition.current-lookups", running_partition_lookups},
+      {"scheduler.partition.concurrency-limit",
+       partition_lookup_concurrency.limit(lookup_parallelism(),
+                                          max_concurrent_partition_lookups)},
     }};
   msg.data.push_back(data_point{
           .key = "memory-usage",
@@ -1061,6 +1116,8 @@ index_state::status(status_verbosity v) const {
     worker_status["idle"]
       = max_concurrent_partition_lookups - running_partition_lookups;
     worker_status["busy"] = running_partition_lookups;
+    worker_status["limit"] = partition_lookup_concurrency.limit(
+      lookup_parallelism(), max_concurrent_partition_lookups);
     rs->content["workers"] = std::move(worker_status);
     auto pending_status = list{};
     for (const auto& [u, qs] : pending_queries.queries()) {
@@ -35,6 +35,7 @@
 #include "vast/format/test.hpp"
 #include "vast/format/zeek.hpp"
 #include "vast/logger.hpp"
+#include "vast/parallel_operator.hpp"
 #include "vast/plugin.hpp"
 #include "vast/system/accountant.hpp"
 #include "vast/system/accountant_config.hpp"
@@ -812,6 +813,10 @@ node(node_actor::stateful_pointer<node_state> self, std::string name,
                                              "local operator '{}'",
                                              *self, op));
         }
+        const auto& options = content(self->system().config());
+        op = parallelize(std::move(op), options,
+                         caf::get_or(options, "vast.exec.node-parallelism",
+                                     defaults::exec::node_parallelism));
         auto description = op->to_string();
         if (op->detached()) {
           result.emplace_back(
@@ -15,6 +15,7 @@
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/uuid.hpp"
 #include "vast/detail/assert.hpp"
+#include "vast/detail/overload.hpp"
 #include "vast/detail/partition_common.hpp"
 #include "vast/detail/tracepoint.hpp"
 #include "vast/fbs/partition.hpp"
@@ -25,6 +26,7 @@
 #include "vast/ip_synopsis.hpp"
 #include "vast/logger.hpp"
 #include "vast/plugin.hpp"
+#include "vast/system/evaluator.hpp"
 #include "vast/system/indexer.hpp"
 #include "vast/system/report.hpp"
 #include "vast/system/shutdown.hpp"
@@ -89,6 +91,20 @@ unpack_schema(const fbs::partition::LegacyPartition& partition) {
                                            "partition flatbuffer");
 }
 
+value_index_ptr
+unpack_value_index_at(const passive_partition_state& state, size_t position) {
+  const auto* qualified_index = state.flatbuffer->indexes()->Get(position);
+  if (!qualified_index || !qualified_index->index())
+    return {};
+  if (auto value_index
+      = unpack_value_index(*qualified_index->index(), *state.container))
+    return value_index;
+  VAST_WARN("passive-partition ({}) failed to deserialize value index for "
+            "field {}",
+            state.id, qualified_index->field_name()->string_view());
+  return {};
+}
+
 } // namespace
 
 value_index_ptr
@@ -150,18 +166,59 @@ indexer_actor passive_partition_state::indexer_at(size_t position) const {
     return indexer;
   // Deserialize the value index and spawn a passive_indexer lazily when it is
   // requested for the first time.
-  const auto* qualified_index = flatbuffer->indexes()->Get(position);
-  if (!qualified_index || !qualified_index->index())
-    return {};
-  if (auto value_index
-      = unpack_value_index(*qualified_index->index(), *container)) {
+  if (auto value_index = unpack_value_index_at(*this, position))
     indexer = self->spawn(passive_indexer, id, std::move(value_index));
-    return indexer;
+  return indexer;
+}
+
+const value_index*
+passive_partition_state::value_index_at(size_t position) const {
+  VAST_ASSERT(position < value_indexes.size());
+  auto& value_index = value_indexes[position];
+  if (!value_index)
+    value_index = unpack_value_index_at(*this, position);
+  return value_index.get();
+}
+
+std::optional<ids>
+passive_partition_state::lookup(const expression& expr) const {
+  if (!combined_schema_)
+    return std::nullopt;
+  auto resolved = resolve(expr, type{*combined_schema_});
+  if (resolved.empty())
+    return std::nullopt;
+  // Like the EVALUATOR, we assume that predicates that we cannot look up in a
+  // value index match all events.
+  auto all_ids = ids{};
+  for (const auto& [_, ids] : type_ids_)
+    all_ids |= ids;
+  auto predicate_hits = evaluator_state::predicate_hits_map{};
+  for (const auto& [offset, predicate] : resolved) {
+    auto f = detail::overload{
+      [&](const meta_extractor& ex, const data& x) -> std::optional<ids> {
+        return detail::lookup_meta(*this, ex, predicate.op, x);
+      },
+      [&](const data_extractor& dx, const data& x) -> std::optional<ids> {
+        const auto* idx = value_index_at(dx.column);
+        if (!idx)
+          return std::nullopt;
+        auto result
+          = idx->lookup(predicate.op, to_internal(idx->type(), make_view(x)));
+        if (!result) {
+          VAST_WARN("{} failed to evaluate predicate {}: {}", *self, predicate,
+                    result.error());
+          return ids{};
+        }
+        return std::move(*result);
+      },
+      [](const auto&, const auto&) -> std::optional<ids> {
+        return std::nullopt;
+      },
+    };
+    auto hits = caf::visit(f, predicate.lhs, predicate.rhs);
+    predicate_hits[offset].second |= hits ? *hits : all_ids;
   }
-  VAST_WARN("passive-partition ({}) failed to deserialize value index for "
-            "field {}",
-            id, qualified_index->field_name()->string_view());
-  return {};
+  return evaluate_predicate_hits(expr, predicate_hits);
 }
 
 const std::optional<vast::record_type>&
@@ -226,6 +283,7 @@ caf::error unpack(const fbs::partition::LegacyPartition& partition,
   // vector must be the same as in `combined_schema`. The actual indexers are
   // deserialized and spawned lazily on demand.
   state.indexers.resize(indexes->size());
+  state.value_indexes.resize(indexes->size());
   VAST_DEBUG("{} found {} indexers for partition {}", state.name,
              indexes->size(), state.id);
   auto const* type_ids = partition.type_ids();
@@ -328,10 +386,11 @@ passive_partition_state::initialize_from_chunk(const vast::chunk_ptr& chunk) {
 partition_actor::behavior_type passive_partition(
   partition_actor::stateful_pointer<passive_partition_state> self, uuid id,
   accountant_actor accountant, filesystem_actor filesystem,
-  const std::filesystem::path& path) {
+  const std::filesystem::path& path, bool synchronous_evaluation) {
   auto id_string = to_string(id);
   self->state.self = self;
   self->state.path = path;
+  self->state.synchronous_evaluation = synchronous_evaluation;
   self->state.accountant = std::move(accountant);
   self->state.filesystem = std::move(filesystem);
   VAST_TRACEPOINT(passive_partition_spawned, id_string.c_str());
@@ -465,6 +524,60 @@ partition_actor::behavior_type passive_partition(
         return rp;
       }
       auto start = std::chrono::steady_clock::now();
+      auto handle_hits = [self, rp, start](vast::query_context query_context,
+                                           const ids& hits) mutable {
+        if (!hits.empty() && hits.size() != self->state.events) {
+          // FIXME: We run into this for at least the IP index following the
+          // quickstart guide in the documentation, indicating that the IP
+          // index returns an undersized bitmap whose length does not match
+          // the number of events in this partition. This _can_ cause subtle
+          // issues downstream because you need to very carefully handle
+          // this scenario, which is easy to overlook as a developer. We
+          // should fix this issue.
+          VAST_DEBUG("{} received evaluator results with wrong length: "
+                     "expected {}, got {}",
+                     *self, self->state.events, hits.size());
+        }
+        VAST_DEBUG("{} received results from the evaluator", *self);
+        duration runtime = std::chrono::steady_clock::now() - start;
+        auto id_str = fmt::to_string(query_context.id);
+        self->send(self->state.accountant, atom::metrics_v,
+                   "partition.lookup.runtime", runtime,
+                   metrics_metadata{
+                     {"query", id_str},
+                     {"issuer", query_context.issuer},
+                     {"partition-type", "passive"},
+                   });
+        self->send(self->state.accountant, atom::metrics_v,
+                   "partition.lookup.hits", rank(hits),
+                   metrics_metadata{
+                     {"query", std::move(id_str)},
+                     {"issuer", query_context.issuer},
+                     {"partition-type", "passive"},
+                   });
+        // TODO: Use the first path if the expression can be evaluated
+        // exactly.
+        auto* count = caf::get_if<count_query_context>(&query_context.cmd);
+        if (count && count->mode == count_query_context::estimate) {
+          self->send(count->sink, rank(hits));
+          rp.deliver(rank(hits));
+        } else {
+          query_context.ids = hits;
+          rp.delegate(self->state.store, atom::query_v,
+                      std::move(query_context));
+        }
+      };
+      // In synchronous mode, we look up the value indexes directly instead of
+      // spawning an EVALUATOR and INDEXER actors that exchange messages.
+      if (self->state.synchronous_evaluation) {
+        auto hits = self->state.lookup(query_context.expr);
+        if (!hits) {
+          rp.deliver(uint64_t{0});
+          return rp;
+        }
+        handle_hits(std::move(query_context), *hits);
+        return rp;
+      }
       auto triples = detail::evaluate(self->state, query_context.expr);
       if (triples.empty()) {
         rp.deliver(uint64_t{0});
@@ -476,48 +589,9 @@ partition_actor::behavior_type passive_partition(
                               std::move(ids_for_evaluation));
       self->request(eval, caf::infinite, atom::run_v)
         .then(
-          [self, rp, start,
-           query_context = std::move(query_context)](const ids& hits) mutable {
-            if (!hits.empty() && hits.size() != self->state.events) {
-              // FIXME: We run into this for at least the IP index following the
-              // quickstart guide in the documentation, indicating that the IP
-              // index returns an undersized bitmap whose length does not match
-              // the number of events in this partition. This _can_ cause subtle
-              // issues downstream because you need to very carefully handle
-              // this scenario, which is easy to overlook as a developer. We
-              // should fix this issue.
-              VAST_DEBUG("{} received evaluator results with wrong length: "
-                         "expected {}, got {}",
-                         *self, self->state.events, hits.size());
-            }
-            VAST_DEBUG("{} received results from the evaluator", *self);
-            duration runtime = std::chrono::steady_clock::now() - start;
-            auto id_str = fmt::to_string(query_context.id);
-            self->send(self->state.accountant, atom::metrics_v,
-                       "partition.lookup.runtime", runtime,
-                       metrics_metadata{
-                         {"query", id_str},
-                         {"issuer", query_context.issuer},
-                         {"partition-type", "passive"},
-                       });
-            self->send(self->state.accountant, atom::metrics_v,
-                       "partition.lookup.hits", rank(hits),
-                       metrics_metadata{
-                         {"query", std::move(id_str)},
-                         {"issuer", query_context.issuer},
-                         {"partition-type", "passive"},
-                       });
-            // TODO: Use the first path if the expression can be evaluated
-            // exactly.
-            auto* count = caf::get_if<count_query_context>(&query_context.cmd);
-            if (count && count->mode == count_query_context::estimate) {
-              self->send(count->sink, rank(hits));
-              rp.deliver(rank(hits));
-            } else {
-              query_context.ids = hits;
-              rp.delegate(self->state.store, atom::query_v,
-                          std::move(query_context));
-            }
+          [handle_hits, query_context = std::move(query_context)](
+            const ids& hits) mutable {
+            handle_hits(std::move(query_context), hits);
           },
           [rp](caf::error& err) mutable {
             rp.deliver(std::move(err));
@@ -565,7 +639,7 @@ partition_actor::behavior_type passive_partition(
       result["size"] = self->state.partition_chunk->size();
       size_t mem_indexers = 0;
       for (size_t i = 0; i < self->state.indexers.size(); ++i)
-        if (self->state.indexers[i])
+        if (self->state.indexers[i] || self->state.value_indexes[i])
           mem_indexers += sizeof(indexer_state)
                           + self->state.flatbuffer->indexes()
                               ->Get(i)
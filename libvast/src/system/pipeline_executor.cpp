@@ -8,11 +8,15 @@
 
 #include "vast/pipeline_executor.hpp"
 
+#include "vast/defaults.hpp"
 #include "vast/detail/narrow.hpp"
 #include "vast/execution_node.hpp"
+#include "vast/operator_queue.hpp"
+#include "vast/parallel_operator.hpp"
 #include "vast/pipeline.hpp"
 #include "vast/system/actors.hpp"
 #include "vast/system/connect_to_node.hpp"
+#include "vast/timed_operator.hpp"
 
 #include <caf/attach_stream_sink.hpp>
 #include <caf/attach_stream_source.hpp>
@@ -24,6 +28,7 @@
 #include <caf/typed_response_promise.hpp>
 
 #include <iterator>
+#include <thread>
 
 namespace vast {
 
@@ -52,6 +57,7 @@ void pipeline_executor_state::spawn_execution_nodes(
         // Spawn and collect execution nodes until the first remote operator.
         auto& v = hosts.emplace_back();
         while (true) {
+          *it = parallelize(std::move(*it), content(self->system().config()));
           auto description = (*it)->to_string();
           if ((*it)->detached()) {
             v.push_back(caf::actor_cast<caf::actor>(
@@ -127,6 +133,62 @@ void pipeline_executor_state::spawn_execution_nodes(
   continue_if_done_spawning();
 }
 
+auto pipeline_executor_state::run_queued(std::vector<operator_ptr> ops)
+  -> caf::result<void> {
+  VAST_DEBUG("running pipeline with {} queued operators", ops.size());
+  // Measure every operator on its own. Operators that run with multiple
+  // instances sum up the time of all instances.
+  auto timings = std::vector<
+    std::pair<std::string, std::shared_ptr<operator_timings>>>{};
+  timings.reserve(ops.size());
+  for (auto& op : ops) {
+    auto timing = std::make_shared<operator_timings>();
+    timings.emplace_back(op->to_string(), timing);
+    op = std::make_unique<timed_operator>(std::move(op), std::move(timing));
+  }
+  // Adjacent operators that only select rows and transform columns run as
+  // one. This happens after wrapping them for measurement, so every operator
+  // of a fused chain still measures its own step. Materializing the rows that
+  // remain at the end of a chain counts towards none of them.
+  ops = pipeline::fuse(std::move(ops));
+  ops = parallelize(std::move(ops), content(self->system().config()));
+  // Create a queue for the output of every operator except the last.
+  auto queues = std::vector<operator_queue_ptr>{};
+  queues.reserve(ops.size() + 1);
+  queues.emplace_back();
+  auto current = operator_type{tag_v<void>};
+  for (size_t i = 0; i < ops.size(); ++i) {
+    auto next = ops[i]->infer_type(current);
+    if (!next)
+      return std::move(next.error());
+    if (i + 1 == ops.size())
+      queues.emplace_back();
+    else
+      queues.push_back(
+        make_operator_queue(*next, defaults::exec::queue_capacity));
+    current = *next;
+  }
+  auto errors = std::vector<caf::error>(ops.size());
+  auto threads = std::vector<std::thread>{};
+  threads.reserve(ops.size());
+  for (size_t i = 0; i < ops.size(); ++i)
+    threads.push_back(self->system().launch_thread("vast.exec", [&, i] {
+      errors[i] = run_queued_execution_node(*ops[i], queues[i], queues[i + 1]);
+    }));
+  for (auto& thread : threads)
+    thread.join();
+  for (const auto& [description, timing] : timings) {
+    using std::chrono::duration_cast, std::chrono::microseconds;
+    VAST_VERBOSE("'{}' spent {} on {} input and {} output batches",
+                 description, duration_cast<microseconds>(timing->busy()),
+                 timing->inputs.load(), timing->outputs.load());
+  }
+  for (auto& error : errors)
+    if (error)
+      return std::move(error);
+  return {};
+}
+
 auto pipeline_executor_state::run() -> caf::result<void> {
   if (!pipe) {
     return caf::make_error(ec::logic_error,
@@ -138,23 +200,26 @@ auto pipeline_executor_state::run() -> caf::result<void> {
   auto has_remote = std::any_of(ops.begin(), ops.end(), [](auto& op) {
     return op->location() == operator_location::remote;
   });
-  rp_complete = self->make_response_promise<void>();
-  if (has_remote) {
-    system::connect_to_node(
-      self, content(self->system().config()),
-      // We use a shared_ptr because of non-copyable operator_ptr.
-      [this, ops = std::make_shared<decltype(ops)>(std::move(ops))](
-        caf::expected<system::node_actor> node) mutable {
-        if (!node) {
-          rp_complete.deliver(node.error());
-          self->quit(node.error());
-          return;
-        }
-        spawn_execution_nodes(*node, std::move(*ops));
-      });
-  } else {
-    spawn_execution_nodes({}, std::move(ops));
+  // Pipelines that run entirely in this process do not need execution node
+  // actors, so we connect their operators with queues instead.
+  if (!has_remote) {
+    auto result = run_queued(std::move(ops));
+    self->quit();
+    return result;
   }
+  rp_complete = self->make_response_promise<void>();
+  system::connect_to_node(
+    self, content(self->system().config()),
+    // We use a shared_ptr because of non-copyable operator_ptr.
+    [this, ops = std::make_shared<decltype(ops)>(std::move(ops))](
+      caf::expected<system::node_actor> node) mutable {
+      if (!node) {
+        rp_complete.deliver(node.error());
+        self->quit(node.error());
+        return;
+      }
+      spawn_execution_nodes(*node, std::move(*ops));
+    });
   return rp_complete;
 }
 
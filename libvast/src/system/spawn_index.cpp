@@ -51,6 +51,8 @@ spawn_index(node_actor::stateful_pointer<node_state> self,
                                                             *settings));
     if (auto err = convert(as_data, index_config))
       return err;
+    if (auto err = validate(index_config))
+      return err;
     VAST_VERBOSE("using customized indexing configuration {}", index_config);
   }
   auto handle = self->spawn(
@@ -27,7 +27,11 @@
 #include "vast/type.hpp"
 #include "vast/value_index.hpp"
 
+#include <arrow/array/array_primitive.h>
+#include <arrow/buffer.h>
+#include <arrow/compute/api_vector.h>
 #include <arrow/record_batch.h>
+#include <arrow/util/bit_util.h>
 
 #include <cstddef>
 #include <span>
@@ -597,17 +601,21 @@ table_slice concatenate(std::vector<table_slice> slices) {
   return result;
 }
 
-generator<table_slice>
-select(const table_slice& slice, expression expr, const ids& hints) {
+namespace {
+
+/// Computes the IDs of the rows in *slice* that are in *hints* and match
+/// *expr*. Returns nullopt if no rows qualify.
+std::optional<ids>
+make_selection(const table_slice& slice, const expression& expr,
+               const ids& hints) {
   VAST_ASSERT(slice.encoding() != table_slice_encoding::none);
   const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
-  auto slice_ids = make_ids({{offset, offset + slice.rows()}});
-  auto selection = slice_ids;
+  auto selection = make_ids({{offset, offset + slice.rows()}});
   if (!hints.empty())
     selection &= hints;
   // Do no rows qualify?
   if (!any(selection))
-    co_return;
+    return std::nullopt;
   // Evaluate the filter expression.
   if (!caf::holds_alternative<caf::none_t>(expr)) {
     // Tailor the expression to the type; this is required for using the
@@ -615,12 +623,24 @@ select(const table_slice& slice, expression expr, const ids& hints) {
     // already.
     auto tailored_expr = tailor(expr, slice.schema());
     if (!tailored_expr)
-      co_return;
+      return std::nullopt;
     selection = evaluate(*tailored_expr, slice, selection);
     // Do no rows qualify?
     if (!any(selection))
-      co_return;
+      return std::nullopt;
   }
+  return selection;
+}
+
+} // namespace
+
+generator<table_slice>
+select(const table_slice& slice, expression expr, const ids& hints) {
+  const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
+  auto maybe_selection = make_selection(slice, expr, hints);
+  if (!maybe_selection)
+    co_return;
+  auto& selection = *maybe_selection;
   // Do all rows qualify?
   if (rank(selection) == slice.rows()) {
     co_yield slice;
@@ -711,10 +731,42 @@ filter(const table_slice& slice, expression expr, const ids& hints) {
   if (slice.encoding() == table_slice_encoding::none) {
     return {};
   }
-  auto selected = collect(select(slice, std::move(expr), hints));
-  if (selected.empty())
+  const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
+  auto selection = make_selection(slice, expr, hints);
+  if (!selection)
+    return {};
+  // Do all rows qualify?
+  const auto num_selected = rank(*selection);
+  if (num_selected == slice.rows())
+    return slice;
+  // Translate the selection into an Arrow filter mask, and let Arrow's filter
+  // kernel gather the selected rows for all columns at once. This is
+  // significantly faster than concatenating the selected runs, which would
+  // require rebuilding the batch row by row.
+  const auto num_rows = detail::narrow_cast<int64_t>(slice.rows());
+  auto mask_buffer = arrow::AllocateEmptyBitmap(num_rows).ValueOrDie();
+  auto first_selected = std::optional<id>{};
+  for (const auto [first, last] : select_runs(*selection)) {
+    if (!first_selected)
+      first_selected = first;
+    arrow::bit_util::SetBitsTo(mask_buffer->mutable_data(),
+                               detail::narrow_cast<int64_t>(first - offset),
+                               detail::narrow_cast<int64_t>(last - first),
+                               true);
+  }
+  VAST_ASSERT(first_selected);
+  const auto mask = std::make_shared<arrow::BooleanArray>(
+    num_rows, std::move(mask_buffer));
+  auto filtered = arrow::compute::Filter(to_record_batch(slice), mask);
+  if (!filtered.ok()) {
+    VAST_WARN("failed to filter table slice: {}", filtered.status().ToString());
     return {};
-  return concatenate(std::move(selected));
+  }
+  auto result = table_slice{filtered->record_batch(), slice.schema()};
+  VAST_ASSERT(result.rows() == num_selected);
+  result.offset(*first_selected);
+  result.import_time(slice.import_time());
+  return result;
 }
 
 std::optional<table_slice>
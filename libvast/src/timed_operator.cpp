@@ -0,0 +1,170 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/timed_operator.hpp"
+
+#include "vast/detail/assert.hpp"
+#include "vast/detail/overload.hpp"
+#include "vast/error.hpp"
+
+#include <fmt/format.h>
+
+namespace vast {
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+void add_busy(operator_timings& timings, clock::duration elapsed) {
+  timings.busy_nanoseconds.fetch_add(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+    std::memory_order_relaxed);
+}
+
+template <class T>
+auto is_batch(const T& x) -> bool {
+  if constexpr (std::is_same_v<T, table_slice>)
+    return x.rows() > 0;
+  else if constexpr (std::is_same_v<T, chunk_ptr>)
+    return x && x->size() > 0;
+  else
+    return false;
+}
+
+/// Forwards the input of an operator, and tracks how long it takes to
+/// produce it.
+template <class Input>
+auto timed_input(generator<Input> input,
+                 std::shared_ptr<std::chrono::nanoseconds> spent,
+                 std::shared_ptr<operator_timings> timings)
+  -> generator<Input> {
+  auto start = clock::now();
+  auto it = input.begin();
+  *spent += clock::now() - start;
+  while (it != input.end()) {
+    if (is_batch(*it))
+      timings->inputs.fetch_add(1, std::memory_order_relaxed);
+    co_yield std::move(*it);
+    start = clock::now();
+    ++it;
+    *spent += clock::now() - start;
+  }
+}
+
+/// Forwards the output of an operator, and accounts the time it takes to
+/// produce it, minus the time spent in producing its input, to the operator.
+template <class Output>
+auto timed_output(generator<Output> output,
+                  std::shared_ptr<std::chrono::nanoseconds> input_spent,
+                  std::shared_ptr<operator_timings> timings)
+  -> generator<Output> {
+  auto account = [&](clock::time_point start,
+                     std::chrono::nanoseconds input_before) {
+    add_busy(*timings, clock::now() - start - (*input_spent - input_before));
+  };
+  auto input_before = *input_spent;
+  auto start = clock::now();
+  auto it = output.begin();
+  account(start, input_before);
+  while (it != output.end()) {
+    if (is_batch(*it))
+      timings->outputs.fetch_add(1, std::memory_order_relaxed);
+    co_yield std::move(*it);
+    input_before = *input_spent;
+    start = clock::now();
+    ++it;
+    account(start, input_before);
+  }
+}
+
+} // namespace
+
+timed_operator::timed_operator(operator_ptr op,
+                               std::shared_ptr<operator_timings> timings)
+  : op_{std::move(op)}, timings_{std::move(timings)} {
+  VAST_ASSERT(op_);
+  VAST_ASSERT(timings_);
+}
+
+auto timed_operator::instantiate(operator_input input,
+                                 operator_control_plane& ctrl) const
+  -> caf::expected<operator_output> {
+  auto input_spent = std::make_shared<std::chrono::nanoseconds>();
+  auto output = op_->instantiate(
+    std::visit(detail::overload{
+                 [](std::monostate) -> operator_input {
+                   return std::monostate{};
+                 },
+                 [&]<class Input>(generator<Input> gen) -> operator_input {
+                   return timed_input(std::move(gen), input_spent, timings_);
+                 },
+               },
+               std::move(input)),
+    ctrl);
+  if (!output)
+    return std::move(output.error());
+  return std::visit(
+    [&]<class Output>(generator<Output> gen) -> operator_output {
+      return timed_output(std::move(gen), input_spent, timings_);
+    },
+    std::move(*output));
+}
+
+auto timed_operator::copy() const -> operator_ptr {
+  return std::make_unique<timed_operator>(op_->copy(), timings_);
+}
+
+auto timed_operator::to_string() const -> std::string {
+  return op_->to_string();
+}
+
+auto timed_operator::location() const -> operator_location {
+  return op_->location();
+}
+
+auto timed_operator::detached() const -> bool {
+  return op_->detached();
+}
+
+auto timed_operator::parallelism() const -> operator_parallelism {
+  return op_->parallelism();
+}
+
+auto timed_operator::infer_type_impl(operator_type input) const
+  -> caf::expected<operator_type> {
+  return op_->infer_type(input);
+}
+
+auto timed_operator::fuse(const type& schema,
+                          operator_control_plane& ctrl) const
+  -> caf::expected<fused_step> {
+  const auto* op = dynamic_cast<const fusable_operator*>(&*op_);
+  if (!op)
+    return caf::make_error(ec::logic_error,
+                           fmt::format("'{}' cannot be fused", to_string()));
+  const auto start = clock::now();
+  auto step = op->fuse(schema, ctrl);
+  add_busy(*timings_, clock::now() - start);
+  if (!step)
+    return std::move(step.error());
+  // The chain only calls a step for batches that still have rows left.
+  return [step = std::move(*step), timings = timings_](fused_batch& batch) {
+    timings->inputs.fetch_add(1, std::memory_order_relaxed);
+    const auto start = clock::now();
+    step(batch);
+    add_busy(*timings, clock::now() - start);
+    if (!batch.empty())
+      timings->outputs.fetch_add(1, std::memory_order_relaxed);
+  };
+}
+
+auto timed_operator::fusable() const -> bool {
+  return is_fusable(*op_);
+}
+
+} // namespace vast
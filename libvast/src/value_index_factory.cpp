@@ -14,12 +14,14 @@
 #include "vast/detail/bit.hpp"
 #include "vast/detail/type_traits.hpp"
 #include "vast/index/arithmetic_index.hpp"
+#include "vast/index/bit_sliced_index.hpp"
 #include "vast/index/enumeration_index.hpp"
 #include "vast/index/hash_index.hpp"
 #include "vast/index/ip_index.hpp"
 #include "vast/index/list_index.hpp"
 #include "vast/index/string_index.hpp"
 #include "vast/index/subnet_index.hpp"
+#include "vast/index/trigram_index.hpp"
 #include "vast/logger.hpp"
 #include "vast/type.hpp"
 #include "vast/value_index.hpp"
@@ -34,6 +36,18 @@ using namespace std::string_view_literals;
 namespace vast {
 namespace {
 
+/// Maps an arithmetic index to the bit-sliced index for the same type.
+template <class Index>
+struct bit_sliced_alternative {
+  using type = void;
+};
+
+template <class T>
+  requires(!std::is_same_v<T, bool>)
+struct bit_sliced_alternative<arithmetic_index<T>> {
+  using type = bit_sliced_index<T>;
+};
+
 template <class T>
 value_index_ptr make(type x, caf::settings opts) {
   using int_type = caf::config_value::integer;
@@ -114,6 +128,17 @@ value_index_ptr make(type x, caf::settings opts) {
       }
     }
   }
+  if constexpr (std::is_same_v<T, string_index>) {
+    if (caf::get_or(opts, "string-index", std::string{"bitslice"})
+        == "trigram")
+      return std::make_unique<trigram_index>(std::move(x), std::move(opts));
+  }
+  using bit_sliced_type = typename bit_sliced_alternative<T>::type;
+  if constexpr (!std::is_void_v<bit_sliced_type>) {
+    if (caf::get_or(opts, "arithmetic-index", std::string{"range"})
+        == "bit-sliced")
+      return std::make_unique<bit_sliced_type>(std::move(x), std::move(opts));
+  }
   return std::make_unique<T>(std::move(x), std::move(opts));
 }
 
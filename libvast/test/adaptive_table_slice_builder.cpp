@@ -1060,3 +1060,41 @@ TEST(Fixed fields builder remove record type row) {
                 }},
               }));
 }
+
+TEST(shape cache serves rows with recently seen fields) {
+  adaptive_table_slice_builder sut;
+  const auto add_row = [&](std::vector<std::string_view> fields) {
+    auto row = sut.push_row();
+    for (auto i = size_t{0}; i < fields.size(); ++i)
+      row.push_field(fields[i]).add(static_cast<int64_t>(i));
+  };
+  add_row({"a", "b", "c"});
+  add_row({"a", "b", "c"});
+  add_row({"c", "b", "a"});
+  add_row({"a", "b", "c"});
+  add_row({"c", "b", "a"});
+  add_row({"a", "b"});
+  add_row({"a", "b", "d"});
+  const auto metrics = sut.shape_cache_metrics();
+  CHECK_EQUAL(metrics.hits, 4u);
+  CHECK_EQUAL(metrics.misses, 3u);
+  const auto before = adaptive_table_slice_builder::total_shape_cache_metrics();
+  auto out = sut.finish();
+  const auto after = adaptive_table_slice_builder::total_shape_cache_metrics();
+  CHECK_EQUAL(after.hits - before.hits, 4u);
+  CHECK_EQUAL(after.misses - before.misses, 3u);
+  REQUIRE_EQUAL(out.rows(), 7u);
+  REQUIRE_EQUAL(out.columns(), 4u);
+  const auto expected = std::vector<std::vector<data>>{
+    {int64_t{0}, int64_t{1}, int64_t{2}, caf::none},
+    {int64_t{0}, int64_t{1}, int64_t{2}, caf::none},
+    {int64_t{2}, int64_t{1}, int64_t{0}, caf::none},
+    {int64_t{0}, int64_t{1}, int64_t{2}, caf::none},
+    {int64_t{2}, int64_t{1}, int64_t{0}, caf::none},
+    {int64_t{0}, int64_t{1}, caf::none, caf::none},
+    {int64_t{0}, int64_t{1}, caf::none, int64_t{2}},
+  };
+  for (auto row = size_t{0}; row < out.rows(); ++row)
+    for (auto column = size_t{0}; column < out.columns(); ++column)
+      CHECK_EQUAL(materialize(out.at(row, column)), expected[row][column]);
+}
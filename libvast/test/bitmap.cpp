@@ -15,6 +15,7 @@
 #include "vast/flatbuffer.hpp"
 #include "vast/ids.hpp"
 #include "vast/null_bitmap.hpp"
+#include "vast/roaring_bitmap.hpp"
 #include "vast/test/test.hpp"
 
 #include <caf/test/dsl.hpp>
@@ -486,6 +487,14 @@ TEST(wah_bitmap) {
 
 FIXTURE_SCOPE_END()
 
+FIXTURE_SCOPE(roaring_bitmap_tests, bitmap_test_harness<roaring_bitmap>)
+
+TEST(roaring_bitmap) {
+  execute();
+}
+
+FIXTURE_SCOPE_END()
+
 FIXTURE_SCOPE(bitmap_tests, bitmap_test_harness<bitmap>)
 
 TEST(bitmap) {
@@ -913,3 +922,58 @@ TEST(EWAH RLE print 2) {
   // CHECK_EQUAL(str, "1F1T421F2T");
   CHECK_EQUAL(str, "1F1T62F320F39F2T");
 }
+
+TEST(Roaring containers) {
+  MESSAGE("sparse bits across chunks");
+  roaring_bitmap sparse;
+  ewah_bitmap expected;
+  for (auto i = 0u; i < 5; ++i) {
+    sparse.append_bits(false, 100'000);
+    sparse.append_bit(true);
+    expected.append_bits(false, 100'000);
+    expected.append_bit(true);
+  }
+  CHECK_EQUAL(rank(sparse), 5u);
+  CHECK_EQUAL(bitmap{sparse}, bitmap{expected});
+  CHECK(sparse[100'000]);
+  CHECK(!sparse[100'001]);
+  MESSAGE("dense bits turn into runs and back");
+  roaring_bitmap dense;
+  dense.append_bits(true, 200'000);
+  dense.append_bits(false, 10);
+  CHECK_EQUAL(rank(dense), 200'000u);
+  auto flipped = ~dense;
+  CHECK_EQUAL(rank(flipped), 10u);
+  CHECK_EQUAL(rank(~flipped), 200'000u);
+  MESSAGE("bitwise operations between chunks");
+  CHECK_EQUAL(rank(sparse & dense), 1u);
+  CHECK_EQUAL(rank(sparse | dense), 200'004u);
+  MESSAGE("mixed encodings");
+  auto mixed = bitmap{sparse} & bitmap{expected};
+  CHECK(caf::holds_alternative<roaring_bitmap>(mixed));
+  CHECK_EQUAL(rank(mixed), 5u);
+}
+
+TEST(bitmap equality across encodings) {
+  auto ewah = ewah_bitmap{};
+  auto roaring = roaring_bitmap{};
+  ewah.append_bits(true, 10);
+  ewah.append_bits(false, 70'000);
+  ewah.append_bit(true);
+  roaring.append_bits(true, 10);
+  roaring.append_bits(false, 70'000);
+  roaring.append_bit(true);
+  CHECK_EQUAL(bitmap{ewah}, bitmap{roaring});
+  CHECK_EQUAL(bitmap{roaring}, bitmap{ewah});
+  MESSAGE("different sizes");
+  auto longer = roaring;
+  longer.append_bit(false);
+  CHECK_NOT_EQUAL(bitmap{ewah}, bitmap{longer});
+  MESSAGE("different bits");
+  auto other = ewah_bitmap{};
+  other.append_bits(true, 9);
+  other.append_bits(false, 70'002);
+  CHECK_NOT_EQUAL(bitmap{other}, bitmap{roaring});
+  MESSAGE("all zeros");
+  CHECK_EQUAL(bitmap{ewah_bitmap{5, false}}, bitmap{null_bitmap{5, false}});
+}
@@ -0,0 +1,55 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/detail/delimiter_scanner.hpp"
+
+#include "vast/detail/string.hpp"
+#include "vast/test/test.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace std::string_view_literals;
+using namespace vast::detail;
+
+TEST(mask of a partial block) {
+  auto scanner = delimiter_scanner{'\t', '\n'};
+  auto str = "a\tb\nc"sv;
+  CHECK_EQUAL(scanner.mask(str.data(), str.size()), uint64_t{0b01010});
+  CHECK_EQUAL(scanner.mask(str.data(), 0), uint64_t{0});
+}
+
+TEST(cursor finds delimiters across blocks) {
+  auto str = std::string(200, 'x');
+  auto expected = std::vector<size_t>{0, 1, 63, 64, 65, 127, 128, 199};
+  for (auto pos : expected)
+    str[pos] = pos % 2 == 0 ? '\r' : '\n';
+  auto scanner = delimiter_scanner{'\n', '\r'};
+  auto cursor = delimiter_cursor{scanner, str};
+  auto positions = std::vector<size_t>{};
+  for (auto pos = cursor.next(); pos != delimiter_cursor::npos;
+       pos = cursor.next())
+    positions.push_back(pos);
+  CHECK_EQUAL(positions, expected);
+}
+
+TEST(split matches detail::split) {
+  auto scanner = delimiter_scanner{'\t'};
+  auto result = std::vector<std::string_view>{};
+  for (auto str : {""sv, "a"sv, "\t"sv, "a\tb"sv, "a\t\tb\t"sv, "\ta\t"sv}) {
+    scanner.split(str, result);
+    CHECK_EQUAL(result, split(str, "\t"));
+  }
+  auto line = std::string{};
+  for (auto i = 0; i < 100; ++i)
+    line += std::to_string(i) + '\t';
+  scanner.split(line, result);
+  REQUIRE_EQUAL(result.size(), 100u);
+  CHECK_EQUAL(result[42], "42"sv);
+  CHECK_EQUAL(result, split(line, "\t"));
+}
@@ -0,0 +1,83 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/detail/mpmc_queue.hpp"
+
+#include "vast/test/test.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace vast;
+
+TEST(capacity) {
+  auto queue = detail::mpmc_queue<int>{5};
+  CHECK_EQUAL(queue.capacity(), 8u);
+  for (auto i = 0; i < 8; ++i)
+    CHECK(queue.try_push(int{i}));
+  CHECK(!queue.try_push(8));
+  CHECK_EQUAL(queue.size(), 8u);
+  auto x = -1;
+  for (auto i = 0; i < 8; ++i) {
+    REQUIRE(queue.try_pop(x));
+    CHECK_EQUAL(x, i);
+  }
+  CHECK(!queue.try_pop(x));
+  CHECK_EQUAL(queue.size(), 0u);
+}
+
+TEST(wrap around) {
+  auto queue = detail::mpmc_queue<std::vector<int>>{2};
+  auto x = std::vector<int>{};
+  for (auto i = 0; i < 10; ++i) {
+    CHECK(queue.try_push(std::vector<int>{i, i}));
+    REQUIRE(queue.try_pop(x));
+    CHECK_EQUAL(x, (std::vector<int>{i, i}));
+  }
+  // A failed push leaves the element untouched.
+  auto y = std::vector<int>{42};
+  CHECK(queue.try_push(std::vector<int>{1}));
+  CHECK(queue.try_push(std::vector<int>{2}));
+  CHECK(!queue.try_push(std::move(y)));
+  CHECK_EQUAL(y, std::vector<int>{42});
+}
+
+TEST(multiple producers and consumers) {
+  constexpr auto num_threads = 4;
+  constexpr auto num_elements = int64_t{10'000};
+  auto queue = detail::mpmc_queue<int64_t>{16};
+  auto producers_done = std::atomic<int>{0};
+  auto sum = std::atomic<int64_t>{0};
+  auto threads = std::vector<std::thread>{};
+  for (auto i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&] {
+      for (auto x = int64_t{1}; x <= num_elements; ++x)
+        while (!queue.try_push(int64_t{x}))
+          std::this_thread::yield();
+      ++producers_done;
+    });
+    threads.emplace_back([&] {
+      auto x = int64_t{0};
+      while (true) {
+        if (queue.try_pop(x))
+          sum += x;
+        else if (producers_done < num_threads)
+          std::this_thread::yield();
+        else if (queue.try_pop(x))
+          sum += x;
+        else
+          break;
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  CHECK_EQUAL(sum.load(), num_threads * num_elements * (num_elements + 1) / 2);
+}
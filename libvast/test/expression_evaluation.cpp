@@ -9,16 +9,20 @@
 #include "vast/concept/parseable/to.hpp"
 #include "vast/concept/parseable/vast/expression.hpp"
 #include "vast/concept/parseable/vast/time.hpp"
+#include "vast/detail/narrow.hpp"
 #include "vast/expression.hpp"
 #include "vast/expression_visitors.hpp"
 #include "vast/ids.hpp"
 #include "vast/module.hpp"
 #include "vast/table_slice.hpp"
+#include "vast/table_slice_builder.hpp"
 #include "vast/test/fixtures/events.hpp"
 #include "vast/test/test.hpp"
 
 #include <caf/test/dsl.hpp>
 
+#include <array>
+
 using namespace vast;
 
 namespace {
@@ -86,6 +90,97 @@ TEST(evaluation - field extractor - service + orig_h) {
   REQUIRE_EQUAL(rank(ids), 2u);
 }
 
+TEST(evaluation - field extractor - service != null) {
+  auto expr = make_conn_expr("service != null");
+  auto ids = evaluate(expr, zeek_conn_log_slice, {});
+  auto expected = size_t{0};
+  for (size_t row = 0; row < zeek_conn_log_slice.rows(); ++row)
+    if (!caf::holds_alternative<caf::none_t>(zeek_conn_log_slice.at(row, 7)))
+      ++expected;
+  CHECK_EQUAL(rank(ids), expected);
+  CHECK_EQUAL(rank(evaluate(make_conn_expr("service == null"),
+                            zeek_conn_log_slice, {})),
+              zeek_conn_log_slice.rows() - expected);
+}
+
+TEST(evaluation - type extractor - count with offset and hints) {
+  // Shift the slice so that its rows do not start at a block boundary, and
+  // restrict the evaluation to a range that crosses a block boundary.
+  auto slice = zeek_conn_log_slice;
+  slice.offset(1003);
+  auto expr = make_conn_expr(":uint64 == 350");
+  auto all_ids = evaluate(expr, slice, {});
+  CHECK_EQUAL(all_ids.size(), 1003 + slice.rows());
+  CHECK_EQUAL(rank(all_ids), 18u);
+  CHECK_GREATER_EQUAL(select(all_ids, 1), 1003u);
+  auto hints = make_ids({{1003 + 50, 1003 + 80}}, 1003 + slice.rows());
+  auto hinted_ids = evaluate(expr, slice, hints);
+  CHECK_EQUAL(hinted_ids, all_ids & hints);
+}
+
+TEST(evaluation - field extractor - string operators) {
+  // Compare the blockwise string kernel against the cell semantics.
+  auto count = [&](auto&& f) {
+    auto result = size_t{0};
+    for (size_t row = 0; row < zeek_conn_log_slice.rows(); ++row)
+      if (const auto* service = caf::get_if<std::string_view>(
+            &zeek_conn_log_slice.at(row, 7));
+          service && f(*service))
+        ++result;
+    return result;
+  };
+  auto check = [&](std::string_view expr, auto&& f) {
+    MESSAGE(expr);
+    CHECK_EQUAL(rank(evaluate(make_conn_expr(expr), zeek_conn_log_slice, {})),
+                count(f));
+  };
+  check(R"__(service < "http")__", [](std::string_view x) {
+    return x < "http";
+  });
+  check(R"__(service >= "http")__", [](std::string_view x) {
+    return x >= "http";
+  });
+  check(R"__(service in "dns,http")__", [](std::string_view x) {
+    return std::string_view{"dns,http"}.find(x) != std::string_view::npos;
+  });
+  check(R"__(service ni "s")__", [](std::string_view x) {
+    return x.find('s') != std::string_view::npos;
+  });
+  check(R"__(service !ni "s")__", [](std::string_view x) {
+    return x.find('s') == std::string_view::npos;
+  });
+}
+
+TEST(evaluation - field extractor - enumeration) {
+  const auto schema = type{
+    "enums",
+    record_type{
+      {"e", enumeration_type{{"a"}, {"b"}, {"c"}}},
+    },
+  };
+  auto builder = table_slice_builder{schema};
+  for (auto i = 0; i < 200; ++i) {
+    if (i % 7 == 0)
+      REQUIRE(builder.add(caf::none));
+    else
+      REQUIRE(builder.add(detail::narrow_cast<enumeration>(i % 3)));
+  }
+  auto slice = builder.finish();
+  slice.offset(0);
+  auto eval = [&](std::string_view str) {
+    auto expr = unbox(tailor(make_expr(str), slice.schema()));
+    return rank(evaluate(expr, slice, {}));
+  };
+  auto expected = std::array<size_t, 3>{};
+  for (auto i = 0; i < 200; ++i)
+    if (i % 7 != 0)
+      ++expected[i % 3];
+  CHECK_EQUAL(eval(R"__(e == "b")__"), expected[1]);
+  CHECK_EQUAL(eval(R"__(e != "b")__"), expected[0] + expected[2]);
+  CHECK_EQUAL(eval(R"__(e == "d")__"), 0u);
+  CHECK_EQUAL(eval("e == null"), 29u);
+}
+
 TEST(evaluation - empty expression) {
   auto expr = expression{};
   auto ids = evaluate(expr, zeek_conn_log_slice, {});
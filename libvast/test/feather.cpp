@@ -26,6 +26,7 @@
 #include <vast/test/test.hpp>
 
 #include <chrono>
+#include <limits>
 
 namespace vast::plugins::feather {
 
@@ -370,6 +371,64 @@ TEST(passive feather store selective query) {
   compare_table_slices(*expected_slice, results[0]);
 }
 
+TEST(passive feather store selective query across batches) {
+  const auto schema = record_type{{"x", int64_type{}}};
+  auto slices = std::vector<table_slice>{
+    make_slice(schema, std::vector<int64_t>{1, 2}),
+    make_slice(schema, std::vector<int64_t>{10, 11}),
+    make_slice(schema, std::vector<int64_t>{20, 21}),
+  };
+  const auto* plugin = vast::plugins::find<vast::store_actor_plugin>("feather");
+  REQUIRE(plugin);
+  auto builder_and_header
+    = plugin->make_store_builder(accountant, filesystem, vast::uuid::random());
+  REQUIRE_NOERROR(builder_and_header);
+  auto& [builder, header] = *builder_and_header;
+  vast::detail::spawn_container_source(sys, slices, builder);
+  run();
+  auto store = plugin->make_store(accountant, filesystem, as_bytes(header));
+  REQUIRE_NOERROR(store);
+  run();
+  // The first batch is excluded by the selection, and the last batch by the
+  // value range of its column.
+  auto expr = to<expression>("x >= 10 && x < 20");
+  REQUIRE_NOERROR(expr);
+  auto results = query(*store, make_ids({id_range(1, 6)}), *expr);
+  run();
+  REQUIRE_EQUAL(results.size(), 1ull);
+  CHECK_EQUAL(results[0].rows(), 2ull);
+  CHECK_EQUAL(materialize(results[0].at(0, 0)), data{int64_t{10}});
+}
+
+TEST(passive feather store selective query with leading NaN) {
+  const auto schema = record_type{{"x", double_type{}}};
+  const auto nan = std::numeric_limits<double>::quiet_NaN();
+  auto slices = std::vector<table_slice>{
+    make_slice(schema, std::vector<double>{nan, 5.0}),
+    make_slice(schema, std::vector<double>{1.0, 2.0}),
+  };
+  const auto* plugin = vast::plugins::find<vast::store_actor_plugin>("feather");
+  REQUIRE(plugin);
+  auto builder_and_header
+    = plugin->make_store_builder(accountant, filesystem, vast::uuid::random());
+  REQUIRE_NOERROR(builder_and_header);
+  auto& [builder, header] = *builder_and_header;
+  vast::detail::spawn_container_source(sys, slices, builder);
+  run();
+  auto store = plugin->make_store(accountant, filesystem, as_bytes(header));
+  REQUIRE_NOERROR(store);
+  run();
+  // The NaN must not hide the value 5.0 from the statistics of the first
+  // batch, while the second batch is still excluded by its value range.
+  auto expr = to<expression>("x > 4.0");
+  REQUIRE_NOERROR(expr);
+  auto results = query(*store, make_ids({id_range(0, 4)}), *expr);
+  run();
+  REQUIRE_EQUAL(results.size(), 1ull);
+  CHECK_EQUAL(results[0].rows(), 1ull);
+  CHECK_EQUAL(materialize(results[0].at(0, 0)), data{5.0});
+}
+
 TEST(passive feather store erase) {
   auto f = table_slice_fixture();
   auto slice = f.slice;
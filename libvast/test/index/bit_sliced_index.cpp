@@ -0,0 +1,186 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/index/bit_sliced_index.hpp"
+
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/bitmap.hpp"
+#include "vast/fbs/value_index.hpp"
+#include "vast/flatbuffer.hpp"
+#include "vast/test/test.hpp"
+#include "vast/value_index_factory.hpp"
+
+#include <caf/test/dsl.hpp>
+
+#include <limits>
+
+using namespace vast;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    factory<value_index>::initialize();
+    caf::put(opts, "arithmetic-index", "bit-sliced");
+  }
+
+  template <class Index>
+  static std::string
+  lookup(const Index& idx, relational_operator op, data_view x) {
+    return to_string(unbox(idx.lookup(op, x)));
+  }
+
+  caf::settings opts;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(bit_sliced_index_tests, fixture)
+
+TEST(factory construction) {
+  auto idx = factory<value_index>::make(type{int64_type{}}, opts);
+  CHECK(dynamic_cast<bit_sliced_index<int64_t>*>(idx.get()) != nullptr);
+  idx = factory<value_index>::make(type{time_type{}}, opts);
+  CHECK(dynamic_cast<bit_sliced_index<vast::time>*>(idx.get()) != nullptr);
+  idx = factory<value_index>::make(type{int64_type{}}, {});
+  CHECK(dynamic_cast<bit_sliced_index<int64_t>*>(idx.get()) == nullptr);
+}
+
+TEST(signed integers) {
+  constexpr auto min = std::numeric_limits<int64_t>::min();
+  constexpr auto max = std::numeric_limits<int64_t>::max();
+  auto idx = bit_sliced_index<int64_t>{type{int64_type{}}};
+  REQUIRE(idx.append(make_data_view(int64_t{-7})));
+  REQUIRE(idx.append(make_data_view(int64_t{42})));
+  REQUIRE(idx.append(make_data_view(caf::none)));
+  REQUIRE(idx.append(make_data_view(int64_t{0})));
+  REQUIRE(idx.append(make_data_view(int64_t{-7})));
+  REQUIRE(idx.append(make_data_view(min)));
+  REQUIRE(idx.append(make_data_view(max)));
+  const auto minus_seven = make_data_view(int64_t{-7});
+  const auto zero = make_data_view(int64_t{0});
+  CHECK_EQUAL(lookup(idx, relational_operator::equal, minus_seven), "1000100");
+  CHECK_EQUAL(lookup(idx, relational_operator::not_equal, minus_seven),
+              "0111011");
+  CHECK_EQUAL(lookup(idx, relational_operator::less, zero), "1000110");
+  CHECK_EQUAL(lookup(idx, relational_operator::less_equal, zero), "1001110");
+  CHECK_EQUAL(lookup(idx, relational_operator::greater, zero), "0100001");
+  CHECK_EQUAL(lookup(idx, relational_operator::greater_equal, minus_seven),
+              "1101101");
+  CHECK_EQUAL(lookup(idx, relational_operator::equal, make_data_view(max)),
+              "0000001");
+  CHECK_EQUAL(lookup(idx, relational_operator::less, make_data_view(min)),
+              "0000000");
+  auto err = idx.lookup(relational_operator::in, zero);
+  CHECK(!err);
+}
+
+TEST(reals) {
+  constexpr auto inf = std::numeric_limits<double>::infinity();
+  auto idx = bit_sliced_index<double>{type{double_type{}}};
+  REQUIRE(idx.append(make_data_view(-1.5)));
+  REQUIRE(idx.append(make_data_view(-0.0)));
+  REQUIRE(idx.append(make_data_view(0.0)));
+  REQUIRE(idx.append(make_data_view(2.5)));
+  REQUIRE(idx.append(make_data_view(-inf)));
+  REQUIRE(idx.append(make_data_view(1e300)));
+  CHECK_EQUAL(lookup(idx, relational_operator::equal, make_data_view(0.0)),
+              "011000");
+  CHECK_EQUAL(lookup(idx, relational_operator::less, make_data_view(0.0)),
+              "100010");
+  CHECK_EQUAL(lookup(idx, relational_operator::greater, make_data_view(-1.5)),
+              "011101");
+  CHECK_EQUAL(
+    lookup(idx, relational_operator::less_equal, make_data_view(-inf)),
+    "000010");
+  const auto all = make_ids({{0, 6}});
+  CHECK_EQUAL(unbox(idx.min(all)), -inf);
+  CHECK_EQUAL(unbox(idx.max(all)), 1e300);
+  CHECK_EQUAL(unbox(idx.min(make_ids({{1, 4}}))), 0.0);
+}
+
+TEST(aggregates) {
+  auto idx = bit_sliced_index<int64_t>{type{int64_type{}}};
+  REQUIRE(idx.append(make_data_view(int64_t{-7})));
+  REQUIRE(idx.append(make_data_view(int64_t{42})));
+  REQUIRE(idx.append(make_data_view(caf::none)));
+  REQUIRE(idx.append(make_data_view(int64_t{0})));
+  REQUIRE(idx.append(make_data_view(int64_t{-7})));
+  REQUIRE(idx.append(make_data_view(std::numeric_limits<int64_t>::min())));
+  REQUIRE(idx.append(make_data_view(std::numeric_limits<int64_t>::max())));
+  // Null values do not contribute to aggregates, even if selected.
+  const auto all = make_ids({{0, 7}});
+  CHECK_EQUAL(unbox(idx.sum(all)), int64_t{27});
+  CHECK_EQUAL(unbox(idx.min(all)), std::numeric_limits<int64_t>::min());
+  CHECK_EQUAL(unbox(idx.max(all)), std::numeric_limits<int64_t>::max());
+  CHECK_EQUAL(unbox(idx.sum(make_ids({{0, 5}}))), int64_t{28});
+  const auto hits
+    = unbox(idx.lookup(relational_operator::less, make_data_view(int64_t{1})));
+  CHECK_EQUAL(unbox(idx.max(hits)), int64_t{0});
+  CHECK(!idx.sum(hits));
+  CHECK_EQUAL(unbox(idx.sum(make_ids({{2, 3}}))), int64_t{0});
+  CHECK(!idx.min(make_ids({{2, 3}})));
+  auto unsigned_idx = bit_sliced_index<uint64_t>{type{uint64_type{}}};
+  REQUIRE(unsigned_idx.append(make_data_view(uint64_t{1} << 63)));
+  REQUIRE(unsigned_idx.append(make_data_view(uint64_t{1} << 62)));
+  REQUIRE(unsigned_idx.append(make_data_view(uint64_t{1} << 63)));
+  CHECK_EQUAL(unbox(unsigned_idx.sum(make_ids({{0, 2}}))),
+              (uint64_t{1} << 63) + (uint64_t{1} << 62));
+  CHECK(!unsigned_idx.sum(make_ids({{0, 3}})));
+}
+
+TEST(timestamps) {
+  const auto epoch = vast::time{} + 1'700'000'000s;
+  auto idx = bit_sliced_index<vast::time>{type{time_type{}}};
+  for (auto i = 0; i < 1000; ++i)
+    REQUIRE(idx.append(make_data_view(epoch + i * 1ms)));
+  const auto x = make_data_view(epoch + 990ms);
+  CHECK_EQUAL(rank(unbox(idx.lookup(relational_operator::greater_equal, x))),
+              10u);
+  CHECK_EQUAL(rank(unbox(idx.lookup(relational_operator::less, x))), 990u);
+  const auto hits = unbox(idx.lookup(relational_operator::less, x));
+  CHECK_EQUAL(unbox(idx.min(hits)), epoch);
+  CHECK_EQUAL(unbox(idx.max(hits)), epoch + 989ms);
+}
+
+TEST(serialization) {
+  const auto epoch = vast::time{} + 1'700'000'000s;
+  auto idx = factory<value_index>::make(type{time_type{}}, opts);
+  REQUIRE_NOT_EQUAL(idx, nullptr);
+  for (auto i = 0; i < 100; ++i)
+    REQUIRE(idx->append(make_data_view(epoch + i * 1s)));
+  REQUIRE(idx->append(make_data_view(caf::none)));
+  auto builder = flatbuffers::FlatBufferBuilder{};
+  const auto idx_offset = pack(builder, idx);
+  builder.Finish(idx_offset);
+  auto fb = unbox(flatbuffer<fbs::ValueIndex>::make(builder.Release()));
+  REQUIRE(fb);
+  auto idx2 = value_index_ptr{};
+  REQUIRE_EQUAL(unpack(*fb, idx2), caf::none);
+  const auto* bit_sliced
+    = dynamic_cast<bit_sliced_index<vast::time>*>(idx2.get());
+  REQUIRE(bit_sliced != nullptr);
+  CHECK_EQUAL(idx->options(), idx2->options());
+  const auto x = make_data_view(epoch + 42s);
+  for (auto op : {relational_operator::equal, relational_operator::less,
+                  relational_operator::greater_equal})
+    CHECK_EQUAL(lookup(*idx2, op, x), lookup(*idx, op, x));
+  const auto all = make_ids({{0, 101}});
+  CHECK_EQUAL(unbox(bit_sliced->min(all)), epoch);
+  CHECK_EQUAL(unbox(bit_sliced->max(all)), epoch + 99s);
+  // Appending after unpacking restores the slices that were stored as a
+  // single bit.
+  REQUIRE(idx2->append(make_data_view(epoch - 1s)));
+  CHECK_EQUAL(unbox(bit_sliced->min(make_ids({{0, 102}}))), epoch - 1s);
+  CHECK_EQUAL(rank(unbox(idx2->lookup(relational_operator::less,
+                                      make_data_view(epoch)))),
+              1u);
+}
+
+FIXTURE_SCOPE_END()
@@ -0,0 +1,118 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/index/trigram_index.hpp"
+
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/bitmap.hpp"
+#include "vast/fbs/value_index.hpp"
+#include "vast/flatbuffer.hpp"
+#include "vast/pattern.hpp"
+#include "vast/test/test.hpp"
+#include "vast/value_index_factory.hpp"
+
+#include <caf/test/dsl.hpp>
+
+using namespace vast;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    factory<value_index>::initialize();
+    caf::put(opts, "string-index", "trigram");
+    idx = factory<value_index>::make(type{string_type{}}, opts);
+    REQUIRE_NOT_EQUAL(idx, nullptr);
+    REQUIRE(idx->append(make_data_view("http://evil.com/payload.exe")));
+    REQUIRE(idx->append(make_data_view("http://example.com/index.html")));
+    REQUIRE(idx->append(make_data_view(caf::none)));
+    REQUIRE(idx->append(make_data_view("HTTP://EVIL.COM/a.EXE")));
+    REQUIRE(idx->append(make_data_view("ab")));
+    REQUIRE(idx->append(make_data_view("https://example.org/evil")));
+    REQUIRE(idx->append(make_data_view("http://example.com/index.html")));
+    REQUIRE(idx->append(make_data_view("curl.exe")));
+  }
+
+  std::string lookup(relational_operator op, data_view x) {
+    return to_string(unbox(idx->lookup(op, x)));
+  }
+
+  std::string lookup(std::string regex) {
+    auto x = unbox(pattern::make(std::move(regex)));
+    return lookup(relational_operator::equal, make_data_view(x));
+  }
+
+  caf::settings opts;
+  value_index_ptr idx;
+};
+
+} // namespace
+
+FIXTURE_SCOPE(trigram_index_tests, fixture)
+
+TEST(factory construction) {
+  CHECK(dynamic_cast<trigram_index*>(idx.get()) != nullptr);
+  auto bitslice = factory<value_index>::make(type{string_type{}}, {});
+  CHECK(dynamic_cast<trigram_index*>(bitslice.get()) == nullptr);
+}
+
+TEST(equality) {
+  const auto url = make_data_view("http://example.com/index.html");
+  CHECK_EQUAL(lookup(relational_operator::equal, url), "01000010");
+  CHECK_EQUAL(lookup(relational_operator::not_equal, url), "10111101");
+  CHECK_EQUAL(lookup(relational_operator::equal, make_data_view("ab")),
+              "00001000");
+  CHECK_EQUAL(lookup(relational_operator::equal, make_data_view(caf::none)),
+              "00100000");
+}
+
+TEST(substring) {
+  // The index folds case, so the candidates include upper-case matches that
+  // the store filters out afterwards.
+  CHECK_EQUAL(lookup(relational_operator::ni, make_data_view("evil")),
+              "10010100");
+  CHECK_EQUAL(lookup(relational_operator::ni, make_data_view("example.com")),
+              "01000010");
+  CHECK_EQUAL(lookup(relational_operator::ni, make_data_view("nothere")),
+              "00000000");
+  // Needles shorter than a trigram and negations cannot rule out any rows.
+  CHECK_EQUAL(lookup(relational_operator::ni, make_data_view("ab")),
+              "11011111");
+  CHECK_EQUAL(lookup(relational_operator::not_ni, make_data_view("evil")),
+              "11011111");
+}
+
+TEST(pattern) {
+  CHECK_EQUAL(lookup(".*evil.*\\.exe"), "10010000");
+  CHECK_EQUAL(lookup(".*(curl|wget).*"), "00000001");
+  CHECK_EQUAL(lookup(".*(evil|curl).*"), "10010101");
+  CHECK_EQUAL(lookup(".*nothere.*"), "00000000");
+  // Without literal substrings, the pattern may match any row.
+  CHECK_EQUAL(lookup("a.*"), "11011111");
+}
+
+TEST(serialization) {
+  auto builder = flatbuffers::FlatBufferBuilder{};
+  const auto idx_offset = pack(builder, idx);
+  builder.Finish(idx_offset);
+  auto fb = unbox(flatbuffer<fbs::ValueIndex>::make(builder.Release()));
+  REQUIRE(fb);
+  auto idx2 = value_index_ptr{};
+  REQUIRE_EQUAL(unpack(*fb, idx2), caf::none);
+  CHECK(dynamic_cast<trigram_index*>(idx2.get()) != nullptr);
+  CHECK_EQUAL(idx->options(), idx2->options());
+  idx = std::move(idx2);
+  CHECK_EQUAL(lookup(relational_operator::ni, make_data_view("evil")),
+              "10010100");
+  CHECK_EQUAL(lookup(relational_operator::equal,
+                     make_data_view("http://example.com/index.html")),
+              "01000010");
+  CHECK_EQUAL(lookup(".*evil.*\\.exe"), "10010000");
+}
+
+FIXTURE_SCOPE_END()
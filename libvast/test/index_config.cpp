@@ -28,6 +28,16 @@ rules:
   - targets:
       - zeek.conn.id.orig_h
     partition-index: false
+  - targets:
+      - zeek.conn.uid
+    bitmap: roaring
+  - targets:
+      - zeek.http.uri
+    string-index: trigram
+  - targets:
+      - zeek.conn.ts
+    arithmetic-index: bit-sliced
+synchronous-evaluation: true
 )__";
 
 const vast::type schema{
@@ -44,7 +54,8 @@ TEST(example configuration) {
   const auto yaml = unbox(from_yaml(example_index_config));
   index_config config;
   REQUIRE_EQUAL(convert(yaml, config), caf::none);
-  REQUIRE_EQUAL(config.rules.size(), 2u);
+  REQUIRE_EQUAL(config.rules.size(), 5u);
+  CHECK(config.synchronous_evaluation);
   const auto& rule0 = config.rules[0];
   REQUIRE_EQUAL(rule0.targets.size(), 2u);
   CHECK_EQUAL(rule0.targets[0], "suricata.dns.dns.rrname");
@@ -55,6 +66,24 @@ TEST(example configuration) {
   CHECK_EQUAL(rule1.fp_rate, 0.01); // default
   CHECK_EQUAL(rule0.create_partition_index, true); // default
   CHECK_EQUAL(rule1.create_partition_index, false);
+  CHECK_EQUAL(rule1.bitmap, "ewah"); // default
+  const auto& rule2 = config.rules[2];
+  CHECK_EQUAL(rule2.bitmap, "roaring");
+  CHECK_EQUAL(rule2.string_index, "bitslice"); // default
+  const auto& rule3 = config.rules[3];
+  CHECK_EQUAL(rule3.string_index, "trigram");
+  CHECK_EQUAL(rule3.arithmetic_index, "range"); // default
+  const auto& rule4 = config.rules[4];
+  CHECK_EQUAL(rule4.arithmetic_index, "bit-sliced");
+  CHECK_EQUAL(validate(config), caf::none);
+  config.rules[3].string_index = "ngram";
+  CHECK_NOT_EQUAL(validate(config), caf::none);
+  config.rules[3].string_index = "trigram";
+  config.rules[4].arithmetic_index = "bitmap";
+  CHECK_NOT_EQUAL(validate(config), caf::none);
+  config.rules[4].arithmetic_index = "bit-sliced";
+  config.rules[2].bitmap = "bitset";
+  CHECK_NOT_EQUAL(validate(config), caf::none);
 }
 
 TEST(should_create_partition_index will return true for empty rules)
@@ -102,3 +131,36 @@ TEST(should_create_partition_index will will use create_partition_index from
   CHECK_EQUAL(should_create_partition_index(in_y, rules_x), true);
   CHECK_EQUAL(should_create_partition_index(in_y, rules_y), true);
 }
+
+TEST(index_bitmap_encoding uses the first matching rule) {
+  qualified_record_field in_x{schema, {0u}};
+  qualified_record_field in_y{schema, {1u}};
+  auto rules = std::vector{
+    index_config::rule{.targets = {"y.x"}, .bitmap = "roaring"},
+  };
+  CHECK_EQUAL(index_bitmap_encoding(in_x, {}), "ewah");
+  CHECK_EQUAL(index_bitmap_encoding(in_x, rules), "roaring");
+  CHECK_EQUAL(index_bitmap_encoding(in_y, rules), "ewah");
+}
+
+TEST(index_string_kind uses the first matching rule) {
+  qualified_record_field in_x{schema, {0u}};
+  qualified_record_field in_y{schema, {1u}};
+  auto rules = std::vector{
+    index_config::rule{.targets = {"y.x"}, .string_index = "trigram"},
+  };
+  CHECK_EQUAL(index_string_kind(in_x, {}), "bitslice");
+  CHECK_EQUAL(index_string_kind(in_x, rules), "trigram");
+  CHECK_EQUAL(index_string_kind(in_y, rules), "bitslice");
+}
+
+TEST(index_arithmetic_kind uses the first matching rule) {
+  qualified_record_field in_x{schema, {0u}};
+  qualified_record_field in_y{schema, {1u}};
+  auto rules = std::vector{
+    index_config::rule{.targets = {"y.x"}, .arithmetic_index = "bit-sliced"},
+  };
+  CHECK_EQUAL(index_arithmetic_kind(in_x, {}), "range");
+  CHECK_EQUAL(index_arithmetic_kind(in_x, rules), "bit-sliced");
+  CHECK_EQUAL(index_arithmetic_kind(in_y, rules), "range");
+}
@@ -314,6 +314,51 @@ TEST(split results into two slices when input chunks has more events than a
   CHECK_EQUAL(output_slices.front().rows(), defaults::import::table_slice_size);
 }
 
+TEST(split results into slices with a configurable maximum number of rows) {
+  auto in_json = std::string{};
+  for (auto i = 0u; i < 5u; ++i) {
+    in_json.append(R"({"a": 5})");
+  }
+  auto sut = create_sut(make_chunk_generator({in_json}), control_plane_mock,
+                        {"--max-rows=2"});
+  auto output_slices = std::vector<vast::table_slice>{};
+  for (auto slice : sut) {
+    output_slices.push_back(std::move(slice));
+  }
+  REQUIRE_EQUAL(output_slices.size(), 3u);
+  CHECK_EQUAL(output_slices.at(0).rows(), 2u);
+  CHECK_EQUAL(output_slices.at(1).rows(), 2u);
+  CHECK_EQUAL(output_slices.at(2).rows(), 1u);
+}
+
+TEST(parallel parsing preserves the order of events) {
+  // Enough input for multiple blocks, spread across chunks that end in the
+  // middle of a line.
+  constexpr auto events = uint64_t{1'000'000};
+  auto in_json = std::string{};
+  for (auto i = uint64_t{0}; i < events; ++i) {
+    in_json.append(fmt::format("{{\"a\": {}}}\n", i));
+  }
+  auto chunks = std::vector<std::string_view>{};
+  constexpr auto chunk_size = size_t{1'000'003};
+  for (auto i = size_t{0}; i < in_json.size(); i += chunk_size) {
+    chunks.push_back(std::string_view{in_json}.substr(i, chunk_size));
+  }
+  auto sut = create_sut(make_chunk_generator(chunks), control_plane_mock,
+                        {"--threads=4"});
+  auto next = int64_t{0};
+  for (auto slice : sut) {
+    if (slice.rows() == 0)
+      continue;
+    CHECK_LESS_EQUAL(slice.rows(), defaults::import::table_slice_size);
+    for (auto i = 0u; i < slice.rows(); ++i) {
+      REQUIRE_EQUAL(materialize(slice.at(i, 0u)), next);
+      ++next;
+    }
+  }
+  CHECK_EQUAL(next, static_cast<int64_t>(events));
+}
+
 TEST(empty chunk from input generator causes the parser to yield an empty table
        slice) {
   auto gen = []() -> generator<chunk_ptr> {
@@ -175,6 +175,47 @@ TEST(file loader - nonexistent file) {
   REQUIRE_ERROR(loader_plugin->make_loader(args, control_plane));
 }
 
+TEST(file loader - block reads) {
+  loader_plugin = vast::plugins::find<vast::loader_plugin>("file");
+  REQUIRE(loader_plugin);
+  const auto path = std::string{VAST_TEST_PATH
+                                "artifacts/inputs/longer_input.txt"};
+  const auto file_size = std::filesystem::file_size(path);
+  const auto chunk_size = size_t{16384};
+  auto make_chunks = [&](std::vector<std::string> args) {
+    args.push_back(path);
+    return collect(unbox(loader_plugin->make_loader(args, control_plane)));
+  };
+  auto chunks = make_chunks({});
+  REQUIRE_EQUAL(chunks.size(), size_t{1});
+  CHECK_EQUAL(chunks[0]->size(), file_size);
+  for (auto args : {std::vector<std::string>{"--chunk-size", "16KiB"},
+                    std::vector<std::string>{"--chunk-size", "16KiB",
+                                             "--no-cache"},
+                    std::vector<std::string>{"--mmap", "--chunk-size",
+                                             "16KiB"}}) {
+    auto windows = make_chunks(args);
+    REQUIRE_EQUAL(windows.size(), size_t{3});
+    CHECK_EQUAL(windows[0]->size(), chunk_size);
+    CHECK_EQUAL(windows[1]->size(), chunk_size);
+    CHECK_EQUAL(windows[2]->size(), file_size - (chunk_size * 2));
+    CHECK(std::equal(windows[1]->begin(), windows[1]->end(),
+                     chunks[0]->begin() + chunk_size));
+  }
+}
+
+TEST(file loader - invalid block options) {
+  loader_plugin = vast::plugins::find<vast::loader_plugin>("file");
+  REQUIRE(loader_plugin);
+  const auto path = std::string{VAST_TEST_PATH
+                                "artifacts/inputs/longer_input.txt"};
+  for (auto args : {std::vector<std::string>{"--chunk-size", "0", path},
+                    std::vector<std::string>{"--chunk-size", "lots", path},
+                    std::vector<std::string>{"--mmap", "--no-cache", path},
+                    std::vector<std::string>{"--no-cache", "-"}})
+    CHECK_ERROR(loader_plugin->make_loader(args, control_plane));
+}
+
 // TODO: Does not run unter Ubuntu CI unit test step.
 /*
 TEST(file loader - unreadable file) {
@@ -0,0 +1,128 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/operator_queue.hpp"
+
+#include "vast/chunk.hpp"
+#include "vast/test/test.hpp"
+
+#include <string>
+#include <thread>
+
+using namespace vast;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Creates a chunk whose size identifies it.
+chunk_ptr make_chunk(size_t size) {
+  return chunk::make(std::string(size, 'x'));
+}
+
+} // namespace
+
+TEST(order and metrics) {
+  constexpr auto num_chunks = size_t{1'000};
+  auto queue = operator_queue<chunk_ptr>{4};
+  auto producer = std::thread{[&] {
+    for (size_t i = 1; i <= num_chunks; ++i)
+      if (!queue.push(make_chunk(i)))
+        return;
+    queue.close();
+  }};
+  auto expected = size_t{1};
+  auto chunk = chunk_ptr{};
+  while (true) {
+    const auto status = queue.pop(chunk, 1s);
+    if (status == operator_queue_status::closed)
+      break;
+    if (status == operator_queue_status::timeout)
+      continue;
+    REQUIRE(chunk);
+    if (chunk->size() != expected)
+      break;
+    ++expected;
+  }
+  producer.join();
+  CHECK_EQUAL(expected, num_chunks + 1);
+  const auto metrics = queue.metrics();
+  CHECK_EQUAL(metrics.batches, num_chunks);
+  CHECK_GREATER_EQUAL(metrics.total_latency.count(),
+                      metrics.max_latency.count());
+}
+
+TEST(timeout) {
+  auto queue = operator_queue<chunk_ptr>{4};
+  auto chunk = chunk_ptr{};
+  CHECK(queue.pop(chunk, 10ms) == operator_queue_status::timeout);
+  CHECK(queue.push(make_chunk(1)));
+  queue.close();
+  // Closing the queue does not drop batches that are still in the queue.
+  CHECK(queue.pop(chunk, 10ms) == operator_queue_status::ok);
+  CHECK_EQUAL(chunk->size(), 1u);
+  CHECK(queue.pop(chunk, 10ms) == operator_queue_status::closed);
+}
+
+TEST(cancellation unblocks the producer) {
+  auto queue = operator_queue<chunk_ptr>{2};
+  auto pushed = size_t{0};
+  auto producer = std::thread{[&] {
+    while (queue.push(make_chunk(1)))
+      ++pushed;
+  }};
+  auto chunk = chunk_ptr{};
+  CHECK(queue.pop(chunk, 1s) == operator_queue_status::ok);
+  queue.cancel();
+  producer.join();
+  CHECK_GREATER_EQUAL(pushed, 1u);
+}
+
+TEST(sequence numbers) {
+  auto queue = operator_queue<chunk_ptr>{4};
+  CHECK(queue.push(make_chunk(1)));
+  CHECK(queue.push(make_chunk(2), 42));
+  CHECK(queue.push(make_chunk(3)));
+  auto chunk = chunk_ptr{};
+  auto sequence = uint64_t{};
+  CHECK(queue.pop(chunk, sequence, 10ms) == operator_queue_status::ok);
+  CHECK_EQUAL(sequence, 0u);
+  CHECK(queue.pop(chunk, sequence, 10ms) == operator_queue_status::ok);
+  CHECK_EQUAL(sequence, 42u);
+  CHECK(queue.pop(chunk, sequence, 10ms) == operator_queue_status::ok);
+  CHECK_EQUAL(sequence, 1u);
+}
+
+TEST(push with timeout) {
+  auto queue = operator_queue<chunk_ptr>{2};
+  CHECK(queue.push(make_chunk(1)));
+  CHECK(queue.push(make_chunk(2)));
+  auto chunk = make_chunk(3);
+  CHECK(queue.push(chunk, 7, 10ms) == operator_queue_status::timeout);
+  // The batch stays with the caller if the queue does not accept it.
+  REQUIRE(chunk);
+  CHECK_EQUAL(chunk->size(), 3u);
+  queue.cancel();
+  CHECK(queue.push(chunk, 7, 10ms) == operator_queue_status::closed);
+}
+
+TEST(multiple producers and consumers) {
+  auto queue = operator_queue<chunk_ptr>{4, 2, 2};
+  CHECK(queue.push(make_chunk(1)));
+  queue.close();
+  // The queue stays open until the last producer closes it.
+  auto chunk = chunk_ptr{};
+  CHECK(queue.pop(chunk, 10ms) == operator_queue_status::ok);
+  CHECK(queue.pop(chunk, 10ms) == operator_queue_status::timeout);
+  queue.close();
+  CHECK(queue.pop(chunk, 10ms) == operator_queue_status::closed);
+  auto other = operator_queue<chunk_ptr>{2, 1, 2};
+  other.cancel();
+  CHECK(other.push(make_chunk(1)));
+  other.cancel();
+  CHECK(!other.push(make_chunk(1)));
+}
@@ -262,10 +262,16 @@ TEST(full partition roundtrip) {
       FAIL(err);
     });
   self->send_exit(partition, caf::exit_reason::user_shutdown);
+  // Load the partition twice, evaluating queries with INDEXER actors and
+  // synchronously, respectively.
   auto readonly_partition
     = sys.spawn(vast::system::passive_partition, partition_uuid,
-                vast::system::accountant_actor{}, fs, persist_path);
+                vast::system::accountant_actor{}, fs, persist_path, false);
   REQUIRE(readonly_partition);
+  auto synchronous_partition
+    = sys.spawn(vast::system::passive_partition, partition_uuid,
+                vast::system::accountant_actor{}, fs, persist_path, true);
+  REQUIRE(synchronous_partition);
   run();
   // A minimal `partition_client_actor`that stores the results in a local
   // variable.
@@ -277,13 +283,14 @@ TEST(full partition roundtrip) {
       },
     };
   };
-  auto test_expression = [&](const vast::expression& expression,
-                             size_t expected_hits) {
+  auto test_partition = [&](const vast::system::partition_actor& partition,
+                            const vast::expression& expression,
+                            size_t expected_hits) {
     uint64_t tally = 0;
     auto result = std::make_shared<uint64_t>();
     auto dummy = self->spawn(dummy_client, result);
     auto rp = self->request(
-      readonly_partition, caf::infinite, vast::atom::query_v,
+      partition, caf::infinite, vast::atom::query_v,
       vast::query_context::make_count(
         "test", dummy, vast::count_query_context::mode::estimate, expression));
     run();
@@ -302,6 +309,11 @@ TEST(full partition roundtrip) {
     CHECK_EQUAL(tally, expected_hits);
     return true;
   };
+  auto test_expression = [&](const vast::expression& expression,
+                             size_t expected_hits) {
+    return test_partition(readonly_partition, expression, expected_hits)
+           && test_partition(synchronous_partition, expression, expected_hits);
+  };
   auto x_equals_zero = vast::expression{
     vast::predicate{vast::field_extractor{"x"},
                     vast::relational_operator::equal, vast::data{0u}}};
@@ -329,6 +341,7 @@ TEST(full partition roundtrip) {
   test_expression(type_equals_foo, 0);
   // Shut down test actors.
   self->send_exit(readonly_partition, caf::exit_reason::user_shutdown);
+  self->send_exit(synchronous_partition, caf::exit_reason::user_shutdown);
   self->send_exit(fs, caf::exit_reason::user_shutdown);
   run();
 }
@@ -11,6 +11,7 @@
 #include "vast/bloom_filter_synopsis.hpp"
 #include "vast/collect.hpp"
 #include "vast/defaults.hpp"
+#include "vast/table_slice_builder.hpp"
 #include "vast/test/fixtures/events.hpp"
 #include "vast/test/test.hpp"
 
@@ -72,4 +73,38 @@ TEST(custom index_config) {
   CHECK_EQUAL(address_parameters->p, 0.05);
 }
 
+TEST(null fields) {
+  auto schema = vast::type{
+    "test",
+    vast::record_type{
+      {"x", vast::int64_type{}},
+      {"y", vast::int64_type{}},
+    },
+  };
+  auto builder = std::make_shared<vast::table_slice_builder>(schema);
+  REQUIRE(builder->add(int64_t{1}, int64_t{2}));
+  REQUIRE(builder->add(int64_t{3}, caf::none));
+  auto slice = builder->finish();
+  auto ps = vast::partition_synopsis{};
+  ps.add(slice, vast::defaults::system::max_partition_size,
+         vast::index_config{});
+  const auto& schema_rt = caf::get<vast::record_type>(schema);
+  auto x = vast::qualified_record_field{schema, *schema_rt.resolve_key("x")};
+  auto y = vast::qualified_record_field{schema, *schema_rt.resolve_key("y")};
+  CHECK(!ps.may_have_nulls(x));
+  CHECK(ps.may_have_nulls(y));
+  MESSAGE("the null fields survive a roundtrip");
+  flatbuffers::FlatBufferBuilder fbb;
+  auto offset = pack(fbb, ps);
+  REQUIRE_NOERROR(offset);
+  fbb.Finish(*offset);
+  const auto* fbs = flatbuffers::GetRoot<
+    vast::fbs::partition_synopsis::LegacyPartitionSynopsis>(
+    fbb.GetBufferPointer());
+  auto unpacked = vast::partition_synopsis{};
+  REQUIRE_EQUAL(unpack(*fbs, unpacked), caf::none);
+  CHECK(!unpacked.may_have_nulls(x));
+  CHECK(unpacked.may_have_nulls(y));
+}
+
 FIXTURE_SCOPE_END()
@@ -6,14 +6,20 @@
 // SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <vast/aggregation_function.hpp>
 #include <vast/concept/parseable/to.hpp>
 #include <vast/concept/parseable/vast/data.hpp>
 #include <vast/concept/parseable/vast/expression.hpp>
 #include <vast/concept/parseable/vast/pipeline.hpp>
 #include <vast/detail/pp.hpp>
+#include <vast/execution_node.hpp>
+#include <vast/fused_operator.hpp>
+#include <vast/operator_queue.hpp>
+#include <vast/parallel_operator.hpp>
 #include <vast/pipeline.hpp>
 #include <vast/pipeline_executor.hpp>
 #include <vast/plugin.hpp>
+#include <vast/timed_operator.hpp>
 #include <vast/test/fixtures/actor_system.hpp>
 #include <vast/test/fixtures/actor_system_and_events.hpp>
 #include <vast/test/fixtures/events.hpp>
@@ -22,8 +28,14 @@
 #include <vast/test/utils.hpp>
 
 #include <caf/detail/scope_guard.hpp>
+#include <caf/settings.hpp>
 #include <caf/test/dsl.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
 namespace vast {
 namespace {
 
@@ -128,6 +140,36 @@ struct sink final : public crtp_operator<sink> {
   std::function<void(table_slice)> callback_;
 };
 
+// A source that only yields its second batch once the output for the first
+// batch arrived at the sink, or after giving up waiting for it.
+struct idle_source final : public crtp_operator<idle_source> {
+  idle_source(table_slice first, table_slice second,
+              std::shared_ptr<std::atomic<bool>> received)
+    : first_{std::move(first)},
+      second_{std::move(second)},
+      received_{std::move(received)} {
+  }
+
+  auto operator()() const -> generator<table_slice> {
+    co_yield first_;
+    const auto deadline
+      = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (!*received_ && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      co_yield {};
+    }
+    co_yield second_;
+  }
+
+  auto to_string() const -> std::string override {
+    return "idle_source";
+  }
+
+  table_slice first_;
+  table_slice second_;
+  std::shared_ptr<std::atomic<bool>> received_;
+};
+
 struct fixture : fixtures::deterministic_actor_system_and_events {
   fixture() : deterministic_actor_system_and_events{VAST_PP_STRINGIFY(SUITE)} {
   }
@@ -257,6 +299,209 @@ TEST(source | where #type == "zeek.conn" | sink) {
   REQUIRE_EQUAL(count, size_t{10});
 }
 
+TEST(parallel where preserves order) {
+  auto ops = unbox(pipeline::parse(R"(where #type == "zeek.conn")")).unwrap();
+  REQUIRE_EQUAL(ops.size(), 1u);
+  auto where = std::move(ops.front());
+  REQUIRE(where->parallelism() == operator_parallelism::stateless);
+  auto input = std::vector<table_slice>{};
+  auto expected = std::vector<uint64_t>{};
+  for (size_t i = 1; i <= 8; ++i) {
+    input.push_back(head(zeek_conn_log.at(0), i));
+    expected.push_back(i);
+  }
+  auto v = std::vector<operator_ptr>{};
+  v.push_back(std::make_unique<source>(std::move(input)));
+  v.push_back(std::make_unique<parallel_operator>(std::move(where), 4, true));
+  auto rows = std::vector<uint64_t>{};
+  v.push_back(std::make_unique<sink>([&](table_slice slice) {
+    if (slice.rows() > 0)
+      rows.push_back(slice.rows());
+  }));
+  for (auto&& result : make_local_executor(pipeline{std::move(v)})) {
+    REQUIRE_NOERROR(result);
+  }
+  CHECK_EQUAL(rows, expected);
+}
+
+TEST(parallel taste preserves order per schema) {
+  auto ops = unbox(pipeline::parse("taste 1")).unwrap();
+  REQUIRE_EQUAL(ops.size(), 1u);
+  auto taste = std::move(ops.front());
+  REQUIRE(taste->parallelism() == operator_parallelism::per_schema);
+  auto input = std::vector<table_slice>{
+    head(zeek_conn_log.at(0), 2), head(zeek_dns_log.at(0), 2),
+    head(zeek_conn_log.at(0), 3), head(zeek_http_log.at(0), 2),
+    head(zeek_dns_log.at(0), 1),
+  };
+  auto v = std::vector<operator_ptr>{};
+  v.push_back(std::make_unique<source>(std::move(input)));
+  v.push_back(std::make_unique<parallel_operator>(std::move(taste), 4, true));
+  auto names = std::vector<std::string>{};
+  v.push_back(std::make_unique<sink>([&](table_slice slice) {
+    CHECK_EQUAL(slice.rows(), 1u);
+    names.emplace_back(slice.schema().name());
+  }));
+  for (auto&& result : make_local_executor(pipeline{std::move(v)})) {
+    REQUIRE_NOERROR(result);
+  }
+  CHECK_EQUAL(names, (std::vector<std::string>{"zeek.conn", "zeek.dns",
+                                               "zeek.http"}));
+}
+
+TEST(parallel where releases output while input is idle) {
+  auto ops = unbox(pipeline::parse(R"(where #type == "zeek.conn")")).unwrap();
+  REQUIRE_EQUAL(ops.size(), 1u);
+  auto received = std::make_shared<std::atomic<bool>>(false);
+  auto v = std::vector<operator_ptr>{};
+  v.push_back(std::make_unique<idle_source>(head(zeek_conn_log.at(0), 1),
+                                            head(zeek_conn_log.at(0), 2),
+                                            received));
+  v.push_back(
+    std::make_unique<parallel_operator>(std::move(ops.front()), 2, true));
+  auto rows = std::vector<uint64_t>{};
+  auto received_before_second = false;
+  v.push_back(std::make_unique<sink>([&](table_slice slice) {
+    if (rows.empty())
+      received_before_second = !*received;
+    rows.push_back(slice.rows());
+    *received = true;
+  }));
+  for (auto&& result : make_local_executor(pipeline{std::move(v)})) {
+    REQUIRE_NOERROR(result);
+  }
+  CHECK(received_before_second);
+  CHECK_EQUAL(rows, (std::vector<uint64_t>{1, 2}));
+}
+
+TEST(queued operators combine small batches) {
+  auto op = unbox(pipeline::parse_as_operator("pass"));
+  auto input = std::make_shared<operator_queue<table_slice>>(16);
+  auto output = std::make_shared<operator_queue<table_slice>>(16);
+  for (size_t i = 0; i < 10; ++i)
+    REQUIRE(input->push(head(zeek_conn_log.at(0), 1)));
+  // A slice of another schema ends the combined slice before it.
+  REQUIRE(input->push(head(zeek_dns_log.at(0), 1)));
+  input->close();
+  REQUIRE_NOERROR(run_queued_execution_node(*op, input, output));
+  auto slices = std::vector<table_slice>{};
+  auto slice = table_slice{};
+  while (output->pop(slice, std::chrono::milliseconds{0})
+         == operator_queue_status::ok)
+    slices.push_back(std::move(slice));
+  REQUIRE_EQUAL(slices.size(), 2u);
+  CHECK_EQUAL(slices[0].rows(), 10u);
+  CHECK_EQUAL(slices[0].schema(), zeek_conn_log.at(0).schema());
+  CHECK_EQUAL(slices[1].rows(), 1u);
+  CHECK_EQUAL(slices[1].schema(), zeek_dns_log.at(0).schema());
+}
+
+TEST(timed operator) {
+  auto ops = unbox(pipeline::parse(R"(where #type == "zeek.conn")")).unwrap();
+  REQUIRE_EQUAL(ops.size(), 1u);
+  auto timings = std::make_shared<operator_timings>();
+  auto v = std::vector<operator_ptr>{};
+  v.push_back(std::make_unique<source>(std::vector<table_slice>{
+    head(zeek_conn_log.at(0), 1), head(zeek_conn_log.at(0), 2),
+    head(zeek_conn_log.at(0), 3)}));
+  v.push_back(
+    std::make_unique<timed_operator>(std::move(ops.front()), timings));
+  v.push_back(std::make_unique<sink>([](table_slice) {}));
+  for (auto&& result : make_local_executor(pipeline{std::move(v)})) {
+    REQUIRE_NOERROR(result);
+  }
+  CHECK_EQUAL(timings->inputs.load(), 3u);
+  CHECK_EQUAL(timings->outputs.load(), 3u);
+  CHECK_GREATER(timings->busy().count(), 0);
+}
+
+TEST(timed operators fuse and keep their own timings) {
+  auto ops = unbox(pipeline::parse(R"(where #type == "zeek.conn" | )"
+                                   R"(where #type == "zeek.dns")"))
+               .unwrap();
+  REQUIRE_EQUAL(ops.size(), 2u);
+  auto first = std::make_shared<operator_timings>();
+  auto second = std::make_shared<operator_timings>();
+  auto timed = std::vector<operator_ptr>{};
+  timed.push_back(std::make_unique<timed_operator>(std::move(ops[0]), first));
+  timed.push_back(std::make_unique<timed_operator>(std::move(ops[1]), second));
+  auto fused = pipeline::fuse(std::move(timed));
+  REQUIRE_EQUAL(fused.size(), 1u);
+  CHECK(dynamic_cast<fused_operator*>(fused[0].get()) != nullptr);
+  auto v = std::vector<operator_ptr>{};
+  v.push_back(std::make_unique<source>(std::vector<table_slice>{
+    head(zeek_conn_log.at(0), 1), head(zeek_conn_log.at(0), 2),
+    head(zeek_conn_log.at(0), 3)}));
+  v.push_back(std::move(fused[0]));
+  v.push_back(std::make_unique<sink>([](table_slice) {}));
+  for (auto&& result : make_local_executor(pipeline{std::move(v)})) {
+    REQUIRE_NOERROR(result);
+  }
+  CHECK_EQUAL(first->inputs.load(), 3u);
+  CHECK_EQUAL(first->outputs.load(), 3u);
+  CHECK_GREATER(first->busy().count(), 0);
+  CHECK_EQUAL(second->inputs.load(), 3u);
+  CHECK_EQUAL(second->outputs.load(), 0u);
+  CHECK_GREATER(second->busy().count(), 0);
+}
+
+TEST(parallelize fuses stateless operators) {
+  auto options = caf::settings{};
+  caf::put(options, "vast.exec.parallelism", 4);
+  auto ops
+    = unbox(pipeline::parse("select :ip, name | hash name | head 1 | taste 1"))
+        .unwrap();
+  REQUIRE_EQUAL(ops.size(), 4u);
+  auto result = parallelize(std::move(ops), options);
+  REQUIRE_EQUAL(result.size(), 3u);
+  CHECK_EQUAL(result[0]->to_string(), "select :ip, name | hash name");
+  CHECK(dynamic_cast<parallel_operator*>(result[0].get()) != nullptr);
+  CHECK(dynamic_cast<parallel_operator*>(result[1].get()) == nullptr);
+  CHECK(dynamic_cast<parallel_operator*>(result[2].get()) != nullptr);
+  caf::put(options, "vast.exec.parallelism", 1);
+  ops = unbox(pipeline::parse("select :ip, name | hash name")).unwrap();
+  CHECK_EQUAL(parallelize(std::move(ops), options).size(), 2u);
+}
+
+TEST(fused operators match unfused operators) {
+  const auto* definition
+    = R"(where id.resp_h == 192.168.1.255 | where service == "dns" | )"
+      R"(select ts, id.orig_h, id.resp_p | rename source=id.orig_h | )"
+      R"(extend foo=123)";
+  auto fused = pipeline::fuse(unbox(pipeline::parse(definition)).unwrap());
+  REQUIRE_EQUAL(fused.size(), 1u);
+  CHECK(dynamic_cast<fused_operator*>(fused[0].get()) != nullptr);
+  CHECK_EQUAL(fused[0]->to_string(),
+              unbox(pipeline::parse(definition)).to_string());
+  auto run = [&](bool interleave_pass) {
+    auto v = std::vector<operator_ptr>{};
+    v.push_back(std::make_unique<source>(zeek_conn_log));
+    for (auto&& op : unbox(pipeline::parse(definition)).unwrap()) {
+      v.push_back(std::move(op));
+      // Operators that do not support fusion prevent it.
+      if (interleave_pass)
+        v.push_back(unbox(pipeline::parse_as_operator("pass")));
+    }
+    auto slices = std::vector<table_slice>{};
+    v.push_back(std::make_unique<sink>([&](table_slice slice) {
+      slices.push_back(std::move(slice));
+    }));
+    for (auto&& result : make_local_executor(pipeline{std::move(v)})) {
+      REQUIRE_NOERROR(result);
+    }
+    return slices;
+  };
+  const auto expected = run(true);
+  const auto actual = run(false);
+  REQUIRE_EQUAL(actual.size(), expected.size());
+  CHECK_GREATER(rows(actual), 0u);
+  CHECK_LESS(rows(actual), rows(zeek_conn_log));
+  for (size_t i = 0; i < actual.size(); ++i) {
+    CHECK(actual[i] == expected[i]);
+    CHECK_EQUAL(actual[i].schema(), expected[i].schema());
+  }
+}
+
 TEST(tail 5) {
   {
     auto v = unbox(pipeline::parse("tail 5")).unwrap();
@@ -299,6 +544,158 @@ TEST(unique) {
   CHECK_EQUAL(count, size_t{1 + 0 + 4 + 0 + 4 + 5 + 6 + 7});
 }
 
+TEST(sort | head) {
+  auto ops = unbox(pipeline::parse("sort ts desc | head 3")).unwrap();
+  REQUIRE_EQUAL(ops.size(), size_t{1});
+  CHECK_EQUAL(ops[0]->to_string(), "sort ts desc | head 3");
+  ops.insert(ops.begin(), std::make_unique<source>(std::vector<table_slice>{
+                            head(zeek_conn_log.at(0), 5),
+                            head(zeek_conn_log.at(0), 8),
+                          }));
+  auto uids = std::vector<std::string>{};
+  ops.push_back(std::make_unique<sink>([&](table_slice slice) {
+    for (size_t row = 0; row < slice.rows(); ++row) {
+      uids.emplace_back(caf::get<std::string_view>(slice.at(row, 1)));
+    }
+  }));
+  auto executor = make_local_executor(pipeline{std::move(ops)});
+  for (auto&& error : executor) {
+    REQUIRE_NOERROR(error);
+  }
+  CHECK_EQUAL(uids, (std::vector<std::string>{"KlF6tbPUSQ1", "kmnBNBtl96d",
+                                              "CFIX6YVTFp2"}));
+}
+
+TEST(summarize) {
+  auto ops = unbox(pipeline::parse("summarize count(uid), sum(orig_bytes) by "
+                                   "id.orig_h"))
+               .unwrap();
+  ops.insert(ops.begin(), std::make_unique<source>(zeek_conn_log));
+  auto counts = std::vector<uint64_t>{};
+  auto sums = std::vector<uint64_t>{};
+  ops.push_back(std::make_unique<sink>([&](table_slice slice) {
+    for (size_t row = 0; row < slice.rows(); ++row) {
+      counts.push_back(caf::get<uint64_t>(slice.at(row, 1)));
+      sums.push_back(caf::get<uint64_t>(slice.at(row, 2)));
+    }
+  }));
+  auto executor = make_local_executor(pipeline{std::move(ops)});
+  for (auto&& error : executor) {
+    REQUIRE_NOERROR(error);
+  }
+  // Groups are emitted in the order of their first appearance.
+  CHECK_EQUAL(counts, (std::vector<uint64_t>{8, 5, 4, 2, 1}));
+  CHECK_EQUAL(sums, (std::vector<uint64_t>{1766, 1911, 1246, 546, 273}));
+}
+
+TEST(summarize split into partial and final phase) {
+  auto op = unbox(pipeline::parse_as_operator(
+    "summarize count(uid), sum(orig_bytes), distinct(id.resp_p) by "
+    "id.orig_h"));
+  auto split = op->split_partial();
+  REQUIRE(split);
+  CHECK(!split->first->split_partial());
+  auto run = [](std::vector<table_slice> input, const operator_ptr& op) {
+    auto v = std::vector<operator_ptr>{};
+    v.push_back(std::make_unique<source>(std::move(input)));
+    v.push_back(op->copy());
+    auto result = std::vector<table_slice>{};
+    v.push_back(std::make_unique<sink>([&](table_slice slice) {
+      result.push_back(std::move(slice));
+    }));
+    for (auto&& error : make_local_executor(pipeline{std::move(v)})) {
+      REQUIRE_NOERROR(error);
+    }
+    return result;
+  };
+  // Run the partial phase on two disjoint parts of the input separately, and
+  // merge their partial states in the final phase.
+  const auto middle = zeek_conn_log.begin() + zeek_conn_log.size() / 2;
+  auto partial_states = run({zeek_conn_log.begin(), middle}, split->first);
+  for (auto&& slice : run({middle, zeek_conn_log.end()}, split->first))
+    partial_states.push_back(std::move(slice));
+  REQUIRE(!partial_states.empty());
+  CHECK(partial_states[0].schema().attribute("summarize-partial"));
+  CHECK_LESS(rows(partial_states), rows(zeek_conn_log));
+  const auto expected = run(zeek_conn_log, op);
+  const auto actual = run(std::move(partial_states), split->second);
+  REQUIRE_EQUAL(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i)
+    CHECK(actual[i] == expected[i]);
+}
+
+TEST(aggregation function merge) {
+  const auto make = [](std::string_view name) {
+    const auto* plugin = plugins::find<aggregation_function_plugin>(name);
+    REQUIRE(plugin);
+    return unbox(plugin->make_aggregation_function(type{int64_type{}}));
+  };
+  const auto merged = [&](std::string_view name) {
+    auto lhs = make(name);
+    auto rhs = make(name);
+    lhs->add(data_view{int64_t{1}});
+    lhs->add(data_view{int64_t{2}});
+    rhs->add(data_view{int64_t{2}});
+    rhs->add(data_view{caf::none});
+    rhs->add(data_view{int64_t{3}});
+    auto state = unbox(rhs->save());
+    REQUIRE_NOERROR(lhs->merge(make_view(state)));
+    return unbox(std::move(*lhs).finish());
+  };
+  CHECK_EQUAL(merged("count"), data{uint64_t{5}});
+  CHECK_EQUAL(merged("sum"), data{int64_t{8}});
+  CHECK_EQUAL(merged("min"), data{int64_t{1}});
+  CHECK_EQUAL(merged("max"), data{int64_t{3}});
+  CHECK_EQUAL(merged("count_distinct"), data{uint64_t{3}});
+  CHECK_EQUAL(merged("distinct"),
+              (data{list{int64_t{1}, int64_t{2}, int64_t{3}}}));
+  CHECK_EQUAL(merged("approx_count_distinct"), data{uint64_t{3}});
+}
+
+TEST(sketch aggregation functions) {
+  const auto make = [](std::string_view name) {
+    const auto* plugin = plugins::find<aggregation_function_plugin>(name);
+    REQUIRE(plugin);
+    return unbox(plugin->make_aggregation_function(type{int64_type{}}));
+  };
+  // Feed the values to two instances of the function and merge them, so that
+  // the partial states are exercised as well.
+  const auto run = [&](std::string_view name, const auto& values) {
+    auto lhs = make(name);
+    auto rhs = make(name);
+    for (size_t i = 0; i < values.size(); ++i)
+      (i % 2 == 0 ? lhs : rhs)->add(data_view{values[i]});
+    auto state = unbox(rhs->save());
+    REQUIRE_NOERROR(lhs->merge(make_view(state)));
+    return unbox(std::move(*lhs).finish());
+  };
+  auto values = std::vector<int64_t>{};
+  for (int64_t i = 1; i <= 100'000; ++i)
+    values.push_back(i);
+  const auto count = caf::get<uint64_t>(run("approx_count_distinct", values));
+  CHECK_LESS(count, uint64_t{103'000});
+  CHECK_GREATER(count, uint64_t{97'000});
+  const auto median = caf::get<double>(run("approx_median", values));
+  CHECK_LESS(std::abs(median - 50'000.0), 500.0);
+  const auto p99 = caf::get<double>(run("approx_p99", values));
+  CHECK_LESS(std::abs(p99 - 99'000.0), 500.0);
+  // Ten heavy hitters between lots of noise.
+  values.clear();
+  for (int64_t i = 0; i < 10; ++i)
+    for (int64_t j = 0; j < 1'000 + i * 100; ++j)
+      values.push_back(-i - 1);
+  for (int64_t i = 0; i < 5'000; ++i)
+    values.push_back(i);
+  std::shuffle(values.begin(), values.end(), std::mt19937_64{42});
+  auto heavy_hitters = caf::get<list>(run("approx_heavy_hitters", values));
+  REQUIRE_EQUAL(heavy_hitters.size(), size_t{10});
+  std::sort(heavy_hitters.begin(), heavy_hitters.end());
+  CHECK_EQUAL(heavy_hitters,
+              (list{int64_t{-10}, int64_t{-9}, int64_t{-8}, int64_t{-7},
+                    int64_t{-6}, int64_t{-5}, int64_t{-4}, int64_t{-3},
+                    int64_t{-2}, int64_t{-1}}));
+}
+
 FIXTURE_SCOPE_END()
 
 TEST(pipeline operator typing) {
@@ -6,7 +6,10 @@
 // SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "vast/arrow_table_slice.hpp"
 #include "vast/collect.hpp"
+#include "vast/columnar_json_printer.hpp"
+#include "vast/concept/printable/vast/json.hpp"
 #include "vast/plugin.hpp"
 #include "vast/table_slice.hpp"
 #include "vast/table_slice_builder.hpp"
@@ -433,4 +436,31 @@ TEST(json printer - zeek conn log) {
   }
 }
 
+TEST(columnar json printer matches generic json printer) {
+  const auto logs = std::vector<const std::vector<table_slice>*>{
+    &zeek_conn_log,        &zeek_dns_log,          &zeek_http_log,
+    &suricata_alert_log,   &suricata_dns_log,      &suricata_fileinfo_log,
+    &suricata_flow_log,    &suricata_http_log,     &suricata_netflow_log,
+    &suricata_stats_log,
+  };
+  const auto generic = json_printer{{.oneline = true}};
+  for (const auto* log : logs) {
+    for (const auto& slice : *log) {
+      auto expected = std::string{};
+      auto resolved = resolve_enumerations(slice);
+      auto array = to_record_batch(resolved)->ToStructArray().ValueOrDie();
+      auto out = std::back_inserter(expected);
+      for (const auto& row :
+           values(caf::get<record_type>(resolved.schema()), *array)) {
+        REQUIRE(row);
+        REQUIRE(generic.print(out, *row));
+        expected += '\n';
+      }
+      auto buffer = std::vector<char>{};
+      columnar_json_printer{slice.schema()}.print(slice, buffer);
+      CHECK_EQUAL(std::string_view(buffer.data(), buffer.size()), expected);
+    }
+  }
+}
+
 FIXTURE_SCOPE_END()
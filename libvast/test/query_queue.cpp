@@ -154,4 +154,74 @@ TEST(2 overlapping queries) {
   CHECK(q.queries().empty());
 }
 
+TEST(small queries overtake large queries) {
+  auto now = time{};
+  query_queue q{[&] {
+    return now;
+  }};
+  auto large = make_insert(q, cands(0, 10));
+  auto a = unbox(q.next());
+  CHECK_EQUAL(a.queries, std::vector{large});
+  now += std::chrono::milliseconds{1};
+  auto small = make_insert(q, cands(10, 12));
+  auto b = unbox(q.next());
+  CHECK_EQUAL(b.queries, std::vector{small});
+  // From here on, the queries take turns.
+  auto c = unbox(q.next());
+  CHECK_EQUAL(c.queries, std::vector{large});
+  auto d = unbox(q.next());
+  CHECK_EQUAL(d.queries, std::vector{small});
+  auto e = unbox(q.next());
+  CHECK_EQUAL(e.queries, std::vector{large});
+}
+
+TEST(normal priority queries overtake low priority queries) {
+  auto now = time{};
+  query_queue q{[&] {
+    return now;
+  }};
+  auto low = make_insert(q, cands(0, 3), 3, query_context::priority::low);
+  now += std::chrono::milliseconds{1};
+  auto normal = make_insert(q, cands(3, 5), 2);
+  CHECK_EQUAL(unbox(q.next()).queries, std::vector{normal});
+  CHECK_EQUAL(unbox(q.next()).queries, std::vector{normal});
+  CHECK_EQUAL(unbox(q.next()).queries, std::vector{low});
+}
+
+TEST(low priority queries wait for a bounded number of partitions) {
+  auto now = time{};
+  query_queue q{[&] {
+    return now;
+  }};
+  auto low = make_insert(q, cands(0, 2), 2, query_context::priority::low);
+  now += std::chrono::milliseconds{50};
+  auto normal = make_insert(q, cands(2, 16), 14);
+  // The low-priority query has ten times the slack of the normal query, so
+  // it gets its turn after the normal query had nine partitions scheduled,
+  // even though the normal query has more partitions left.
+  for (auto i = 0; i < 9; ++i)
+    CHECK_EQUAL(unbox(q.next()).queries, std::vector{normal});
+  CHECK_EQUAL(unbox(q.next()).queries, std::vector{low});
+  CHECK_EQUAL(unbox(q.next()).queries, std::vector{normal});
+}
+
+TEST(activated queries move their partitions forward) {
+  auto now = time{};
+  query_queue q{[&] {
+    return now;
+  }};
+  auto low = make_insert(q, cands(0, 3), 3, query_context::priority::low);
+  now += std::chrono::milliseconds{1};
+  auto normal = make_insert(q, cands(1, 4), 1);
+  CHECK_EQUAL(unbox(q.next()).queries, (std::vector{low, normal}));
+  // The normal query is inactive now, so its remaining partitions wait for
+  // the low-priority query.
+  CHECK_EQUAL(unbox(q.next()).queries, std::vector{low});
+  REQUIRE_SUCCESS(q.activate(normal, 2));
+  CHECK_EQUAL(unbox(q.next()).queries, std::vector{normal});
+  CHECK_EQUAL(unbox(q.next()).queries, std::vector{normal});
+  CHECK_EQUAL(unbox(q.next()).queries, std::vector{low});
+  CHECK_ERROR(q.next());
+}
+
 } // namespace vast
@@ -0,0 +1,115 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "vast/sketch/split_block_bloom_filter.hpp"
+
+#include "vast/hash/hash.hpp"
+#include "vast/si_literals.hpp"
+#include "vast/test/test.hpp"
+
+#include <caf/test/dsl.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace vast;
+using namespace vast::sketch;
+using namespace si_literals;
+
+TEST(split block bloom filter api) {
+  bloom_filter_config cfg;
+  cfg.n = 1_k;
+  cfg.p = 0.1;
+  auto filter = unbox(split_block_bloom_filter::make(cfg));
+  filter.add(hash("foo"));
+  CHECK(filter.lookup(hash("foo")));
+  CHECK(!filter.lookup(hash("bar")));
+  CHECK_EQUAL(filter.parameters().k, split_block_words);
+  CHECK_EQUAL(filter.parameters().m % split_block_bits, 0u);
+  CHECK_LESS_EQUAL(filter.parameters().p, 0.1);
+}
+
+TEST(split block bloom filter invalid parameters) {
+  bloom_filter_config cfg;
+  cfg.n = 1_k;
+  cfg.p = 0.1;
+  cfg.k = 3;
+  CHECK(!split_block_bloom_filter::make(cfg));
+  cfg.k = std::nullopt;
+  cfg.p = 1.5;
+  CHECK(!split_block_bloom_filter::make(cfg));
+  cfg.p = std::nullopt;
+  CHECK(!split_block_bloom_filter::make(cfg));
+}
+
+TEST(split block bloom filter fp test) {
+  bloom_filter_config cfg;
+  cfg.n = 10_k;
+  cfg.p = 0.01;
+  auto filter = unbox(split_block_bloom_filter::make(cfg));
+  auto params = filter.parameters();
+  std::mt19937_64 r{0};
+  auto num_fps = 0u;
+  auto num_queries = 1_M;
+  // Load filter to full capacity.
+  for (size_t i = 0; i < params.n; ++i)
+    filter.add(hash(r()));
+  // Sample true negatives.
+  for (size_t i = 0; i < num_queries; ++i)
+    if (filter.lookup(hash(r())))
+      ++num_fps;
+  auto p = params.p;
+  auto p_hat = static_cast<double>(num_fps) / num_queries;
+  auto epsilon = 0.001;
+  CHECK_LESS(std::abs(p_hat - p), epsilon);
+}
+
+TEST(frozen split block bloom filter) {
+  bloom_filter_config cfg;
+  cfg.m = 8_k;
+  cfg.n = 100;
+  auto filter = unbox(split_block_bloom_filter::make(cfg));
+  filter.add(hash("foo"));
+  CHECK(filter.lookup(hash("foo")));
+  auto frozen = unbox(freeze(filter));
+  CHECK(frozen.lookup(hash("foo")));
+  CHECK(!frozen.lookup(hash("bar")));
+  CHECK_EQUAL(filter.parameters(), frozen.parameters());
+  CHECK(std::equal(filter.blocks().begin(), filter.blocks().end(),
+                   frozen.blocks().begin(), frozen.blocks().end()));
+}
+
+TEST(split block bloom filter batch lookup) {
+  bloom_filter_config cfg;
+  cfg.n = 100;
+  cfg.p = 0.01;
+  auto filters = std::vector<split_block_bloom_filter>{};
+  std::mt19937_64 r{0};
+  for (size_t i = 0; i < 100; ++i) {
+    auto& filter = filters.emplace_back(
+      unbox(split_block_bloom_filter::make(cfg)));
+    for (size_t j = 0; j < 50; ++j)
+      filter.add(r());
+    filter.add(i);
+  }
+  auto blocks = std::vector<std::span<const uint32_t>>{};
+  for (const auto& filter : filters)
+    blocks.push_back(filter.blocks());
+  // Empty filters never contain anything.
+  blocks.emplace_back();
+  for (uint64_t digest = 0; digest < 1_k; ++digest) {
+    auto result = std::vector<uint8_t>(blocks.size(), 0);
+    lookup(digest, blocks, result);
+    for (size_t i = 0; i < filters.size(); ++i)
+      CHECK_EQUAL(result[i] != 0, filters[i].lookup(digest));
+    CHECK_EQUAL(result.back(), 0);
+  }
+}
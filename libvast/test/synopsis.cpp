@@ -41,24 +41,24 @@ TEST(min - max synopsis) {
   verify(zero, {N, N, N, N, F, T, F, F, T, T});
   MESSAGE("[4,7] op 4");
   time four = epoch + 4s;
-  verify(four, {N, N, N, N, T, F, F, T, T, T});
+  verify(four, {N, N, N, N, T, T, F, T, T, T});
   MESSAGE("[4,7] op 6");
   time six = epoch + 6s;
-  verify(six, {N, N, N, N, T, F, T, T, T, T});
+  verify(six, {N, N, N, N, T, T, T, T, T, T});
   MESSAGE("[4,7] op 7");
   time seven = epoch + 7s;
-  verify(seven, {N, N, N, N, T, F, T, T, F, T});
+  verify(seven, {N, N, N, N, T, T, T, T, F, T});
   MESSAGE("[4,7] op 9");
   time nine = epoch + 9s;
   verify(nine, {N, N, N, N, F, T, T, T, F, F});
   MESSAGE("[4,7] op [0, 4]");
   auto zero_four = data{list{zero, four}};
   auto zero_four_view = make_view(zero_four);
-  verify(zero_four_view, {T, F, N, N, N, N, N, N, N, N});
+  verify(zero_four_view, {T, T, N, N, N, N, N, N, N, N});
   MESSAGE("[4,7] op [7, 9]");
   auto seven_nine = data{list{seven, nine}};
   auto seven_nine_view = make_view(seven_nine);
-  verify(seven_nine_view, {T, F, N, N, N, N, N, N, N, N});
+  verify(seven_nine_view, {T, T, N, N, N, N, N, N, N, N});
   MESSAGE("[4,7] op [0, 9]");
   auto zero_nine = data{list{zero, nine}};
   auto zero_nine_view = make_view(zero_nine);
@@ -70,7 +70,60 @@ TEST(min - max synopsis) {
   MESSAGE("[4,7] op [count{5}, 7]");
   auto heterogeneous = data{list{c, seven}};
   auto heterogeneous_view = make_view(heterogeneous);
-  verify(heterogeneous_view, {T, F, N, N, N, N, N, N, N, N});
+  verify(heterogeneous_view, {T, T, N, N, N, N, N, N, N, N});
+}
+
+TEST(min - max synopsis exact lookup) {
+  using vast::time;
+  factory<synopsis>::initialize();
+  auto x = factory<synopsis>::make(type{time_type{}}, caf::settings{});
+  REQUIRE_NOT_EQUAL(x, nullptr);
+  auto check = [&](relational_operator op, time rhs, synopsis_match expected) {
+    CHECK(x->exact_lookup(op, rhs) == expected);
+  };
+  MESSAGE("empty synopsis");
+  check(relational_operator::less, epoch, synopsis_match::none);
+  check(relational_operator::not_equal, epoch, synopsis_match::none);
+  MESSAGE("[4,7]");
+  x->add(time{epoch + 4s});
+  x->add(time{epoch + 7s});
+  check(relational_operator::less, epoch + 4s, synopsis_match::none);
+  check(relational_operator::less, epoch + 5s, synopsis_match::maybe);
+  check(relational_operator::less, epoch + 8s, synopsis_match::all);
+  check(relational_operator::less_equal, epoch + 7s, synopsis_match::all);
+  check(relational_operator::greater, epoch + 3s, synopsis_match::all);
+  check(relational_operator::greater, epoch + 7s, synopsis_match::none);
+  check(relational_operator::greater_equal, epoch + 7s, synopsis_match::maybe);
+  check(relational_operator::equal, epoch + 5s, synopsis_match::maybe);
+  check(relational_operator::not_equal, epoch + 5s, synopsis_match::maybe);
+  check(relational_operator::not_equal, epoch + 9s, synopsis_match::all);
+  MESSAGE("[4,4]");
+  x = std::make_unique<time_synopsis>(epoch + 4s, epoch + 4s);
+  check(relational_operator::equal, epoch + 4s, synopsis_match::all);
+  check(relational_operator::not_equal, epoch + 4s, synopsis_match::none);
+  CHECK_EQUAL(x->lookup(relational_operator::not_equal, time{epoch + 4s}),
+              false);
+}
+
+TEST(bool synopsis exact lookup) {
+  auto check = [](bool true_, bool false_, relational_operator op, bool rhs,
+                  synopsis_match expected) {
+    CHECK(bool_synopsis{true_, false_}.exact_lookup(op, make_data_view(rhs))
+          == expected);
+  };
+  MESSAGE("only true");
+  check(true, false, relational_operator::equal, true, synopsis_match::all);
+  check(true, false, relational_operator::equal, false, synopsis_match::none);
+  check(true, false, relational_operator::not_equal, false,
+        synopsis_match::all);
+  MESSAGE("true and false");
+  check(true, true, relational_operator::equal, true, synopsis_match::maybe);
+  check(true, true, relational_operator::not_equal, true,
+        synopsis_match::maybe);
+  MESSAGE("neither true nor false");
+  check(false, false, relational_operator::equal, true, synopsis_match::none);
+  check(false, false, relational_operator::not_equal, true,
+        synopsis_match::none);
 }
 
 namespace {
@@ -339,6 +339,107 @@ TEST(attribute extractor - import time) {
   CHECK_EQUAL(lookup(newer_than_y2021), empty());
   CHECK_EQUAL(lookup(older_than_y2030), ids);
   CHECK_EQUAL(lookup(newer_than_y2030), empty());
+  CHECK_EQUAL(lookup(expression{negation{older_than_y2k}}), foobar);
+  CHECK_EQUAL(lookup(expression{negation{older_than_y2030}}), empty());
+}
+
+TEST(connectives with restricted candidates) {
+  auto foobar = std::vector<uuid>{ids[1], ids[3]};
+  const auto early = std::string{":timestamp <= 1970-01-01+00:00:30.0"};
+  const auto is_foo = std::string{"#type == \"foo\""};
+  CHECK_EQUAL(lookup(is_foo + " && " + early), slice(0));
+  // Reordering the operands must not change the result.
+  CHECK_EQUAL(lookup(early + " && " + is_foo), slice(0));
+  CHECK_EQUAL(lookup(is_foo + " || " + early), slice(0, 3));
+  CHECK_EQUAL(lookup("#type == \"bar\" || #type == \"foobar\""), foobar);
+  CHECK_EQUAL(lookup("#type == \"foo\" || #type == \"foobar\""), ids);
+  CHECK_EQUAL(lookup("(#type == \"foo\" || #type == \"foobar\") && "
+                     "#type != \"foo\""),
+              foobar);
+  CHECK_EQUAL(lookup("#type == \"foobar\" && #type == \"foo\""), empty());
+}
+
+TEST(negations) {
+  const auto early = std::string{":timestamp < 1970-01-01+00:00:50.0"};
+  const auto is_foo = std::string{"#type == \"foo\""};
+  CHECK_EQUAL(lookup("! (" + early + ")"), slice(2, 4));
+  CHECK_EQUAL(lookup("! (! (" + early + "))"), slice(0, 2));
+  CHECK_EQUAL(lookup("! (" + is_foo + ")"),
+              (std::vector<uuid>{ids[1], ids[3]}));
+  // Negated connectives are looked up using De Morgan's laws.
+  CHECK_EQUAL(lookup("! (" + early + " && " + is_foo + ")"), slice(1, 4));
+  CHECK_EQUAL(lookup("! (" + early + " || " + is_foo + ")"), slice(3));
+  // A point in time cannot rule out any partition for the negation.
+  CHECK_EQUAL(lookup("! (:timestamp == 1970-01-01+00:00:10.0)"), ids);
+}
+
+TEST(erase and reinsert partitions) {
+  const auto early = std::string{":timestamp < 1970-01-01+00:00:50.0"};
+  const auto late = std::string{":timestamp >= 1970-01-01+00:00:50.0"};
+  auto erase = [&](const uuid& id) {
+    auto rp = self->request(catalog_act, caf::infinite, atom::erase_v, id);
+    run();
+    rp.receive([](atom::ok) {},
+               [](const caf::error& e) {
+                 FAIL(render(e));
+               });
+  };
+  // Every schema keeps one of its two partitions, so that the indexes of
+  // both schemas free a slot.
+  erase(ids[0]);
+  erase(ids[1]);
+  CHECK_EQUAL(lookup(early), std::vector<uuid>{});
+  CHECK_EQUAL(lookup(late), slice(2, 4));
+  CHECK_EQUAL(lookup("! (" + early + ")"), slice(2, 4));
+  // Reinserting the partitions reuses the freed slots.
+  merge(catalog_act, ids[1], merged_synopses[1]);
+  CHECK_EQUAL(lookup(early), slice(1));
+  merge(catalog_act, ids[0], merged_synopses[0]);
+  CHECK_EQUAL(lookup(early), slice(0, 2));
+  CHECK_EQUAL(lookup(late), slice(2, 4));
+  CHECK_EQUAL(lookup("! (" + early + ")"), slice(2, 4));
+}
+
+TEST(negations with null values) {
+  auto meta_idx = self->spawn(catalog, accountant_actor{}, directory / "types");
+  auto schema = type{
+    "test",
+    record_type{
+      {"ts", type{"timestamp", time_type{}}},
+    },
+  };
+  auto builder = std::make_shared<table_slice_builder>(schema);
+  auto add_partition = [&](std::optional<vast::time> null_or_ts) {
+    CHECK(builder->add(make_data_view(epoch + 10s)));
+    if (null_or_ts)
+      CHECK(builder->add(make_data_view(*null_or_ts)));
+    else
+      CHECK(builder->add(make_data_view(caf::none)));
+    auto slice = builder->finish();
+    slice.offset(0);
+    auto id = uuid::random();
+    merge(meta_idx, id,
+          caf::make_copy_on_write<partition_synopsis>(
+            make_partition_synopsis(slice)));
+    return id;
+  };
+  const auto without_nulls = add_partition(epoch + 20s);
+  const auto with_nulls = add_partition(std::nullopt);
+  auto both = std::vector<uuid>{without_nulls, with_nulls};
+  std::sort(both.begin(), both.end());
+  auto lookup_ = [&](std::string_view expr) {
+    return lookup(meta_idx, expr);
+  };
+  // All non-null timestamps are early, but the null timestamp satisfies the
+  // negated predicate, so the partition with nulls must not be pruned.
+  const auto early = std::string{"1970-01-01+00:01:00.0"};
+  CHECK_EQUAL(lookup_(":timestamp < " + early), both);
+  CHECK_EQUAL(lookup_("! (:timestamp < " + early + ")"),
+              std::vector<uuid>{with_nulls});
+  CHECK_EQUAL(lookup_("! (ts < " + early + ")"),
+              std::vector<uuid>{with_nulls});
+  CHECK_EQUAL(lookup_("! (ts != 1970-01-01+00:00:05.0)"),
+              std::vector<uuid>{with_nulls});
 }
 
 TEST(catalog with bool synopsis) {
@@ -399,6 +500,14 @@ TEST(catalog with bool synopsis) {
   CHECK_EQUAL(lookup_(":bool != false"), expected1);
   CHECK_EQUAL(lookup_(":bool == false"), expected2);
   CHECK_EQUAL(lookup_(":bool != true"), expected2);
+  // Negations prune partitions for which all values satisfy the predicate.
+  auto expected23 = std::vector<uuid>{id2, id3};
+  std::sort(expected23.begin(), expected23.end());
+  auto expected13 = std::vector<uuid>{id1, id3};
+  std::sort(expected13.begin(), expected13.end());
+  CHECK_EQUAL(lookup_("! (x == true)"), expected23);
+  CHECK_EQUAL(lookup_("! (x == false)"), expected13);
+  CHECK_EQUAL(lookup_("! (:bool != false)"), expected23);
   // Invalid schema: y does not a valid field
   CHECK_EQUAL(lookup_("y == true"), none);
   CHECK_EQUAL(lookup_("y != false"), none);
@@ -406,6 +515,52 @@ TEST(catalog with bool synopsis) {
   CHECK_EQUAL(lookup_("y != true"), none);
 }
 
+TEST(catalog with string synopsis) {
+  MESSAGE("generate slice data and add it to the catalog");
+  auto meta_idx = self->spawn(catalog, accountant_actor{}, directory / "types");
+  auto schema = type{
+    "test",
+    record_type{
+      {"x", string_type{}},
+    },
+  };
+  auto builder = std::make_shared<table_slice_builder>(schema);
+  REQUIRE(builder);
+  auto ids = std::vector<uuid>{};
+  auto offset = id{0};
+  for (const auto* value : {"foo", "bar", "baz"}) {
+    CHECK(builder->add(make_data_view(std::string_view{value})));
+    auto slice = builder->finish();
+    slice.offset(offset++);
+    auto ps = make_partition_synopsis(slice);
+    // Shrinking turns the buffered synopses into Bloom filters.
+    ps.shrink();
+    ids.push_back(uuid::random());
+    merge(meta_idx, ids.back(),
+          caf::make_copy_on_write<partition_synopsis>(std::move(ps)));
+  }
+  auto lookup_ = [&](std::string_view expr) {
+    return lookup(meta_idx, expr);
+  };
+  auto sorted = [](std::vector<uuid> xs) {
+    std::sort(xs.begin(), xs.end());
+    return xs;
+  };
+  auto none = std::vector<uuid>{};
+  MESSAGE("equality lookups probe the filters of all partitions at once");
+  CHECK_EQUAL(lookup_("x == \"foo\""), std::vector<uuid>{ids[0]});
+  CHECK_EQUAL(lookup_("x == \"bar\""), std::vector<uuid>{ids[1]});
+  CHECK_EQUAL(lookup_(":string == \"baz\""), std::vector<uuid>{ids[2]});
+  CHECK_EQUAL(lookup_("x == \"qux\""), none);
+  CHECK_EQUAL(lookup_("x in [\"foo\", \"baz\"]"), sorted({ids[0], ids[2]}));
+  CHECK_EQUAL(lookup_("x in [\"qux\"]"), none);
+  MESSAGE("restricted candidates probe only the surviving partitions");
+  CHECK_EQUAL(lookup_("x in [\"foo\", \"bar\"] && x == \"bar\""),
+              std::vector<uuid>{ids[1]});
+  MESSAGE("other operators fall back to the synopses");
+  CHECK_EQUAL(lookup_("x != \"foo\""), sorted(ids));
+}
+
 TEST(catalog messages) {
   // All of the pregenerated data has "foo" as content and its id as timestamp,
   // so this selects everything but the first partition.
@@ -10,6 +10,7 @@
 
 #include "vast/collect.hpp"
 #include "vast/config.hpp"
+#include "vast/defaults.hpp"
 #include "vast/detail/spawn_container_source.hpp"
 #include "vast/qualified_record_field.hpp"
 #include "vast/string_synopsis.hpp"
@@ -113,8 +114,10 @@ TEST(passive_partition - load) {
   auto id = uuid{bytes_view};
   auto fs = self->spawn(mock_filesystem);
   auto path = std::filesystem::path{};
-  auto aut = self->spawn(system::passive_partition, id,
-                         vast::system::accountant_actor{}, fs, path);
+  auto aut
+    = self->spawn(system::passive_partition, id,
+                  vast::system::accountant_actor{}, fs, path,
+                  vast::defaults::system::synchronous_evaluation);
   sched.run();
   self->send(aut, atom::erase_v);
   CHECK_EQUAL(sched.jobs.size(), 1u);
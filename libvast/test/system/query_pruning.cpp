@@ -106,6 +106,10 @@ TEST(simple query pruning) {
                       vast::relational_operator::equal,
                       vast::data{std::string{"foo"}}};
   CHECK_EQUAL(expected5, result5);
+  // !(foo == "foo" || bar == "foo")
+  auto expression6 = vast::expression{vast::negation{expression1}};
+  auto result6 = vast::prune(expression6, unprunable_types);
+  CHECK_EQUAL(expression6, result6);
 }
 
 TEST(query pruning with index config) {
@@ -0,0 +1,124 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include "vast/fwd.hpp"
+
+#include "vast/expression.hpp"
+#include "vast/ids.hpp"
+
+#include <caf/expected.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vast::plugins::sigma {
+
+/// A Sigma rule translated into a VAST expression.
+struct rule {
+  /// The title of the rule, or its file name if it has no title.
+  std::string title;
+
+  /// The normalized and validated expression of the rule.
+  expression expr;
+};
+
+/// Loads a Sigma rule from a file, or all Sigma rules from the files ending
+/// in `.yml` or `.yaml` in a directory and its subdirectories. Skips rules
+/// that VAST cannot express with a warning.
+/// @param path The file or directory to load.
+/// @returns The rules in lexicographical order of their files.
+caf::expected<std::vector<rule>> load_rules(const std::filesystem::path& path);
+
+/// A shared evaluation plan that matches many Sigma rules against table
+/// slices of a single schema.
+///
+/// The matcher evaluates every distinct predicate of all rules once per table
+/// slice. Predicates that compare a string column with a pattern or a string
+/// go into one `RE2::Set` per column, so that every cell is scanned once no
+/// matter how many rules refer to the column. The rules then combine the
+/// results of their predicates with bitmap operations.
+class matcher {
+public:
+  /// Compiles rules for a schema. Rules that cannot be tailored to the schema
+  /// never match.
+  /// @param rules The rules to compile.
+  /// @param schema The schema of the table slices to match.
+  static caf::expected<matcher>
+  make(const std::vector<rule>& rules, const type& schema);
+
+  matcher(matcher&&) noexcept;
+  matcher& operator=(matcher&&) noexcept;
+  ~matcher() noexcept;
+
+  /// Matches all rules against a table slice.
+  /// @param slice A table slice of the schema of the matcher.
+  /// @returns The indices of the rules that match at least one row, together
+  /// with the IDs of the matching rows.
+  [[nodiscard]] std::vector<std::pair<size_t, ids>>
+  match(const table_slice& slice) const;
+
+  /// @returns The number of distinct predicates.
+  [[nodiscard]] size_t num_predicates() const noexcept;
+
+  /// @returns The number of string columns scanned once per table slice.
+  [[nodiscard]] size_t num_scans() const noexcept;
+
+private:
+  /// A step of a rule in postfix order.
+  struct instruction {
+    enum class opcode { predicate, conjunction, disjunction, negation };
+
+    opcode op;
+
+    /// The predicate index for predicates, and the number of operands for
+    /// conjunctions and disjunctions.
+    size_t arg;
+  };
+
+  /// A distinct predicate of all rules.
+  struct leaf {
+    static constexpr auto no_scan = std::numeric_limits<size_t>::max();
+
+    predicate pred;
+
+    /// The scan that evaluates the predicate, if any.
+    size_t scan = no_scan;
+
+    /// The index of the regular expression in the set of the scan.
+    int entry = -1;
+
+    /// Whether the predicate holds if the regular expression does not match.
+    bool negated = false;
+  };
+
+  struct scan;
+
+  matcher();
+
+  /// Translates an expression into instructions.
+  void compile(const expression& expr, std::vector<instruction>& program,
+               std::map<predicate, size_t>& leaves,
+               std::map<size_t, size_t>& scans);
+
+  /// Registers a predicate and returns its index.
+  size_t add(const predicate& pred, std::map<predicate, size_t>& leaves,
+             std::map<size_t, size_t>& scans);
+
+  std::vector<std::pair<size_t, std::vector<instruction>>> programs_;
+  std::vector<leaf> leaves_;
+  std::vector<scan> scans_;
+};
+
+} // namespace vast::plugins::sigma
@@ -0,0 +1,358 @@
+//    _   _____   __________
+//   | | / / _ | / __/_  __/     Visibility
+//   | |/ / __ |_\ \  / /          Across
+//   |___/_/ |_/___/ /_/       Space and Time
+//
+// SPDX-FileCopyrightText: (c) 2023 The VAST Contributors
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "sigma/matcher.hpp"
+
+#include "sigma/parse.hpp"
+
+#include <vast/arrow_table_slice.hpp>
+#include <vast/bitmap_algorithms.hpp>
+#include <vast/data.hpp>
+#include <vast/detail/assert.hpp>
+#include <vast/detail/load_contents.hpp>
+#include <vast/detail/overload.hpp>
+#include <vast/error.hpp>
+#include <vast/logger.hpp>
+#include <vast/pattern.hpp>
+#include <vast/table_slice.hpp>
+#include <vast/type.hpp>
+
+#include <arrow/array.h>
+#include <arrow/record_batch.h>
+#include <fmt/format.h>
+#include <re2/re2.h>
+#include <re2/set.h>
+
+#include <algorithm>
+#include <memory>
+
+namespace vast::plugins::sigma {
+
+namespace {
+
+/// The memory budget of the automaton of a single column. Exceeding the
+/// budget while scanning falls back to evaluating the predicates one by one.
+constexpr auto max_scan_memory = int64_t{64} << 20;
+
+/// Translates a predicate on a string column into a regular expression with
+/// the same semantics when fully matching a cell.
+std::optional<std::string> to_regex(relational_operator op, const data& rhs) {
+  auto f = detail::overload{
+    [&](const pattern& x) -> std::optional<std::string> {
+      if (op != relational_operator::equal
+          && op != relational_operator::not_equal)
+        return std::nullopt;
+      if (x.options().case_insensitive)
+        return fmt::format("(?i:{})", x.string());
+      return x.string();
+    },
+    [&](const std::string& x) -> std::optional<std::string> {
+      switch (op) {
+        default:
+          return std::nullopt;
+        case relational_operator::equal:
+        case relational_operator::not_equal:
+          return re2::RE2::QuoteMeta(x);
+        case relational_operator::ni:
+        case relational_operator::not_ni:
+          return fmt::format("(?s).*{}.*", re2::RE2::QuoteMeta(x));
+      }
+    },
+    [](const auto&) -> std::optional<std::string> {
+      return std::nullopt;
+    },
+  };
+  return caf::visit(f, rhs);
+}
+
+/// Creates an ID set of length *end* from sorted IDs.
+ids to_ids(const std::vector<id>& xs, id end) {
+  auto result = ids{};
+  for (auto x : xs) {
+    result.append(false, x - result.size());
+    result.append(true, 1u);
+  }
+  result.append(false, end - result.size());
+  return result;
+}
+
+} // namespace
+
+caf::expected<std::vector<rule>> load_rules(const std::filesystem::path& path) {
+  auto files = std::vector<std::filesystem::path>{};
+  auto err = std::error_code{};
+  if (std::filesystem::is_directory(path, err)) {
+    for (auto it = std::filesystem::recursive_directory_iterator{path, err};
+         !err && it != std::filesystem::recursive_directory_iterator{};
+         it.increment(err)) {
+      const auto extension = it->path().extension();
+      if (it->is_regular_file()
+          && (extension == ".yml" || extension == ".yaml"))
+        files.push_back(it->path());
+    }
+    std::sort(files.begin(), files.end());
+  } else if (!err) {
+    files.push_back(path);
+  }
+  if (err)
+    return caf::make_error(ec::filesystem_error,
+                           fmt::format("failed to list Sigma rules in {}: {}",
+                                       path.string(), err.message()));
+  auto result = std::vector<rule>{};
+  for (const auto& file : files) {
+    auto contents = detail::load_contents(file);
+    if (!contents)
+      return std::move(contents.error());
+    auto yaml = from_yaml(*contents);
+    if (!yaml)
+      return caf::make_error(ec::parse_error,
+                             fmt::format("failed to parse Sigma rule {}: {}",
+                                         file.string(), yaml.error()));
+    auto expr = parse_rule(*yaml);
+    if (expr)
+      expr = normalize_and_validate(std::move(*expr));
+    if (!expr) {
+      VAST_WARN("sigma skips rule {}: {}", file.string(), expr.error());
+      continue;
+    }
+    auto title = file.stem().string();
+    if (const auto* xs = caf::get_if<record>(&*yaml))
+      if (auto i = xs->find("title"); i != xs->end())
+        if (const auto* str = caf::get_if<std::string>(&i->second))
+          title = *str;
+    result.push_back({std::move(title), std::move(*expr)});
+  }
+  if (result.empty())
+    return caf::make_error(ec::invalid_argument,
+                           fmt::format("found no Sigma rules in {}",
+                                       path.string()));
+  return result;
+}
+
+/// A string column together with the regular expressions of all predicates
+/// on the column.
+struct matcher::scan {
+  size_t column = {};
+  std::unique_ptr<re2::RE2::Set> set = {};
+  std::map<std::string, int> entries = {};
+};
+
+matcher::matcher() = default;
+matcher::matcher(matcher&&) noexcept = default;
+matcher& matcher::operator=(matcher&&) noexcept = default;
+matcher::~matcher() noexcept = default;
+
+caf::expected<matcher>
+matcher::make(const std::vector<rule>& rules, const type& schema) {
+  auto result = matcher{};
+  auto leaves = std::map<predicate, size_t>{};
+  auto scans = std::map<size_t, size_t>{};
+  for (size_t i = 0; i < rules.size(); ++i) {
+    // A rule that refers to fields that do not exist in the schema cannot
+    // match, just like the where operator yields nothing in this case.
+    auto tailored = tailor(rules[i].expr, schema);
+    if (!tailored)
+      continue;
+    auto program = std::vector<instruction>{};
+    result.compile(*tailored, program, leaves, scans);
+    result.programs_.emplace_back(i, std::move(program));
+  }
+  for (size_t i = 0; i < result.scans_.size(); ++i) {
+    auto& scan = result.scans_[i];
+    if (scan.set->Compile())
+      continue;
+    VAST_WARN("sigma failed to compile {} patterns for column {} of schema {}; "
+              "falling back to evaluating them one by one",
+              scan.entries.size(), scan.column, schema);
+    scan.set = nullptr;
+    for (auto& x : result.leaves_)
+      if (x.scan == i)
+        x.scan = leaf::no_scan;
+  }
+  return result;
+}
+
+void matcher::compile(const expression& expr,
+                      std::vector<instruction>& program,
+                      std::map<predicate, size_t>& leaves,
+                      std::map<size_t, size_t>& scans) {
+  auto f = detail::overload{
+    [&](caf::none_t) {
+      // An empty expression matches everything.
+      program.push_back({instruction::opcode::conjunction, 0});
+    },
+    [&](const conjunction& xs) {
+      for (const auto& x : xs)
+        compile(x, program, leaves, scans);
+      program.push_back({instruction::opcode::conjunction, xs.size()});
+    },
+    [&](const disjunction& xs) {
+      for (const auto& x : xs)
+        compile(x, program, leaves, scans);
+      program.push_back({instruction::opcode::disjunction, xs.size()});
+    },
+    [&](const negation& x) {
+      compile(x.expr(), program, leaves, scans);
+      program.push_back({instruction::opcode::negation, 0});
+    },
+    [&](const predicate& x) {
+      program.push_back(
+        {instruction::opcode::predicate, add(x, leaves, scans)});
+    },
+  };
+  caf::visit(f, expr);
+}
+
+size_t matcher::add(const predicate& pred, std::map<predicate, size_t>& leaves,
+                    std::map<size_t, size_t>& scans) {
+  if (auto it = leaves.find(pred); it != leaves.end())
+    return it->second;
+  const auto index = leaves_.size();
+  leaves.emplace(pred, index);
+  auto& new_leaf = leaves_.emplace_back();
+  new_leaf.pred = pred;
+  const auto* lhs = caf::get_if<data_extractor>(&pred.lhs);
+  const auto* rhs = caf::get_if<data>(&pred.rhs);
+  if (!lhs || !rhs || !caf::holds_alternative<string_type>(lhs->type))
+    return index;
+  auto regex = to_regex(pred.op, *rhs);
+  if (!regex)
+    return index;
+  auto [scan_it, inserted] = scans.try_emplace(lhs->column, scans_.size());
+  if (inserted) {
+    auto options = re2::RE2::Options{re2::RE2::CannedOptions::Quiet};
+    options.set_max_mem(max_scan_memory);
+    auto& new_scan = scans_.emplace_back();
+    new_scan.column = lhs->column;
+    new_scan.set
+      = std::make_unique<re2::RE2::Set>(options, re2::RE2::ANCHOR_BOTH);
+  }
+  auto& scan = scans_[scan_it->second];
+  auto [entry_it, added] = scan.entries.try_emplace(*regex, -1);
+  if (added)
+    entry_it->second = scan.set->Add(*regex, nullptr);
+  // Patterns that RE2 rejects as part of a set fall back to the evaluator.
+  if (entry_it->second < 0)
+    return index;
+  new_leaf.scan = scan_it->second;
+  new_leaf.entry = entry_it->second;
+  new_leaf.negated = pred.op == relational_operator::not_equal
+                     || pred.op == relational_operator::not_ni;
+  return index;
+}
+
+std::vector<std::pair<size_t, ids>>
+matcher::match(const table_slice& slice) const {
+  const auto offset = slice.offset() == invalid_id ? 0 : slice.offset();
+  const auto end = offset + slice.rows();
+  const auto all = make_ids({{offset, end}});
+  auto hits = std::vector<ids>(leaves_.size());
+  auto evaluated = std::vector<bool>(leaves_.size());
+  // Scan every string column once with the patterns of all rules.
+  const auto& schema = caf::get<record_type>(slice.schema());
+  const auto batch = to_record_batch(slice);
+  auto matches = std::vector<int>{};
+  for (size_t i = 0; i < scans_.size(); ++i) {
+    const auto& scan = scans_[i];
+    if (!scan.set)
+      continue;
+    const auto column = static_cast<arrow::FieldPath>(
+                          schema.resolve_flat_index(scan.column))
+                          .Get(*batch)
+                          .ValueOrDie();
+    const auto& array = caf::get<type_to_arrow_array_t<string_type>>(*column);
+    auto rows = std::vector<std::vector<id>>(scan.entries.size());
+    auto valid = std::vector<id>{};
+    auto failed = false;
+    for (int64_t row = 0; row < array.length() && !failed; ++row) {
+      if (array.IsNull(row))
+        continue;
+      valid.push_back(offset + row);
+      const auto str = array.GetView(row);
+      auto error = re2::RE2::Set::ErrorInfo{};
+      matches.clear();
+      if (!scan.set->Match(re2::StringPiece{str.data(), str.size()}, &matches,
+                           &error)
+          && error.kind != re2::RE2::Set::kNoError) {
+        failed = true;
+        break;
+      }
+      for (auto entry : matches)
+        rows[entry].push_back(offset + row);
+    }
+    if (failed) {
+      VAST_DEBUG("sigma exceeded the memory budget of the automaton for "
+                 "column {} of schema {}",
+                 scan.column, slice.schema());
+      continue;
+    }
+    const auto valid_ids = to_ids(valid, end);
+    for (size_t j = 0; j < leaves_.size(); ++j) {
+      const auto& leaf = leaves_[j];
+      if (leaf.scan != i)
+        continue;
+      hits[j] = to_ids(rows[leaf.entry], end);
+      if (leaf.negated)
+        hits[j] = valid_ids & ~hits[j];
+      evaluated[j] = true;
+    }
+  }
+  // Evaluate all remaining predicates once, no matter how many rules share
+  // them.
+  for (size_t j = 0; j < leaves_.size(); ++j)
+    if (!evaluated[j])
+      hits[j] = evaluate(expression{leaves_[j].pred}, slice, all);
+  // Combine the results of the predicates for every rule.
+  auto result = std::vector<std::pair<size_t, ids>>{};
+  auto stack = std::vector<ids>{};
+  for (const auto& [index, program] : programs_) {
+    stack.clear();
+    for (const auto& step : program) {
+      switch (step.op) {
+        case instruction::opcode::predicate:
+          stack.push_back(hits[step.arg]);
+          break;
+        case instruction::opcode::conjunction: {
+          auto x = all;
+          for (size_t k = 0; k < step.arg; ++k) {
+            x &= stack.back();
+            stack.pop_back();
+          }
+          stack.push_back(std::move(x));
+          break;
+        }
+        case instruction::opcode::disjunction: {
+          auto x = ids{end, false};
+          for (size_t k = 0; k < step.arg; ++k) {
+            x |= stack.back();
+            stack.pop_back();
+          }
+          stack.push_back(std::move(x));
+          break;
+        }
+        case instruction::opcode::negation:
+          stack.back() = all & ~stack.back();
+          break;
+      }
+    }
+    VAST_ASSERT(stack.size() == 1);
+    if (any(stack.back()))
+      result.emplace_back(index, std::move(stack.back()));
+  }
+  return result;
+}
+
+size_t matcher::num_predicates() const noexcept {
+  return leaves_.size();
+}
+
+size_t matcher::num_scans() const noexcept {
+  return scans_.size();
+}
+
+} // namespace vast::plugins::sigma
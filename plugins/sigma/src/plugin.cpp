@@ -6,19 +6,119 @@
 // SPDX-FileCopyrightText: (c) 2022 The VAST Contributors
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "sigma/matcher.hpp"
 #include "sigma/parse.hpp"
 
+#include <vast/arrow_table_slice.hpp>
+#include <vast/concept/parseable/vast/pipeline.hpp>
 #include <vast/data.hpp>
+#include <vast/detail/string.hpp>
 #include <vast/error.hpp>
+#include <vast/pipeline.hpp>
 #include <vast/plugin.hpp>
+#include <vast/table_slice.hpp>
 
+#include <arrow/type.h>
 #include <caf/error.hpp>
 #include <caf/expected.hpp>
 #include <fmt/format.h>
 
 namespace vast::plugins::sigma {
 
-class plugin final : public virtual language_plugin {
+namespace {
+
+/// The per-schema state of the sigma operator.
+struct sigma_state {
+  /// The shared evaluation plan of all rules.
+  matcher rules;
+
+  /// Whether to prepend the title of the matching rule to every event.
+  bool annotate = true;
+};
+
+// Matches events against a set of Sigma rules, and yields the events that
+// match a rule together with the title of that rule.
+class sigma_operator final
+  : public schematic_operator<sigma_operator, sigma_state,
+                              generator<table_slice>> {
+  static constexpr auto annotation_field = "sigma";
+
+public:
+  sigma_operator(std::string path, std::vector<rule> rules)
+    : path_{std::move(path)}, rules_{std::move(rules)} {
+    // nop
+  }
+
+  auto initialize(const type& schema, operator_control_plane& ctrl) const
+    -> caf::expected<state_type> override {
+    auto rules = matcher::make(rules_, schema);
+    if (!rules)
+      return std::move(rules.error());
+    auto annotate
+      = !caf::get<record_type>(schema).resolve_key(annotation_field);
+    if (!annotate)
+      ctrl.warn(caf::make_error(ec::unspecified,
+                                fmt::format("not annotating schema {} with "
+                                            "already existing key {}",
+                                            schema.name(), annotation_field)));
+    return sigma_state{std::move(*rules), annotate};
+  }
+
+  auto process(table_slice slice, state_type& state) const
+    -> output_type override {
+    for (auto&& [index, hits] : state.rules.match(slice)) {
+      auto result = filter(slice, hits);
+      if (!result)
+        continue;
+      if (!state.annotate) {
+        co_yield std::move(*result);
+        continue;
+      }
+      const auto& title = rules_[index].title;
+      auto transformations = std::vector<indexed_transformation>{};
+      auto function = [&](struct record_type::field field,
+                          std::shared_ptr<arrow::Array> array)
+        -> std::vector<std::pair<struct record_type::field,
+                                 std::shared_ptr<arrow::Array>>> {
+        auto builder
+          = string_type::make_arrow_builder(arrow::default_memory_pool());
+        auto reserve_result = builder->Reserve(array->length());
+        VAST_ASSERT_CHEAP(reserve_result.ok(),
+                          reserve_result.ToString().c_str());
+        for (int64_t i = 0; i < array->length(); ++i) {
+          auto append_result = builder->Append(title);
+          VAST_ASSERT(append_result.ok(), append_result.ToString().c_str());
+        }
+        return {
+          {{annotation_field, string_type{}}, builder->Finish().ValueOrDie()},
+          {std::move(field), std::move(array)},
+        };
+      };
+      transformations.push_back({offset{0}, std::move(function)});
+      co_yield transform_columns(*result, transformations);
+    }
+  }
+
+  auto parallelism() const -> operator_parallelism override {
+    return operator_parallelism::stateless;
+  }
+
+  auto to_string() const -> std::string override {
+    auto escaper = [](auto& f, auto out) {
+      if (*f == '\\' || *f == '"')
+        *out++ = '\\';
+      *out++ = *f++;
+    };
+    return fmt::format("sigma \"{}\"", detail::escape(path_, escaper));
+  }
+
+private:
+  std::string path_;
+  std::vector<rule> rules_;
+};
+
+class plugin final : public virtual language_plugin,
+                     public virtual operator_plugin {
   auto initialize(const record&, const record&) -> caf::error override {
     return caf::none;
   }
@@ -40,8 +140,36 @@ class plugin final : public virtual language_plugin {
                              fmt::format("not a Sigma rule: {}", yaml.error()));
     }
   }
+
+  auto make_operator(std::string_view pipeline) const
+    -> std::pair<std::string_view, caf::expected<operator_ptr>> override {
+    using parsers::end_of_pipeline_operator, parsers::required_ws_or_comment,
+      parsers::optional_ws_or_comment, parsers::operator_arg;
+    const auto* f = pipeline.begin();
+    const auto* const l = pipeline.end();
+    const auto p = required_ws_or_comment >> operator_arg
+                   >> optional_ws_or_comment >> end_of_pipeline_operator;
+    auto path = std::string{};
+    if (!p(f, l, path)) {
+      return {
+        std::string_view{f, l},
+        caf::make_error(ec::syntax_error,
+                        fmt::format("failed to parse sigma operator: '{}'",
+                                    pipeline)),
+      };
+    }
+    auto rules = load_rules(path);
+    if (!rules)
+      return {std::string_view{f, l}, std::move(rules.error())};
+    return {
+      std::string_view{f, l},
+      std::make_unique<sigma_operator>(std::move(path), std::move(*rules)),
+    };
+  }
 };
 
+} // namespace
+
 } // namespace vast::plugins::sigma
 
 VAST_REGISTER_PLUGIN(vast::plugins::sigma::plugin)
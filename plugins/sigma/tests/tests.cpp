@@ -6,6 +6,7 @@
 // SPDX-FileCopyrightText: (c) 2022 The VAST Contributors
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include "sigma/matcher.hpp"
 #include "sigma/parse.hpp"
 
 #include <vast/concept/parseable/to.hpp>
@@ -15,10 +16,15 @@
 #include <vast/concept/printable/vast/expression.hpp>
 #include <vast/detail/base64.hpp>
 #include <vast/expression.hpp>
+#include <vast/table_slice.hpp>
+#include <vast/table_slice_builder.hpp>
 #include <vast/test/test.hpp>
 
 #include <caf/test/dsl.hpp>
 
+#include <filesystem>
+#include <fstream>
+
 using namespace std::string_literals;
 using namespace std::string_view_literals;
 using namespace vast;
@@ -38,6 +44,10 @@ expression to_expr(std::string_view expr) {
   return unbox(to<expression>(expr));
 }
 
+plugins::sigma::rule to_matcher_rule(std::string title, std::string_view yaml) {
+  return {std::move(title), unbox(normalize_and_validate(to_rule(yaml)))};
+}
+
 } // namespace
 
 TEST(wildcard unescaping) {
@@ -580,3 +590,95 @@ TEST_DISABLED(modifier test rule) {
   expected.emplace_back(to_expr(start));
   CHECK_EQUAL(expr, expression{expected});
 }
+
+TEST(matcher) {
+  const auto schema = type{
+    "process",
+    record_type{
+      {"image", string_type{}},
+      {"cmd", string_type{}},
+      {"pid", int64_type{}},
+    },
+  };
+  auto builder = table_slice_builder{schema};
+  REQUIRE(builder.add("C:\\Windows\\cmd.exe"sv, "whoami"sv, int64_t{1}));
+  REQUIRE(builder.add("powershell.exe"sv, "-enc ZQBjAGgAbwA="sv, int64_t{2}));
+  REQUIRE(builder.add("explorer.exe"sv, "whoami /all"sv, int64_t{3}));
+  REQUIRE(builder.add(caf::none, "whoami"sv, int64_t{4}));
+  auto slice = builder.finish();
+  slice.offset(0);
+  auto rules = std::vector<plugins::sigma::rule>{
+    to_matcher_rule("cmd", R"__(
+detection:
+  selection:
+    image|endswith: cmd.exe
+  condition: selection
+)__"),
+    to_matcher_rule("whoami", R"__(
+detection:
+  selection:
+    cmd|contains: whoami
+  filter:
+    image|endswith: cmd.exe
+  condition: selection and not filter
+)__"),
+    to_matcher_rule("pid", R"__(
+detection:
+  selection:
+    pid: 4
+  condition: selection
+)__"),
+    to_matcher_rule("unknown field", R"__(
+detection:
+  selection:
+    user: root
+  condition: selection
+)__"),
+  };
+  auto sut = unbox(plugins::sigma::matcher::make(rules, schema));
+  // The rules share the predicate on the image column, and every string
+  // column is scanned only once.
+  CHECK_EQUAL(sut.num_predicates(), 3u);
+  CHECK_EQUAL(sut.num_scans(), 2u);
+  auto result = sut.match(slice);
+  REQUIRE_EQUAL(result.size(), 3u);
+  CHECK_EQUAL(result[0].first, 0u);
+  CHECK_EQUAL(result[0].second, make_ids({0}, 4));
+  // The null image of the last row satisfies neither the filter nor its
+  // negation.
+  CHECK_EQUAL(result[1].first, 1u);
+  CHECK_EQUAL(result[1].second, make_ids({2}, 4));
+  CHECK_EQUAL(result[2].first, 2u);
+  CHECK_EQUAL(result[2].second, make_ids({3}, 4));
+}
+
+TEST(loading rules) {
+  const auto dir = std::filesystem::temp_directory_path() / "vast-sigma-rules";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir / "nested");
+  std::ofstream{dir / "b.yml"} << R"__(
+title: Whoami
+detection:
+  selection:
+    cmd|contains: whoami
+  condition: selection
+)__";
+  std::ofstream{dir / "nested" / "a.yaml"} << R"__(
+detection:
+  selection:
+    pid: 4
+  condition: selection
+)__";
+  std::ofstream{dir / "invalid.yml"} << "title: No detection";
+  std::ofstream{dir / "README.md"} << "# Rules";
+  auto rules = unbox(plugins::sigma::load_rules(dir));
+  REQUIRE_EQUAL(rules.size(), 2u);
+  CHECK_EQUAL(rules[0].title, "Whoami");
+  CHECK_EQUAL(rules[0].expr, to_expr("cmd ni \"whoami\""));
+  CHECK_EQUAL(rules[1].title, "a");
+  CHECK_EQUAL(rules[1].expr, to_expr("pid == 4"));
+  std::filesystem::remove_all(dir / "nested");
+  std::filesystem::remove(dir / "b.yml");
+  CHECK(!plugins::sigma::load_rules(dir));
+  std::filesystem::remove_all(dir);
+}